@@ -1,5 +1,10 @@
 #!/bin/bash
 
+# Usage: hid.sh [nkro]
+#
+# With "nkro" a fourth function, an n-key rollover keyboard, is added
+# as /dev/hidg3 alongside the boot protocol keyboard.
+
 # Linux only
 #if [ "$(lsusb)" != "Bus 001 Device 001: ID 1d6b:0002 Linux Foundation 2.0 root hub" ]
 #then
@@ -32,7 +37,7 @@ B_N="mouse"
 mkdir -p functions/hid.$B_N
 echo 2 > functions/hid.$B_N/protocol
 echo 1 > functions/hid.$B_N/subclass
-echo 5 > functions/hid.$B_N/report_length
+echo 7 > functions/hid.$B_N/report_length
 echo -ne \
 \\x05\\x01\
 \\x09\\x02\
@@ -95,6 +100,42 @@ echo -ne \
 \\x81\\x02\
 \\xc0\\xc0 > functions/hid.$C_N/report_desc
 
+# N-key rollover keyboard:  one bit for each usage 0x00-0xe7 (the last
+# byte is the modifiers), plus the same LED output report as above.
+# not a boot device, so the BIOS keeps using the boot keyboard.
+if [ "$1" == "nkro" ]
+then
+E_N="keyboard_nkro"
+mkdir -p functions/hid.$E_N
+echo 0 > functions/hid.$E_N/protocol
+echo 0 > functions/hid.$E_N/subclass
+echo 29 > functions/hid.$E_N/report_length
+echo -ne \
+\\x05\\x01\
+\\x09\\x06\
+\\xa1\\x01\
+\\x05\\x08\
+\\x19\\x01\
+\\x29\\x05\
+\\x15\\x00\
+\\x25\\x01\
+\\x75\\x01\
+\\x95\\x05\
+\\x91\\x02\
+\\x95\\x01\
+\\x75\\x03\
+\\x91\\x03\
+\\x05\\x07\
+\\x19\\x00\
+\\x29\\xE7\
+\\x15\\x00\
+\\x25\\x01\
+\\x75\\x01\
+\\x95\\xE8\
+\\x81\\x02\
+\\xc0 > functions/hid.$E_N/report_desc
+fi
+
 D=1
 mkdir -p configs/c.$D/strings/0x409
 echo "Config $D: ECM network" > configs/c.$D/strings/0x409/configuration
@@ -102,9 +143,17 @@ echo 250 > configs/c.$D/MaxPower
 ln -s functions/hid.$A_N configs/c.$D/
 ln -s functions/hid.$B_N configs/c.$D/
 ln -s functions/hid.$C_N configs/c.$D/
+if [ -n "$E_N" ]
+then
+ln -s functions/hid.$E_N configs/c.$D/
+fi
 ls /sys/class/udc > UDC
 
 
 chmod -R 777 /dev/hidg0
 chmod -R 777 /dev/hidg1
 chmod -R 777 /dev/hidg2
+if [ -n "$E_N" ]
+then
+chmod -R 777 /dev/hidg3
+fi
@@ -216,6 +216,23 @@ public:
     virtual size_t        writeSocket(ArchSocket s,
                             const void* buf, size_t len) = 0;
 
+    //! Read a datagram from socket
+    /*!
+    Like readSocket() for a datagram socket, also returning the address
+    the datagram came from in \c addr.  The caller must close \c addr
+    with closeAddr().  \c addr is set to NULL if there's no datagram.
+    */
+    virtual size_t        readSocketFrom(ArchSocket s, void* buf, size_t len,
+                            ArchNetAddress* addr) = 0;
+
+    //! Write a datagram to socket
+    /*!
+    Like writeSocket() for a datagram socket, sending the datagram to
+    \c addr.  Returns 0 if the datagram couldn't be queued.
+    */
+    virtual size_t        writeSocketTo(ArchSocket s, const void* buf,
+                            size_t len, ArchNetAddress addr) = 0;
+
     //! Check error on socket
     /*!
     If the socket \c s is in an error state then throws an appropriate
@@ -237,6 +254,15 @@ public:
     */
     virtual bool        setReuseAddrOnSocket(ArchSocket, bool reuse) = 0;
 
+    //! Limit unsent data held by the socket
+    /*!
+    Stops the socket from reporting itself writable while more than
+    \c bytes of written data have yet to be sent, so data written later
+    doesn't queue behind a full send buffer.  Returns false if the
+    platform can't do this.
+    */
+    virtual bool        setUnsentLimitOnSocket(ArchSocket, size_t bytes) = 0;
+
     //! Return local host's name
     virtual std::string        getHostName() = 0;
 
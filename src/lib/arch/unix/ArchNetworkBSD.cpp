@@ -538,6 +538,47 @@ ArchNetworkBSD::writeSocket(ArchSocket s, const void* buf, size_t len)
     return n;
 }
 
+size_t
+ArchNetworkBSD::readSocketFrom(ArchSocket s, void* buf, size_t len,
+                ArchNetAddress* addr)
+{
+    assert(s != NULL);
+    assert(addr != NULL);
+
+    auto* from = new ArchNetAddressImpl;
+    ssize_t n  = recvfrom(s->m_fd, buf, len, 0,
+                            TYPED_ADDR(struct sockaddr, from), &from->m_len);
+    if (n == -1) {
+        int err = errno;
+        delete from;
+        *addr = nullptr;
+        if (err == EINTR || err == EAGAIN) {
+            return 0;
+        }
+        throwError(err);
+    }
+    *addr = from;
+    return n;
+}
+
+size_t
+ArchNetworkBSD::writeSocketTo(ArchSocket s, const void* buf, size_t len,
+                ArchNetAddress addr)
+{
+    assert(s != NULL);
+    assert(addr != NULL);
+
+    ssize_t n = sendto(s->m_fd, buf, len, 0,
+                            TYPED_ADDR(struct sockaddr, addr), addr->m_len);
+    if (n == -1) {
+        if (errno == EINTR || errno == EAGAIN || errno == ENOBUFS) {
+            return 0;
+        }
+        throwError(errno);
+    }
+    return n;
+}
+
 void
 ArchNetworkBSD::throwErrorOnSocket(ArchSocket s)
 {
@@ -623,6 +664,25 @@ ArchNetworkBSD::setReuseAddrOnSocket(ArchSocket s, bool reuse)
     return (oflag != 0);
 }
 
+bool
+ArchNetworkBSD::setUnsentLimitOnSocket(ArchSocket s, size_t bytes)
+{
+    assert(s != NULL);
+
+#if defined(TCP_NOTSENT_LOWAT)
+    int limit = static_cast<int>(bytes);
+    if (setsockopt(s->m_fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT,
+                            reinterpret_cast<optval_t*>(&limit),
+                            static_cast<socklen_t>(sizeof(limit))) == -1) {
+        return false;
+    }
+    return true;
+#else
+    (void)bytes;
+    return false;
+#endif
+}
+
 std::string
 ArchNetworkBSD::getHostName()
 {
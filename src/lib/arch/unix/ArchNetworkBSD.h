@@ -77,9 +77,14 @@ public:
     virtual size_t        readSocket(ArchSocket s, void* buf, size_t len);
     virtual size_t        writeSocket(ArchSocket s,
                             const void* buf, size_t len);
+    virtual size_t        readSocketFrom(ArchSocket s, void* buf, size_t len,
+                            ArchNetAddress* addr);
+    virtual size_t        writeSocketTo(ArchSocket s, const void* buf,
+                            size_t len, ArchNetAddress addr);
     virtual void        throwErrorOnSocket(ArchSocket);
     virtual bool        setNoDelayOnSocket(ArchSocket, bool noDelay);
     virtual bool        setReuseAddrOnSocket(ArchSocket, bool reuse);
+    virtual bool        setUnsentLimitOnSocket(ArchSocket, size_t bytes);
     virtual std::string        getHostName();
     virtual ArchNetAddress    newAnyAddr(EAddressFamily);
     virtual ArchNetAddress    copyAddr(ArchNetAddress);
@@ -48,8 +48,10 @@ static int (PASCAL FAR *ioctl_winsock)(SOCKET s, int cmd, void FAR * data);
 static int (PASCAL FAR *listen_winsock)(SOCKET s, int backlog);
 static u_short (PASCAL FAR *ntohs_winsock)(u_short v);
 static int (PASCAL FAR *recv_winsock)(SOCKET s, void FAR * buf, int len, int flags);
+static int (PASCAL FAR *recvfrom_winsock)(SOCKET s, void FAR * buf, int len, int flags, struct sockaddr FAR *from, int FAR *fromlen);
 static int (PASCAL FAR *select_winsock)(int nfds, fd_set FAR *readfds, fd_set FAR *writefds, fd_set FAR *exceptfds, const struct timeval FAR *timeout);
 static int (PASCAL FAR *send_winsock)(SOCKET s, const void FAR * buf, int len, int flags);
+static int (PASCAL FAR *sendto_winsock)(SOCKET s, const void FAR * buf, int len, int flags, const struct sockaddr FAR *to, int tolen);
 static int (PASCAL FAR *setsockopt_winsock)(SOCKET s, int level, int optname, const void FAR * optval, int optlen);
 static int (PASCAL FAR *shutdown_winsock)(SOCKET s, int how);
 static SOCKET (PASCAL FAR *socket_winsock)(int af, int type, int protocol);
@@ -183,8 +185,10 @@ ArchNetworkWinsock::initModule(HMODULE module)
     setfunc(listen_winsock, listen, int (PASCAL FAR *)(SOCKET s, int backlog));
     setfunc(ntohs_winsock, ntohs, u_short (PASCAL FAR *)(u_short v));
     setfunc(recv_winsock, recv, int (PASCAL FAR *)(SOCKET s, void FAR * buf, int len, int flags));
+    setfunc(recvfrom_winsock, recvfrom, int (PASCAL FAR *)(SOCKET s, void FAR * buf, int len, int flags, struct sockaddr FAR *from, int FAR *fromlen));
     setfunc(select_winsock, select, int (PASCAL FAR *)(int nfds, fd_set FAR *readfds, fd_set FAR *writefds, fd_set FAR *exceptfds, const struct timeval FAR *timeout));
     setfunc(send_winsock, send, int (PASCAL FAR *)(SOCKET s, const void FAR * buf, int len, int flags));
+    setfunc(sendto_winsock, sendto, int (PASCAL FAR *)(SOCKET s, const void FAR * buf, int len, int flags, const struct sockaddr FAR *to, int tolen));
     setfunc(setsockopt_winsock, setsockopt, int (PASCAL FAR *)(SOCKET s, int level, int optname, const void FAR * optval, int optlen));
     setfunc(shutdown_winsock, shutdown, int (PASCAL FAR *)(SOCKET s, int how));
     setfunc(socket_winsock, socket, SOCKET (PASCAL FAR *)(int af, int type, int protocol));
@@ -586,6 +590,51 @@ ArchNetworkWinsock::writeSocket(ArchSocket s, const void* buf, size_t len)
     return static_cast<size_t>(n);
 }
 
+size_t
+ArchNetworkWinsock::readSocketFrom(ArchSocket s, void* buf, size_t len,
+                ArchNetAddress* addr)
+{
+    assert(s != NULL);
+    assert(addr != NULL);
+
+    ArchNetAddress from = ArchNetAddressImpl::alloc(sizeof(struct sockaddr_in6));
+    int n = recvfrom_winsock(s->m_socket, buf, (int)len, 0,
+                            TYPED_ADDR(struct sockaddr, from), &from->m_len);
+    if (n == SOCKET_ERROR) {
+        int err = getsockerror_winsock();
+        free(from);
+        *addr = NULL;
+        // WSAECONNRESET reports an ICMP port unreachable for an earlier
+        // datagram, not a datagram to read
+        if (err == WSAEINTR || err == WSAEWOULDBLOCK ||
+            err == WSAECONNRESET || err == WSAEMSGSIZE) {
+            return 0;
+        }
+        throwError(err);
+    }
+    *addr = from;
+    return static_cast<size_t>(n);
+}
+
+size_t
+ArchNetworkWinsock::writeSocketTo(ArchSocket s, const void* buf, size_t len,
+                ArchNetAddress addr)
+{
+    assert(s != NULL);
+    assert(addr != NULL);
+
+    int n = sendto_winsock(s->m_socket, buf, (int)len, 0,
+                            TYPED_ADDR(struct sockaddr, addr), addr->m_len);
+    if (n == SOCKET_ERROR) {
+        int err = getsockerror_winsock();
+        if (err == WSAEINTR || err == WSAEWOULDBLOCK || err == WSAENOBUFS) {
+            return 0;
+        }
+        throwError(err);
+    }
+    return static_cast<size_t>(n);
+}
+
 void
 ArchNetworkWinsock::throwErrorOnSocket(ArchSocket s)
 {
@@ -664,6 +713,15 @@ ArchNetworkWinsock::setReuseAddrOnSocket(ArchSocket s, bool reuse)
     return (oflag != 0);
 }
 
+bool
+ArchNetworkWinsock::setUnsentLimitOnSocket(ArchSocket s, size_t /*bytes*/)
+{
+    assert(s != NULL);
+
+    // winsock has no equivalent of TCP_NOTSENT_LOWAT
+    return false;
+}
+
 std::string
 ArchNetworkWinsock::getHostName()
 {
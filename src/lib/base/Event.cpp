@@ -17,18 +17,24 @@
  */
 
 #include "base/Event.h"
+#include "base/EventDataPool.h"
 #include "base/EventQueue.h"
 
+#include <cstring>
+
 //
 // Event
 //
 
+const UInt32 Event::kInlineDataSize;
+
 Event::Event() :
     m_type(kUnknown),
     m_target(nullptr),
     m_data(nullptr),
     m_flags(0),
-    m_dataObject(nullptr)
+    m_dataObject(nullptr),
+    m_hasInlineData(false)
 {
     // do nothing
 }
@@ -38,7 +44,8 @@ Event::Event(Type type, void* target, void* data, Flags flags) :
     m_target(target),
     m_data(data),
     m_flags(flags),
-    m_dataObject(nullptr)
+    m_dataObject(nullptr),
+    m_hasInlineData(false)
 {
     // do nothing
 }
@@ -58,6 +65,9 @@ Event::getTarget() const
 void*
 Event::getData() const
 {
+    if (m_hasInlineData) {
+        return const_cast<UInt8*>(m_inlineData);
+    }
     return m_data;
 }
 
@@ -85,7 +95,7 @@ Event::deleteData(const Event& event)
 
     default:
         if ((event.getFlags() & kDontFreeData) == 0) {
-            free(event.getData());
+            EventDataPool::release(event.m_data);
             delete event.getDataObject();
         }
         break;
@@ -98,3 +108,12 @@ Event::setDataObject(EventData* dataObject)
     assert(m_dataObject == nullptr);
     m_dataObject = dataObject;
 }
+
+void
+Event::setInlineData(const void* data, UInt32 size)
+{
+    assert(size <= kInlineDataSize);
+    memcpy(m_inlineData, data, size);
+    m_data          = nullptr;
+    m_hasInlineData = true;
+}
@@ -63,12 +63,16 @@ public:
     Event(Type type, void* target = NULL, void* data = NULL,
                              Flags flags = kNone);
 
+    //! Largest data that can be stored in the event itself
+    static const UInt32 kInlineDataSize = 8;
+
     //! @name manipulators
     //@{
 
     //! Release event data
     /*!
-    Deletes event data for the given event (using free()).
+    Deletes event data for the given event (using
+    EventDataPool::release()).  Inline data needs no deleting.
     */
     static void            deleteData(const Event&);
     
@@ -79,6 +83,16 @@ public:
     */
     void                setDataObject(EventData* dataObject);
 
+    //! Set data (inline POD)
+    /*!
+    Copies \p size bytes of POD \p data into the event itself, replacing
+    any data pointer, so the event carries its data without an
+    allocation.  \p size must be at most \c kInlineDataSize.  Because
+    the data moves with the event, the pointer getData() returns is only
+    valid while the event it was called on exists.
+    */
+    void                setInlineData(const void* data, UInt32 size);
+
     //@}
     //! @name accessors
     //@{
@@ -97,7 +111,8 @@ public:
 
     //! Get the event data (POD).
     /*!
-    Returns the event data (POD).
+    Returns the event data (POD), which may be stored in the event
+    itself (see \c setInlineData()).
     */
     void*                getData() const;
 
@@ -123,4 +138,6 @@ private:
     void*                m_data;
     Flags                m_flags;
     EventData*            m_dataObject;
+    bool                m_hasInlineData;
+    alignas(8) UInt8    m_inlineData[kInlineDataSize];
 };
@@ -0,0 +1,205 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/EventDataPool.h"
+
+#include "base/Log.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+
+// every live pool, so release() can find the pool a block came from.
+// s_numPools is one past the highest slot ever used.
+static const UInt32 kMaxPools = 64;
+static std::atomic<EventDataPool*> s_pools[kMaxPools];
+static std::atomic<UInt32> s_numPools(0);
+
+//
+// EventDataPool
+//
+
+const UInt32 EventDataPool::kDefaultCapacity;
+const UInt32 EventDataPool::kMaxCapacity;
+
+EventDataPool::EventDataPool(const char* name,
+                UInt32 blockSize, UInt32 capacity) :
+    m_name(name),
+    m_blockSize((blockSize + 7) & ~7u),
+    m_capacity(capacity),
+    m_blocks(nullptr),
+    m_nextFree(nullptr),
+    m_registryIndex(kMaxPools),
+    m_inUse(0),
+    m_highWater(0),
+    m_overflows(0)
+{
+    assert(capacity <= kMaxCapacity);
+
+    m_blocks   = static_cast<UInt8*>(malloc(m_capacity * m_blockSize));
+    m_nextFree = new std::atomic<UInt32>[m_capacity];
+    for (UInt32 i = 0; i < m_capacity; ++i) {
+        m_nextFree[i].store(i + 1, std::memory_order_relaxed);
+    }
+
+    // register before any block can be handed out, so release() never
+    // sees a block from a pool it can't find
+    for (UInt32 i = 0; i < kMaxPools; ++i) {
+        EventDataPool* expected = nullptr;
+        if (s_pools[i].compare_exchange_strong(expected, this,
+                            std::memory_order_release,
+                            std::memory_order_relaxed)) {
+            m_registryIndex = i;
+            break;
+        }
+    }
+    assert(m_registryIndex < kMaxPools);
+
+    // a pool that couldn't be registered hands everything to malloc()
+    if (m_registryIndex == kMaxPools) {
+        m_capacity = 0;
+        return;
+    }
+    if (m_capacity > 0) {
+        m_free.push(m_nextFree, 0, m_capacity - 1);
+    }
+
+    UInt32 n = s_numPools.load(std::memory_order_relaxed);
+    while (n <= m_registryIndex &&
+            !s_numPools.compare_exchange_weak(n, m_registryIndex + 1,
+                            std::memory_order_release,
+                            std::memory_order_relaxed)) {
+        // try again
+    }
+}
+
+EventDataPool::~EventDataPool()
+{
+    if (m_registryIndex < kMaxPools) {
+        s_pools[m_registryIndex].store(nullptr, std::memory_order_release);
+    }
+    delete[] m_nextFree;
+    ::free(m_blocks);
+}
+
+void*
+EventDataPool::alloc(UInt32 size)
+{
+    UInt32 index = IndexFreeList::kNone;
+    if (size <= m_blockSize) {
+        index = m_free.pop(m_nextFree);
+    }
+    if (index != IndexFreeList::kNone) {
+        UInt32 inUse = m_inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+        UInt32 high  = m_highWater.load(std::memory_order_relaxed);
+        while (inUse > high &&
+                !m_highWater.compare_exchange_weak(high, inUse,
+                            std::memory_order_relaxed)) {
+            // try again
+        }
+        return m_blocks + index * m_blockSize;
+    }
+
+    m_overflows.fetch_add(1, std::memory_order_relaxed);
+    return malloc(size);
+}
+
+void
+EventDataPool::release(void* data)
+{
+    if (data == nullptr) {
+        return;
+    }
+
+    UInt32 n = s_numPools.load(std::memory_order_acquire);
+    for (UInt32 i = 0; i < n; ++i) {
+        EventDataPool* pool = s_pools[i].load(std::memory_order_acquire);
+        if (pool != nullptr && pool->owns(data)) {
+            pool->releaseBlock(data);
+            return;
+        }
+    }
+    ::free(data);
+}
+
+const char*
+EventDataPool::getName() const
+{
+    return m_name;
+}
+
+UInt32
+EventDataPool::getBlockSize() const
+{
+    return m_blockSize;
+}
+
+UInt32
+EventDataPool::getCapacity() const
+{
+    return m_capacity;
+}
+
+UInt32
+EventDataPool::getInUse() const
+{
+    return m_inUse.load(std::memory_order_relaxed);
+}
+
+UInt32
+EventDataPool::getHighWater() const
+{
+    return m_highWater.load(std::memory_order_relaxed);
+}
+
+UInt32
+EventDataPool::getOverflows() const
+{
+    return m_overflows.load(std::memory_order_relaxed);
+}
+
+void
+EventDataPool::logUsage()
+{
+    UInt32 n = s_numPools.load(std::memory_order_acquire);
+    for (UInt32 i = 0; i < n; ++i) {
+        EventDataPool* pool = s_pools[i].load(std::memory_order_acquire);
+        if (pool != nullptr && pool->getHighWater() > 0) {
+            LOG((CLOG_DEBUG1 "%s pool: high-water %d of %d blocks, %d overflow(s)",
+                            pool->getName(), pool->getHighWater(),
+                            pool->getCapacity(), pool->getOverflows()));
+        }
+    }
+}
+
+bool
+EventDataPool::owns(const void* data) const
+{
+    auto address = reinterpret_cast<uintptr_t>(data);
+    auto begin   = reinterpret_cast<uintptr_t>(m_blocks);
+    return (address >= begin && address < begin + m_capacity * m_blockSize);
+}
+
+void
+EventDataPool::releaseBlock(void* data)
+{
+    auto offset = static_cast<UInt32>(static_cast<UInt8*>(data) - m_blocks);
+    assert(offset % m_blockSize == 0);
+
+    UInt32 index = offset / m_blockSize;
+    m_inUse.fetch_sub(1, std::memory_order_relaxed);
+    m_free.push(m_nextFree, index, index);
+}
@@ -0,0 +1,148 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/IndexFreeList.h"
+#include "common/basic_types.h"
+
+#include <atomic>
+#include <type_traits>
+
+//! Pool of event data blocks
+/*!
+Event data is POD that's allocated by whoever posts an event and freed
+by Event::deleteData() once it's been dispatched.  A pool hands out
+blocks of one size from a preallocated region so the common payloads
+don't cost a malloc() and free() per event.  Any thread can allocate or
+release a block without taking a lock.
+
+Requests that don't fit in a block, or that arrive when every block is
+in use, fall back to malloc().  release() tells the two apart, so event
+data from a pool and from malloc() can be freed the same way.
+
+Pools are meant to be static objects.  A pool must outlive every block
+it hands out.
+*/
+class EventDataPool {
+public:
+    //! Blocks in a pool unless the pool says otherwise
+    static const UInt32 kDefaultCapacity = 1024;
+
+    //! Most blocks a pool can have
+    static const UInt32 kMaxCapacity = IndexFreeList::kNone - 1;
+
+    /*!
+    \c name identifies the pool in logUsage().  \c blockSize is rounded
+    up so every block is suitably aligned for pointers and integers.
+    */
+    EventDataPool(const char* name, UInt32 blockSize,
+                            UInt32 capacity = kDefaultCapacity);
+    ~EventDataPool();
+
+    //! @name manipulators
+    //@{
+
+    //! Allocate event data
+    /*!
+    Returns \c size uninitialized bytes from the pool or, if they won't
+    fit or the pool is exhausted, from malloc().  Free the data with
+    release().
+    */
+    void*               alloc(UInt32 size);
+
+    //! Free event data
+    /*!
+    Returns \c data to the pool it came from, or passes it to free() if
+    it didn't come from a pool.  Does nothing if \c data is NULL.
+    */
+    static void         release(void* data);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get the pool's name
+    const char*         getName() const;
+
+    //! Get the size of each block
+    UInt32              getBlockSize() const;
+
+    //! Get the number of blocks in the pool
+    UInt32              getCapacity() const;
+
+    //! Get the number of blocks in use
+    UInt32              getInUse() const;
+
+    //! Get the most blocks that have been in use at once
+    UInt32              getHighWater() const;
+
+    //! Get the number of allocations that fell back to malloc()
+    UInt32              getOverflows() const;
+
+    //! Log the usage of every pool
+    static void         logUsage();
+
+    //@}
+
+private:
+    EventDataPool(const EventDataPool&);
+    EventDataPool&      operator=(const EventDataPool&);
+
+    bool                owns(const void* data) const;
+    void                releaseBlock(void* data);
+
+private:
+    const char*         m_name;
+    UInt32              m_blockSize;
+    UInt32              m_capacity;
+    UInt8*              m_blocks;
+    std::atomic<UInt32>* m_nextFree;
+    UInt32              m_registryIndex;
+    IndexFreeList       m_free;
+
+    std::atomic<UInt32> m_inUse;
+    std::atomic<UInt32> m_highWater;
+    std::atomic<UInt32> m_overflows;
+};
+
+//! Pool of one type of event data
+/*!
+An EventDataPool sized for \c T, for the \c alloc() helpers of event
+data types.  \c T is plain data so the blocks are never constructed or
+destroyed.
+*/
+template <class T>
+class TypedEventDataPool : public EventDataPool {
+public:
+    static_assert(std::is_trivially_destructible<T>::value,
+                            "event data must be plain data");
+
+    /*!
+    Each block holds a \c T followed by \c extra bytes, for types that
+    end in a variable length array.
+    */
+    TypedEventDataPool(const char* name, UInt32 extra = 0,
+                            UInt32 capacity = kDefaultCapacity) :
+        EventDataPool(name, sizeof(T) + extra, capacity) { }
+
+    //! Allocate a \c T followed by \c extra bytes
+    T*                  alloc(UInt32 extra = 0)
+    {
+        return static_cast<T*>(EventDataPool::alloc(
+                            static_cast<UInt32>(sizeof(T)) + extra));
+    }
+};
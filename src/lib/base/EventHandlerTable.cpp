@@ -0,0 +1,199 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/EventHandlerTable.h"
+
+#include "arch/Arch.h"
+
+//
+// EventHandlerTable
+//
+
+EventHandlerTable::EventHandlerTable() :
+    m_table(newTable(0)),
+    m_readers(0)
+{
+    m_mutex = ARCH->newMutex();
+}
+
+EventHandlerTable::~EventHandlerTable()
+{
+    for (auto table : m_retired) {
+        deleteTable(table);
+    }
+    deleteTable(m_table.load());
+    ARCH->closeMutex(m_mutex);
+}
+
+IEventJob*
+EventHandlerTable::adopt(Event::Type type, void* target, IEventJob* job)
+{
+    if (job == nullptr) {
+        return remove(type, target);
+    }
+
+    ArchMutexLock lock(m_mutex);
+    const Table* table  = m_table.load(std::memory_order_relaxed);
+    const Entry* entry  = find(table, type, target);
+    IEventJob* oldJob   = (entry != nullptr) ? entry->m_job : nullptr;
+
+    Table* newTable = copyWithout(table, type, target, false, 1);
+    insert(newTable, Entry{ target, type, job });
+    publish(newTable);
+    return oldJob;
+}
+
+IEventJob*
+EventHandlerTable::remove(Event::Type type, void* target)
+{
+    ArchMutexLock lock(m_mutex);
+    const Table* table = m_table.load(std::memory_order_relaxed);
+    const Entry* entry = find(table, type, target);
+    if (entry == nullptr) {
+        return nullptr;
+    }
+
+    IEventJob* oldJob = entry->m_job;
+    publish(copyWithout(table, type, target, false, 0));
+    return oldJob;
+}
+
+void
+EventHandlerTable::removeAll(void* target, std::vector<IEventJob*>& removed)
+{
+    ArchMutexLock lock(m_mutex);
+    const Table* table = m_table.load(std::memory_order_relaxed);
+    size_t n = removed.size();
+    for (UInt32 i = 0; i <= table->m_mask; ++i) {
+        const Entry& entry = table->m_entries[i];
+        if (entry.m_job != nullptr && entry.m_target == target) {
+            removed.push_back(entry.m_job);
+        }
+    }
+    if (removed.size() != n) {
+        publish(copyWithout(table, Event::kUnknown, target, true, 0));
+    }
+}
+
+IEventJob*
+EventHandlerTable::get(Event::Type type, void* target) const
+{
+    m_readers.fetch_add(1, std::memory_order_seq_cst);
+    const Entry* entry = find(m_table.load(std::memory_order_seq_cst),
+                            type, target);
+    IEventJob* job = (entry != nullptr) ? entry->m_job : nullptr;
+    m_readers.fetch_sub(1, std::memory_order_release);
+    return job;
+}
+
+UInt32
+EventHandlerTable::hash(Event::Type type, void* target)
+{
+    // fold in the high half of 64 bit pointers and drop the low bits,
+    // which are the same for every aligned object
+    size_t bits = reinterpret_cast<size_t>(target);
+    bits ^= (bits >> 16) >> 16;
+    UInt32 h = static_cast<UInt32>(bits >> 3) ^ (type * 0x85ebca6bu);
+    h *= 0x9e3779b1u;
+    return h ^ (h >> 16);
+}
+
+EventHandlerTable::Table*
+EventHandlerTable::newTable(UInt32 size)
+{
+    // keep the table at most half full so probes stay short
+    UInt32 capacity = 16;
+    while (capacity < 2 * size) {
+        capacity <<= 1;
+    }
+
+    auto* table      = new Table;
+    table->m_mask    = capacity - 1;
+    table->m_size    = 0;
+    table->m_entries = new Entry[capacity];
+    for (UInt32 i = 0; i < capacity; ++i) {
+        table->m_entries[i] = Entry{ nullptr, Event::kUnknown, nullptr };
+    }
+    return table;
+}
+
+void
+EventHandlerTable::deleteTable(Table* table)
+{
+    delete[] table->m_entries;
+    delete table;
+}
+
+void
+EventHandlerTable::insert(Table* table, const Entry& entry)
+{
+    UInt32 i = hash(entry.m_type, entry.m_target) & table->m_mask;
+    while (table->m_entries[i].m_job != nullptr) {
+        i = (i + 1) & table->m_mask;
+    }
+    table->m_entries[i] = entry;
+    ++table->m_size;
+}
+
+const EventHandlerTable::Entry*
+EventHandlerTable::find(const Table* table, Event::Type type, void* target)
+{
+    UInt32 i = hash(type, target) & table->m_mask;
+    for (;;) {
+        const Entry& entry = table->m_entries[i];
+        if (entry.m_job == nullptr) {
+            return nullptr;
+        }
+        if (entry.m_target == target && entry.m_type == type) {
+            return &entry;
+        }
+        i = (i + 1) & table->m_mask;
+    }
+}
+
+EventHandlerTable::Table*
+EventHandlerTable::copyWithout(const Table* table, Event::Type type,
+                void* target, bool anyType, UInt32 extra) const
+{
+    // rebuilding rather than deleting in place means there are never
+    // tombstones to probe past
+    Table* newTable = EventHandlerTable::newTable(table->m_size + extra);
+    for (UInt32 i = 0; i <= table->m_mask; ++i) {
+        const Entry& entry = table->m_entries[i];
+        if (entry.m_job == nullptr ||
+                (entry.m_target == target &&
+                    (anyType || entry.m_type == type))) {
+            continue;
+        }
+        insert(newTable, entry);
+    }
+    return newTable;
+}
+
+void
+EventHandlerTable::publish(Table* table)
+{
+    m_retired.push_back(m_table.exchange(table, std::memory_order_seq_cst));
+
+    // a lookup that starts after this sees the new table, so if none
+    // are running now nothing can be using the retired ones
+    if (m_readers.load(std::memory_order_seq_cst) == 0) {
+        for (auto retired : m_retired) {
+            deleteTable(retired);
+        }
+        m_retired.clear();
+    }
+}
@@ -0,0 +1,114 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "arch/IArchMultithread.h"
+#include "base/Event.h"
+#include "common/stdvector.h"
+
+#include <atomic>
+
+class IEventJob;
+
+//! Event handler table
+/*!
+Maps (target, event type) pairs to the jobs that handle them.  Lookups
+happen for every dispatched event so they don't lock:  the table is an
+open addressing hash that's never changed once published.  Changes
+build a new table under a lock and swap it in, and old tables are freed
+once no lookup can still be using them.
+
+The table never deletes jobs;  anything it stops referring to is
+returned to the caller.
+*/
+class EventHandlerTable {
+public:
+    EventHandlerTable();
+    ~EventHandlerTable();
+
+    //! @name manipulators
+    //@{
+
+    //! Set the handler for \c type on \c target
+    /*!
+    Returns the handler it replaces, if any.
+    */
+    IEventJob*          adopt(Event::Type type, void* target, IEventJob*);
+
+    //! Remove the handler for \c type on \c target
+    /*!
+    Returns the handler removed, if any.
+    */
+    IEventJob*          remove(Event::Type type, void* target);
+
+    //! Remove every handler on \c target
+    /*!
+    Appends the handlers removed to \c removed.
+    */
+    void                removeAll(void* target,
+                            std::vector<IEventJob*>& removed);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get the handler for \c type on \c target
+    /*!
+    Returns NULL if there's no such handler.  Safe to call from any
+    thread at any time.
+    */
+    IEventJob*          get(Event::Type type, void* target) const;
+
+    //@}
+
+private:
+    struct Entry {
+        void*           m_target;
+        Event::Type     m_type;
+        IEventJob*      m_job;
+    };
+
+    struct Table {
+        UInt32          m_mask;
+        UInt32          m_size;
+        Entry*          m_entries;
+    };
+
+    EventHandlerTable(const EventHandlerTable&);
+    EventHandlerTable&  operator=(const EventHandlerTable&);
+
+    static UInt32       hash(Event::Type type, void* target);
+    static Table*       newTable(UInt32 size);
+    static void         deleteTable(Table*);
+    static void         insert(Table*, const Entry&);
+    static const Entry* find(const Table*, Event::Type type, void* target);
+
+    Table*              copyWithout(const Table*, Event::Type type,
+                            void* target, bool anyType, UInt32 extra) const;
+    void                publish(Table*);
+
+private:
+    typedef std::vector<Table*> TableList;
+
+    ArchMutex           m_mutex;
+    std::atomic<Table*> m_table;
+
+    // lookups in progress.  tables replaced while any are running are
+    // kept until a later change finds none running.
+    mutable std::atomic<UInt32> m_readers;
+    TableList           m_retired;
+};
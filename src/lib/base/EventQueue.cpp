@@ -19,6 +19,7 @@
 #include "base/EventQueue.h"
 
 #include "arch/Arch.h"
+#include "base/EventDataPool.h"
 #include "base/EventTypes.h"
 #include "base/IEventJob.h"
 #include "base/Log.h"
@@ -45,6 +46,18 @@ EVENT_TYPE_ACCESSOR(IScreen)
 EVENT_TYPE_ACCESSOR(Clipboard)
 EVENT_TYPE_ACCESSOR(File)
 
+// event type providers are made up front so getting one doesn't need a
+// lock or a check
+template <class T>
+static
+T*
+newEventTypes(IEventQueue* events)
+{
+    auto* types = new T;
+    types->setEvents(events);
+    return types;
+}
+
 // interrupt handler.  this just adds a quit event to the queue.
 static
 void
@@ -62,25 +75,30 @@ interrupt(Arch::ESignal /*unused*/, void* data)
 EventQueue::EventQueue() :
     m_systemTarget(0),
     m_nextType(Event::kLast),
-    m_typesForClient(nullptr),
-    m_typesForIStream(nullptr),
-    m_typesForIDataSocket(nullptr),
-    m_typesForIListenSocket(nullptr),
-    m_typesForISocket(nullptr),
-    m_typesForOSXScreen(nullptr),
-    m_typesForClientListener(nullptr),
-    m_typesForClientProxy(nullptr),
-    m_typesForClientProxyUnknown(nullptr),
-    m_typesForServer(nullptr),
-    m_typesForServerApp(nullptr),
-    m_typesForIKeyState(nullptr),
-    m_typesForIPrimaryScreen(nullptr),
-    m_typesForIScreen(nullptr),
-    m_typesForClipboard(nullptr),
-    m_typesForFile(nullptr),
+    m_buffer(nullptr),
+    m_posting(0),
+    m_typesForClient(newEventTypes<ClientEvents>(this)),
+    m_typesForIStream(newEventTypes<IStreamEvents>(this)),
+    m_typesForIDataSocket(newEventTypes<IDataSocketEvents>(this)),
+    m_typesForIListenSocket(newEventTypes<IListenSocketEvents>(this)),
+    m_typesForISocket(newEventTypes<ISocketEvents>(this)),
+    m_typesForOSXScreen(newEventTypes<OSXScreenEvents>(this)),
+    m_typesForClientListener(newEventTypes<ClientListenerEvents>(this)),
+    m_typesForClientProxy(newEventTypes<ClientProxyEvents>(this)),
+    m_typesForClientProxyUnknown(newEventTypes<ClientProxyUnknownEvents>(this)),
+    m_typesForServer(newEventTypes<ServerEvents>(this)),
+    m_typesForServerApp(newEventTypes<ServerAppEvents>(this)),
+    m_typesForIKeyState(newEventTypes<IKeyStateEvents>(this)),
+    m_typesForIPrimaryScreen(newEventTypes<IPrimaryScreenEvents>(this)),
+    m_typesForIScreen(newEventTypes<IScreenEvents>(this)),
+    m_typesForClipboard(newEventTypes<ClipboardEvents>(this)),
+    m_typesForFile(newEventTypes<FileEvents>(this)),
     m_readyMutex(new Mutex),
     m_readyCondVar(new CondVar<bool>(m_readyMutex, false))
 {
+    for (UInt32 i = 0; i < kMaxTypes; ++i) {
+        m_typeNames[i].store(nullptr, std::memory_order_relaxed);
+    }
     m_mutex = ARCH->newMutex();
     ARCH->setSignalHandler(Arch::kINTERRUPT, &interrupt, this);
     ARCH->setSignalHandler(Arch::kTERMINATE, &interrupt, this);
@@ -89,8 +107,29 @@ EventQueue::EventQueue() :
 
 EventQueue::~EventQueue()
 {
-    delete m_buffer;
+    EventDataPool::logUsage();
+
+    for (auto& timer : m_timers) {
+        delete timer.second;
+    }
+    delete m_buffer.load();
     delete m_readyCondVar;
+    delete m_typesForClient;
+    delete m_typesForIStream;
+    delete m_typesForIDataSocket;
+    delete m_typesForIListenSocket;
+    delete m_typesForISocket;
+    delete m_typesForOSXScreen;
+    delete m_typesForClientListener;
+    delete m_typesForClientProxy;
+    delete m_typesForClientProxyUnknown;
+    delete m_typesForServer;
+    delete m_typesForServerApp;
+    delete m_typesForIKeyState;
+    delete m_typesForIPrimaryScreen;
+    delete m_typesForIScreen;
+    delete m_typesForClipboard;
+    delete m_typesForFile;
     delete m_readyMutex;
     
     ARCH->setSignalHandler(Arch::kINTERRUPT, nullptr, nullptr);
@@ -101,7 +140,7 @@ EventQueue::~EventQueue()
 void
 EventQueue::loop()
 {
-    m_buffer->init();
+    m_buffer.load()->init();
     {
         Lock lock(m_readyMutex);
         *m_readyCondVar = true;
@@ -125,16 +164,20 @@ EventQueue::loop()
 }
 
 Event::Type
-EventQueue::registerTypeOnce(Event::Type& type, const char* name)
+EventQueue::registerTypeOnce(std::atomic<Event::Type>& type, const char* name)
 {
     ArchMutexLock lock(m_mutex);
-    if (type == Event::kUnknown) {
-        m_typeMap.insert(std::make_pair(m_nextType, name));
+    if (type.load(std::memory_order_relaxed) == Event::kUnknown) {
+        UInt32 index = m_nextType - Event::kLast;
+        assert(index < kMaxTypes && "too many event types");
+        if (index < kMaxTypes) {
+            m_typeNames[index].store(name, std::memory_order_release);
+        }
         m_nameMap.insert(std::make_pair(name, m_nextType));
         LOG((CLOG_DEBUG1 "registered event type %s as %d", name, m_nextType));
-        type = m_nextType++;
+        type.store(m_nextType++, std::memory_order_release);
     }
-    return type;
+    return type.load(std::memory_order_relaxed);
 }
 
 const char*
@@ -154,13 +197,11 @@ EventQueue::getTypeName(Event::Type type)
         return "timer";
 
     default:
-        TypeMap::const_iterator i = m_typeMap.find(type);
-        if (i == m_typeMap.end()) {
-            return "<unknown>";
+        const char* name = nullptr;
+        if (type >= Event::kLast && type - Event::kLast < kMaxTypes) {
+            name = m_typeNames[type - Event::kLast].load(std::memory_order_acquire);
         }
-        
-            return i->second;
-        
+        return (name != nullptr) ? name : "<unknown>";
     }
 }
 
@@ -171,25 +212,34 @@ EventQueue::adoptBuffer(IEventQueueBuffer* buffer)
 
     LOG((CLOG_DEBUG "adopting new buffer"));
 
-    if (!m_events.empty()) {
-        // this can come as a nasty surprise to programmers expecting
-        // their events to be raised, only to have them deleted.
-        LOG((CLOG_DEBUG "discarding %d event(s)", m_events.size()));
+    // use new buffer
+    if (buffer == nullptr) {
+        buffer = new SimpleEventQueueBuffer;
     }
+    IEventQueueBuffer* oldBuffer = m_buffer.exchange(buffer);
 
-    // discard old buffer and old events
-    delete m_buffer;
-    for (auto & m_event : m_events) {
-        Event::deleteData(m_event.second);
+    // wait for threads that got the old buffer to finish with it
+    while (m_posting.load() != 0) {
+        ARCH->sleep(0.0);
     }
-    m_events.clear();
-    m_oldEventIDs.clear();
 
-    // use new buffer
-    m_buffer = buffer;
-    if (m_buffer == nullptr) {
-        m_buffer = new SimpleEventQueueBuffer;
+    // discard old buffer and the events still in it.  events posted
+    // since the swap are in the new buffer so leave the rest alone.
+    UInt32 discarded = 0;
+    Event event;
+    UInt32 dataID;
+    while (!oldBuffer->isEmpty()) {
+        if (oldBuffer->getEvent(event, dataID) == IEventQueueBuffer::kUser) {
+            Event::deleteData(m_slab.remove(dataID));
+            ++discarded;
+        }
+    }
+    if (discarded != 0) {
+        // this can come as a nasty surprise to programmers expecting
+        // their events to be raised, only to have them deleted.
+        LOG((CLOG_DEBUG "discarding %d event(s)", discarded));
     }
+    delete oldBuffer;
 }
 
 bool
@@ -198,7 +248,8 @@ EventQueue::getEvent(Event& event, double timeout)
     Stopwatch timer(true);
 retry:
     // if no events are waiting then handle timers and then wait
-    while (m_buffer->isEmpty()) {
+    IEventQueueBuffer* buffer = m_buffer.load();
+    while (buffer->isEmpty()) {
         // handle timers first
         if (hasTimerExpired(event)) {
             return true;
@@ -219,12 +270,12 @@ retry:
         }
 
         // wait for an event
-        m_buffer->waitForEvent(timeLeft);
+        buffer->waitForEvent(timeLeft);
     }
 
     // get the event
     UInt32 dataID;
-    IEventQueueBuffer::Type type = m_buffer->getEvent(event, dataID);
+    IEventQueueBuffer::Type type = buffer->getEvent(event, dataID);
     switch (type) {
     case IEventQueueBuffer::kNone:
         if (timeout < 0.0 || timeout <= timer.getTime()) {
@@ -239,11 +290,8 @@ retry:
         return true;
 
     case IEventQueueBuffer::kUser:
-        {
-            ArchMutexLock lock(m_mutex);
-            event = removeEvent(dataID);
-            return true;
-        }
+        event = m_slab.remove(dataID);
+        return true;
 
     default:
         assert(0 && "invalid event type");
@@ -295,15 +343,21 @@ EventQueue::addEvent(const Event& event)
 void
 EventQueue::addEventToBuffer(const Event& event)
 {
-    ArchMutexLock lock(m_mutex);
-    
     // store the event's data locally
-    UInt32 eventID = saveEvent(event);
-    
+    UInt32 eventID = m_slab.add(event);
+    if (eventID == EventSlab::kNoID) {
+        LOG((CLOG_WARN "event queue is full, dropping event of type %d", event.getType()));
+        Event::deleteData(event);
+        return;
+    }
+
     // add it
-    if (!m_buffer->addEvent(eventID)) {
+    m_posting.fetch_add(1);
+    bool added = m_buffer.load()->addEvent(eventID);
+    m_posting.fetch_sub(1);
+    if (!added) {
         // failed to send event
-        removeEvent(eventID);
+        m_slab.remove(eventID);
         Event::deleteData(event);
     }
 }
@@ -313,17 +367,14 @@ EventQueue::newTimer(double duration, void* target)
 {
     assert(duration > 0.0);
 
-    EventQueueTimer* timer = m_buffer->newTimer(duration, false);
+    EventQueueTimer* timer = m_buffer.load()->newTimer(duration, false);
     if (target == nullptr) {
         target = timer;
     }
     ArchMutexLock lock(m_mutex);
-    m_timers.insert(timer);
-    // initial duration is requested duration plus whatever's on
-    // the clock currently because the latter will be subtracted
-    // the next time we check for timers.
-    m_timerQueue.push(Timer(timer, duration,
-                            duration + m_time.getTime(), target, false));
+    auto* entry = new Timer(timer, duration, target, false);
+    m_timers[timer] = entry;
+    m_timerWheel.arm(entry, TimerWheel::getTime(), duration);
     return timer;
 }
 
@@ -332,17 +383,14 @@ EventQueue::newOneShotTimer(double duration, void* target)
 {
     assert(duration > 0.0);
 
-    EventQueueTimer* timer = m_buffer->newTimer(duration, true);
+    EventQueueTimer* timer = m_buffer.load()->newTimer(duration, true);
     if (target == nullptr) {
         target = timer;
     }
     ArchMutexLock lock(m_mutex);
-    m_timers.insert(timer);
-    // initial duration is requested duration plus whatever's on
-    // the clock currently because the latter will be subtracted
-    // the next time we check for timers.
-    m_timerQueue.push(Timer(timer, duration,
-                            duration + m_time.getTime(), target, true));
+    auto* entry = new Timer(timer, duration, target, true);
+    m_timers[timer] = entry;
+    m_timerWheel.arm(entry, TimerWheel::getTime(), duration);
     return timer;
 }
 
@@ -350,64 +398,45 @@ void
 EventQueue::deleteTimer(EventQueueTimer* timer)
 {
     ArchMutexLock lock(m_mutex);
-    for (auto index = m_timerQueue.begin();
-                            index != m_timerQueue.end(); ++index) {
-        if (index->getTimer() == timer) {
-            m_timerQueue.erase(index);
-            break;
-        }
-    }
     auto index = m_timers.find(timer);
     if (index != m_timers.end()) {
+        m_timerWheel.cancel(index->second);
+        delete index->second;
         m_timers.erase(index);
     }
-    m_buffer->deleteTimer(timer);
+    m_buffer.load()->deleteTimer(timer);
 }
 
 void
-EventQueue::adoptHandler(Event::Type type, void* target, IEventJob* handler)
+EventQueue::rearmTimer(EventQueueTimer* timer, double duration)
 {
+    assert(duration > 0.0);
+
     ArchMutexLock lock(m_mutex);
-    IEventJob*& job = m_handlers[target][type];
-    delete job;
-    job = handler;
+    auto index = m_timers.find(timer);
+    if (index != m_timers.end()) {
+        index->second->setTimeout(duration);
+        m_timerWheel.arm(index->second, TimerWheel::getTime(), duration);
+    }
+}
+
+void
+EventQueue::adoptHandler(Event::Type type, void* target, IEventJob* handler)
+{
+    delete m_handlers.adopt(type, target, handler);
 }
 
 void
 EventQueue::removeHandler(Event::Type type, void* target)
 {
-    IEventJob* handler = nullptr;
-    {
-        ArchMutexLock lock(m_mutex);
-        auto index = m_handlers.find(target);
-        if (index != m_handlers.end()) {
-            TypeHandlerTable& typeHandlers = index->second;
-            auto index2 = typeHandlers.find(type);
-            if (index2 != typeHandlers.end()) {
-                handler = index2->second;
-                typeHandlers.erase(index2);
-            }
-        }
-    }
-    delete handler;
+    delete m_handlers.remove(type, target);
 }
 
 void
 EventQueue::removeHandlers(void* target)
 {
     std::vector<IEventJob*> handlers;
-    {
-        ArchMutexLock lock(m_mutex);
-        auto index = m_handlers.find(target);
-        if (index != m_handlers.end()) {
-            // copy to handlers array and clear table for target
-            TypeHandlerTable& typeHandlers = index->second;
-            for (auto & typeHandler : typeHandlers) {
-                handlers.push_back(typeHandler.second);
-            }
-            typeHandlers.clear();
-        }
-    }
+    m_handlers.removeAll(target, handlers);
 
     // delete handlers
     for (auto & handler : handlers) {
@@ -418,99 +447,35 @@ EventQueue::removeHandlers(void* target)
 bool
 EventQueue::isEmpty() const
 {
-    return (m_buffer->isEmpty() && getNextTimerTimeout() != 0.0);
+    return (m_buffer.load()->isEmpty() && getNextTimerTimeout() != 0.0);
 }
 
 IEventJob*
 EventQueue::getHandler(Event::Type type, void* target) const
 {
-    ArchMutexLock lock(m_mutex);
-    auto index = m_handlers.find(target);
-    if (index != m_handlers.end()) {
-        const TypeHandlerTable& typeHandlers = index->second;
-        auto index2 = typeHandlers.find(type);
-        if (index2 != typeHandlers.end()) {
-            return index2->second;
-        }
-    }
-    return nullptr;
-}
-
-UInt32
-EventQueue::saveEvent(const Event& event)
-{
-    // choose id
-    UInt32 id;
-    if (!m_oldEventIDs.empty()) {
-        // reuse an id
-        id = m_oldEventIDs.back();
-        m_oldEventIDs.pop_back();
-    }
-    else {
-        // make a new id
-        id = static_cast<UInt32>(m_events.size());
-    }
-
-    // save data
-    m_events[id] = event;
-    return id;
-}
-
-Event
-EventQueue::removeEvent(UInt32 eventID)
-{
-    // look up id
-    auto index = m_events.find(eventID);
-    if (index == m_events.end()) {
-        return {};
-    }
-
-    // get data
-    Event event = index->second;
-    m_events.erase(index);
-
-    // save old id for reuse
-    m_oldEventIDs.push_back(eventID);
-
-    return event;
+    return m_handlers.get(type, target);
 }
 
 bool
 EventQueue::hasTimerExpired(Event& event)
 {
-    // return true if there's a timer in the timer priority queue that
-    // has expired.  if returning true then fill in event appropriately
-    // and reset and reinsert the timer.
-    if (m_timerQueue.empty()) {
-        return false;
-    }
-
-    // get time elapsed since last check
-    const double time = m_time.getTime();
-    m_time.reset();
-
-    // countdown elapsed time
-    for (auto & index : m_timerQueue) {
-        index -= time;
-    }
-
-    // done if no timers are expired
-    if (m_timerQueue.top() > 0.0) {
+    // return true if a timer has expired.  if returning true then fill
+    // in event appropriately and rearm the timer if it's recurring.
+    ArchMutexLock lock(m_mutex);
+    const double now = TimerWheel::getTime();
+    double late;
+    auto* timer = static_cast<Timer*>(m_timerWheel.expire(now, late));
+    if (timer == nullptr) {
         return false;
     }
 
-    // remove timer from queue
-    Timer timer = m_timerQueue.top();
-    m_timerQueue.pop();
-
-    // prepare event and reset the timer's clock
-    timer.fillEvent(m_timerEvent);
-    event = Event(Event::kTimer, timer.getTarget(), &m_timerEvent);
-    timer.reset();
+    // prepare event
+    timer->fillEvent(m_timerEvent, late);
+    event = Event(Event::kTimer, timer->getTarget(), &m_timerEvent);
 
-    // reinsert timer into queue if it's not a one-shot
-    if (!timer.isOneShot()) {
-        m_timerQueue.push(timer);
+    // start the next period if it's not a one-shot
+    if (!timer->isOneShot()) {
+        m_timerWheel.arm(timer, now, timer->getTimeout());
     }
 
     return true;
@@ -519,21 +484,16 @@ EventQueue::hasTimerExpired(Event& event)
 double
 EventQueue::getNextTimerTimeout() const
 {
-    // return -1 if no timers, 0 if the top timer has expired, otherwise
-    // the time until the top timer in the timer priority queue will
-    // expire.
-    if (m_timerQueue.empty()) {
-        return -1.0;
-    }
-    if (m_timerQueue.top() <= 0.0) {
-        return 0.0;
-    }
-    return m_timerQueue.top();
+    // return -1 if no timers, 0 if a timer has expired, otherwise the
+    // time until the timer wheel next needs looking at.
+    ArchMutexLock lock(m_mutex);
+    return m_timerWheel.getTimeout(TimerWheel::getTime());
 }
 
 Event::Type
 EventQueue::getRegisteredType(const String& name) const
 {
+    ArchMutexLock lock(m_mutex);
     auto found = m_nameMap.find(name);
     if (found != m_nameMap.end()) {
         return found->second;
@@ -567,12 +527,11 @@ EventQueue::waitForReady() const
 //
 
 EventQueue::Timer::Timer(EventQueueTimer* timer, double timeout,
-                double initialTime, void* target, bool oneShot) :
+                void* target, bool oneShot) :
     m_timer(timer),
     m_timeout(timeout),
     m_target(target),
-    m_oneShot(oneShot),
-    m_time(initialTime)
+    m_oneShot(oneShot)
 {
     assert(m_timeout > 0.0);
 }
@@ -583,21 +542,10 @@ EventQueue::Timer::~Timer()
 }
 
 void
-EventQueue::Timer::reset()
-{
-    m_time = m_timeout;
-}
-
-EventQueue::Timer&
-EventQueue::Timer::operator-=(double dt)
-{
-    m_time -= dt;
-    return *this;
-}
-
-EventQueue::Timer::operator double() const
+EventQueue::Timer::setTimeout(double timeout)
 {
-    return m_time;
+    assert(timeout > 0.0);
+    m_timeout = timeout;
 }
 
 bool
@@ -606,6 +554,12 @@ EventQueue::Timer::isOneShot() const
     return m_oneShot;
 }
 
+double
+EventQueue::Timer::getTimeout() const
+{
+    return m_timeout;
+}
+
 EventQueueTimer*
 EventQueue::Timer::getTimer() const
 {
@@ -619,17 +573,9 @@ EventQueue::Timer::getTarget() const
 }
 
 void
-EventQueue::Timer::fillEvent(TimerEvent& event) const
+EventQueue::Timer::fillEvent(TimerEvent& event, double late) const
 {
+    // count the periods that have gone by, this one included
     event.m_timer = m_timer;
-    event.m_count = 0;
-    if (m_time <= 0.0) {
-        event.m_count = static_cast<UInt32>((m_timeout - m_time) / m_timeout);
-    }
-}
-
-bool
-EventQueue::Timer::operator<(const Timer& t) const
-{
-    return m_time < t.m_time;
+    event.m_count = 1 + static_cast<UInt32>(late / m_timeout);
 }
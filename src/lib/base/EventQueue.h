@@ -22,12 +22,15 @@
 #include "arch/IArchMultithread.h"
 #include "base/IEventQueue.h"
 #include "base/Event.h"
-#include "base/PriorityQueue.h"
+#include "base/EventHandlerTable.h"
+#include "base/EventSlab.h"
 #include "base/Stopwatch.h"
+#include "base/TimerWheel.h"
 #include "common/stdmap.h"
-#include "common/stdset.h"
 
+#include <atomic>
 #include <queue>
+#include <unordered_map>
 
 class Mutex;
 
@@ -52,12 +55,14 @@ public:
     virtual EventQueueTimer*
                         newOneShotTimer(double duration, void* target);
     virtual void        deleteTimer(EventQueueTimer*);
+    virtual void        rearmTimer(EventQueueTimer*, double duration);
     virtual void        adoptHandler(Event::Type type,
                             void* target, IEventJob* handler);
     virtual void        removeHandler(Event::Type type, void* target);
     virtual void        removeHandlers(void* target);
     virtual Event::Type
-                        registerTypeOnce(Event::Type& type, const char* name);
+                        registerTypeOnce(std::atomic<Event::Type>& type,
+                            const char* name);
     virtual bool        isEmpty() const;
     virtual IEventJob*    getHandler(Event::Type type, void* target) const;
     virtual const char*    getTypeName(Event::Type type);
@@ -67,73 +72,62 @@ public:
     virtual void        waitForReady() const;
 
 private:
-    UInt32                saveEvent(const Event& event);
-    Event                removeEvent(UInt32 eventID);
     bool                hasTimerExpired(Event& event);
     double                getNextTimerTimeout() const;
     void                addEventToBuffer(const Event& event);
     
 private:
-    class Timer {
+    class Timer : public TimerWheel::Timer {
     public:
-        Timer(EventQueueTimer*, double timeout, double initialTime,
-                            void* target, bool oneShot);
+        Timer(EventQueueTimer*, double timeout, void* target, bool oneShot);
         ~Timer();
 
-        void            reset();
-
-        Timer&            operator-=(double);
-
-                        operator double() const;
+        void            setTimeout(double timeout);
 
         bool            isOneShot() const;
+        double            getTimeout() const;
         EventQueueTimer*
                         getTimer() const;
         void*            getTarget() const;
-        void            fillEvent(TimerEvent&) const;
-
-        bool            operator<(const Timer&) const;
+        void            fillEvent(TimerEvent&, double late) const;
 
     private:
         EventQueueTimer*    m_timer;
         double                m_timeout;
         void*                m_target;
         bool                m_oneShot;
-        double                m_time;
     };
 
-    typedef std::set<EventQueueTimer*> Timers;
-    typedef PriorityQueue<Timer> TimerQueue;
-    typedef std::map<UInt32, Event> EventTable;
-    typedef std::vector<UInt32> EventIDList;
-    typedef std::map<Event::Type, const char*> TypeMap;
+    typedef std::unordered_map<EventQueueTimer*, Timer*> Timers;
     typedef std::map<String, Event::Type> NameMap;
-    typedef std::map<Event::Type, IEventJob*> TypeHandlerTable;
-    typedef std::map<void*, TypeHandlerTable> HandlerTable;
 
     int                    m_systemTarget;
     ArchMutex            m_mutex;
 
     // registered events
+    // names are looked up by type without locking so they're kept in a
+    // fixed array indexed from Event::kLast
+    static const UInt32 kMaxTypes = 256;
+
     Event::Type        m_nextType;
-    TypeMap            m_typeMap;
+    std::atomic<const char*>    m_typeNames[kMaxTypes];
     NameMap            m_nameMap;
 
-    // buffer of events
-    IEventQueueBuffer*    m_buffer;
+    // buffer of events.  m_posting counts threads adding to it so
+    // adoptBuffer() knows when the old one is no longer in use.
+    std::atomic<IEventQueueBuffer*>    m_buffer;
+    std::atomic<UInt32>    m_posting;
 
     // saved events
-    EventTable            m_events;
-    EventIDList        m_oldEventIDs;
+    EventSlab            m_slab;
 
     // timers
-    Stopwatch            m_time;
     Timers                m_timers;
-    TimerQueue            m_timerQueue;
+    TimerWheel            m_timerWheel;
     TimerEvent            m_timerEvent{};
 
     // event handlers
-    HandlerTable        m_handlers;
+    EventHandlerTable    m_handlers;
 
 public:
     //
@@ -181,9 +175,5 @@ private:
 #define EVENT_TYPE_ACCESSOR(type_)                                            \
 type_##Events&                                                                \
 EventQueue::for##type_() {                                                \
-    if (m_typesFor##type_ == NULL) {                                        \
-        m_typesFor##type_ = new type_##Events();                            \
-        m_typesFor##type_->setEvents(dynamic_cast<IEventQueue*>(this));        \
-    }                                                                        \
     return *m_typesFor##type_;                                                \
 }
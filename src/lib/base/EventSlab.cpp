@@ -0,0 +1,135 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/EventSlab.h"
+
+#include "arch/Arch.h"
+
+//
+// EventSlab
+//
+
+const UInt32 EventSlab::kNoID;
+const UInt32 EventSlab::kMaxEvents;
+
+EventSlab::EventSlab() :
+    m_numChunks(0)
+{
+    for (UInt32 i = 0; i < kMaxChunks; ++i) {
+        m_chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+    m_growMutex = ARCH->newMutex();
+    grow();
+}
+
+EventSlab::~EventSlab()
+{
+    UInt32 n = m_numChunks.load(std::memory_order_acquire);
+    for (UInt32 i = 0; i < n; ++i) {
+        delete[] m_chunks[i].load(std::memory_order_relaxed);
+    }
+    ARCH->closeMutex(m_growMutex);
+}
+
+UInt32
+EventSlab::add(const Event& event)
+{
+    UInt32 id = popFree();
+    if (id == kNoID) {
+        return kNoID;
+    }
+
+    Slot& slot = getSlot(id);
+    slot.m_event = event;
+    slot.m_stored.store(true, std::memory_order_release);
+    return id;
+}
+
+Event
+EventSlab::remove(UInt32 id)
+{
+    if (id >= getCapacity()) {
+        return {};
+    }
+
+    // whoever clears the flag owns the slot until it's freed
+    Slot& slot = getSlot(id);
+    if (!slot.m_stored.exchange(false, std::memory_order_acq_rel)) {
+        return {};
+    }
+
+    Event event = slot.m_event;
+    pushFree(id, id);
+    return event;
+}
+
+UInt32
+EventSlab::getCapacity() const
+{
+    return m_numChunks.load(std::memory_order_acquire) * kChunkSize;
+}
+
+EventSlab::Slot&
+EventSlab::getSlot(UInt32 id) const
+{
+    Slot* chunk = m_chunks[id >> kChunkShift].load(std::memory_order_acquire);
+    return chunk[id & (kChunkSize - 1)];
+}
+
+UInt32
+EventSlab::popFree()
+{
+    for (;;) {
+        UInt32 id = m_free.pop(NextFree{this});
+        if (id != kNoID || !grow()) {
+            return id;
+        }
+    }
+}
+
+void
+EventSlab::pushFree(UInt32 first, UInt32 last)
+{
+    m_free.push(NextFree{this}, first, last);
+}
+
+bool
+EventSlab::grow()
+{
+    ArchMutexLock lock(m_growMutex);
+
+    // another thread may have grown the slab or freed a slot while
+    // we waited for the lock
+    if (!m_free.isEmpty()) {
+        return true;
+    }
+
+    UInt32 n = m_numChunks.load(std::memory_order_relaxed);
+    if (n == kMaxChunks) {
+        return false;
+    }
+
+    UInt32 base = n * kChunkSize;
+    Slot* chunk = new Slot[kChunkSize];
+    for (UInt32 i = 0; i < kChunkSize; ++i) {
+        chunk[i].m_stored.store(false, std::memory_order_relaxed);
+        chunk[i].m_nextFree.store(base + i + 1, std::memory_order_relaxed);
+    }
+    m_chunks[n].store(chunk, std::memory_order_release);
+    m_numChunks.store(n + 1, std::memory_order_release);
+    pushFree(base, base + kChunkSize - 1);
+    return true;
+}
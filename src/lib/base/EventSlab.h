@@ -0,0 +1,108 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "arch/IArchMultithread.h"
+#include "base/Event.h"
+#include "base/IndexFreeList.h"
+#include "common/basic_types.h"
+
+#include <atomic>
+
+//! Event storage for an event queue
+/*!
+Holds events between being posted and being dispatched, identified by
+a small integer that can be passed through an IEventQueueBuffer.  Events
+are copied into preallocated slots so posting doesn't allocate, and any
+thread can add or remove an event without taking a lock.
+
+Slots come in chunks.  The first is allocated up front and more are
+added only when every slot is in use, up to a fixed limit.
+*/
+class EventSlab {
+public:
+    //! Returned by add() when every slot is in use
+    static const UInt32 kNoID = IndexFreeList::kNone;
+
+    //! Most events the slab can hold;  every id is less than this
+    static const UInt32 kMaxEvents = 63 * 1024;
+
+    EventSlab();
+    ~EventSlab();
+
+    //! @name manipulators
+    //@{
+
+    //! Store an event
+    /*!
+    Copies \c event into a free slot and returns its id, or kNoID if
+    the slab is full.  Safe to call from any thread.
+    */
+    UInt32              add(const Event& event);
+
+    //! Take an event out
+    /*!
+    Returns the event with id \c id and frees its slot.  Returns an
+    event of type Event::kUnknown if there's no such event.
+    */
+    Event               remove(UInt32 id);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get the number of slots allocated so far
+    UInt32              getCapacity() const;
+
+    //@}
+
+private:
+    struct Slot {
+        Event               m_event;
+        std::atomic<bool>   m_stored;
+        std::atomic<UInt32> m_nextFree;
+    };
+
+    // the free list's view of each slot's m_nextFree
+    struct NextFree {
+        const EventSlab*    m_slab;
+
+        std::atomic<UInt32>&
+                            operator[](UInt32 id) const
+        {
+            return m_slab->getSlot(id).m_nextFree;
+        }
+    };
+
+    EventSlab(const EventSlab&);
+    EventSlab&          operator=(const EventSlab&);
+
+    Slot&               getSlot(UInt32 id) const;
+    UInt32              popFree();
+    void                pushFree(UInt32 first, UInt32 last);
+    bool                grow();
+
+private:
+    static const UInt32 kChunkShift = 10;
+    static const UInt32 kChunkSize  = 1 << kChunkShift;
+    static const UInt32 kMaxChunks  = kMaxEvents / kChunkSize;
+
+    std::atomic<Slot*>  m_chunks[kMaxChunks];
+    std::atomic<UInt32> m_numChunks;
+    ArchMutex           m_growMutex;
+    IndexFreeList       m_free;
+};
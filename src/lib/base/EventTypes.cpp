@@ -53,6 +53,7 @@ REGISTER_EVENT(Client, disconnected)
 
 REGISTER_EVENT(IStream, inputReady)
 REGISTER_EVENT(IStream, outputFlushed)
+REGISTER_EVENT(IStream, outputDrained)
 REGISTER_EVENT(IStream, outputError)
 REGISTER_EVENT(IStream, inputShutdown)
 REGISTER_EVENT(IStream, outputShutdown)
@@ -96,6 +97,7 @@ REGISTER_EVENT(ClientListener, connected)
 
 REGISTER_EVENT(ClientProxy, ready)
 REGISTER_EVENT(ClientProxy, disconnected)
+REGISTER_EVENT(ClientProxy, flushInput)
 
 //
 // ClientProxyUnknown
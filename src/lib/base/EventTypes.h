@@ -19,6 +19,8 @@
 
 #include "base/Event.h"
 
+#include <atomic>
+
 class IEventQueue;
 
 class EventTypes {
@@ -37,6 +39,10 @@ private:
 Event::Type                                                            \
 type_##Events::name_()                                                    \
 {                                                                        \
+    Event::Type type = m_##name_.load(std::memory_order_acquire);        \
+    if (type != Event::kUnknown) {                                        \
+        return type;                                                    \
+    }                                                                    \
     return getEvents()->registerTypeOnce(m_##name_, __FUNCTION__);            \
 }
 
@@ -75,9 +81,9 @@ public:
     //@}
 
 private:
-    Event::Type        m_connected;
-    Event::Type        m_connectionFailed;
-    Event::Type        m_disconnected;
+    std::atomic<Event::Type> m_connected;
+    std::atomic<Event::Type> m_connectionFailed;
+    std::atomic<Event::Type> m_disconnected;
 };
 
 class IStreamEvents : public EventTypes {
@@ -85,6 +91,7 @@ public:
     IStreamEvents() :
         m_inputReady(Event::kUnknown),
         m_outputFlushed(Event::kUnknown),
+        m_outputDrained(Event::kUnknown),
         m_outputError(Event::kUnknown),
         m_inputShutdown(Event::kUnknown),
         m_outputShutdown(Event::kUnknown) { }
@@ -109,6 +116,14 @@ public:
     */
     Event::Type        outputFlushed();
 
+    //! Get output drained event type
+    /*!
+    Returns the output drained event type.  A stream sends this event
+    when data it reported as pending from \c hasPendingOutput() has been
+    sent.  Unlike output flushed, bulk data may still be waiting.
+    */
+    Event::Type        outputDrained();
+
     //! Get output error event type
     /*!
     Returns the output error event type.  A stream sends this event
@@ -136,11 +151,12 @@ public:
     //@}
         
 private:
-    Event::Type        m_inputReady;
-    Event::Type        m_outputFlushed;
-    Event::Type        m_outputError;
-    Event::Type        m_inputShutdown;
-    Event::Type        m_outputShutdown;
+    std::atomic<Event::Type> m_inputReady;
+    std::atomic<Event::Type> m_outputFlushed;
+    std::atomic<Event::Type> m_outputDrained;
+    std::atomic<Event::Type> m_outputError;
+    std::atomic<Event::Type> m_inputShutdown;
+    std::atomic<Event::Type> m_outputShutdown;
 };
 
 class IDataSocketEvents : public EventTypes {
@@ -170,8 +186,8 @@ public:
     //@}
 
 private:
-    Event::Type        m_connected;
-    Event::Type        m_connectionFailed;
+    std::atomic<Event::Type> m_connected;
+    std::atomic<Event::Type> m_connectionFailed;
 };
 
 class IListenSocketEvents : public EventTypes {
@@ -192,7 +208,7 @@ public:
     //@}
 
 private:
-    Event::Type        m_connecting;
+    std::atomic<Event::Type> m_connecting;
 };
 
 class ISocketEvents : public EventTypes {
@@ -222,8 +238,8 @@ public:
     //@}
 
 private:
-    Event::Type        m_disconnected;
-    Event::Type        m_stopRetry;
+    std::atomic<Event::Type> m_disconnected;
+    std::atomic<Event::Type> m_stopRetry;
 };
 
 class OSXScreenEvents : public EventTypes {
@@ -239,7 +255,7 @@ public:
     //@}
 
 private:
-    Event::Type        m_confirmSleep;
+    std::atomic<Event::Type> m_confirmSleep;
 };
 
 class ClientListenerEvents : public EventTypes {
@@ -268,15 +284,16 @@ public:
     //@}
 
 private:
-    Event::Type        m_accepted;
-    Event::Type        m_connected;
+    std::atomic<Event::Type> m_accepted;
+    std::atomic<Event::Type> m_connected;
 };
 
 class ClientProxyEvents : public EventTypes {
 public:
     ClientProxyEvents() :
         m_ready(Event::kUnknown),
-        m_disconnected(Event::kUnknown) { }
+        m_disconnected(Event::kUnknown),
+        m_flushInput(Event::kUnknown) { }
 
     //! @name accessors
     //@{
@@ -296,11 +313,20 @@ public:
     */
     Event::Type        disconnected();
 
+    //! Get flush input event type
+    /*!
+    Returns the flush input event type.  A proxy that packs input sends
+    this to itself when it starts a frame and writes the frame when it
+    arrives, so the frame holds the input that was queued ahead of it.
+    */
+    Event::Type        flushInput();
+
     //@}
 
 private:
-    Event::Type        m_ready;
-    Event::Type        m_disconnected;
+    std::atomic<Event::Type> m_ready;
+    std::atomic<Event::Type> m_disconnected;
+    std::atomic<Event::Type> m_flushInput;
 };
 
 class ClientProxyUnknownEvents : public EventTypes {
@@ -329,8 +355,8 @@ public:
     //@}
         
 private:
-    Event::Type        m_success;
-    Event::Type        m_failure;
+    std::atomic<Event::Type> m_success;
+    std::atomic<Event::Type> m_failure;
 };
 
 class ServerEvents : public EventTypes {
@@ -412,14 +438,14 @@ public:
     //@}
         
 private:
-    Event::Type        m_error;
-    Event::Type        m_connected;
-    Event::Type        m_disconnected;
-    Event::Type        m_switchToScreen;
-    Event::Type        m_switchInDirection;
-    Event::Type        m_keyboardBroadcast;
-    Event::Type        m_lockCursorToScreen;
-    Event::Type        m_screenSwitched;
+    std::atomic<Event::Type> m_error;
+    std::atomic<Event::Type> m_connected;
+    std::atomic<Event::Type> m_disconnected;
+    std::atomic<Event::Type> m_switchToScreen;
+    std::atomic<Event::Type> m_switchInDirection;
+    std::atomic<Event::Type> m_keyboardBroadcast;
+    std::atomic<Event::Type> m_lockCursorToScreen;
+    std::atomic<Event::Type> m_screenSwitched;
 };
 
 class ServerAppEvents : public EventTypes {
@@ -439,9 +465,9 @@ public:
     //@}
         
 private:
-    Event::Type        m_reloadConfig;
-    Event::Type        m_forceReconnect;
-    Event::Type        m_resetServer;
+    std::atomic<Event::Type> m_reloadConfig;
+    std::atomic<Event::Type> m_forceReconnect;
+    std::atomic<Event::Type> m_resetServer;
 };
 
 class IKeyStateEvents : public EventTypes {
@@ -466,9 +492,9 @@ public:
     //@}
         
 private:
-    Event::Type        m_keyDown;
-    Event::Type        m_keyUp;
-    Event::Type        m_keyRepeat;
+    std::atomic<Event::Type> m_keyDown;
+    std::atomic<Event::Type> m_keyUp;
+    std::atomic<Event::Type> m_keyRepeat;
 };
 
 class IPrimaryScreenEvents : public EventTypes {
@@ -532,17 +558,17 @@ public:
     //@}
 
 private:
-    Event::Type        m_buttonDown;
-    Event::Type        m_buttonUp;
-    Event::Type        m_motionOnPrimary;
-    Event::Type        m_motionOnSecondary;
-    Event::Type        m_wheel;
-    Event::Type        m_screensaverActivated;
-    Event::Type        m_screensaverDeactivated;
-    Event::Type        m_hotKeyDown;
-    Event::Type        m_hotKeyUp;
-    Event::Type        m_fakeInputBegin;
-    Event::Type        m_fakeInputEnd;
+    std::atomic<Event::Type> m_buttonDown;
+    std::atomic<Event::Type> m_buttonUp;
+    std::atomic<Event::Type> m_motionOnPrimary;
+    std::atomic<Event::Type> m_motionOnSecondary;
+    std::atomic<Event::Type> m_wheel;
+    std::atomic<Event::Type> m_screensaverActivated;
+    std::atomic<Event::Type> m_screensaverDeactivated;
+    std::atomic<Event::Type> m_hotKeyDown;
+    std::atomic<Event::Type> m_hotKeyUp;
+    std::atomic<Event::Type> m_fakeInputBegin;
+    std::atomic<Event::Type> m_fakeInputEnd;
 };
 
 class IScreenEvents : public EventTypes {
@@ -587,10 +613,10 @@ public:
     //@}
         
 private:
-    Event::Type        m_error;
-    Event::Type        m_shapeChanged;
-    Event::Type        m_suspend;
-    Event::Type        m_resume;
+    std::atomic<Event::Type> m_error;
+    std::atomic<Event::Type> m_shapeChanged;
+    std::atomic<Event::Type> m_suspend;
+    std::atomic<Event::Type> m_resume;
 };
 
 class ClipboardEvents : public EventTypes {
@@ -629,9 +655,9 @@ public:
     //@}
 
 private:
-    Event::Type        m_clipboardGrabbed;
-    Event::Type        m_clipboardChanged;
-    Event::Type        m_clipboardSending;
+    std::atomic<Event::Type> m_clipboardGrabbed;
+    std::atomic<Event::Type> m_clipboardChanged;
+    std::atomic<Event::Type> m_clipboardSending;
 };
 
 class FileEvents : public EventTypes {
@@ -656,7 +682,7 @@ public:
     //@}
 
 private:
-    Event::Type        m_fileChunkSending;
-    Event::Type        m_fileRecieveCompleted;
-    Event::Type        m_keepAlive;
+    std::atomic<Event::Type> m_fileChunkSending;
+    std::atomic<Event::Type> m_fileRecieveCompleted;
+    std::atomic<Event::Type> m_keepAlive;
 };
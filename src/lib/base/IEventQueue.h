@@ -22,6 +22,8 @@
 #include "base/Event.h"
 #include "base/String.h"
 
+#include <atomic>
+
 class IEventJob;
 class IEventQueueBuffer;
 
@@ -140,6 +142,15 @@ public:
     */
     virtual void        deleteTimer(EventQueueTimer*) = 0;
 
+    //! Restart a timer
+    /*!
+    Sets a previously created timer to next expire \p duration seconds
+    from now, which also becomes the period of a recurring timer.  A
+    one-shot timer that has already expired is armed again.  This is
+    much cheaper than deleting the timer and creating a new one.
+    */
+    virtual void        rearmTimer(EventQueueTimer*, double duration) = 0;
+
     //! Register an event handler for an event type
     /*!
     Registers an event handler for \p type and \p target.  The \p handler
@@ -168,10 +179,11 @@ public:
     /*!
     If \p type contains \c kUnknown then it is set to a unique event
     type id otherwise it is left alone.  The final value of \p type
-    is returned.
+    is returned.  Callers should check \p type first;  once it's set
+    reading it is all it takes to get the type.
     */
     virtual Event::Type
-                        registerTypeOnce(Event::Type& type,
+                        registerTypeOnce(std::atomic<Event::Type>& type,
                             const char* name) = 0;
 
     //! Wait for event queue to become ready
@@ -0,0 +1,119 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/basic_types.h"
+
+#include <atomic>
+
+//! Lock-free list of free indices
+/*!
+A Treiber stack of indices below kNone, for pools that hand out slots
+by index.  Any thread can push or pop without taking a lock.  The list
+only holds the head;  each index's link lives with its slot, and the
+caller passes the links as anything that can be indexed like an array
+of \c std::atomic<UInt32>.
+*/
+class IndexFreeList {
+public:
+    //! Returned by pop() when the list is empty;  never a valid index
+    static const UInt32 kNone = 0xffff;
+
+    IndexFreeList() : m_head(kNone) { }
+
+    //! @name manipulators
+    //@{
+
+    //! Take the first index
+    /*!
+    Returns the first free index, or kNone if there isn't one.
+    \c links[index] must be the \c std::atomic<UInt32> holding the index
+    after \c index.
+    */
+    template <class Links>
+    UInt32              pop(Links links);
+
+    //! Put back a run of indices
+    /*!
+    Pushes the indices from \c first to \c last, which must already be
+    linked to each other in that order.  Pass the same index twice to
+    push one.  \c links is as for pop().
+    */
+    template <class Links>
+    void                push(Links links, UInt32 first, UInt32 last);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Test if the list is empty
+    bool                isEmpty() const;
+
+    //@}
+
+private:
+    IndexFreeList(const IndexFreeList&);
+    IndexFreeList&      operator=(const IndexFreeList&);
+
+private:
+    // indices are 16 bits so the head can carry a tag against ABA in
+    // the same word:  tag in the high 16 bits, first index in the low
+    // 16.  the tag changes on every update so a head that was popped
+    // and pushed back while another thread looked at it won't match.
+    std::atomic<UInt32> m_head;
+};
+
+template <class Links>
+inline
+UInt32
+IndexFreeList::pop(Links links)
+{
+    UInt32 head = m_head.load(std::memory_order_acquire);
+    while ((head & 0xffff) != kNone) {
+        UInt32 index   = (head & 0xffff);
+        UInt32 next    = links[index].load(std::memory_order_relaxed);
+        UInt32 newHead = ((head + 0x10000) & 0xffff0000) | next;
+        if (m_head.compare_exchange_weak(head, newHead,
+                            std::memory_order_acquire,
+                            std::memory_order_acquire)) {
+            return index;
+        }
+    }
+    return kNone;
+}
+
+template <class Links>
+inline
+void
+IndexFreeList::push(Links links, UInt32 first, UInt32 last)
+{
+    UInt32 head = m_head.load(std::memory_order_relaxed);
+    UInt32 newHead;
+    do {
+        links[last].store(head & 0xffff, std::memory_order_relaxed);
+        newHead = ((head + 0x10000) & 0xffff0000) | first;
+    } while (!m_head.compare_exchange_weak(head, newHead,
+                            std::memory_order_release,
+                            std::memory_order_relaxed));
+}
+
+inline
+bool
+IndexFreeList::isEmpty() const
+{
+    return ((m_head.load(std::memory_order_acquire) & 0xffff) == kNone);
+}
@@ -26,15 +26,24 @@ class EventQueueTimer { };
 // SimpleEventQueueBuffer
 //
 
-SimpleEventQueueBuffer::SimpleEventQueueBuffer()
+const UInt32 SimpleEventQueueBuffer::kMaxEvents;
+
+SimpleEventQueueBuffer::SimpleEventQueueBuffer() :
+    m_waiting(false),
+    m_cells(new std::atomic<UInt32>[kMaxEvents]),
+    m_head(0),
+    m_tail(0)
 {
     m_queueMutex     = ARCH->newMutex();
     m_queueReadyCond = ARCH->newCondVar();
-    m_queueReady     = false;
+    for (UInt32 i = 0; i < kMaxEvents; ++i) {
+        m_cells[i].store(0, std::memory_order_relaxed);
+    }
 }
 
 SimpleEventQueueBuffer::~SimpleEventQueueBuffer()
 {
+    delete[] m_cells;
     ARCH->closeCondVar(m_queueReadyCond);
     ARCH->closeMutex(m_queueMutex);
 }
@@ -42,40 +51,65 @@ SimpleEventQueueBuffer::~SimpleEventQueueBuffer()
 void
 SimpleEventQueueBuffer::waitForEvent(double timeout)
 {
+    if (!isEmpty()) {
+        return;
+    }
+
+    // tell producers to wake us, then check again in case an event
+    // arrived before they could see that
     ArchMutexLock lock(m_queueMutex);
     Stopwatch timer(true);
-    while (!m_queueReady) {
+    m_waiting.store(true, std::memory_order_seq_cst);
+    while (isEmpty()) {
         double timeLeft = timeout;
         if (timeLeft >= 0.0) {
             timeLeft -= timer.getTime();
             if (timeLeft < 0.0) {
-                return;
+                break;
             }
         }
         ARCH->waitCondVar(m_queueReadyCond, m_queueMutex, timeLeft);
     }
+    m_waiting.store(false, std::memory_order_relaxed);
 }
 
 IEventQueueBuffer::Type
 SimpleEventQueueBuffer::getEvent(Event& /*event*/, UInt32& dataID)
 {
-    ArchMutexLock lock(m_queueMutex);
-    if (!m_queueReady) {
+    UInt32 head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) {
         return kNone;
     }
-    dataID = m_queue.back();
-    m_queue.pop_back();
-    m_queueReady = !m_queue.empty();
+
+    // the cell has been claimed but its producer may not have filled
+    // it yet.  it's only a couple of instructions away so wait for it.
+    std::atomic<UInt32>& cell = m_cells[head & (kMaxEvents - 1)];
+    UInt32 value;
+    while ((value = cell.load(std::memory_order_acquire)) == 0) {
+        ARCH->sleep(0.0);
+    }
+    cell.store(0, std::memory_order_relaxed);
+    m_head.store(head + 1, std::memory_order_release);
+    dataID = value - 1;
     return kUser;
 }
 
 bool
 SimpleEventQueueBuffer::addEvent(UInt32 dataID)
 {
-    ArchMutexLock lock(m_queueMutex);
-    m_queue.push_front(dataID);
-    if (!m_queueReady) {
-        m_queueReady = true;
+    if (dataID >= kMaxEvents - 1 ||
+            m_tail.load(std::memory_order_relaxed) -
+            m_head.load(std::memory_order_acquire) >= kMaxEvents) {
+        return false;
+    }
+
+    UInt32 tail = m_tail.fetch_add(1, std::memory_order_seq_cst);
+    m_cells[tail & (kMaxEvents - 1)].store(dataID + 1,
+                            std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiting.load(std::memory_order_relaxed)) {
+        ArchMutexLock lock(m_queueMutex);
         ARCH->broadcastCondVar(m_queueReadyCond);
     }
     return true;
@@ -84,8 +118,8 @@ SimpleEventQueueBuffer::addEvent(UInt32 dataID)
 bool
 SimpleEventQueueBuffer::isEmpty() const
 {
-    ArchMutexLock lock(m_queueMutex);
-    return !m_queueReady;
+    return m_head.load(std::memory_order_seq_cst) ==
+           m_tail.load(std::memory_order_seq_cst);
 }
 
 EventQueueTimer*
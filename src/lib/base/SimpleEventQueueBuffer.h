@@ -20,14 +20,24 @@
 
 #include "base/IEventQueueBuffer.h"
 #include "arch/IArchMultithread.h"
-#include "common/stddeque.h"
+
+#include <atomic>
 
 //! In-memory event queue buffer
 /*!
 An event queue buffer provides a queue of events for an IEventQueue.
+
+Any number of threads may add events but only one may get them.  Adding
+an event is a single atomic increment and store;  the lock is only
+taken to wake the consumer when it's asleep, which it only is when the
+queue is empty.  Ids must be below kMaxEvents and no more than that many
+may be queued at once, which EventSlab guarantees.
 */
 class SimpleEventQueueBuffer : public IEventQueueBuffer {
 public:
+    //! Most ids that can be queued at once
+    static const UInt32 kMaxEvents = 0x10000;
+
     SimpleEventQueueBuffer();    
     ~SimpleEventQueueBuffer();
 
@@ -42,11 +52,21 @@ public:
     virtual void        deleteTimer(EventQueueTimer*) const;
 
 private:
-    typedef std::deque<UInt32> EventDeque;
+    SimpleEventQueueBuffer(const SimpleEventQueueBuffer&);
+    SimpleEventQueueBuffer&
+                        operator=(const SimpleEventQueueBuffer&);
 
+private:
     ArchMutex            m_queueMutex;
     ArchCond            m_queueReadyCond;
-    bool                m_queueReady;
-    EventDeque            m_queue;
-};
+    std::atomic<bool>    m_waiting;
 
+    // each cell holds an id plus one, or zero if it's empty.  a
+    // producer claims a cell by bumping m_tail and then fills it, so
+    // the consumer can briefly see m_tail ahead of a filled cell.  the
+    // padding keeps the consumer's m_head off the producers' cache line.
+    std::atomic<UInt32>*    m_cells;
+    std::atomic<UInt32> m_head;
+    UInt8               m_pad[64];
+    std::atomic<UInt32> m_tail;
+};
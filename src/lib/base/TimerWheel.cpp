@@ -0,0 +1,270 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/TimerWheel.h"
+
+#include <chrono>
+#include <cmath>
+
+//
+// TimerWheel::Timer
+//
+
+TimerWheel::Timer::Timer() :
+    m_prev(nullptr),
+    m_next(nullptr),
+    m_expires(0),
+    m_due(false)
+{
+    // do nothing
+}
+
+
+//
+// TimerWheel
+//
+
+TimerWheel::TimerWheel() :
+    m_current(0),
+    m_size(0),
+    m_inSlots(0)
+{
+    for (auto& level : m_slots) {
+        for (auto& slot : level) {
+            slot.m_prev = slot.m_next = &slot;
+        }
+    }
+    m_expired.m_prev = m_expired.m_next = &m_expired;
+}
+
+TimerWheel::~TimerWheel()
+{
+    // do nothing
+}
+
+void
+TimerWheel::arm(Timer* timer, double now, double delay)
+{
+    cancel(timer);
+
+    // keep the expiry within half the range of a tick count
+    if (delay < 0.0) {
+        delay = 0.0;
+    }
+    else if (delay > 2.0e6) {
+        delay = 2.0e6;
+    }
+
+    // nothing's waiting so skip straight to now
+    if (m_inSlots == 0) {
+        m_current = toTicks(now, false);
+    }
+
+    timer->m_expires = toTicks(now + delay, true);
+    timer->m_due     = false;
+    insert(timer);
+    ++m_inSlots;
+    ++m_size;
+}
+
+void
+TimerWheel::cancel(Timer* timer)
+{
+    if (!timer->isArmed()) {
+        return;
+    }
+
+    // timers on the expired list have already left the slots
+    if (!timer->m_due) {
+        --m_inSlots;
+    }
+    unlink(timer);
+    --m_size;
+}
+
+TimerWheel::Timer*
+TimerWheel::expire(double now, double& late)
+{
+    UInt32 nowTicks = toTicks(now, false);
+    if (m_expired.m_next == &m_expired) {
+        advance(nowTicks);
+        if (m_expired.m_next == &m_expired) {
+            return nullptr;
+        }
+    }
+
+    Timer* timer = m_expired.m_next;
+    unlink(timer);
+    --m_size;
+
+    SInt32 ticksLate = static_cast<SInt32>(nowTicks - timer->m_expires);
+    late = (ticksLate > 0) ? 1.0e-3 * ticksLate : 0.0;
+    return timer;
+}
+
+double
+TimerWheel::getTimeout(double now) const
+{
+    if (m_expired.m_next != &m_expired) {
+        return 0.0;
+    }
+    if (m_inSlots == 0) {
+        return -1.0;
+    }
+
+    // the first timer on the bottom level is exact.  on the levels
+    // above it's when the first occupied slot will be moved down.
+    bool found  = false;
+    UInt32 next = 0;
+    for (UInt32 i = 0; i < kSlots; ++i) {
+        const Timer& slot = m_slots[0][(m_current + i) & kSlotMask];
+        if (slot.m_next != &slot) {
+            found = true;
+            next  = m_current + i;
+            break;
+        }
+    }
+    for (UInt32 level = 1; level < kLevels; ++level) {
+        UInt32 shift = kSlotBits * level;
+        UInt32 block = m_current >> shift;
+        for (UInt32 i = 1; i <= kSlots; ++i) {
+            const Timer& slot = m_slots[level][(block + i) & kSlotMask];
+            if (slot.m_next != &slot) {
+                UInt32 tick = (block + i) << shift;
+                if (!found || static_cast<SInt32>(tick - next) < 0) {
+                    found = true;
+                    next  = tick;
+                }
+                break;
+            }
+        }
+    }
+
+    SInt32 ticks = static_cast<SInt32>(next - toTicks(now, false));
+    return (ticks > 0) ? 1.0e-3 * ticks : 0.0;
+}
+
+UInt32
+TimerWheel::getSize() const
+{
+    return m_size;
+}
+
+double
+TimerWheel::getTime()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+UInt32
+TimerWheel::toTicks(double time, bool roundUp)
+{
+    double ms = time * 1000.0;
+    ms = roundUp ? std::ceil(ms) : std::floor(ms);
+
+    // wraps modulo 2^32 like any other tick count
+    return static_cast<UInt32>(static_cast<long long>(ms));
+}
+
+void
+TimerWheel::link(Timer* list, Timer* timer)
+{
+    timer->m_prev         = list->m_prev;
+    timer->m_next         = list;
+    list->m_prev->m_next  = timer;
+    list->m_prev          = timer;
+}
+
+void
+TimerWheel::unlink(Timer* timer)
+{
+    timer->m_prev->m_next = timer->m_next;
+    timer->m_next->m_prev = timer->m_prev;
+    timer->m_prev         = nullptr;
+    timer->m_next         = nullptr;
+}
+
+void
+TimerWheel::insert(Timer* timer)
+{
+    // overdue timers go in the slot that's processed next
+    SInt32 delta = static_cast<SInt32>(timer->m_expires - m_current);
+    if (delta < 0) {
+        link(&m_slots[0][m_current & kSlotMask], timer);
+        return;
+    }
+
+    // find the lowest level that spans the delay.  anything beyond the
+    // top level is parked at its far end and moved down from there.
+    UInt32 expires = timer->m_expires;
+    UInt32 level   = 0;
+    while (level + 1 < kLevels &&
+            static_cast<UInt32>(delta) >= (1u << (kSlotBits * (level + 1)))) {
+        ++level;
+    }
+    if (static_cast<UInt32>(delta) >= (1u << (kSlotBits * kLevels))) {
+        expires = m_current + (1u << (kSlotBits * kLevels)) - 1;
+    }
+    link(&m_slots[level][(expires >> (kSlotBits * level)) & kSlotMask], timer);
+}
+
+void
+TimerWheel::cascade(UInt32 level)
+{
+    Timer& slot = m_slots[level][(m_current >> (kSlotBits * level)) & kSlotMask];
+    while (slot.m_next != &slot) {
+        Timer* timer = slot.m_next;
+        unlink(timer);
+        insert(timer);
+    }
+}
+
+void
+TimerWheel::advance(UInt32 now)
+{
+    while (static_cast<SInt32>(now - m_current) >= 0) {
+        if (m_inSlots == 0) {
+            m_current = now + 1;
+            return;
+        }
+
+        // at the start of a block on a level move its timers down.  the
+        // levels go top first so timers coming down from one level can
+        // land in a slot of the next one that's about to be moved.
+        UInt32 index = m_current & kSlotMask;
+        if (index == 0) {
+            UInt32 top = 1;
+            while (top + 1 < kLevels &&
+                    ((m_current >> (kSlotBits * top)) & kSlotMask) == 0) {
+                ++top;
+            }
+            for (UInt32 level = top; level > 0; --level) {
+                cascade(level);
+            }
+        }
+
+        Timer& slot = m_slots[0][index];
+        while (slot.m_next != &slot) {
+            Timer* timer = slot.m_next;
+            unlink(timer);
+            link(&m_expired, timer);
+            timer->m_due = true;
+            --m_inSlots;
+        }
+        ++m_current;
+    }
+}
@@ -0,0 +1,133 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/basic_types.h"
+
+//! Hierarchical timing wheel
+/*!
+Keeps timers in four levels of 64 slots, each level's slots 64 times
+coarser than the one below, with a 1ms tick.  Arming, re-arming and
+cancelling a timer are constant time and never allocate;  timers move
+down a level as their expiry gets closer.  The timer objects belong to
+the caller, who normally derives from TimerWheel::Timer.
+
+Times are in seconds on any clock that doesn't go backwards, normally
+getTime().
+*/
+class TimerWheel {
+public:
+    //! A timer in a wheel
+    class Timer {
+    public:
+        Timer();
+
+        //! Test if the timer is in a wheel
+        bool            isArmed() const { return m_next != nullptr; }
+
+    private:
+        friend class TimerWheel;
+
+        Timer*          m_prev;
+        Timer*          m_next;
+        UInt32          m_expires;
+        bool            m_due;
+    };
+
+    TimerWheel();
+    ~TimerWheel();
+
+    //! @name manipulators
+    //@{
+
+    //! Arm a timer
+    /*!
+    Sets \c timer to expire \c delay seconds after \c now, first
+    cancelling it if it's armed.  Delays are limited to about 24 days.
+    */
+    void                arm(Timer* timer, double now, double delay);
+
+    //! Cancel a timer
+    /*!
+    Removes \c timer from the wheel.  Does nothing if it isn't armed.
+    */
+    void                cancel(Timer* timer);
+
+    //! Get an expired timer
+    /*!
+    Advances the wheel to \c now and removes and returns a timer that
+    has expired, setting \c late to how long ago it expired.  Returns
+    NULL if no timer has expired.  Timers that expire on the same tick
+    are returned in the order they were armed.
+    */
+    Timer*              expire(double now, double& late);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get time until the wheel needs to be looked at
+    /*!
+    Returns the seconds after \c now at which expire() may next return
+    a timer, 0 if one is ready now, or -1 if no timers are armed.  This
+    can be earlier than the next expiry since timers on the upper levels
+    need moving down before they expire.
+    */
+    double              getTimeout(double now) const;
+
+    //! Get the number of armed timers
+    UInt32              getSize() const;
+
+    //! Get the current time
+    /*!
+    Returns the time in seconds on a monotonic clock.
+    */
+    static double       getTime();
+
+    //@}
+
+private:
+    enum {
+        kLevels     = 4,
+        kSlotBits   = 6,
+        kSlots      = 1 << kSlotBits,
+        kSlotMask   = kSlots - 1
+    };
+
+    TimerWheel(const TimerWheel&);
+    TimerWheel&         operator=(const TimerWheel&);
+
+    static UInt32       toTicks(double time, bool roundUp);
+    static void         link(Timer* list, Timer* timer);
+    static void         unlink(Timer* timer);
+
+    void                insert(Timer* timer);
+    void                cascade(UInt32 level);
+    void                advance(UInt32 now);
+
+private:
+    // each slot is a circular list with a sentinel.  m_expired holds
+    // timers that are due but haven't been returned by expire() yet.
+    Timer               m_slots[kLevels][kSlots];
+    Timer               m_expired;
+
+    // the next tick to process.  ticks wrap so they're only ever
+    // compared by their difference.
+    UInt32              m_current;
+    UInt32              m_size;
+    UInt32              m_inSlots;
+};
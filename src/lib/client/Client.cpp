@@ -212,6 +212,13 @@ Client::getServerAddress() const
     return m_serverAddress;
 }
 
+IDatagramSocket*
+Client::createDatagramSocket() const
+{
+    return m_socketFactory->createDatagram(
+                            ARCH->getAddrFamily(m_serverAddress.getAddress()));
+}
+
 void*
 Client::getEventTarget() const
 {
@@ -690,7 +697,7 @@ void
 Client::handleHello(const Event& /*unused*/, void* /*unused*/)
 {
     SInt16 major, minor;
-    if (!ProtocolUtil::readf(m_stream, kMsgHello, &major, &minor)) {
+    if (!ProtocolUtil::readMessage<MsgHello>(m_stream, major, minor)) {
         sendConnectionFailedEvent("Protocol error from server. Aborting");
         cleanupTimer();
         cleanupConnection();
@@ -709,9 +716,9 @@ Client::handleHello(const Event& /*unused*/, void* /*unused*/)
 
     // say hello back
     LOG((CLOG_DEBUG1 "say hello version %d.%d", kProtocolMajorVersion, kProtocolMinorVersion));
-    ProtocolUtil::writef(m_stream, kMsgHelloBack,
+    ProtocolUtil::write<MsgHelloBack>(m_stream,
                             kProtocolMajorVersion,
-                            kProtocolMinorVersion, &m_name);
+                            kProtocolMinorVersion, m_name);
 
     // now connected but waiting to complete handshake
     setupScreen();
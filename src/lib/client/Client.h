@@ -32,6 +32,7 @@ class EventQueueTimer;
 namespace synergy { class Screen; }
 class ServerProxy;
 class IDataSocket;
+class IDatagramSocket;
 class ISocketFactory;
 namespace synergy { class IStream; }
 class IEventQueue;
@@ -63,6 +64,12 @@ public:
 
     ~Client();
 
+#ifdef TEST_ENV
+    Client() : m_mock(true) { }
+    Client(const NetworkAddress& address, ISocketFactory* socketFactory) :
+        m_mock(true), m_serverAddress(address), m_socketFactory(socketFactory) { }
+#endif
+
     //! @name manipulators
     //@{
 
@@ -118,6 +125,13 @@ public:
     to connect) to.
     */
     NetworkAddress        getServerAddress() const;
+
+    //! Create a datagram socket
+    /*!
+    Returns a new, unbound datagram socket for talking to the server.
+    The caller must delete it.
+    */
+    IDatagramSocket*    createDatagramSocket() const;
     
     //! Return true if recieved file size is valid
     bool                isReceivedFileSizeValid();
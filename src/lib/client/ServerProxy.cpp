@@ -26,12 +26,16 @@
 #include "core/Clipboard.h"
 #include "core/ClipboardChunk.h"
 #include "core/FileChunk.h"
+#include "core/MotionDatagram.h"
 #include "core/ProtocolUtil.h"
 #include "core/StreamChunker.h"
 #include "core/option_types.h"
 #include "core/protocol_types.h"
 #include "io/IStream.h"
+#include "net/IDatagramSocket.h"
+#include "net/XSocket.h"
 
+#include <cstring>
 #include <memory>
 
 //
@@ -49,8 +53,14 @@ ServerProxy::ServerProxy(Client* client, synergy::IStream* stream, IEventQueue*
     m_dxMouse(0),
     m_dyMouse(0),
     m_ignoreMouse(false),
+    m_entered(false),
+    m_motionSocket(nullptr),
+    m_motionToken(0),
+    m_motionSeq(0),
     m_keepAliveAlarm(0.0),
     m_keepAliveAlarmTimer(nullptr),
+    m_noopAck(kNoopAckMessage),
+    m_noopPending(false),
     m_parser(&ServerProxy::parseHandshakeMessage),
     m_events(events)
 {
@@ -62,6 +72,8 @@ ServerProxy::ServerProxy(Client* client, synergy::IStream* stream, IEventQueue*
         m_modifierTranslationTable[id] = id;
 }
 
+    initMessageHandlers();
+
     // handle data on stream
     m_events->adoptHandler(m_events->forIStream().inputReady(),
                             m_stream->getEventTarget(),
@@ -79,7 +91,9 @@ ServerProxy::ServerProxy(Client* client, synergy::IStream* stream, IEventQueue*
 
 ServerProxy::~ServerProxy()
 {
+    LOG((CLOG_DEBUG1 "messages from server: %s", ProtocolUtil::formatMessageCounts(m_received).c_str()));
     setKeepAliveRate(-1.0);
+    closeMotionChannel();
     m_events->removeHandler(m_events->forIStream().inputReady(),
                             m_stream->getEventTarget());
 }
@@ -87,6 +101,11 @@ ServerProxy::~ServerProxy()
 void
 ServerProxy::resetKeepAliveAlarm()
 {
+    // every keep alive lands here so reuse the timer if we can
+    if (m_keepAliveAlarmTimer != nullptr && m_keepAliveAlarm > 0.0) {
+        m_events->rearmTimer(m_keepAliveAlarmTimer, m_keepAliveAlarm);
+        return;
+    }
     if (m_keepAliveAlarmTimer != nullptr) {
         m_events->removeHandler(Event::kTimer, m_keepAliveAlarmTimer);
         m_events->deleteTimer(m_keepAliveAlarmTimer);
@@ -108,13 +127,117 @@ ServerProxy::setKeepAliveRate(double rate)
     resetKeepAliveAlarm();
 }
 
+void
+ServerProxy::openMotionChannel(UInt32 token)
+{
+    try {
+        m_motionSocket = m_client->createDatagramSocket();
+    }
+    catch (XSocket& e) {
+        LOG((CLOG_WARN "cannot open motion channel: %s", e.what()));
+        return;
+    }
+
+    LOG((CLOG_DEBUG "motion channel open"));
+    m_motionAddress = m_client->getServerAddress();
+    m_motionToken   = token;
+    m_motionSeq     = 0;
+    m_events->adoptHandler(m_events->forIStream().inputReady(),
+                            m_motionSocket->getEventTarget(),
+                            new TMethodEventJob<ServerProxy>(this,
+                                &ServerProxy::handleMotion));
+    sendMotionHello();
+}
+
+void
+ServerProxy::closeMotionChannel()
+{
+    if (m_motionSocket != nullptr) {
+        LOG((CLOG_DEBUG "motion channel closed"));
+        m_events->removeHandler(m_events->forIStream().inputReady(),
+                            m_motionSocket->getEventTarget());
+        delete m_motionSocket;
+        m_motionSocket = nullptr;
+        m_motionToken  = 0;
+    }
+}
+
+void
+ServerProxy::sendMotionHello()
+{
+    // the server only sends motion once it's heard from us and the
+    // hello can be lost, so it's repeated with every keep alive
+    if (m_motionSocket != nullptr) {
+        MotionDatagram hello;
+        hello.m_type  = MotionDatagram::kHello;
+        hello.m_token = m_motionToken;
+
+        UInt8 buffer[MotionDatagram::kMaxSize];
+        m_motionSocket->sendTo(buffer, hello.encode(buffer), m_motionAddress);
+    }
+}
+
+void
+ServerProxy::handleMotion(const Event& /*unused*/, void* /*unused*/)
+{
+    // only the newest move matters so skip any that were overtaken,
+    // whether by each other or by ones in this batch
+    bool moved = false;
+    UInt8 buffer[MotionDatagram::kMaxSize];
+    NetworkAddress from;
+    MotionDatagram move, last;
+    UInt32 n;
+    while ((n = m_motionSocket->receiveFrom(buffer, sizeof(buffer), from)) != 0) {
+        // anyone can send to our port so only listen to the server
+        if (from != m_motionAddress) {
+            continue;
+        }
+        if (!move.decode(buffer, n) ||
+                move.m_type != MotionDatagram::kMove ||
+                move.m_token != m_motionToken) {
+            continue;
+        }
+        if (m_motionSeq == 0 || MotionDatagram::isNewer(move.m_seq, m_motionSeq)) {
+            m_motionSeq = move.m_seq;
+            last        = move;
+            moved       = true;
+        }
+    }
+
+    if (moved && m_entered && !m_ignoreMouse) {
+        // a compressed move from the stream is older than the datagram
+        // and mustn't be applied after it
+        m_compressMouse = false;
+
+        LOG((CLOG_DEBUG2 "recv mouse move datagram %d,%d seq=%u", last.m_x, last.m_y, last.m_seq));
+        m_client->mouseMove(last.m_x, last.m_y);
+    }
+}
+
 void
 ServerProxy::handleData(const Event& /*unused*/, void* /*unused*/)
 {
+    // replies to everything we read go out together.  the stream is
+    // gone if we disconnect so only uncork on the way out of the loop.
+    m_stream->cork();
+
     // handle messages until there are no more.  first read message code.
     UInt8 code[4];
     UInt32 n = m_stream->read(code, 4);
     while (n != 0) {
+        // input frames have no code.  their header is the first 2 bytes.
+        if (n >= kCompactHeaderSize &&
+                m_parser == &ServerProxy::parseMessage &&
+                CompactInputReader::isFrame(code[0])) {
+            if (compactInput(code, n) != kOkay) {
+                LOG((CLOG_ERR "invalid input frame from server"));
+                m_client->disconnect("invalid message from server");
+                return;
+            }
+            n = m_stream->read(code, 4);
+            continue;
+        }
+
         // verify we got an entire code
         if (n != 4) {
             LOG((CLOG_ERR "incomplete message from server: %d bytes", n));
@@ -124,7 +247,9 @@ ServerProxy::handleData(const Event& /*unused*/, void* /*unused*/)
 
         // parse message
         LOG((CLOG_DEBUG2 "msg from server: %c%c%c%c", code[0], code[1], code[2], code[3]));
-        switch ((this->*m_parser)(code)) {
+        EMessageID id = ProtocolUtil::getMessageID(code);
+        ++m_received[id];
+        switch ((this->*m_parser)(id)) {
         case kOkay:
             break;
 
@@ -142,194 +267,194 @@ ServerProxy::handleData(const Event& /*unused*/, void* /*unused*/)
     }
 
     flushCompressedMouse();
+    flushNoop();
+    m_stream->uncork();
 }
 
 ServerProxy::EResult
-ServerProxy::parseHandshakeMessage(const UInt8* code)
+ServerProxy::parseHandshakeMessage(EMessageID id)
 {
-    if (memcmp(code, kMsgQInfo, 4) == 0) {
-        queryInfo();
-    }
-
-    else if (memcmp(code, kMsgCInfoAck, 4) == 0) {
-        infoAcknowledgment();
-    }
-
-    else if (memcmp(code, kMsgDSetOptions, 4) == 0) {
-        setOptions();
-
-        // handshake is complete
-        m_parser = &ServerProxy::parseMessage;
-        m_client->handshakeComplete();
-    }
-
-    else if (memcmp(code, kMsgCResetOptions, 4) == 0) {
-        resetOptions();
-    }
-
-    else if (memcmp(code, kMsgCKeepAlive, 4) == 0) {
-        // echo keep alives and reset alarm
-        ProtocolUtil::writef(m_stream, kMsgCKeepAlive);
-        resetKeepAliveAlarm();
-    }
-
-    else if (memcmp(code, kMsgCNoop, 4) == 0) {
-        // accept and discard no-op
-    }
-
-    else if (memcmp(code, kMsgCClose, 4) == 0) {
-        // server wants us to hangup
-        LOG((CLOG_DEBUG1 "recv close"));
-        m_client->disconnect(nullptr);
-        return kDisconnect;
-    }
-
-    else if (memcmp(code, kMsgEIncompatible, 4) == 0) {
-        SInt32 major, minor;
-        ProtocolUtil::readf(m_stream,
-                        kMsgEIncompatible + 4, &major, &minor);
-        LOG((CLOG_ERR "server has incompatible version %d.%d", major, minor));
-        m_client->disconnect("server has incompatible version");
-        return kDisconnect;
-    }
-
-    else if (memcmp(code, kMsgEBusy, 4) == 0) {
-        LOG((CLOG_ERR "server already has a connected client with name \"%s\"", m_client->getName().c_str()));
-        m_client->disconnect("server already has a connected client with our name");
-        return kDisconnect;
-    }
-
-    else if (memcmp(code, kMsgEUnknown, 4) == 0) {
-        LOG((CLOG_ERR "server refused client with name \"%s\"", m_client->getName().c_str()));
-        m_client->disconnect("server refused client with our name");
-        return kDisconnect;
-    }
-
-    else if (memcmp(code, kMsgEBad, 4) == 0) {
-        LOG((CLOG_ERR "server disconnected due to a protocol error"));
-        m_client->disconnect("server reported a protocol error");
-        return kDisconnect;
-    }
-    else {
+    MessageHandler handler = m_handshakeHandlers[id];
+    if (handler == nullptr) {
         return kUnknown;
     }
-
-    return kOkay;
+    return (this->*handler)();
 }
 
 ServerProxy::EResult
-ServerProxy::parseMessage(const UInt8* code)
+ServerProxy::parseMessage(EMessageID id)
 {
-    if (memcmp(code, kMsgDMouseMove, 4) == 0) {
-        mouseMove();
-    }
-
-    else if (memcmp(code, kMsgDMouseRelMove, 4) == 0) {
-        mouseRelativeMove();
-    }
-
-    else if (memcmp(code, kMsgDMouseWheel, 4) == 0) {
-        mouseWheel();
-    }
-
-    else if (memcmp(code, kMsgDKeyDown, 4) == 0) {
-        keyDown();
-    }
-
-    else if (memcmp(code, kMsgDKeyUp, 4) == 0) {
-        keyUp();
-    }
-
-    else if (memcmp(code, kMsgDMouseDown, 4) == 0) {
-        mouseDown();
+    MessageHandler handler = m_messageHandlers[id];
+    if (handler == nullptr) {
+        return kUnknown;
     }
 
-    else if (memcmp(code, kMsgDMouseUp, 4) == 0) {
-        mouseUp();
+    EResult result = (this->*handler)();
+    if (result == kOkay) {
+        acknowledge();
     }
+    return result;
+}
 
-    else if (memcmp(code, kMsgDKeyRepeat, 4) == 0) {
-        keyRepeat();
-    }
+void
+ServerProxy::acknowledge()
+{
+    // send a reply.  this is intended to work around a delay when
+    // running a linux server and an OS X (any BSD?) client.  the
+    // client waits to send an ACK (if the system control flag
+    // net.inet.tcp.delayed_ack is 1) in hopes of piggybacking it
+    // on a data packet.  we provide that packet here.  i don't
+    // know why a delayed ACK should cause the server to wait since
+    // TCP_NODELAY is enabled.  servers that don't need one per
+    // message tell us so with kOptionNoopAck.
+    switch (m_noopAck) {
+    case kNoopAckMessage:
+        ProtocolUtil::write<MsgCNoop>(m_stream);
+        break;
 
-    else if (memcmp(code, kMsgCKeepAlive, 4) == 0) {
-        // echo keep alives and reset alarm
-        ProtocolUtil::writef(m_stream, kMsgCKeepAlive);
-        resetKeepAliveAlarm();
-    }
+    case kNoopAckRead:
+        m_noopPending = true;
+        break;
 
-    else if (memcmp(code, kMsgCNoop, 4) == 0) {
-        // accept and discard no-op
+    case kNoopAckNone:
+        break;
     }
+}
 
-    else if (memcmp(code, kMsgCEnter, 4) == 0) {
-        enter();
+void
+ServerProxy::flushNoop()
+{
+    if (m_noopPending) {
+        m_noopPending = false;
+        ProtocolUtil::write<MsgCNoop>(m_stream);
     }
+}
 
-    else if (memcmp(code, kMsgCLeave, 4) == 0) {
-        leave();
+void
+ServerProxy::initMessageHandlers()
+{
+    for (UInt32 i = 0; i < kNumMessageIDs; ++i) {
+        m_handshakeHandlers[i] = nullptr;
+        m_messageHandlers[i]   = nullptr;
     }
 
-    else if (memcmp(code, kMsgCClipboard, 4) == 0) {
-        grabClipboard();
-    }
+    MessageHandler* handshake = m_handshakeHandlers;
+    handshake[kMsgIDQInfo]         = &ServerProxy::handle<&ServerProxy::queryInfo>;
+    handshake[kMsgIDCInfoAck]      = &ServerProxy::handle<&ServerProxy::infoAcknowledgment>;
+    handshake[kMsgIDDSetOptions]   = &ServerProxy::handshakeOptions;
+    handshake[kMsgIDCResetOptions] = &ServerProxy::handle<&ServerProxy::resetOptions>;
+    handshake[kMsgIDCKeepAlive]    = &ServerProxy::keepAlive;
+    handshake[kMsgIDCNoop]         = &ServerProxy::noop;
+    handshake[kMsgIDCClose]        = &ServerProxy::close;
+    handshake[kMsgIDEIncompatible] = &ServerProxy::incompatible;
+    handshake[kMsgIDEBusy]         = &ServerProxy::busy;
+    handshake[kMsgIDEUnknown]      = &ServerProxy::unknownName;
+    handshake[kMsgIDEBad]          = &ServerProxy::protocolError;
+
+    MessageHandler* message = m_messageHandlers;
+    message[kMsgIDDMouseMove]      = &ServerProxy::handle<&ServerProxy::mouseMove>;
+    message[kMsgIDDMouseRelMove]   = &ServerProxy::handle<&ServerProxy::mouseRelativeMove>;
+    message[kMsgIDDMotionSeq]      = &ServerProxy::handle<&ServerProxy::motionSeq>;
+    message[kMsgIDDMouseWheel]     = &ServerProxy::handle<&ServerProxy::mouseWheel>;
+    message[kMsgIDDKeyDown]        = &ServerProxy::handle<&ServerProxy::keyDown>;
+    message[kMsgIDDKeyUp]          = &ServerProxy::handle<&ServerProxy::keyUp>;
+    message[kMsgIDDMouseDown]      = &ServerProxy::handle<&ServerProxy::mouseDown>;
+    message[kMsgIDDMouseUp]        = &ServerProxy::handle<&ServerProxy::mouseUp>;
+    message[kMsgIDDKeyRepeat]      = &ServerProxy::handle<&ServerProxy::keyRepeat>;
+    message[kMsgIDCKeepAlive]      = &ServerProxy::keepAlive;
+    message[kMsgIDCNoop]           = &ServerProxy::noop;
+    message[kMsgIDCEnter]          = &ServerProxy::handle<&ServerProxy::enter>;
+    message[kMsgIDCLeave]          = &ServerProxy::handle<&ServerProxy::leave>;
+    message[kMsgIDCClipboard]      = &ServerProxy::handle<&ServerProxy::grabClipboard>;
+    message[kMsgIDCScreenSaver]    = &ServerProxy::handle<&ServerProxy::screensaver>;
+    message[kMsgIDQInfo]           = &ServerProxy::handle<&ServerProxy::queryInfo>;
+    message[kMsgIDCInfoAck]        = &ServerProxy::handle<&ServerProxy::infoAcknowledgment>;
+    message[kMsgIDDClipboard]      = &ServerProxy::handle<&ServerProxy::setClipboard>;
+    message[kMsgIDCResetOptions]   = &ServerProxy::handle<&ServerProxy::resetOptions>;
+    message[kMsgIDDSetOptions]     = &ServerProxy::handle<&ServerProxy::setOptions>;
+    message[kMsgIDDFileTransfer]   = &ServerProxy::handle<&ServerProxy::fileChunkReceived>;
+    message[kMsgIDDDragInfo]       = &ServerProxy::handle<&ServerProxy::dragInfoReceived>;
+    message[kMsgIDCClose]          = &ServerProxy::close;
+    message[kMsgIDEBad]            = &ServerProxy::protocolError;
+}
 
-    else if (memcmp(code, kMsgCScreenSaver, 4) == 0) {
-        screensaver();
-    }
+template <void (ServerProxy::*Handler)()>
+ServerProxy::EResult
+ServerProxy::handle()
+{
+    (this->*Handler)();
+    return kOkay;
+}
 
-    else if (memcmp(code, kMsgQInfo, 4) == 0) {
-        queryInfo();
-    }
+ServerProxy::EResult
+ServerProxy::handshakeOptions()
+{
+    setOptions();
 
-    else if (memcmp(code, kMsgCInfoAck, 4) == 0) {
-        infoAcknowledgment();
-    }
+    // handshake is complete
+    m_parser = &ServerProxy::parseMessage;
+    m_client->handshakeComplete();
+    return kOkay;
+}
 
-    else if (memcmp(code, kMsgDClipboard, 4) == 0) {
-        setClipboard();
-    }
+ServerProxy::EResult
+ServerProxy::keepAlive()
+{
+    // echo keep alives and reset alarm
+    ProtocolUtil::write<MsgCKeepAlive>(m_stream);
+    resetKeepAliveAlarm();
+    sendMotionHello();
+    return kOkay;
+}
 
-    else if (memcmp(code, kMsgCResetOptions, 4) == 0) {
-        resetOptions();
-    }
+ServerProxy::EResult
+ServerProxy::noop()
+{
+    // accept and discard no-op
+    return kOkay;
+}
 
-    else if (memcmp(code, kMsgDSetOptions, 4) == 0) {
-        setOptions();
-    }
+ServerProxy::EResult
+ServerProxy::close()
+{
+    // server wants us to hangup
+    LOG((CLOG_DEBUG1 "recv close"));
+    m_client->disconnect(nullptr);
+    return kDisconnect;
+}
 
-    else if (memcmp(code, kMsgDFileTransfer, 4) == 0) {
-        fileChunkReceived();
-    }
-    else if (memcmp(code, kMsgDDragInfo, 4) == 0) {
-        dragInfoReceived();
-    }
+ServerProxy::EResult
+ServerProxy::incompatible()
+{
+    SInt32 major, minor;
+    ProtocolUtil::read<MsgEIncompatible>(m_stream, major, minor);
+    LOG((CLOG_ERR "server has incompatible version %d.%d", major, minor));
+    m_client->disconnect("server has incompatible version");
+    return kDisconnect;
+}
 
-    else if (memcmp(code, kMsgCClose, 4) == 0) {
-        // server wants us to hangup
-        LOG((CLOG_DEBUG1 "recv close"));
-        m_client->disconnect(nullptr);
-        return kDisconnect;
-    }
-    else if (memcmp(code, kMsgEBad, 4) == 0) {
-        LOG((CLOG_ERR "server disconnected due to a protocol error"));
-        m_client->disconnect("server reported a protocol error");
-        return kDisconnect;
-    }
-    else {
-        return kUnknown;
-    }
+ServerProxy::EResult
+ServerProxy::busy()
+{
+    LOG((CLOG_ERR "server already has a connected client with name \"%s\"", m_client->getName().c_str()));
+    m_client->disconnect("server already has a connected client with our name");
+    return kDisconnect;
+}
 
-    // send a reply.  this is intended to work around a delay when
-    // running a linux server and an OS X (any BSD?) client.  the
-    // client waits to send an ACK (if the system control flag
-    // net.inet.tcp.delayed_ack is 1) in hopes of piggybacking it
-    // on a data packet.  we provide that packet here.  i don't
-    // know why a delayed ACK should cause the server to wait since
-    // TCP_NODELAY is enabled.
-    ProtocolUtil::writef(m_stream, kMsgCNoop);
+ServerProxy::EResult
+ServerProxy::unknownName()
+{
+    LOG((CLOG_ERR "server refused client with name \"%s\"", m_client->getName().c_str()));
+    m_client->disconnect("server refused client with our name");
+    return kDisconnect;
+}
 
-    return kOkay;
+ServerProxy::EResult
+ServerProxy::protocolError()
+{
+    LOG((CLOG_ERR "server disconnected due to a protocol error"));
+    m_client->disconnect("server reported a protocol error");
+    return kDisconnect;
 }
 
 void
@@ -354,7 +479,7 @@ bool
 ServerProxy::onGrabClipboard(ClipboardID id)
 {
     LOG((CLOG_DEBUG1 "sending clipboard %d changed", id));
-    ProtocolUtil::writef(m_stream, kMsgCClipboard, id, m_seqNum);
+    ProtocolUtil::write<MsgCClipboard>(m_stream, id, m_seqNum);
     return true;
 }
 
@@ -386,7 +511,7 @@ void
 ServerProxy::sendInfo(const ClientInfo& info)
 {
     LOG((CLOG_DEBUG1 "sending info shape=%d,%d %dx%d", info.m_x, info.m_y, info.m_w, info.m_h));
-    ProtocolUtil::writef(m_stream, kMsgDInfo,
+    ProtocolUtil::write<MsgDInfo>(m_stream,
                                 info.m_x, info.m_y,
                                 info.m_w, info.m_h, 0,
                                 info.m_mx, info.m_my);
@@ -519,7 +644,7 @@ ServerProxy::enter()
     SInt16 x, y;
     UInt16 mask;
     UInt32 seqNum;
-    ProtocolUtil::readf(m_stream, kMsgCEnter + 4, &x, &y, &seqNum, &mask);
+    ProtocolUtil::read<MsgCEnter>(m_stream, x, y, seqNum, mask);
     LOG((CLOG_DEBUG1 "recv enter, %d,%d %d %04x", x, y, seqNum, mask));
 
     // discard old compressed mouse motion, if any
@@ -528,6 +653,8 @@ ServerProxy::enter()
     m_dxMouse               = 0;
     m_dyMouse               = 0;
     m_seqNum                = seqNum;
+    m_entered               = true;
+    m_compactInput.setPosition(x, y);
 
     // forward
     m_client->enter(x, y, seqNum, static_cast<KeyModifierMask>(mask), false);
@@ -541,6 +668,7 @@ ServerProxy::leave()
 
     // send last mouse motion
     flushCompressedMouse();
+    m_entered = false;
 
     // forward
     m_client->leave();
@@ -578,7 +706,7 @@ ServerProxy::grabClipboard()
     // parse
     ClipboardID id;
     UInt32 seqNum;
-    ProtocolUtil::readf(m_stream, kMsgCClipboard + 4, &id, &seqNum);
+    ProtocolUtil::read<MsgCClipboard>(m_stream, id, seqNum);
     LOG((CLOG_DEBUG "recv grab clipboard %d", id));
 
     // validate
@@ -593,119 +721,263 @@ ServerProxy::grabClipboard()
 void
 ServerProxy::keyDown()
 {
-    // get mouse up to date
-    flushCompressedMouse();
-
     // parse
     UInt16 id, mask, button;
-    ProtocolUtil::readf(m_stream, kMsgDKeyDown + 4, &id, &mask, &button);
+    ProtocolUtil::read<MsgDKeyDown>(m_stream, id, mask, button);
     LOG((CLOG_DEBUG1 "recv key down id=0x%08x, mask=0x%04x, button=0x%04x", id, mask, button));
 
-    // translate
-    KeyID id2             = translateKey(static_cast<KeyID>(id));
-    KeyModifierMask mask2 = translateModifierMask(
-                                static_cast<KeyModifierMask>(mask));
-    if (id2   != static_cast<KeyID>(id) ||
-        mask2 != static_cast<KeyModifierMask>(mask)) {
-        LOG((CLOG_DEBUG1 "key down translated to id=0x%08x, mask=0x%04x", id2, mask2));
-}
-
     // forward
-    m_client->keyDown(id2, mask2, button);
+    onKeyDown(id, mask, button);
 }
 
 void
 ServerProxy::keyRepeat()
 {
-    // get mouse up to date
-    flushCompressedMouse();
-
     // parse
     UInt16 id, mask, count, button;
-    ProtocolUtil::readf(m_stream, kMsgDKeyRepeat + 4,
-                                &id, &mask, &count, &button);
+    ProtocolUtil::read<MsgDKeyRepeat>(m_stream,
+                                id, mask, count, button);
     LOG((CLOG_DEBUG1 "recv key repeat id=0x%08x, mask=0x%04x, count=%d, button=0x%04x", id, mask, count, button));
 
-    // translate
-    KeyID id2             = translateKey(static_cast<KeyID>(id));
-    KeyModifierMask mask2 = translateModifierMask(
-                                static_cast<KeyModifierMask>(mask));
-    if (id2   != static_cast<KeyID>(id) ||
-        mask2 != static_cast<KeyModifierMask>(mask)) {
-        LOG((CLOG_DEBUG1 "key repeat translated to id=0x%08x, mask=0x%04x", id2, mask2));
-}
-
     // forward
-    m_client->keyRepeat(id2, mask2, count, button);
+    onKeyRepeat(id, mask, count, button);
 }
 
 void
 ServerProxy::keyUp()
 {
-    // get mouse up to date
-    flushCompressedMouse();
-
     // parse
     UInt16 id, mask, button;
-    ProtocolUtil::readf(m_stream, kMsgDKeyUp + 4, &id, &mask, &button);
+    ProtocolUtil::read<MsgDKeyUp>(m_stream, id, mask, button);
     LOG((CLOG_DEBUG1 "recv key up id=0x%08x, mask=0x%04x, button=0x%04x", id, mask, button));
 
-    // translate
-    KeyID id2             = translateKey(static_cast<KeyID>(id));
-    KeyModifierMask mask2 = translateModifierMask(
-                                static_cast<KeyModifierMask>(mask));
-    if (id2   != static_cast<KeyID>(id) ||
-        mask2 != static_cast<KeyModifierMask>(mask)) {
-        LOG((CLOG_DEBUG1 "key up translated to id=0x%08x, mask=0x%04x", id2, mask2));
-}
-
     // forward
-    m_client->keyUp(id2, mask2, button);
+    onKeyUp(id, mask, button);
 }
 
 void
 ServerProxy::mouseDown()
 {
-    // get mouse up to date
-    flushCompressedMouse();
-
     // parse
     SInt8 id;
-    ProtocolUtil::readf(m_stream, kMsgDMouseDown + 4, &id);
+    ProtocolUtil::read<MsgDMouseDown>(m_stream, id);
     LOG((CLOG_DEBUG1 "recv mouse down id=%d", id));
 
     // forward
-    m_client->mouseDown(static_cast<ButtonID>(id));
+    onMouseDown(static_cast<ButtonID>(id));
 }
 
 void
 ServerProxy::mouseUp()
 {
-    // get mouse up to date
-    flushCompressedMouse();
-
     // parse
     SInt8 id;
-    ProtocolUtil::readf(m_stream, kMsgDMouseUp + 4, &id);
+    ProtocolUtil::read<MsgDMouseUp>(m_stream, id);
     LOG((CLOG_DEBUG1 "recv mouse up id=%d", id));
 
     // forward
-    m_client->mouseUp(static_cast<ButtonID>(id));
+    onMouseUp(static_cast<ButtonID>(id));
 }
 
 void
 ServerProxy::mouseMove()
 {
     // parse
-    bool ignore;
     SInt16 x, y;
-    ProtocolUtil::readf(m_stream, kMsgDMouseMove + 4, &x, &y);
+    ProtocolUtil::read<MsgDMouseMove>(m_stream, x, y);
+    LOG((CLOG_DEBUG2 "recv mouse move %d,%d", x, y));
+
+    // forward
+    onMouseMove(x, y, m_stream->isReady());
+}
+
+void
+ServerProxy::mouseRelativeMove()
+{
+    // parse
+    SInt16 dx, dy;
+    ProtocolUtil::read<MsgDMouseRelMove>(m_stream, dx, dy);
+    LOG((CLOG_DEBUG2 "recv mouse relative move %d,%d", dx, dy));
+
+    // forward
+    onMouseRelativeMove(dx, dy, m_stream->isReady());
+}
+
+void
+ServerProxy::motionSeq()
+{
+    // parse
+    UInt32 seq;
+    ProtocolUtil::read<MsgDMotionSeq>(m_stream, seq);
+    LOG((CLOG_DEBUG2 "recv motion fence seq=%u", seq));
+
+    // the server is about to repeat the motion on the stream, so any
+    // datagram up to this one that's still on its way is out of date
+    if (m_motionSeq == 0 || MotionDatagram::isNewer(seq, m_motionSeq)) {
+        m_motionSeq = seq;
+    }
+}
+
+void
+ServerProxy::mouseWheel()
+{
+    // parse
+    SInt16 xDelta, yDelta;
+    ProtocolUtil::read<MsgDMouseWheel>(m_stream, xDelta, yDelta);
+    LOG((CLOG_DEBUG2 "recv mouse wheel %+d,%+d", xDelta, yDelta));
+
+    // forward
+    onMouseWheel(xDelta, yDelta);
+}
+
+ServerProxy::EResult
+ServerProxy::compactInput(const UInt8* start, UInt32 n)
+{
+    // the events follow the header.  some of them were read with it.
+    UInt8 frame[CompactInputWriter::kMaxSize];
+    UInt32 size = CompactInputReader::getFrameSize(start);
+    UInt32 head = n - kCompactHeaderSize;
+    if (size == 0 || size < head) {
+        return kUnknown;
+    }
+    memcpy(frame, start + kCompactHeaderSize, head);
+    if (m_stream->read(frame + head, size - head) != size - head) {
+        return kUnknown;
+    }
+    LOG((CLOG_DEBUG2 "recv input frame size=%d", size));
+
+    CompactInput input{};
+    m_compactInput.setFrame(frame, size);
+    while (m_compactInput.next(input)) {
+        switch (input.m_op) {
+        case kCompactMouseMove:
+            onMouseMove(input.m_x, input.m_y,
+                            m_compactInput.hasMore() || m_stream->isReady());
+            break;
+
+        case kCompactMouseRelMove:
+            onMouseRelativeMove(input.m_x, input.m_y,
+                            m_compactInput.hasMore() || m_stream->isReady());
+            break;
+
+        case kCompactMouseDown:
+            onMouseDown(static_cast<ButtonID>(input.m_id));
+            break;
+
+        case kCompactMouseUp:
+            onMouseUp(static_cast<ButtonID>(input.m_id));
+            break;
+
+        case kCompactMouseWheel:
+            onMouseWheel(input.m_x, input.m_y);
+            break;
+
+        case kCompactKeyDown:
+            onKeyDown(input.m_id, input.m_mask, input.m_button);
+            break;
+
+        case kCompactKeyRepeat:
+            onKeyRepeat(input.m_id, input.m_mask,
+                            static_cast<SInt32>(input.m_count),
+                            input.m_button);
+            break;
+
+        case kCompactKeyUp:
+            onKeyUp(input.m_id, input.m_mask, input.m_button);
+            break;
+
+        default:
+            break;
+        }
+    }
 
+    if (input.m_op == kCompactLast) {
+        return kUnknown;
+    }
+    acknowledge();
+    return kOkay;
+}
+
+void
+ServerProxy::onKeyDown(KeyID id, KeyModifierMask mask, KeyButton button)
+{
+    // get mouse up to date
+    flushCompressedMouse();
+
+    // translate
+    KeyID id2             = translateKey(id);
+    KeyModifierMask mask2 = translateModifierMask(mask);
+    if (id2 != id || mask2 != mask) {
+        LOG((CLOG_DEBUG1 "key down translated to id=0x%08x, mask=0x%04x", id2, mask2));
+    }
+
+    // forward
+    m_client->keyDown(id2, mask2, button);
+}
+
+void
+ServerProxy::onKeyRepeat(KeyID id, KeyModifierMask mask,
+                SInt32 count, KeyButton button)
+{
+    // get mouse up to date
+    flushCompressedMouse();
+
+    // translate
+    KeyID id2             = translateKey(id);
+    KeyModifierMask mask2 = translateModifierMask(mask);
+    if (id2 != id || mask2 != mask) {
+        LOG((CLOG_DEBUG1 "key repeat translated to id=0x%08x, mask=0x%04x", id2, mask2));
+    }
+
+    // forward
+    m_client->keyRepeat(id2, mask2, count, button);
+}
+
+void
+ServerProxy::onKeyUp(KeyID id, KeyModifierMask mask, KeyButton button)
+{
+    // get mouse up to date
+    flushCompressedMouse();
+
+    // translate
+    KeyID id2             = translateKey(id);
+    KeyModifierMask mask2 = translateModifierMask(mask);
+    if (id2 != id || mask2 != mask) {
+        LOG((CLOG_DEBUG1 "key up translated to id=0x%08x, mask=0x%04x", id2, mask2));
+    }
+
+    // forward
+    m_client->keyUp(id2, mask2, button);
+}
+
+void
+ServerProxy::onMouseDown(ButtonID id)
+{
+    // get mouse up to date
+    flushCompressedMouse();
+
+    // forward
+    m_client->mouseDown(id);
+}
+
+void
+ServerProxy::onMouseUp(ButtonID id)
+{
+    // get mouse up to date
+    flushCompressedMouse();
+
+    // forward
+    m_client->mouseUp(id);
+}
+
+void
+ServerProxy::onMouseMove(SInt32 x, SInt32 y, bool more)
+{
     // note if we should ignore the move
-    ignore = m_ignoreMouse;
+    bool ignore = m_ignoreMouse;
 
     // compress mouse motion events if more input follows
-    if (!ignore && !m_compressMouse && m_stream->isReady()) {
+    if (!ignore && !m_compressMouse && more) {
         m_compressMouse = true;
     }
 
@@ -718,7 +990,6 @@ ServerProxy::mouseMove()
         m_dxMouse = 0;
         m_dyMouse = 0;
     }
-    LOG((CLOG_DEBUG2 "recv mouse move %d,%d", x, y));
 
     // forward
     if (!ignore) {
@@ -727,18 +998,13 @@ ServerProxy::mouseMove()
 }
 
 void
-ServerProxy::mouseRelativeMove()
+ServerProxy::onMouseRelativeMove(SInt32 dx, SInt32 dy, bool more)
 {
-    // parse
-    bool ignore;
-    SInt16 dx, dy;
-    ProtocolUtil::readf(m_stream, kMsgDMouseRelMove + 4, &dx, &dy);
-
     // note if we should ignore the move
-    ignore = m_ignoreMouse;
+    bool ignore = m_ignoreMouse;
 
     // compress mouse motion events if more input follows
-    if (!ignore && !m_compressMouseRelative && m_stream->isReady()) {
+    if (!ignore && !m_compressMouseRelative && more) {
         m_compressMouseRelative = true;
     }
 
@@ -748,7 +1014,6 @@ ServerProxy::mouseRelativeMove()
         m_dxMouse += dx;
         m_dyMouse += dy;
     }
-    LOG((CLOG_DEBUG2 "recv mouse relative move %d,%d", dx, dy));
 
     // forward
     if (!ignore) {
@@ -757,16 +1022,11 @@ ServerProxy::mouseRelativeMove()
 }
 
 void
-ServerProxy::mouseWheel()
+ServerProxy::onMouseWheel(SInt32 xDelta, SInt32 yDelta)
 {
     // get mouse up to date
     flushCompressedMouse();
 
-    // parse
-    SInt16 xDelta, yDelta;
-    ProtocolUtil::readf(m_stream, kMsgDMouseWheel + 4, &xDelta, &yDelta);
-    LOG((CLOG_DEBUG2 "recv mouse wheel %+d,%+d", xDelta, yDelta));
-
     // forward
     m_client->mouseWheel(xDelta, yDelta);
 }
@@ -776,7 +1036,7 @@ ServerProxy::screensaver()
 {
     // parse
     SInt8 on;
-    ProtocolUtil::readf(m_stream, kMsgCScreenSaver + 4, &on);
+    ProtocolUtil::read<MsgCScreenSaver>(m_stream, on);
     LOG((CLOG_DEBUG1 "recv screen saver on=%d", on));
 
     // forward
@@ -792,9 +1052,15 @@ ServerProxy::resetOptions()
     // forward
     m_client->resetOptions();
 
+    // the server forgets our motion channel token
+    closeMotionChannel();
+
     // reset keep alive
     setKeepAliveRate(kKeepAliveRate);
 
+    // acknowledge every message until told otherwise
+    m_noopAck = kNoopAckMessage;
+
     // reset modifier translation table
     for (KeyModifierID id = 0; id < kKeyModifierIDLast; ++id) {
         m_modifierTranslationTable[id] = id;
@@ -806,7 +1072,7 @@ ServerProxy::setOptions()
 {
     // parse
     OptionsList options;
-    ProtocolUtil::readf(m_stream, kMsgDSetOptions + 4, &options);
+    ProtocolUtil::read<MsgDSetOptions>(m_stream, options);
     LOG((CLOG_DEBUG1 "recv set options size=%d", options.size()));
 
     // forward
@@ -837,6 +1103,18 @@ ServerProxy::setOptions()
             // update keep alive
             setKeepAliveRate(1.0e-3 * static_cast<double>(options[i + 1]));
         }
+        else if (options[i] == kOptionMotionChannel) {
+            closeMotionChannel();
+            if (options[i + 1] != 0) {
+                openMotionChannel(options[i + 1]);
+            }
+        }
+        else if (options[i] == kOptionNoopAck) {
+            if (options[i + 1] <= kNoopAckNone) {
+                m_noopAck = static_cast<ENoopAck>(options[i + 1]);
+                LOG((CLOG_DEBUG1 "no-op ack mode %d", m_noopAck));
+            }
+        }
 
         if (id != kKeyModifierIDNull) {
             m_modifierTranslationTable[id] =
@@ -887,7 +1165,7 @@ ServerProxy::dragInfoReceived()
     // parse
     UInt32 fileNum = 0;
     String content;
-    ProtocolUtil::readf(m_stream, kMsgDDragInfo + 4, &fileNum, &content);
+    ProtocolUtil::read<MsgDDragInfo>(m_stream, fileNum, content);
 
     m_client->dragInfoReceived(fileNum, content);
 }
@@ -908,5 +1186,5 @@ void
 ServerProxy::sendDragInfo(UInt32 fileCount, const char* info, size_t size)
 {
     String data(info, size);
-    ProtocolUtil::writef(m_stream, kMsgDDragInfo, fileCount, &data);
+    ProtocolUtil::write<MsgDDragInfo>(m_stream, fileCount, data);
 }
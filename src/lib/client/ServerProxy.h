@@ -19,15 +19,21 @@
 #pragma once
 
 #include "core/clipboard_types.h"
+#include "core/CompactInput.h"
 #include "core/key_types.h"
+#include "core/mouse_types.h"
+#include "core/option_types.h"
+#include "core/protocol_types.h"
 #include "base/Event.h"
 #include "base/Stopwatch.h"
 #include "base/String.h"
+#include "net/NetworkAddress.h"
 
 class Client;
 class ClientInfo;
 class EventQueueTimer;
 class IClipboard;
+class IDatagramSocket;
 namespace synergy { class IStream; }
 class IEventQueue;
 
@@ -66,18 +72,32 @@ public:
 
 protected:
     enum EResult { kOkay, kUnknown, kDisconnect };
-    EResult                parseHandshakeMessage(const UInt8* code);
-    EResult                parseMessage(const UInt8* code);
+    EResult                parseHandshakeMessage(EMessageID);
+    EResult                parseMessage(EMessageID);
 
 private:
     // if compressing mouse motion then send the last motion now
     void                flushCompressedMouse();
 
+    // acknowledge a message, now or with the next flushNoop()
+    void                acknowledge();
+
+    // send the no-op owed for the messages read so far, if any
+    void                flushNoop();
+
     void                sendInfo(const ClientInfo&);
 
+    // fill in the message dispatch tables
+    void                initMessageHandlers();
+
     void                resetKeepAliveAlarm();
     void                setKeepAliveRate(double);
 
+    // pointer motion channel
+    void                openMotionChannel(UInt32 token);
+    void                closeMotionChannel();
+    void                sendMotionHello();
+
     // modifier key translation
     KeyID                translateKey(KeyID) const;
     KeyModifierMask            translateModifierMask(KeyModifierMask) const;
@@ -85,6 +105,7 @@ private:
     // event handlers
     void                handleData(const Event&, void*);
     void                handleKeepAliveAlarm(const Event&, void*);
+    void                handleMotion(const Event&, void*);
 
     // message handlers
     void                enter();
@@ -98,6 +119,7 @@ private:
     void                mouseUp();
     void                mouseMove();
     void                mouseRelativeMove();
+    void                motionSeq();
     void                mouseWheel();
     void                screensaver();
     void                resetOptions();
@@ -108,8 +130,33 @@ private:
     void                dragInfoReceived();
     void                handleClipboardSendingEvent(const Event&, void*);
 
+    // input handlers, for both messages and compact frames.  \p more is
+    // true if more input has already arrived.
+    void                onKeyDown(KeyID, KeyModifierMask, KeyButton);
+    void                onKeyRepeat(KeyID, KeyModifierMask,
+                            SInt32 count, KeyButton);
+    void                onKeyUp(KeyID, KeyModifierMask, KeyButton);
+    void                onMouseDown(ButtonID);
+    void                onMouseUp(ButtonID);
+    void                onMouseMove(SInt32 x, SInt32 y, bool more);
+    void                onMouseRelativeMove(SInt32 dx, SInt32 dy, bool more);
+    void                onMouseWheel(SInt32 xDelta, SInt32 yDelta);
+
+    template <void (ServerProxy::*Handler)()>
+    EResult                handle();
+    EResult                handshakeOptions();
+    EResult                compactInput(const UInt8* start, UInt32 n);
+    EResult                keepAlive();
+    EResult                noop();
+    EResult                close();
+    EResult                incompatible();
+    EResult                busy();
+    EResult                unknownName();
+    EResult                protocolError();
+
 private:
-    typedef EResult (ServerProxy::*MessageParser)(const UInt8*);
+    typedef EResult (ServerProxy::*MessageParser)(EMessageID);
+    typedef EResult (ServerProxy::*MessageHandler)();
 
     Client*            m_client;
     synergy::IStream*    m_stream;
@@ -122,12 +169,26 @@ private:
     SInt32                m_dxMouse, m_dyMouse;
 
     bool                m_ignoreMouse;
+    bool                m_entered;
+
+    CompactInputReader  m_compactInput;
+
+    IDatagramSocket*    m_motionSocket;
+    NetworkAddress      m_motionAddress;
+    UInt32              m_motionToken;
+    UInt32              m_motionSeq;
 
     KeyModifierID        m_modifierTranslationTable[kKeyModifierIDLast]{};
 
     double                m_keepAliveAlarm;
     EventQueueTimer*    m_keepAliveAlarmTimer;
 
+    ENoopAck            m_noopAck;
+    bool                m_noopPending;
+
     MessageParser        m_parser;
+    MessageHandler        m_handshakeHandlers[kNumMessageIDs];
+    MessageHandler        m_messageHandlers[kNumMessageIDs];
+    UInt32                m_received[kNumMessageIDs]{};
     IEventQueue*        m_events;
 };
@@ -148,7 +148,9 @@ private:
     "  -1, --no-restart         do not try to restart on failure.\n" \
     "*     --restart            restart the server automatically if it fails.\n" \
     "  -l  --log <file>         write log messages to file.\n" \
-    "      --enable-drag-drop   enable file drag & drop.\n"
+    "      --enable-drag-drop   enable file drag & drop.\n" \
+    "      --multiplexer <type> how sockets are serviced:  * poll, or epoll\n" \
+    "                             on Linux.\n"
 
 #define HELP_COMMON_INFO_2 \
     "  -h, --help               display this help and exit.\n" \
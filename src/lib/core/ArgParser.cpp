@@ -162,6 +162,20 @@ ArgParser::parsePlatformArg(ArgsBase& argsBase, const int& argc, const char* con
         argsBase.m_screenY = atoi(argv[++i]);
     }
 
+    else if (isArg(i, argc, argv, nullptr, "--hid-autotype")) {
+        argsBase.m_hidAutoType = true;
+    }
+
+    else if (isArg(i, argc, argv, nullptr, "--hid-sink", 1)) {
+        argsBase.m_hidSink = argv[++i];
+        if (argsBase.m_hidSink != "gadget" && argsBase.m_hidSink != "uring" &&
+                argsBase.m_hidSink != "pipe" && argsBase.m_hidSink != "memory") {
+            LOG((CLOG_PRINT "%s: unknown HID sink `%s'" BYE,
+                argsBase.m_pname, argv[i], argsBase.m_pname));
+            argsBase.m_shouldExit = true;
+        }
+    }
+
     else {
         // option not supported here
         return false;
@@ -303,6 +317,15 @@ ArgParser::parseGenericArgs(int argc, const char* const* argv, int& i)
     else if (isArg(i, argc, argv, nullptr, "--plugin-dir", 1)) {
         argsBase().m_pluginDirectory = argv[++i];
     }
+    else if (isArg(i, argc, argv, nullptr, "--multiplexer", 1)) {
+        argsBase().m_multiplexer = argv[++i];
+        if (argsBase().m_multiplexer != "poll" &&
+                argsBase().m_multiplexer != "epoll") {
+            LOG((CLOG_PRINT "%s: unknown multiplexer `%s'" BYE,
+                argsBase().m_pname, argv[i], argsBase().m_pname));
+            argsBase().m_shouldExit = true;
+        }
+    }
 #if WINAPI_XWINDOWS
     else if (isArg(i, argc, argv, nullptr, "--run-as-uid", 1)) {
         argsBase().m_runAsUid = std::stoi(argv[++i]);
@@ -46,10 +46,13 @@ m_screenWidth(0),
 m_screenHeight(0),
 m_screenX(0),
 m_screenY(0),
+m_hidAutoType(false),
+m_hidSink("gadget"),
 #endif
 m_shouldExit(false),
 m_profileDirectory(""),
-m_pluginDirectory("")
+m_pluginDirectory(""),
+m_multiplexer("poll")
 {
 }
 
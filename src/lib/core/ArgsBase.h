@@ -52,9 +52,12 @@ public:
     int                 m_screenHeight;
     int                 m_screenX;
     int                 m_screenY;
+    bool                m_hidAutoType;
+    String              m_hidSink;
 #endif
     bool                m_shouldExit;
     String                m_synergyAddress;
     String                m_profileDirectory;
     String                m_pluginDirectory;
+    String                m_multiplexer;
 };
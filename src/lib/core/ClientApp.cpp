@@ -110,12 +110,18 @@ ClientApp::help()
 {
 #if WINAPI_XWINDOWS
 #  define WINAPI_ARG \
-    " [--display <display>] [--no-xinitthreads] [--hid <keyboard> <relative mouse> <absolute mouse> <width> <height> <x> <y>]"
+    " [--display <display>] [--no-xinitthreads] [--hid <keyboard> <relative mouse> <absolute mouse> <width> <height> <x> <y>]" \
+    " [--hid-autotype] [--hid-sink <gadget|uring|pipe|memory>]"
 #  define WINAPI_INFO \
     "      --display <display>  connect to the X server at <display>\n" \
     "      --no-xinitthreads    do not call XInitThreads()\n" \
     "      --hid <keyboard> <relative mouse> <absolute mouse> <width> <height>\n" \
-    "        run in HID mode with the given <keyboard> and <mouse> devices\n"
+    "        run in HID mode with the given <keyboard> and <mouse> devices\n" \
+    "      --hid-autotype       in HID mode, type out text copied on the server.\n" \
+    "      --hid-sink <type>    where HID reports go:  * gadget devices, gadget\n" \
+    "                             devices through io_uring (uring), named pipes\n" \
+    "                             or UNIX sockets (pipe), or nowhere but a\n" \
+    "                             report count (memory).\n"
 #else
 #  define WINAPI_ARG
 #  define WINAPI_INFO
@@ -185,6 +191,8 @@ ClientApp::createScreen()
                 args().m_mouseAbsDevice,
                 args().m_screenWidth, args().m_screenHeight,
                 args().m_screenX, args().m_screenY,
+                args().m_hidAutoType,
+                args().m_hidSink,
                 m_events), m_events);
         //m_bye(kExitArgs);
     }
@@ -462,7 +470,8 @@ ClientApp::mainLoop()
 {
     // create socket multiplexer.  this must happen after daemonization
     // on unix because threads evaporate across a fork().
-    SocketMultiplexer multiplexer;
+    SocketMultiplexer multiplexer(args().m_multiplexer == "epoll" ?
+                            SocketMultiplexer::kEpoll : SocketMultiplexer::kPoll);
     setSocketMultiplexer(&multiplexer);
 
     // start client, etc
@@ -0,0 +1,265 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/CompactInput.h"
+
+#include <cassert>
+
+//
+// CompactInputWriter
+//
+
+const UInt32 CompactInputWriter::kMaxSize;
+
+CompactInputWriter::CompactInputWriter() :
+    m_size(kCompactHeaderSize),
+    m_x(0),
+    m_y(0)
+{
+    m_frame[0] = kCompactFrame;
+    m_frame[1] = 0;
+}
+
+void
+CompactInputWriter::setPosition(SInt32 x, SInt32 y)
+{
+    m_x = x;
+    m_y = y;
+}
+
+void
+CompactInputWriter::add(const CompactInput& input)
+{
+    assert(hasRoom());
+    assert(input.m_op > kCompactNone && input.m_op < kCompactLast);
+
+    m_frame[m_size++] = static_cast<UInt8>(input.m_op);
+    switch (input.m_op) {
+    case kCompactMouseMove:
+        putSigned(input.m_x - m_x);
+        putSigned(input.m_y - m_y);
+        m_x = input.m_x;
+        m_y = input.m_y;
+        break;
+
+    case kCompactMouseRelMove:
+    case kCompactMouseWheel:
+        putSigned(input.m_x);
+        putSigned(input.m_y);
+        break;
+
+    case kCompactMouseDown:
+    case kCompactMouseUp:
+        putUnsigned(input.m_id);
+        break;
+
+    case kCompactKeyDown:
+    case kCompactKeyUp:
+        putUnsigned(input.m_id);
+        putUnsigned(input.m_mask);
+        putUnsigned(input.m_button);
+        break;
+
+    case kCompactKeyRepeat:
+        putUnsigned(input.m_id);
+        putUnsigned(input.m_mask);
+        putUnsigned(input.m_count);
+        putUnsigned(input.m_button);
+        break;
+
+    default:
+        break;
+    }
+
+    m_frame[1] = static_cast<UInt8>(m_size - kCompactHeaderSize);
+}
+
+void
+CompactInputWriter::clear()
+{
+    m_size     = kCompactHeaderSize;
+    m_frame[1] = 0;
+}
+
+bool
+CompactInputWriter::hasRoom() const
+{
+    return (m_size + kMaxEventSize <= kMaxSize);
+}
+
+bool
+CompactInputWriter::isEmpty() const
+{
+    return (m_size == kCompactHeaderSize);
+}
+
+const UInt8*
+CompactInputWriter::getData() const
+{
+    return m_frame;
+}
+
+UInt32
+CompactInputWriter::getSize() const
+{
+    return m_size;
+}
+
+void
+CompactInputWriter::putUnsigned(UInt32 value)
+{
+    while (value >= 0x80) {
+        m_frame[m_size++] = static_cast<UInt8>(value | 0x80);
+        value >>= 7;
+    }
+    m_frame[m_size++] = static_cast<UInt8>(value);
+}
+
+void
+CompactInputWriter::putSigned(SInt32 value)
+{
+    // zig-zag so small negative values are small too
+    putUnsigned((static_cast<UInt32>(value) << 1) ^
+                            static_cast<UInt32>(value >> 31));
+}
+
+
+//
+// CompactInputReader
+//
+
+CompactInputReader::CompactInputReader() :
+    m_next(nullptr),
+    m_end(nullptr),
+    m_x(0),
+    m_y(0)
+{
+    // do nothing
+}
+
+void
+CompactInputReader::setPosition(SInt32 x, SInt32 y)
+{
+    m_x = x;
+    m_y = y;
+}
+
+void
+CompactInputReader::setFrame(const UInt8* frame, UInt32 size)
+{
+    m_next = frame;
+    m_end  = frame + size;
+}
+
+bool
+CompactInputReader::next(CompactInput& input)
+{
+    if (m_next == m_end) {
+        input.m_op = kCompactNone;
+        return false;
+    }
+
+    bool okay = true;
+    input.m_op = static_cast<ECompactOp>(*m_next++);
+    switch (input.m_op) {
+    case kCompactMouseMove: {
+        SInt32 dx = 0, dy = 0;
+        okay = getSigned(dx) && getSigned(dy);
+        m_x += dx;
+        m_y += dy;
+        input.m_x = m_x;
+        input.m_y = m_y;
+        break;
+    }
+
+    case kCompactMouseRelMove:
+    case kCompactMouseWheel:
+        okay = getSigned(input.m_x) && getSigned(input.m_y);
+        break;
+
+    case kCompactMouseDown:
+    case kCompactMouseUp:
+        okay = getUnsigned(input.m_id);
+        break;
+
+    case kCompactKeyDown:
+    case kCompactKeyUp:
+        okay = getUnsigned(input.m_id) &&
+               getUnsigned(input.m_mask) &&
+               getUnsigned(input.m_button);
+        break;
+
+    case kCompactKeyRepeat:
+        okay = getUnsigned(input.m_id) &&
+               getUnsigned(input.m_mask) &&
+               getUnsigned(input.m_count) &&
+               getUnsigned(input.m_button);
+        break;
+
+    default:
+        okay = false;
+        break;
+    }
+
+    if (!okay) {
+        input.m_op = kCompactLast;
+        m_next     = m_end;
+    }
+    return okay;
+}
+
+bool
+CompactInputReader::hasMore() const
+{
+    return (m_next != m_end);
+}
+
+bool
+CompactInputReader::isFrame(UInt8 byte)
+{
+    return (byte == kCompactFrame);
+}
+
+UInt32
+CompactInputReader::getFrameSize(const UInt8* header)
+{
+    return header[1];
+}
+
+bool
+CompactInputReader::getUnsigned(UInt32& value)
+{
+    value = 0;
+    for (UInt32 shift = 0; shift < 35 && m_next != m_end; shift += 7) {
+        UInt8 byte = *m_next++;
+        value |= static_cast<UInt32>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+CompactInputReader::getSigned(SInt32& value)
+{
+    UInt32 zigzag;
+    if (!getUnsigned(zigzag)) {
+        return false;
+    }
+    value = static_cast<SInt32>((zigzag >> 1) ^ (0u - (zigzag & 1)));
+    return true;
+}
@@ -0,0 +1,191 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/basic_types.h"
+
+//! Compact input frame header
+/*!
+Protocol 1.7 sends input as compact frames instead of one message per
+event.  A frame is kCompactFrame, the size of the rest of the frame in
+one byte and then one or more events.  kCompactFrame isn't printable so
+a frame can't be mistaken for a message.
+*/
+static const UInt8      kCompactFrame = 0x01;
+static const UInt32     kCompactHeaderSize = 2;
+
+//! Compact input opcodes
+/*!
+Each event in a compact frame is a 1 byte opcode and then its arguments
+as varints, signed ones zig-zag encoded.  Absolute moves are sent as the
+change from the previous position, which is where the last enter or
+absolute move left the pointer.
+*/
+enum ECompactOp {
+    kCompactNone,
+    kCompactMouseMove,      //!< x, y change
+    kCompactMouseRelMove,   //!< x, y change
+    kCompactMouseDown,      //!< button
+    kCompactMouseUp,        //!< button
+    kCompactMouseWheel,     //!< x, y delta
+    kCompactKeyDown,        //!< key, modifiers, button
+    kCompactKeyRepeat,      //!< key, modifiers, count, button
+    kCompactKeyUp,          //!< key, modifiers, button
+    kCompactLast
+};
+
+//! A compact input event
+struct CompactInput {
+public:
+    ECompactOp          m_op;
+
+    //! Position, relative move or wheel delta
+    SInt32              m_x, m_y;
+
+    //! Key or button
+    UInt32              m_id;
+    UInt32              m_mask;
+    UInt32              m_count;
+    UInt32              m_button;
+};
+
+//! Compact input frame writer
+/*!
+Packs input events into a frame.  The writer remembers the position of
+the last absolute move across frames;  the reader on the other end
+must be told the same positions with setPosition().
+*/
+class CompactInputWriter {
+public:
+    //! Largest frame, including the header
+    static const UInt32 kMaxSize = kCompactHeaderSize + 255;
+
+    CompactInputWriter();
+
+    //! @name manipulators
+    //@{
+
+    //! Set the position
+    /*!
+    Sets the position the next absolute move is relative to.
+    */
+    void                setPosition(SInt32 x, SInt32 y);
+
+    //! Add an event
+    /*!
+    Appends \c input to the frame.  The frame must have room.
+    */
+    void                add(const CompactInput& input);
+
+    //! Empty the frame
+    void                clear();
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Test if another event fits
+    bool                hasRoom() const;
+
+    //! Test if the frame is empty
+    bool                isEmpty() const;
+
+    //! Get the frame
+    /*!
+    Returns the frame, including the header.
+    */
+    const UInt8*        getData() const;
+
+    //! Get the frame size, including the header
+    UInt32              getSize() const;
+
+    //@}
+
+private:
+    void                putUnsigned(UInt32);
+    void                putSigned(SInt32);
+
+private:
+    // opcode and up to four 5 byte varints
+    static const UInt32 kMaxEventSize = 21;
+
+    UInt8               m_frame[kMaxSize];
+    UInt32              m_size;
+    SInt32              m_x, m_y;
+};
+
+//! Compact input frame reader
+class CompactInputReader {
+public:
+    CompactInputReader();
+
+    //! @name manipulators
+    //@{
+
+    //! Set the position
+    /*!
+    Sets the position the next absolute move is relative to.
+    */
+    void                setPosition(SInt32 x, SInt32 y);
+
+    //! Start a frame
+    /*!
+    Reads events from the \c size bytes at \c frame, which follow the
+    header and must stay valid until they've all been read.
+    */
+    void                setFrame(const UInt8* frame, UInt32 size);
+
+    //! Read an event
+    /*!
+    Reads the next event of the frame into \c input, with absolute
+    moves resolved to positions.  Returns false at the end of the frame
+    or, with \c input.m_op set to kCompactLast, if the frame is
+    malformed.
+    */
+    bool                next(CompactInput& input);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Test if more events follow
+    bool                hasMore() const;
+
+    //! Test for a frame
+    /*!
+    Returns true if data starting with \c byte is a compact frame rather
+    than a message.
+    */
+    static bool         isFrame(UInt8 byte);
+
+    //! Get the frame size
+    /*!
+    Returns the size of the events in the frame with \c header.
+    */
+    static UInt32       getFrameSize(const UInt8* header);
+
+    //@}
+
+private:
+    bool                getUnsigned(UInt32&);
+    bool                getSigned(SInt32&);
+
+private:
+    const UInt8*        m_next;
+    const UInt8*        m_end;
+    SInt32              m_x, m_y;
+};
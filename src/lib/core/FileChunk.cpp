@@ -77,7 +77,7 @@ FileChunk::assemble(synergy::IStream* stream, String& dataReceived, size_t& expe
     static double elapsedTime;
     static Stopwatch stopwatch;
 
-    if (!ProtocolUtil::readf(stream, kMsgDFileTransfer + 4, &mark, &content)) {
+    if (!ProtocolUtil::read<MsgDFileTransfer>(stream, mark, content)) {
         return kError;
     }
 
@@ -152,5 +152,5 @@ FileChunk::send(synergy::IStream* stream, UInt8 mark, char* data, size_t dataSiz
         break;
     }
 
-    ProtocolUtil::writef(stream, kMsgDFileTransfer, mark, &chunk);
+    ProtocolUtil::writeBulk<MsgDFileTransfer>(stream, mark, chunk);
 }
@@ -17,11 +17,16 @@
  */
 
 #include "core/IKeyState.h"
+#include "base/EventDataPool.h"
 #include "base/EventQueue.h"
 
-#include <cstdlib>
 #include <cstring>
 
+// blocks have room for a short list of destination screens;  longer
+// lists come from malloc()
+static TypedEventDataPool<IKeyState::KeyInfo>
+                        s_keyInfoPool("KeyInfo", 32, 256);
+
 //
 // IKeyState
 //
@@ -38,7 +43,7 @@ IKeyState::KeyInfo*
 IKeyState::KeyInfo::alloc(KeyID id,
                 KeyModifierMask mask, KeyButton button, SInt32 count)
 {
-    auto* info           = static_cast<KeyInfo*>(malloc(sizeof(KeyInfo)));
+    auto* info           = s_keyInfoPool.alloc();
     info->m_key              = id;
     info->m_mask             = mask;
     info->m_button           = button;
@@ -56,7 +61,7 @@ IKeyState::KeyInfo::alloc(KeyID id,
     String screens = join(destinations);
 
     // build structure
-    auto* info  = static_cast<KeyInfo*>(malloc(sizeof(KeyInfo) + screens.size()));
+    auto* info  = s_keyInfoPool.alloc(static_cast<UInt32>(screens.size()));
     info->m_key     = id;
     info->m_mask    = mask;
     info->m_button  = button;
@@ -69,8 +74,8 @@ IKeyState::KeyInfo::alloc(KeyID id,
 IKeyState::KeyInfo*
 IKeyState::KeyInfo::alloc(const KeyInfo& x)
 {
-    auto* info  = static_cast<KeyInfo*>(malloc(sizeof(KeyInfo) +
-                                        strlen(x.m_screensBuffer)));
+    auto* info  = s_keyInfoPool.alloc(
+                            static_cast<UInt32>(strlen(x.m_screensBuffer)));
     info->m_key     = x.m_key;
     info->m_mask    = x.m_mask;
     info->m_button  = x.m_button;
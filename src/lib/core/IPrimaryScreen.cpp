@@ -17,9 +17,17 @@
  */
 
 #include "core/IPrimaryScreen.h"
+#include "base/EventDataPool.h"
 #include "base/EventQueue.h"
 
-#include <cstdlib>
+static TypedEventDataPool<IPrimaryScreen::ButtonInfo>
+                        s_buttonInfoPool("ButtonInfo", 0, 256);
+static TypedEventDataPool<IPrimaryScreen::MotionInfo>
+                        s_motionInfoPool("MotionInfo");
+static TypedEventDataPool<IPrimaryScreen::WheelInfo>
+                        s_wheelInfoPool("WheelInfo", 0, 256);
+static TypedEventDataPool<IPrimaryScreen::HotKeyInfo>
+                        s_hotKeyInfoPool("HotKeyInfo", 0, 64);
 
 //
 // IPrimaryScreen::ButtonInfo
@@ -28,7 +36,7 @@
 IPrimaryScreen::ButtonInfo*
 IPrimaryScreen::ButtonInfo::alloc(ButtonID id, KeyModifierMask mask)
 {
-    auto* info = static_cast<ButtonInfo*>(malloc(sizeof(ButtonInfo)));
+    auto* info = s_buttonInfoPool.alloc();
     info->m_button = id;
     info->m_mask   = mask;
     return info;
@@ -37,7 +45,7 @@ IPrimaryScreen::ButtonInfo::alloc(ButtonID id, KeyModifierMask mask)
 IPrimaryScreen::ButtonInfo*
 IPrimaryScreen::ButtonInfo::alloc(const ButtonInfo& x)
 {
-    auto* info = static_cast<ButtonInfo*>(malloc(sizeof(ButtonInfo)));
+    auto* info = s_buttonInfoPool.alloc();
     info->m_button = x.m_button;
     info->m_mask   = x.m_mask;
     return info;
@@ -57,12 +65,28 @@ IPrimaryScreen::ButtonInfo::equal(const ButtonInfo* a, const ButtonInfo* b)
 IPrimaryScreen::MotionInfo*
 IPrimaryScreen::MotionInfo::alloc(SInt32 x, SInt32 y)
 {
-    auto* info = static_cast<MotionInfo*>(malloc(sizeof(MotionInfo)));
+    auto* info = s_motionInfoPool.alloc();
     info->m_x = x;
     info->m_y = y;
     return info;
 }
 
+Event
+IPrimaryScreen::MotionInfo::makeEvent(Event::Type type, void* target,
+                SInt32 x, SInt32 y)
+{
+    static_assert(sizeof(MotionInfo) <= Event::kInlineDataSize,
+                            "MotionInfo doesn't fit in an event");
+
+    MotionInfo info;
+    info.m_x = x;
+    info.m_y = y;
+
+    Event event(type, target);
+    event.setInlineData(&info, sizeof(info));
+    return event;
+}
+
 
 //
 // IPrimaryScreen::WheelInfo
@@ -71,12 +95,28 @@ IPrimaryScreen::MotionInfo::alloc(SInt32 x, SInt32 y)
 IPrimaryScreen::WheelInfo*
 IPrimaryScreen::WheelInfo::alloc(SInt32 xDelta, SInt32 yDelta)
 {
-    auto* info = static_cast<WheelInfo*>(malloc(sizeof(WheelInfo)));
+    auto* info = s_wheelInfoPool.alloc();
     info->m_xDelta = xDelta;
     info->m_yDelta = yDelta;
     return info;
 }
 
+Event
+IPrimaryScreen::WheelInfo::makeEvent(Event::Type type, void* target,
+                SInt32 xDelta, SInt32 yDelta)
+{
+    static_assert(sizeof(WheelInfo) <= Event::kInlineDataSize,
+                            "WheelInfo doesn't fit in an event");
+
+    WheelInfo info;
+    info.m_xDelta = xDelta;
+    info.m_yDelta = yDelta;
+
+    Event event(type, target);
+    event.setInlineData(&info, sizeof(info));
+    return event;
+}
+
 
 //
 // IPrimaryScreen::HotKeyInfo
@@ -85,7 +125,7 @@ IPrimaryScreen::WheelInfo::alloc(SInt32 xDelta, SInt32 yDelta)
 IPrimaryScreen::HotKeyInfo*
 IPrimaryScreen::HotKeyInfo::alloc(UInt32 id)
 {
-    auto* info = static_cast<HotKeyInfo*>(malloc(sizeof(HotKeyInfo)));
+    auto* info = s_hotKeyInfoPool.alloc();
     info->m_id = id;
     return info;
 }
@@ -48,6 +48,10 @@ public:
     public:
         static MotionInfo* alloc(SInt32 x, SInt32 y);
 
+        //! Create a motion event that carries its data inline
+        static Event    makeEvent(Event::Type, void* target,
+                            SInt32 x, SInt32 y);
+
     public:
         SInt32            m_x;
         SInt32            m_y;
@@ -57,6 +61,10 @@ public:
     public:
         static WheelInfo* alloc(SInt32 xDelta, SInt32 yDelta);
 
+        //! Create a wheel event that carries its data inline
+        static Event    makeEvent(Event::Type, void* target,
+                            SInt32 xDelta, SInt32 yDelta);
+
     public:
         SInt32            m_xDelta;
         SInt32            m_yDelta;
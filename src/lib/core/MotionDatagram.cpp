@@ -0,0 +1,76 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/MotionDatagram.h"
+
+#include "core/ProtocolLayout.h"
+
+static const UInt32 kHelloSize = 5;
+
+const UInt32 MotionDatagram::kMaxSize;
+
+//
+// MotionDatagram
+//
+
+MotionDatagram::MotionDatagram() :
+    m_type(kHello),
+    m_token(0),
+    m_seq(0),
+    m_x(0),
+    m_y(0)
+{
+    // do nothing
+}
+
+bool
+MotionDatagram::decode(const UInt8* buffer, UInt32 size)
+{
+    if (size == kHelloSize && buffer[0] == kHello) {
+        m_type  = kHello;
+        m_token = ProtocolField<UInt32>::get(buffer + 1);
+        return true;
+    }
+    if (size == kMaxSize && buffer[0] == kMove) {
+        m_type  = kMove;
+        m_token = ProtocolField<UInt32>::get(buffer + 1);
+        m_seq   = ProtocolField<UInt32>::get(buffer + 5);
+        m_x     = static_cast<SInt16>(ProtocolField<SInt16>::get(buffer + 9));
+        m_y     = static_cast<SInt16>(ProtocolField<SInt16>::get(buffer + 11));
+        return true;
+    }
+    return false;
+}
+
+UInt32
+MotionDatagram::encode(UInt8* buffer) const
+{
+    buffer[0] = static_cast<UInt8>(m_type);
+    ProtocolField<UInt32>::put(buffer + 1, m_token);
+    if (m_type == kHello) {
+        return kHelloSize;
+    }
+    ProtocolField<UInt32>::put(buffer + 5, m_seq);
+    ProtocolField<SInt16>::put(buffer + 9, static_cast<UInt16>(m_x));
+    ProtocolField<SInt16>::put(buffer + 11, static_cast<UInt16>(m_y));
+    return kMaxSize;
+}
+
+bool
+MotionDatagram::isNewer(UInt32 seq, UInt32 last)
+{
+    return static_cast<SInt32>(seq - last) > 0;
+}
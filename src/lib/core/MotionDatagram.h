@@ -0,0 +1,77 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/basic_types.h"
+
+//! Pointer motion datagram
+/*!
+A datagram of the motion channel offered with kOptionMotionChannel.
+The secondary screen sends kHello datagrams with the channel's token so
+the primary learns where to send motion, then the primary sends each
+absolute motion as a kMove.  Moves carry a sequence number and only the
+newest matters, so a lost or late datagram is simply skipped.
+*/
+class MotionDatagram {
+public:
+    enum EType {
+        kHello = 'H',       //!< Secondary to primary, no motion
+        kMove  = 'M'        //!< Primary to secondary, absolute motion
+    };
+
+    //! Largest encoded datagram
+    static const UInt32 kMaxSize = 13;
+
+    MotionDatagram();
+
+    //! @name manipulators
+    //@{
+
+    //! Decode a datagram
+    /*!
+    Returns false, leaving the fields unspecified, if \c size bytes of
+    \c buffer aren't a motion datagram.
+    */
+    bool                decode(const UInt8* buffer, UInt32 size);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Encode the datagram
+    /*!
+    Encodes into \c buffer, which must hold kMaxSize bytes, and returns
+    the size.
+    */
+    UInt32              encode(UInt8* buffer) const;
+
+    //! Compare sequence numbers
+    /*!
+    Returns true if \c seq was sent after \c last, allowing for the
+    sequence number wrapping.
+    */
+    static bool         isNewer(UInt32 seq, UInt32 last);
+
+    //@}
+
+public:
+    EType               m_type;
+    UInt32              m_token;
+    UInt32              m_seq;
+    SInt16              m_x;
+    SInt16              m_y;
+};
@@ -20,6 +20,7 @@
 #include "base/IEventQueue.h"
 #include "base/TMethodEventJob.h"
 #include "mt/Lock.h"
+#include "common/stdvector.h"
 
 #include <cstring>
 #include <memory>
@@ -92,16 +93,55 @@ PacketStreamFilter::read(void* buffer, UInt32 n)
 void
 PacketStreamFilter::write(const void* buffer, UInt32 count)
 {
-    // write the length of the payload
+    Buffer payload = { buffer, count };
+    writeBuffers(&payload, 1);
+}
+
+void
+PacketStreamFilter::writeBuffers(const Buffer* buffers, UInt32 count)
+{
+    writePacket(buffers, count, false);
+}
+
+void
+PacketStreamFilter::writeBulk(const Buffer* buffers, UInt32 count)
+{
+    writePacket(buffers, count, true);
+}
+
+void
+PacketStreamFilter::writePacket(const Buffer* buffers, UInt32 count, bool bulk)
+{
+    // the length prefix goes out with the payload in a single write to
+    // the underlying stream
+    Buffer fixed[kStackBuffers + 1];
+    std::vector<Buffer> variable;
+    Buffer* packet = fixed;
+    if (count > kStackBuffers) {
+        variable.resize(count + 1);
+        packet = &variable[0];
+    }
+
+    UInt32 size = 0;
+    for (UInt32 i = 0; i < count; ++i) {
+        packet[i + 1] = buffers[i];
+        size         += buffers[i].m_size;
+    }
+
     UInt8 length[4];
-    length[0] = static_cast<UInt8>((count >> 24) & 0xff);
-    length[1] = static_cast<UInt8>((count >> 16) & 0xff);
-    length[2] = static_cast<UInt8>((count >>  8) & 0xff);
-    length[3] = static_cast<UInt8>( count        & 0xff);
-    getStream()->write(length, sizeof(length));
-
-    // write the payload
-    getStream()->write(buffer, count);
+    length[0] = static_cast<UInt8>((size >> 24) & 0xff);
+    length[1] = static_cast<UInt8>((size >> 16) & 0xff);
+    length[2] = static_cast<UInt8>((size >>  8) & 0xff);
+    length[3] = static_cast<UInt8>( size        & 0xff);
+    packet[0].m_data = length;
+    packet[0].m_size = sizeof(length);
+
+    if (bulk) {
+        getStream()->writeBulk(packet, count + 1);
+    }
+    else {
+        getStream()->writeBuffers(packet, count + 1);
+    }
 }
 
 void
@@ -155,13 +195,13 @@ PacketStreamFilter::readMore()
     // note if we have whole packet
     bool wasReady = isReadyNoLock();
 
-    // read more data
-    char buffer[4096];
-    UInt32 n = getStream()->read(buffer, sizeof(buffer));
-    while (n > 0) {
-        m_buffer.write(buffer, n);
-        n = getStream()->read(buffer, sizeof(buffer));
-    }
+    // read more data straight into the buffer
+    UInt32 n;
+    do {
+        void* buffer = m_buffer.reserve(kReadSize);
+        n = getStream()->read(buffer, kReadSize);
+        m_buffer.commit(n);
+    } while (n > 0);
 
     // if we don't yet have the next packet size then get it,
     // if possible.
@@ -37,6 +37,8 @@ public:
     virtual void        close();
     virtual UInt32        read(void* buffer, UInt32 n);
     virtual void        write(const void* buffer, UInt32 count);
+    virtual void        writeBuffers(const Buffer* buffers, UInt32 count);
+    virtual void        writeBulk(const Buffer* buffers, UInt32 count);
     virtual void        shutdownInput();
     virtual bool        isReady() const;
     virtual UInt32        getSize() const;
@@ -49,8 +51,16 @@ private:
     bool                isReadyNoLock() const;
     void                readPacketSize();
     bool                readMore();
+    void                writePacket(const Buffer* buffers, UInt32 count,
+                            bool bulk);
 
 private:
+    // bytes to make room for before each read from the stream
+    static const UInt32    kReadSize = 4096;
+
+    // most buffers in a packet framed without allocating
+    static const UInt32    kStackBuffers = 8;
+
     Mutex                m_mutex;
     UInt32                m_size;
     StreamBuffer        m_buffer;
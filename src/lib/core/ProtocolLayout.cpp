@@ -0,0 +1,69 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/ProtocolLayout.h"
+#include "base/Log.h"
+#include "io/IStream.h"
+#include "io/XIO.h"
+
+//
+// ProtocolReader
+//
+
+ProtocolReader::ProtocolReader(synergy::IStream* stream) :
+    m_stream(stream),
+    m_next(m_buffer),
+    m_end(m_buffer)
+{
+    assert(m_stream != NULL);
+}
+
+void
+ProtocolReader::fill(UInt32 n)
+{
+    assert(n <= kBufferSize);
+    read(m_buffer, n);
+    m_next = m_buffer;
+    m_end  = m_buffer + n;
+}
+
+UInt32
+ProtocolReader::readLength()
+{
+    UInt8 buffer[4];
+    read(buffer, sizeof(buffer));
+    return ProtocolField<UInt32>::get(buffer);
+}
+
+void
+ProtocolReader::read(void* vbuffer, UInt32 count)
+{
+    auto* buffer = static_cast<UInt8*>(vbuffer);
+    while (count > 0) {
+        // read more
+        UInt32 n = m_stream->read(buffer, count);
+
+        // bail if stream has hungup
+        if (n == 0) {
+            LOG((CLOG_DEBUG2 "unexpected disconnect in read, %d bytes left", count));
+            throw XIOEndOfStream();
+        }
+
+        // prepare for next read
+        buffer += n;
+        count  -= n;
+    }
+}
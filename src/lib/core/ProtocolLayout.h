@@ -0,0 +1,347 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/String.h"
+#include "common/basic_types.h"
+#include "common/stdvector.h"
+
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+namespace synergy { class IStream; }
+
+//! Message code
+/*!
+The literal bytes a message starts with, normally 4 characters.
+*/
+template <char... C>
+class ProtocolCode {
+public:
+    static const UInt32 kSize = sizeof...(C);
+
+    //! The code as a NUL terminated string
+    static constexpr char s_code[] = { C..., '\0' };
+};
+
+template <char... C>
+constexpr char ProtocolCode<C...>::s_code[];
+
+//! Reads the parameters of a message
+/*!
+Used by ProtocolLayout to decode.  The fixed size fields up to the
+next variable length field are read from the stream in one go with
+fill() and then handed out by take();  variable length fields are read
+straight into their destination.  Throws XIO on a short read.
+*/
+class ProtocolReader {
+public:
+    //! Largest run of fixed size fields
+    static const UInt32 kBufferSize = 64;
+
+    ProtocolReader(synergy::IStream*);
+
+    //! Read \c n bytes of fixed size fields
+    void                fill(UInt32 n);
+
+    //! Take the next \c n bytes read by fill()
+    const UInt8*        take(UInt32 n);
+
+    //! Read a 4 byte length
+    UInt32              readLength();
+
+    //! Read \c n bytes of a variable length field
+    void                read(void* buffer, UInt32 n);
+
+private:
+    synergy::IStream*   m_stream;
+    const UInt8*        m_next;
+    const UInt8*        m_end;
+    UInt8               m_buffer[kBufferSize];
+};
+
+inline
+const UInt8*
+ProtocolReader::take(UInt32 n)
+{
+    assert(n <= static_cast<UInt32>(m_end - m_next));
+    const UInt8* data = m_next;
+    m_next += n;
+    return data;
+}
+
+//! Wire encoding of a message field
+/*!
+Integral types are sent as that many bytes in network byte order.
+std::vector of UInt8, UInt16 or UInt32 is sent as a 4 byte count and
+then the elements.  String is sent as a 4 byte length and then the
+bytes.
+*/
+template <class T, class Enable = void>
+class ProtocolField;
+
+template <class T>
+class ProtocolField<T,
+        typename std::enable_if<std::is_integral<T>::value>::type> {
+public:
+    static const bool   kFixed = true;
+    static const UInt32 kSize  = sizeof(T);
+
+    template <class A>
+    static UInt32       getSize(const A&) { return kSize; }
+
+    template <class A>
+    static void         encode(UInt8*& dst, const A& value)
+    {
+        put(dst, static_cast<UInt32>(value));
+        dst += kSize;
+    }
+
+    template <class A>
+    static void         decode(ProtocolReader& reader, A& value)
+    {
+        static_assert(sizeof(A) >= kSize, "field doesn't fit argument");
+        value = static_cast<A>(static_cast<T>(get(reader.take(kSize))));
+    }
+
+    static void         put(UInt8* dst, UInt32 value)
+    {
+        for (UInt32 i = 0; i < kSize; ++i) {
+            dst[i] = static_cast<UInt8>(value >> (8 * (kSize - 1 - i)));
+        }
+    }
+
+    static UInt32       get(const UInt8* src)
+    {
+        UInt32 value = 0;
+        for (UInt32 i = 0; i < kSize; ++i) {
+            value = (value << 8) | src[i];
+        }
+        return value;
+    }
+};
+
+template <class E>
+class ProtocolField<std::vector<E> > {
+public:
+    static_assert(std::is_unsigned<E>::value && sizeof(E) <= 4,
+                            "unsupported vector element");
+    typedef ProtocolField<E> Element;
+
+    static const bool   kFixed = false;
+    static const UInt32 kSize  = 4;
+
+    static UInt32       getSize(const std::vector<E>& value)
+    {
+        return kSize + static_cast<UInt32>(value.size() * sizeof(E));
+    }
+
+    static void         encode(UInt8*& dst, const std::vector<E>& value)
+    {
+        const UInt32 n = static_cast<UInt32>(value.size());
+        ProtocolField<UInt32>::put(dst, n);
+        dst += kSize;
+        if (sizeof(E) == 1) {
+            if (n != 0) {
+                memcpy(dst, &value[0], n);
+            }
+            dst += n;
+            return;
+        }
+        for (UInt32 i = 0; i < n; ++i) {
+            Element::put(dst, value[i]);
+            dst += sizeof(E);
+        }
+    }
+
+    static void         decode(ProtocolReader& reader, std::vector<E>& value)
+    {
+        // read in bounded steps so a bogus count can't make us allocate
+        // more than the stream actually holds
+        const UInt32 n = reader.readLength();
+        value.clear();
+        for (UInt32 done = 0; done < n; ) {
+            UInt32 count = n - done;
+            if (count > kStep) {
+                count = kStep;
+            }
+            value.resize(done + count);
+            reader.read(&value[done], count * sizeof(E));
+            done += count;
+        }
+
+        // elements arrive in network byte order
+        if (sizeof(E) > 1) {
+            for (UInt32 i = 0; i < n; ++i) {
+                value[i] = static_cast<E>(Element::get(
+                                reinterpret_cast<const UInt8*>(&value[i])));
+            }
+        }
+    }
+
+private:
+    static const UInt32 kStep = 65536 / sizeof(E);
+};
+
+template <>
+class ProtocolField<String> {
+public:
+    static const bool   kFixed = false;
+    static const UInt32 kSize  = 4;
+
+    static UInt32       getSize(const String& value)
+    {
+        return kSize + static_cast<UInt32>(value.size());
+    }
+
+    static void         encode(UInt8*& dst, const String& value)
+    {
+        const UInt32 n = static_cast<UInt32>(value.size());
+        ProtocolField<UInt32>::put(dst, n);
+        dst += kSize;
+        if (n != 0) {
+            memcpy(dst, value.data(), n);
+        }
+        dst += n;
+    }
+
+    static void         decode(ProtocolReader& reader, String& value)
+    {
+        const UInt32 n = reader.readLength();
+        value.clear();
+        for (UInt32 done = 0; done < n; ) {
+            UInt32 count = n - done;
+            if (count > kStep) {
+                count = kStep;
+            }
+            value.resize(done + count);
+            reader.read(&value[done], count);
+            done += count;
+        }
+    }
+
+private:
+    static const UInt32 kStep = 65536;
+};
+
+//! The fields of a message
+/*!
+kFixedSize is the size of all fields not counting the contents of
+variable length fields and kLeadSize is the size of the fixed size
+fields before the first variable length one.
+*/
+template <class... Fields>
+class ProtocolFields;
+
+template <>
+class ProtocolFields<> {
+public:
+    static const bool   kFixed     = true;
+    static const UInt32 kFixedSize = 0;
+    static const UInt32 kLeadSize  = 0;
+
+    static UInt32       getSize() { return 0; }
+    static void         encode(UInt8*&) { }
+    static void         decode(ProtocolReader&) { }
+};
+
+template <class F, class... Rest>
+class ProtocolFields<F, Rest...> {
+public:
+    typedef ProtocolField<F> Field;
+    typedef ProtocolFields<Rest...> Next;
+
+    static const bool   kFixed     = Field::kFixed && Next::kFixed;
+    static const UInt32 kFixedSize = Field::kSize + Next::kFixedSize;
+    static const UInt32 kLeadSize  =
+                            Field::kFixed ? Field::kSize + Next::kLeadSize : 0;
+
+    template <class A, class... As>
+    static UInt32       getSize(const A& arg, const As&... args)
+    {
+        return Field::getSize(arg) + Next::getSize(args...);
+    }
+
+    template <class A, class... As>
+    static void         encode(UInt8*& dst, const A& arg, const As&... args)
+    {
+        Field::encode(dst, arg);
+        Next::encode(dst, args...);
+    }
+
+    template <class A, class... As>
+    static void         decode(ProtocolReader& reader, A& arg, As&... args)
+    {
+        Field::decode(reader, arg);
+        if (!Field::kFixed) {
+            reader.fill(Next::kLeadSize);
+        }
+        Next::decode(reader, args...);
+    }
+};
+
+//! Message layout
+/*!
+Describes a message as its code followed by its fields, each given
+as the C++ type it's encoded from (see ProtocolField), so the encoder
+and decoder are generated at compile time.  For example:
+
+\code
+typedef ProtocolLayout<ProtocolCode<'D','M','M','V'>,
+                       SInt16, SInt16> MsgDMouseMove;
+\endcode
+
+Use with ProtocolUtil::write() and ProtocolUtil::read().
+*/
+template <class C, class... Fields>
+class ProtocolLayout {
+public:
+    typedef C Code;
+    typedef ProtocolFields<Fields...> Params;
+
+    //! Number of fields
+    static const UInt32 kNumFields = sizeof...(Fields);
+
+    //! True if the message has no variable length fields
+    static const bool   kFixed     = Params::kFixed;
+
+    //! Size of the message without variable length contents
+    static const UInt32 kFixedSize = Code::kSize + Params::kFixedSize;
+
+    static_assert(Code::kSize + Params::kLeadSize <= ProtocolReader::kBufferSize,
+                            "message too large");
+
+    //! Get the size of the encoded message
+    template <class... Args>
+    static UInt32       getSize(const Args&... args)
+    {
+        return Code::kSize + Params::getSize(args...);
+    }
+
+    //! Encode the message
+    /*!
+    \c buffer must hold getSize() bytes.
+    */
+    template <class... Args>
+    static void         encode(UInt8* buffer, const Args&... args)
+    {
+        memcpy(buffer, Code::s_code, Code::kSize);
+        buffer += Code::kSize;
+        Params::encode(buffer, args...);
+    }
+};
@@ -18,517 +18,174 @@
 
 #include "core/ProtocolUtil.h"
 #include "base/Log.h"
-#include "common/stdvector.h"
 #include "io/IStream.h"
 
-#include <cctype>
 #include <cstring>
-
-//
-// ProtocolUtil
-//
-
-void
-ProtocolUtil::writef(synergy::IStream* stream, const char* fmt, ...)
+#include <sstream>
+
+namespace {
+
+struct MessageCode {
+    const char*         m_code;
+    EMessageID          m_id;
+};
+
+// every message with a 4 byte code.  the 1.0 versions of the key and
+// wheel messages reuse the codes of their successors.
+constexpr MessageCode s_messageCodes[] = {
+    { MsgCNoop::Code::s_code,           kMsgIDCNoop },
+    { MsgCClose::Code::s_code,          kMsgIDCClose },
+    { MsgCEnter::Code::s_code,          kMsgIDCEnter },
+    { MsgCLeave::Code::s_code,          kMsgIDCLeave },
+    { MsgCClipboard::Code::s_code,      kMsgIDCClipboard },
+    { MsgCScreenSaver::Code::s_code,    kMsgIDCScreenSaver },
+    { MsgCResetOptions::Code::s_code,   kMsgIDCResetOptions },
+    { MsgCInfoAck::Code::s_code,        kMsgIDCInfoAck },
+    { MsgCKeepAlive::Code::s_code,      kMsgIDCKeepAlive },
+    { MsgDKeyDown::Code::s_code,        kMsgIDDKeyDown },
+    { MsgDKeyRepeat::Code::s_code,      kMsgIDDKeyRepeat },
+    { MsgDKeyUp::Code::s_code,          kMsgIDDKeyUp },
+    { MsgDMouseDown::Code::s_code,      kMsgIDDMouseDown },
+    { MsgDMouseUp::Code::s_code,        kMsgIDDMouseUp },
+    { MsgDMouseMove::Code::s_code,      kMsgIDDMouseMove },
+    { MsgDMouseRelMove::Code::s_code,   kMsgIDDMouseRelMove },
+    { MsgDMotionSeq::Code::s_code,      kMsgIDDMotionSeq },
+    { MsgDMouseWheel::Code::s_code,     kMsgIDDMouseWheel },
+    { MsgDClipboard::Code::s_code,      kMsgIDDClipboard },
+    { MsgDInfo::Code::s_code,           kMsgIDDInfo },
+    { MsgDSetOptions::Code::s_code,     kMsgIDDSetOptions },
+    { MsgDFileTransfer::Code::s_code,   kMsgIDDFileTransfer },
+    { MsgDDragInfo::Code::s_code,       kMsgIDDDragInfo },
+    { MsgQInfo::Code::s_code,           kMsgIDQInfo },
+    { MsgEIncompatible::Code::s_code,   kMsgIDEIncompatible },
+    { MsgEBusy::Code::s_code,           kMsgIDEBusy },
+    { MsgEUnknown::Code::s_code,        kMsgIDEUnknown },
+    { MsgEBad::Code::s_code,            kMsgIDEBad }
+};
+
+static_assert(sizeof(s_messageCodes) / sizeof(s_messageCodes[0]) ==
+                            kNumMessageIDs - 1, "missing message code");
+
+// open addressed hash of codes to IDs, built at compile time.  it's
+// kept under a quarter full so a lookup almost never probes twice.
+const UInt32 kMessageSlots = 128;
+
+struct MessageTable {
+    UInt32              m_code[kMessageSlots];
+    UInt8               m_id[kMessageSlots];
+};
+
+constexpr UInt32
+toCode(const char* code)
 {
-    assert(stream != NULL);
-    assert(fmt != NULL);
-    LOG((CLOG_DEBUG2 "writef(%s)", fmt));
-
-    va_list args;
-    va_start(args, fmt);
-    UInt32 size = getLength(fmt, args);
-    va_end(args);
-    va_start(args, fmt);
-    vwritef(stream, fmt, size, args);
-    va_end(args);
+    return (static_cast<UInt32>(static_cast<UInt8>(code[0])) << 24) |
+           (static_cast<UInt32>(static_cast<UInt8>(code[1])) << 16) |
+           (static_cast<UInt32>(static_cast<UInt8>(code[2])) <<  8) |
+            static_cast<UInt32>(static_cast<UInt8>(code[3]));
 }
 
-bool
-ProtocolUtil::readf(synergy::IStream* stream, const char* fmt, ...)
+constexpr UInt32
+toSlot(UInt32 code)
 {
-    assert(stream != NULL);
-    assert(fmt != NULL);
-    LOG((CLOG_DEBUG2 "readf(%s)", fmt));
-
-    bool result;
-    va_list args;
-    va_start(args, fmt);
-    try {
-        vreadf(stream, fmt, args);
-        result = true;
-    }
-    catch (XIO&) {
-        result = false;
-    }
-    va_end(args);
-    return result;
+    // fibonacci hashing;  the top 7 bits of the product
+    return (code * 0x9e3779b1u) >> 25;
 }
 
-void
-ProtocolUtil::vwritef(synergy::IStream* stream,
-                const char* fmt, UInt32 size, va_list args)
+constexpr MessageTable
+makeMessageTable()
 {
-    assert(stream != NULL);
-    assert(fmt != NULL);
-
-    // done if nothing to write
-    if (size == 0) {
-        return;
-    }
-
-    // fill buffer
-    auto* buffer = new UInt8[size];
-    writef(buffer, fmt, args);
-
-    try {
-        // write buffer
-        stream->write(buffer, size);
-        LOG((CLOG_DEBUG2 "wrote %d bytes", size));
-
-        delete[] buffer;
-    }
-    catch (XBase&) {
-        delete[] buffer;
-        throw;
+    MessageTable table{};
+    for (const MessageCode& message : s_messageCodes) {
+        UInt32 code = toCode(message.m_code);
+        UInt32 slot = toSlot(code);
+        while (table.m_code[slot] != 0) {
+            slot = (slot + 1) & (kMessageSlots - 1);
+        }
+        table.m_code[slot] = code;
+        table.m_id[slot]   = static_cast<UInt8>(message.m_id);
     }
+    return table;
 }
 
-void
-ProtocolUtil::vreadf(synergy::IStream* stream, const char* fmt, va_list args)
-{
-    assert(stream != NULL);
-    assert(fmt != NULL);
-
-    // begin scanning
-    while (*fmt != 0) {
-        if (*fmt == '%') {
-            // format specifier.  determine argument size.
-            ++fmt;
-            UInt32 len = eatLength(&fmt);
-            switch (*fmt) {
-            case 'i': {
-                // check for valid length
-                assert(len == 1 || len == 2 || len == 4);
-
-                // read the data
-                UInt8 buffer[4];
-                read(stream, buffer, len);
-
-                // convert it
-                void* v = va_arg(args, void*);
-                switch (len) {
-                case 1:
-                    // 1 byte integer
-                    *static_cast<UInt8*>(v) = buffer[0];
-                    LOG((CLOG_DEBUG2 "readf: read %d byte integer: %d (0x%x)", len, *static_cast<UInt8*>(v), *static_cast<UInt8*>(v)));
-                    break;
-
-                case 2:
-                    // 2 byte integer
-                    *static_cast<UInt16*>(v) =
-                        static_cast<UInt16>(
-                        (static_cast<UInt16>(buffer[0]) << 8) |
-                         static_cast<UInt16>(buffer[1]));
-                    LOG((CLOG_DEBUG2 "readf: read %d byte integer: %d (0x%x)", len, *static_cast<UInt16*>(v), *static_cast<UInt16*>(v)));
-                    break;
-
-                case 4:
-                    // 4 byte integer
-                    *static_cast<UInt32*>(v) =
-                        (static_cast<UInt32>(buffer[0]) << 24) |
-                        (static_cast<UInt32>(buffer[1]) << 16) |
-                        (static_cast<UInt32>(buffer[2]) <<  8) |
-                         static_cast<UInt32>(buffer[3]);
-                    LOG((CLOG_DEBUG2 "readf: read %d byte integer: %d (0x%x)", len, *static_cast<UInt32*>(v), *static_cast<UInt32*>(v)));
-                    break;
-                }
-                break;
-            }
-
-            case 'I': {
-                // check for valid length
-                assert(len == 1 || len == 2 || len == 4);
-
-                // read the vector length
-                UInt8 buffer[4];
-                read(stream, buffer, 4);
-                UInt32 n = (static_cast<UInt32>(buffer[0]) << 24) |
-                           (static_cast<UInt32>(buffer[1]) << 16) |
-                           (static_cast<UInt32>(buffer[2]) <<  8) |
-                            static_cast<UInt32>(buffer[3]);
-
-                // convert it
-                void* v = va_arg(args, void*);
-                switch (len) {
-                case 1:
-                    // 1 byte integer
-                    for (UInt32 i = 0; i < n; ++i) {
-                        read(stream, buffer, 1);
-                        static_cast<std::vector<UInt8>*>(v)->push_back(
-                            buffer[0]);
-                        LOG((CLOG_DEBUG2 "readf: read %d byte integer[%d]: %d (0x%x)", len, i, static_cast<std::vector<UInt8>*>(v)->back(), static_cast<std::vector<UInt8>*>(v)->back()));
-                    }
-                    break;
-
-                case 2:
-                    // 2 byte integer
-                    for (UInt32 i = 0; i < n; ++i) {
-                        read(stream, buffer, 2);
-                        static_cast<std::vector<UInt16>*>(v)->push_back(
-                            static_cast<UInt16>(
-                            (static_cast<UInt16>(buffer[0]) << 8) |
-                             static_cast<UInt16>(buffer[1])));
-                        LOG((CLOG_DEBUG2 "readf: read %d byte integer[%d]: %d (0x%x)", len, i, static_cast<std::vector<UInt16>*>(v)->back(), static_cast<std::vector<UInt16>*>(v)->back()));
-                    }
-                    break;
-
-                case 4:
-                    // 4 byte integer
-                    for (UInt32 i = 0; i < n; ++i) {
-                        read(stream, buffer, 4);
-                        static_cast<std::vector<UInt32>*>(v)->push_back(
-                            (static_cast<UInt32>(buffer[0]) << 24) |
-                            (static_cast<UInt32>(buffer[1]) << 16) |
-                            (static_cast<UInt32>(buffer[2]) <<  8) |
-                             static_cast<UInt32>(buffer[3]));
-                        LOG((CLOG_DEBUG2 "readf: read %d byte integer[%d]: %d (0x%x)", len, i, static_cast<std::vector<UInt32>*>(v)->back(), static_cast<std::vector<UInt32>*>(v)->back()));
-                    }
-                    break;
-                }
-                break;
-            }
-
-            case 's': {
-                assert(len == 0);
-
-                // read the string length
-                UInt8 buffer[128];
-                read(stream, buffer, 4);
-                UInt32 len = (static_cast<UInt32>(buffer[0]) << 24) |
-                             (static_cast<UInt32>(buffer[1]) << 16) |
-                             (static_cast<UInt32>(buffer[2]) <<  8) |
-                              static_cast<UInt32>(buffer[3]);
-
-                // use a fixed size buffer if its big enough
-                const bool useFixed = (len <= sizeof(buffer));
-
-                // allocate a buffer to read the data
-                UInt8* sBuffer = buffer;
-                if (!useFixed) {
-                    sBuffer = new UInt8[len];
-                }
-
-                // read the data
-                try {
-                    read(stream, sBuffer, len);
-                }
-                catch (...) {
-                    if (!useFixed) {
-                        delete[] sBuffer;
-                    }
-                    throw;
-                }
-
-                LOG((CLOG_DEBUG2 "readf: read %d byte string", len));
-
-                // save the data
-                String* dst = va_arg(args, String*);
-                dst->assign(reinterpret_cast<const char*>(sBuffer), len);
-
-                // release the buffer
-                if (!useFixed) {
-                    delete[] sBuffer;
-                }
-                break;
-            }
-
-            case '%':
-                assert(len == 0);
-                break;
-
-            default:
-                assert(0 && "invalid format specifier");
-            }
+constexpr MessageTable s_messageTable = makeMessageTable();
 
-            // next format character
-            ++fmt;
-        }
-        else {
-            // read next character
-            char buffer[1];
-            read(stream, buffer, 1);
+}
 
-            // verify match
-            if (buffer[0] != *fmt) {
-                LOG((CLOG_DEBUG2 "readf: format mismatch: %c vs %c", *fmt, buffer[0]));
-                throw XIOReadMismatch();
-            }
+//
+// ProtocolUtil
+//
 
-            // next format character
-            ++fmt;
+EMessageID
+ProtocolUtil::getMessageID(const UInt8* code)
+{
+    UInt32 value = (static_cast<UInt32>(code[0]) << 24) |
+                   (static_cast<UInt32>(code[1]) << 16) |
+                   (static_cast<UInt32>(code[2]) <<  8) |
+                    static_cast<UInt32>(code[3]);
+    for (UInt32 slot = toSlot(value); s_messageTable.m_code[slot] != 0;
+                            slot = (slot + 1) & (kMessageSlots - 1)) {
+        if (s_messageTable.m_code[slot] == value) {
+            return static_cast<EMessageID>(s_messageTable.m_id[slot]);
         }
     }
+    return kMsgIDUnknown;
 }
 
-UInt32
-ProtocolUtil::getLength(const char* fmt, va_list args)
+const char*
+ProtocolUtil::getMessageCode(EMessageID id)
 {
-    UInt32 n = 0;
-    while (*fmt != 0) {
-        if (*fmt == '%') {
-            // format specifier.  determine argument size.
-            ++fmt;
-            UInt32 len = eatLength(&fmt);
-            switch (*fmt) {
-            case 'i':
-                assert(len == 1 || len == 2 || len == 4);
-                (void)va_arg(args, UInt32);
-                break;
-
-            case 'I':
-                assert(len == 1 || len == 2 || len == 4);
-                switch (len) {
-                case 1:
-                    len = static_cast<UInt32>((va_arg(args, std::vector<UInt8>*))->size()) + 4;
-                    break;
-
-                case 2:
-                    len = 2 * static_cast<UInt32>((va_arg(args, std::vector<UInt16>*))->size()) + 4;
-                    break;
-
-                case 4:
-                    len = 4 * static_cast<UInt32>((va_arg(args, std::vector<UInt32>*))->size()) + 4;
-                    break;
-                }
-                break;
-
-            case 's':
-                assert(len == 0);
-                len = static_cast<UInt32>((va_arg(args, String*))->size()) + 4;
-                (void)va_arg(args, UInt8*);
-                break;
-
-            case 'S':
-                assert(len == 0);
-                len = va_arg(args, UInt32) + 4;
-                (void)va_arg(args, UInt8*);
-                break;
-
-            case '%':
-                assert(len == 0);
-                len = 1;
-                break;
-
-            default:
-                assert(0 && "invalid format specifier");
-            }
-
-            // accumulate size
-            n += len;
-            ++fmt;
-        }
-        else {
-            // regular character
-            ++n;
-            ++fmt;
+    for (const MessageCode& message : s_messageCodes) {
+        if (message.m_id == id) {
+            return message.m_code;
         }
     }
-    return n;
+    return NULL;
 }
 
-void
-ProtocolUtil::writef(void* buffer, const char* fmt, va_list args)
+String
+ProtocolUtil::formatMessageCounts(const UInt32* counts)
 {
-    auto* dst = static_cast<UInt8*>(buffer);
-
-    while (*fmt != 0) {
-        if (*fmt == '%') {
-            // format specifier.  determine argument size.
-            ++fmt;
-            UInt32 len = eatLength(&fmt);
-            switch (*fmt) {
-            case 'i': {
-                const UInt32 v = va_arg(args, UInt32);
-                switch (len) {
-                case 1:
-                    // 1 byte integer
-                    *dst++ = static_cast<UInt8>(v & 0xff);
-                    break;
-
-                case 2:
-                    // 2 byte integer
-                    *dst++ = static_cast<UInt8>((v >> 8) & 0xff);
-                    *dst++ = static_cast<UInt8>( v       & 0xff);
-                    break;
-
-                case 4:
-                    // 4 byte integer
-                    *dst++ = static_cast<UInt8>((v >> 24) & 0xff);
-                    *dst++ = static_cast<UInt8>((v >> 16) & 0xff);
-                    *dst++ = static_cast<UInt8>((v >>  8) & 0xff);
-                    *dst++ = static_cast<UInt8>( v        & 0xff);
-                    break;
-
-                default:
-                    assert(0 && "invalid integer format length");
-                    return;
-                }
-                break;
+    std::ostringstream stream;
+    for (const MessageCode& message : s_messageCodes) {
+        if (counts[message.m_id] != 0) {
+            if (stream.tellp() > 0) {
+                stream << ", ";
             }
-
-            case 'I': {
-                switch (len) {
-                case 1: {
-                    // 1 byte integers
-                    const std::vector<UInt8>* list =
-                        va_arg(args, const std::vector<UInt8>*);
-                    const auto n = static_cast<UInt32>(list->size());
-                    *dst++ = static_cast<UInt8>((n >> 24) & 0xff);
-                    *dst++ = static_cast<UInt8>((n >> 16) & 0xff);
-                    *dst++ = static_cast<UInt8>((n >>  8) & 0xff);
-                    *dst++ = static_cast<UInt8>( n        & 0xff);
-                    for (UInt32 i = 0; i < n; ++i) {
-                        *dst++ = (*list)[i];
-                    }
-                    break;
-                }
-
-                case 2: {
-                    // 2 byte integers
-                    const std::vector<UInt16>* list =
-                        va_arg(args, const std::vector<UInt16>*);
-                    const auto n = static_cast<UInt32>(list->size());
-                    *dst++ = static_cast<UInt8>((n >> 24) & 0xff);
-                    *dst++ = static_cast<UInt8>((n >> 16) & 0xff);
-                    *dst++ = static_cast<UInt8>((n >>  8) & 0xff);
-                    *dst++ = static_cast<UInt8>( n        & 0xff);
-                    for (UInt32 i = 0; i < n; ++i) {
-                        const UInt16 v = (*list)[i];
-                        *dst++ = static_cast<UInt8>((v >> 8) & 0xff);
-                        *dst++ = static_cast<UInt8>( v       & 0xff);
-                    }
-                    break;
-                }
-
-                case 4: {
-                    // 4 byte integers
-                    const std::vector<UInt32>* list =
-                        va_arg(args, const std::vector<UInt32>*);
-                    const auto n = static_cast<UInt32>(list->size());
-                    *dst++ = static_cast<UInt8>((n >> 24) & 0xff);
-                    *dst++ = static_cast<UInt8>((n >> 16) & 0xff);
-                    *dst++ = static_cast<UInt8>((n >>  8) & 0xff);
-                    *dst++ = static_cast<UInt8>( n        & 0xff);
-                    for (UInt32 i = 0; i < n; ++i) {
-                        const UInt32 v = (*list)[i];
-                        *dst++ = static_cast<UInt8>((v >> 24) & 0xff);
-                        *dst++ = static_cast<UInt8>((v >> 16) & 0xff);
-                        *dst++ = static_cast<UInt8>((v >>  8) & 0xff);
-                        *dst++ = static_cast<UInt8>( v        & 0xff);
-                    }
-                    break;
-                }
-
-                default:
-                    assert(0 && "invalid integer vector format length");
-                    return;
-                }
-                break;
-            }
-
-            case 's': {
-                assert(len == 0);
-                const String* src = va_arg(args, String*);
-                const UInt32 len = (src != nullptr) ? static_cast<UInt32>(src->size()) : 0;
-                *dst++ = static_cast<UInt8>((len >> 24) & 0xff);
-                *dst++ = static_cast<UInt8>((len >> 16) & 0xff);
-                *dst++ = static_cast<UInt8>((len >>  8) & 0xff);
-                *dst++ = static_cast<UInt8>( len        & 0xff);
-                if (len != 0) {
-                    memcpy(dst, src->data(), len);
-                    dst += len;
-                }
-                break;
-            }
-
-            case 'S': {
-                assert(len == 0);
-                const UInt32 len = va_arg(args, UInt32);
-                const UInt8* src = va_arg(args, UInt8*);
-                *dst++ = static_cast<UInt8>((len >> 24) & 0xff);
-                *dst++ = static_cast<UInt8>((len >> 16) & 0xff);
-                *dst++ = static_cast<UInt8>((len >>  8) & 0xff);
-                *dst++ = static_cast<UInt8>( len        & 0xff);
-                memcpy(dst, src, len);
-                dst += len;
-                break;
-            }
-
-            case '%':
-                assert(len == 0);
-                *dst++ = '%';
-                break;
-
-            default:
-                assert(0 && "invalid format specifier");
-            }
-
-            // next format character
-            ++fmt;
-        }
-        else {
-            // copy regular character
-            *dst++ = *fmt++;
+            stream << message.m_code << " " << counts[message.m_id];
         }
     }
+    return stream.str();
 }
 
-UInt32
-ProtocolUtil::eatLength(const char** pfmt)
+void
+ProtocolUtil::writeCode(synergy::IStream* stream, const char* code)
 {
-    const char* fmt = *pfmt;
-    UInt32 n = 0;
-    for (;;) {
-        UInt32 d;
-        switch (*fmt) {
-        case '0': d = 0; break;
-        case '1': d = 1; break;
-        case '2': d = 2; break;
-        case '3': d = 3; break;
-        case '4': d = 4; break;
-        case '5': d = 5; break;
-        case '6': d = 6; break;
-        case '7': d = 7; break;
-        case '8': d = 8; break;
-        case '9': d = 9; break;
-        default: *pfmt = fmt; return n;
-        }
-        n = 10 * n + d;
-        ++fmt;
-    }
+    assert(code != NULL && strlen(code) == 4);
+    writeBuffer(stream, reinterpret_cast<const UInt8*>(code), 4, false);
 }
 
 void
-ProtocolUtil::read(synergy::IStream* stream, void* vbuffer, UInt32 count)
+ProtocolUtil::writeBuffer(synergy::IStream* stream,
+                const UInt8* buffer, UInt32 size, bool bulk)
 {
     assert(stream != NULL);
-    assert(vbuffer != NULL);
-
-    auto* buffer = static_cast<UInt8*>(vbuffer);
-    while (count > 0) {
-        // read more
-        UInt32 n = stream->read(buffer, count);
-
-        // bail if stream has hungup
-        if (n == 0) {
-            LOG((CLOG_DEBUG2 "unexpected disconnect in readf(), %d bytes left", count));
-            throw XIOEndOfStream();
-        }
+    if (bulk) {
+        synergy::IStream::Buffer data = { buffer, size };
+        stream->writeBulk(&data, 1);
+    }
+    else {
+        stream->write(buffer, size);
+    }
+    LOG((CLOG_DEBUG2 "wrote %.4s, %d bytes", buffer, size));
+}
 
-        // prepare for next read
-        buffer += n;
-        count  -= n;
+void
+ProtocolUtil::checkCode(ProtocolReader& reader, const char* code, UInt32 size)
+{
+    const UInt8* data = reader.take(size);
+    if (memcmp(data, code, size) != 0) {
+        LOG((CLOG_DEBUG2 "readMessage: code mismatch, expected %s", code));
+        throw XIOReadMismatch();
     }
 }
 
@@ -540,5 +197,5 @@ ProtocolUtil::read(synergy::IStream* stream, void* vbuffer, UInt32 count)
 String
 XIOReadMismatch::getWhat() const noexcept
 {
-    return format("XIOReadMismatch", "ProtocolUtil::readf() mismatch");
+    return format("XIOReadMismatch", "ProtocolUtil::readMessage() mismatch");
 }
@@ -18,79 +18,177 @@
 
 #pragma once
 
+#include "core/ProtocolLayout.h"
+#include "core/protocol_types.h"
 #include "io/XIO.h"
 #include "base/EventTypes.h"
 
-#include <stdarg.h>
-
 namespace synergy { class IStream; }
 
 //! Synergy protocol utilities
 /*!
 This class provides various functions for implementing the synergy
-protocol.
+protocol.  Messages are described by ProtocolLayout types, see
+protocol_types.h, so encoding and decoding is worked out at compile
+time.
 */
 class ProtocolUtil {
 public:
-    //! Write formatted data
+    //! Write a message
+    /*!
+    Encodes a \c Message with one argument per field and writes it to
+    the stream with a single write.  Messages without variable length
+    fields are encoded on the stack.
+    */
+    template <class Message, class... Args>
+    static void            write(synergy::IStream*, const Args&... args);
+
+    //! Write a bulk message
+    /*!
+    Like write() but the message is written with IStream::writeBulk(),
+    so messages written later with write() can overtake it.  Use it for
+    clipboard and file chunks.
+    */
+    template <class Message, class... Args>
+    static void            writeBulk(synergy::IStream*, const Args&... args);
+
+    //! Write a message without fields
+    /*!
+    Writes the 4 byte message \c code.
+    */
+    static void            writeCode(synergy::IStream*, const char* code);
+
+    //! Read message fields
+    /*!
+    Reads the fields of a \c Message, whose code has already been read,
+    into \c args.  Returns false if the stream ended first.
+    */
+    template <class Message, class... Args>
+    static bool            read(synergy::IStream*, Args&... args);
+
+    //! Read a message
+    /*!
+    Like read() but first reads the message code.  Returns false if the
+    code doesn't match or the stream ended first.
+    */
+    template <class Message, class... Args>
+    static bool            readMessage(synergy::IStream*, Args&... args);
+
+    //! Identify a message
+    /*!
+    Returns the ID of the 4 byte message \c code or kMsgIDUnknown if
+    it isn't a code we know.
+    */
+    static EMessageID      getMessageID(const UInt8* code);
+
+    //! Get the code of a message
     /*!
-    Write formatted binary data to a stream.  \c fmt consists of
-    regular characters and format specifiers.  Format specifiers
-    begin with \%.  All characters not part of a format specifier
-    are regular and are transmitted unchanged.
-    
-    Format specifiers are:
-    - \%\%   -- literal `\%'
-    - \%1i  -- converts integer argument to 1 byte integer
-    - \%2i  -- converts integer argument to 2 byte integer in NBO
-    - \%4i  -- converts integer argument to 4 byte integer in NBO
-    - \%1I  -- converts std::vector<UInt8>* to 1 byte integers
-    - \%2I  -- converts std::vector<UInt16>* to 2 byte integers in NBO
-    - \%4I  -- converts std::vector<UInt32>* to 4 byte integers in NBO
-    - \%s   -- converts String* to stream of bytes
-    - \%S   -- converts integer N and const UInt8* to stream of N bytes
+    Returns the 4 byte code for \c id, or NULL for kMsgIDUnknown.
     */
-    static void            writef(synergy::IStream*,
-                            const char* fmt, ...);
+    static const char*     getMessageCode(EMessageID id);
 
-    //! Read formatted data
+    //! Format message counts
     /*!
-    Read formatted binary data from a buffer.  This performs the
-    reverse operation of writef().  Returns true if the entire
-    format was successfully parsed, false otherwise.
-    
-    Format specifiers are:
-    - \%\%   -- read (and discard) a literal `\%'
-    - \%1i  -- reads a 1 byte integer; argument is a SInt32* or UInt32*
-    - \%2i  -- reads an NBO 2 byte integer;  arg is SInt32* or UInt32*
-    - \%4i  -- reads an NBO 4 byte integer;  arg is SInt32* or UInt32*
-    - \%1I  -- reads 1 byte integers;  arg is std::vector<UInt8>*
-    - \%2I  -- reads NBO 2 byte integers;  arg is std::vector<UInt16>*
-    - \%4I  -- reads NBO 4 byte integers;  arg is std::vector<UInt32>*
-    - \%s   -- reads bytes;  argument must be a String*, \b not a char*
+    Returns the code and count of each non-zero entry in \c counts,
+    which must have kNumMessageIDs entries indexed by EMessageID.
     */
-    static bool            readf(synergy::IStream*,
-                            const char* fmt, ...);
+    static String          formatMessageCounts(const UInt32* counts);
 
 private:
-    static void            vwritef(synergy::IStream*,
-                            const char* fmt, UInt32 size, va_list);
-    static void            vreadf(synergy::IStream*,
-                            const char* fmt, va_list);
-
-    static UInt32        getLength(const char* fmt, va_list);
-    static void            writef(void*, const char* fmt, va_list);
-    static UInt32        eatLength(const char** pfmt);
-    static void            read(synergy::IStream*, void*, UInt32);
+    // largest variable length message encoded on the stack
+    static const UInt32    kStackSize = 256;
+
+    template <class Message, class... Args>
+    static void            writeMessage(synergy::IStream*, bool bulk,
+                            const Args&... args);
+    static void            writeBuffer(synergy::IStream*,
+                            const UInt8* buffer, UInt32 size, bool bulk);
+    static void            checkCode(ProtocolReader&,
+                            const char* code, UInt32 size);
 };
 
 //! Mismatched read exception
 /*!
-Thrown by ProtocolUtil::readf() when the data being read does not
-match the format.
+Thrown inside ProtocolUtil::readMessage() when the message code does
+not match.
 */
 class XIOReadMismatch : public XIO {
 public:
     // XBase overrides
     virtual String        getWhat() const throw();
 };
+
+template <class Message, class... Args>
+void
+ProtocolUtil::write(synergy::IStream* stream, const Args&... args)
+{
+    writeMessage<Message>(stream, false, args...);
+}
+
+template <class Message, class... Args>
+void
+ProtocolUtil::writeBulk(synergy::IStream* stream, const Args&... args)
+{
+    writeMessage<Message>(stream, true, args...);
+}
+
+template <class Message, class... Args>
+void
+ProtocolUtil::writeMessage(synergy::IStream* stream, bool bulk,
+                const Args&... args)
+{
+    static_assert(sizeof...(Args) == Message::kNumFields,
+                            "wrong number of message arguments");
+    static_assert(Message::kFixedSize <= kStackSize, "message too large");
+
+    UInt8 fixed[kStackSize];
+    std::vector<UInt8> variable;
+    UInt8* buffer = fixed;
+
+    UInt32 size = Message::getSize(args...);
+    if (!Message::kFixed && size > kStackSize) {
+        variable.resize(size);
+        buffer = &variable[0];
+    }
+
+    Message::encode(buffer, args...);
+    writeBuffer(stream, buffer, size, bulk);
+}
+
+template <class Message, class... Args>
+bool
+ProtocolUtil::read(synergy::IStream* stream, Args&... args)
+{
+    static_assert(sizeof...(Args) == Message::kNumFields,
+                            "wrong number of message arguments");
+
+    try {
+        ProtocolReader reader(stream);
+        reader.fill(Message::Params::kLeadSize);
+        Message::Params::decode(reader, args...);
+        return true;
+    }
+    catch (XIO&) {
+        return false;
+    }
+}
+
+template <class Message, class... Args>
+bool
+ProtocolUtil::readMessage(synergy::IStream* stream, Args&... args)
+{
+    static_assert(sizeof...(Args) == Message::kNumFields,
+                            "wrong number of message arguments");
+    typedef typename Message::Code Code;
+
+    try {
+        ProtocolReader reader(stream);
+        reader.fill(Code::kSize + Message::Params::kLeadSize);
+        checkCode(reader, Code::s_code, Code::kSize);
+        Message::Params::decode(reader, args...);
+        return true;
+    }
+    catch (XIO&) {
+        return false;
+    }
+}
@@ -675,7 +675,8 @@ ServerApp::mainLoop()
 {
     // create socket multiplexer.  this must happen after daemonization
     // on unix because threads evaporate across a fork().
-    SocketMultiplexer multiplexer;
+    SocketMultiplexer multiplexer(args().m_multiplexer == "epoll" ?
+                            SocketMultiplexer::kEpoll : SocketMultiplexer::kPoll);
     setSocketMultiplexer(&multiplexer);
 
     // if configuration has no screens then add this system
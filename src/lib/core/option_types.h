@@ -70,6 +70,22 @@ static const OptionID    kOptionWin32KeepForeground        = OPTION_CODE("_KFW")
 static const OptionID    kOptionDisableLockToScreen    = OPTION_CODE("DLTS");
 static const OptionID    kOptionClipboardSharing            = OPTION_CODE("CLPS");
 static const OptionID   kOptionClipboardSharingSize     = OPTION_CODE("CLSZ");
+static const OptionID   kOptionNoopAck                  = OPTION_CODE("NACK");
+static const OptionID   kOptionMotionChannel            = OPTION_CODE("MUDP");
+//@}
+
+//! @name No-op acknowledgement modes
+/*!
+How often a secondary screen answers the primary's messages with a
+kMsgCNoop.  Secondaries that don't get kOptionNoopAck, or don't know
+it, answer every message.
+*/
+//@{
+enum ENoopAck {
+    kNoopAckMessage,    //!< After every message
+    kNoopAckRead,       //!< Once per batch of messages read together
+    kNoopAckNone        //!< Never
+};
 //@}
 
 //! @name Screen switch corner enumeration
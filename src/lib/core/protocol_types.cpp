@@ -18,36 +18,37 @@
 
 #include "core/protocol_types.h"
 
-const char*                kMsgHello            = "Synergy%2i%2i";
-const char*                kMsgHelloBack        = "Synergy%2i%2i%s";
-const char*                kMsgCNoop             = "CNOP";
-const char*                kMsgCClose             = "CBYE";
-const char*                kMsgCEnter             = "CINN%2i%2i%4i%2i";
-const char*                kMsgCLeave             = "COUT";
-const char*                kMsgCClipboard         = "CCLP%1i%4i";
-const char*                kMsgCScreenSaver     = "CSEC%1i";
-const char*                kMsgCResetOptions    = "CROP";
-const char*                kMsgCInfoAck        = "CIAK";
-const char*                kMsgCKeepAlive        = "CALV";
-const char*                kMsgDKeyDown        = "DKDN%2i%2i%2i";
-const char*                kMsgDKeyDown1_0        = "DKDN%2i%2i";
-const char*                kMsgDKeyRepeat        = "DKRP%2i%2i%2i%2i";
-const char*                kMsgDKeyRepeat1_0    = "DKRP%2i%2i%2i";
-const char*                kMsgDKeyUp            = "DKUP%2i%2i%2i";
-const char*                kMsgDKeyUp1_0        = "DKUP%2i%2i";
-const char*                kMsgDMouseDown        = "DMDN%1i";
-const char*                kMsgDMouseUp        = "DMUP%1i";
-const char*                kMsgDMouseMove        = "DMMV%2i%2i";
-const char*                kMsgDMouseRelMove    = "DMRM%2i%2i";
-const char*                kMsgDMouseWheel        = "DMWM%2i%2i";
-const char*                kMsgDMouseWheel1_0    = "DMWM%2i";
-const char*                kMsgDClipboard        = "DCLP%1i%4i%1i%s";
-const char*                kMsgDInfo            = "DINF%2i%2i%2i%2i%2i%2i%2i";
-const char*                kMsgDSetOptions        = "DSOP%4I";
-const char*                kMsgDFileTransfer    = "DFTR%1i%s";
-const char*                kMsgDDragInfo        = "DDRG%2i%s";
-const char*                kMsgQInfo            = "QINF";
-const char*                kMsgEIncompatible    = "EICV%2i%2i";
-const char*                kMsgEBusy             = "EBSY";
-const char*                kMsgEUnknown        = "EUNK";
-const char*                kMsgEBad            = "EBAD";
+const char*                kMsgHello            = MsgHello::Code::s_code;
+const char*                kMsgHelloBack        = MsgHelloBack::Code::s_code;
+const char*                kMsgCNoop             = MsgCNoop::Code::s_code;
+const char*                kMsgCClose             = MsgCClose::Code::s_code;
+const char*                kMsgCEnter             = MsgCEnter::Code::s_code;
+const char*                kMsgCLeave             = MsgCLeave::Code::s_code;
+const char*                kMsgCClipboard         = MsgCClipboard::Code::s_code;
+const char*                kMsgCScreenSaver     = MsgCScreenSaver::Code::s_code;
+const char*                kMsgCResetOptions    = MsgCResetOptions::Code::s_code;
+const char*                kMsgCInfoAck        = MsgCInfoAck::Code::s_code;
+const char*                kMsgCKeepAlive        = MsgCKeepAlive::Code::s_code;
+const char*                kMsgDKeyDown        = MsgDKeyDown::Code::s_code;
+const char*                kMsgDKeyDown1_0        = MsgDKeyDown1_0::Code::s_code;
+const char*                kMsgDKeyRepeat        = MsgDKeyRepeat::Code::s_code;
+const char*                kMsgDKeyRepeat1_0    = MsgDKeyRepeat1_0::Code::s_code;
+const char*                kMsgDKeyUp            = MsgDKeyUp::Code::s_code;
+const char*                kMsgDKeyUp1_0        = MsgDKeyUp1_0::Code::s_code;
+const char*                kMsgDMouseDown        = MsgDMouseDown::Code::s_code;
+const char*                kMsgDMouseUp        = MsgDMouseUp::Code::s_code;
+const char*                kMsgDMouseMove        = MsgDMouseMove::Code::s_code;
+const char*                kMsgDMouseRelMove    = MsgDMouseRelMove::Code::s_code;
+const char*                kMsgDMotionSeq        = MsgDMotionSeq::Code::s_code;
+const char*                kMsgDMouseWheel        = MsgDMouseWheel::Code::s_code;
+const char*                kMsgDMouseWheel1_0    = MsgDMouseWheel1_0::Code::s_code;
+const char*                kMsgDClipboard        = MsgDClipboard::Code::s_code;
+const char*                kMsgDInfo            = MsgDInfo::Code::s_code;
+const char*                kMsgDSetOptions        = MsgDSetOptions::Code::s_code;
+const char*                kMsgDFileTransfer    = MsgDFileTransfer::Code::s_code;
+const char*                kMsgDDragInfo        = MsgDDragInfo::Code::s_code;
+const char*                kMsgQInfo            = MsgQInfo::Code::s_code;
+const char*                kMsgEIncompatible    = MsgEIncompatible::Code::s_code;
+const char*                kMsgEBusy             = MsgEBusy::Code::s_code;
+const char*                kMsgEUnknown        = MsgEUnknown::Code::s_code;
+const char*                kMsgEBad            = MsgEBad::Code::s_code;
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "base/EventTypes.h"
+#include "core/ProtocolLayout.h"
 
 // protocol version number
 // 1.0:  initial protocol
@@ -29,9 +30,10 @@
 // 1.4:  adds crypto support
 // 1.5:  adds file transfer and removes home brew crypto
 // 1.6:  adds clipboard streaming
+// 1.7:  sends key and mouse input as compact frames, see CompactInput.h
 // NOTE: with new version, synergy minor version should increment
 static const SInt16        kProtocolMajorVersion = 1;
-static const SInt16        kProtocolMinorVersion = 6;
+static const SInt16        kProtocolMinorVersion = 7;
 
 // default contact port number
 static const UInt16        kDefaultPort = 24800;
@@ -89,7 +91,8 @@ enum EDataReceived {
 // message codes (trailing NUL is not part of code).  in comments, $n
 // refers to the n'th argument (counting from one).  message codes are
 // always 4 bytes optionally followed by message specific parameters
-// except those for the greeting handshake.
+// except those for the greeting handshake.  each code is followed by
+// the message layout used with ProtocolUtil::write() and read().
 //
 
 //
@@ -104,12 +107,16 @@ enum EDataReceived {
 // $1 = protocol major version number supported by server.  $2 =
 // protocol minor version number supported by server.
 extern const char*        kMsgHello;
+typedef ProtocolLayout<ProtocolCode<'S','y','n','e','r','g','y'>,
+                       SInt16, SInt16> MsgHello;
 
 // respond to hello from server;  secondary -> primary
 // $1 = protocol major version number supported by client.  $2 =
 // protocol minor version number supported by client.  $3 = client
 // name.
 extern const char*        kMsgHelloBack;
+typedef ProtocolLayout<ProtocolCode<'S','y','n','e','r','g','y'>,
+                       SInt16, SInt16, String> MsgHelloBack;
 
 
 //
@@ -118,9 +125,11 @@ extern const char*        kMsgHelloBack;
 
 // no operation;  secondary -> primary
 extern const char*        kMsgCNoop;
+typedef ProtocolLayout<ProtocolCode<'C','N','O','P'>> MsgCNoop;
 
 // close connection;  primary -> secondary
 extern const char*        kMsgCClose;
+typedef ProtocolLayout<ProtocolCode<'C','B','Y','E'>> MsgCClose;
 
 // enter screen:  primary -> secondary
 // entering screen at screen position $1 = x, $2 = y.  x,y are
@@ -131,6 +140,8 @@ extern const char*        kMsgCClose;
 // that is activated on entry to the screen.  the secondary screen
 // should adjust its toggle modifiers to reflect that state.
 extern const char*        kMsgCEnter;
+typedef ProtocolLayout<ProtocolCode<'C','I','N','N'>,
+                       SInt16, SInt16, UInt32, UInt16> MsgCEnter;
 
 // leave screen:  primary -> secondary
 // leaving screen.  the secondary screen should send clipboard
@@ -140,6 +151,7 @@ extern const char*        kMsgCEnter;
 // number) and that were grabbed or have changed since the
 // last leave.
 extern const char*        kMsgCLeave;
+typedef ProtocolLayout<ProtocolCode<'C','O','U','T'>> MsgCLeave;
 
 // grab clipboard:  primary <-> secondary
 // sent by screen when some other app on that screen grabs a
@@ -147,20 +159,25 @@ extern const char*        kMsgCLeave;
 // secondary screens must use the sequence number passed in the
 // most recent kMsgCEnter.  the primary always sends 0.
 extern const char*        kMsgCClipboard;
+typedef ProtocolLayout<ProtocolCode<'C','C','L','P'>,
+                       UInt8, UInt32> MsgCClipboard;
 
 // screensaver change:  primary -> secondary
 // screensaver on primary has started ($1 == 1) or closed ($1 == 0)
 extern const char*        kMsgCScreenSaver;
+typedef ProtocolLayout<ProtocolCode<'C','S','E','C'>, UInt8> MsgCScreenSaver;
 
 // reset options:  primary -> secondary
 // client should reset all of its options to their defaults.
 extern const char*        kMsgCResetOptions;
+typedef ProtocolLayout<ProtocolCode<'C','R','O','P'>> MsgCResetOptions;
 
 // resolution change acknowledgment:  primary -> secondary
 // sent by primary in response to a secondary screen's kMsgDInfo.
 // this is sent for every kMsgDInfo, whether or not the primary
 // had sent a kMsgQInfo.
 extern const char*        kMsgCInfoAck;
+typedef ProtocolLayout<ProtocolCode<'C','I','A','K'>> MsgCInfoAck;
 
 // keep connection alive:  primary <-> secondary
 // sent by the server periodically to verify that connections are still
@@ -171,6 +188,7 @@ extern const char*        kMsgCInfoAck;
 // should disconnect from the server.  the appropriate interval is
 // defined by an option.
 extern const char*        kMsgCKeepAlive;
+typedef ProtocolLayout<ProtocolCode<'C','A','L','V'>> MsgCKeepAlive;
 
 //
 // data codes
@@ -188,49 +206,80 @@ extern const char*        kMsgCKeepAlive;
 // the keyboard layouts are not identical and the user releases
 // a modifier key before releasing the modified key.
 extern const char*        kMsgDKeyDown;
+typedef ProtocolLayout<ProtocolCode<'D','K','D','N'>,
+                       UInt16, UInt16, UInt16> MsgDKeyDown;
 
 // key pressed 1.0:  same as above but without KeyButton
 extern const char*        kMsgDKeyDown1_0;
+typedef ProtocolLayout<ProtocolCode<'D','K','D','N'>,
+                       UInt16, UInt16> MsgDKeyDown1_0;
 
 // key auto-repeat:  primary -> secondary
 // $1 = KeyID, $2 = KeyModifierMask, $3 = number of repeats, $4 = KeyButton
 extern const char*        kMsgDKeyRepeat;
+typedef ProtocolLayout<ProtocolCode<'D','K','R','P'>,
+                       UInt16, UInt16, UInt16, UInt16> MsgDKeyRepeat;
 
 // key auto-repeat 1.0:  same as above but without KeyButton
 extern const char*        kMsgDKeyRepeat1_0;
+typedef ProtocolLayout<ProtocolCode<'D','K','R','P'>,
+                       UInt16, UInt16, UInt16> MsgDKeyRepeat1_0;
 
 // key released:  primary -> secondary
 // $1 = KeyID, $2 = KeyModifierMask, $3 = KeyButton
 extern const char*        kMsgDKeyUp;
+typedef ProtocolLayout<ProtocolCode<'D','K','U','P'>,
+                       UInt16, UInt16, UInt16> MsgDKeyUp;
 
 // key released 1.0:  same as above but without KeyButton
 extern const char*        kMsgDKeyUp1_0;
+typedef ProtocolLayout<ProtocolCode<'D','K','U','P'>,
+                       UInt16, UInt16> MsgDKeyUp1_0;
 
 // mouse button pressed:  primary -> secondary
 // $1 = ButtonID
 extern const char*        kMsgDMouseDown;
+typedef ProtocolLayout<ProtocolCode<'D','M','D','N'>, UInt8> MsgDMouseDown;
 
 // mouse button released:  primary -> secondary
 // $1 = ButtonID
 extern const char*        kMsgDMouseUp;
+typedef ProtocolLayout<ProtocolCode<'D','M','U','P'>, UInt8> MsgDMouseUp;
 
 // mouse moved:  primary -> secondary
 // $1 = x, $2 = y.  x,y are absolute screen coordinates.
 extern const char*        kMsgDMouseMove;
+typedef ProtocolLayout<ProtocolCode<'D','M','M','V'>,
+                       SInt16, SInt16> MsgDMouseMove;
 
 // relative mouse move:  primary -> secondary
 // $1 = dx, $2 = dy.  dx,dy are motion deltas.
 extern const char*        kMsgDMouseRelMove;
+typedef ProtocolLayout<ProtocolCode<'D','M','R','M'>,
+                       SInt16, SInt16> MsgDMouseRelMove;
+
+// motion datagram fence:  primary -> secondary
+// $1 = sequence number of the last motion datagram sent.  only sent to
+// secondaries using the motion channel (see kOptionMotionChannel), just
+// before a move or enter that repeats datagram motion on the stream.
+// the secondary must ignore datagrams with this sequence number or an
+// older one, since they'd move the pointer back to where it was before.
+extern const char*        kMsgDMotionSeq;
+typedef ProtocolLayout<ProtocolCode<'D','M','S','Q'>, UInt32> MsgDMotionSeq;
 
 // mouse scroll:  primary -> secondary
 // $1 = xDelta, $2 = yDelta.  the delta should be +120 for one tick forward
 // (away from the user) or right and -120 for one tick backward (toward
 // the user) or left.
 extern const char*        kMsgDMouseWheel;
+typedef ProtocolLayout<ProtocolCode<'D','M','W','M'>,
+                       SInt16, SInt16> MsgDMouseWheel;
 
 // mouse vertical scroll:  primary -> secondary
 // like as kMsgDMouseWheel except only sends $1 = yDelta.
 extern const char*        kMsgDMouseWheel1_0;
+typedef ProtocolLayout<ProtocolCode<'D','M','W','M'>,
+                       SInt16> MsgDMouseWheel1_0;
 
 // clipboard data:  primary <-> secondary
 // $2 = sequence number, $3 = mark $4 = clipboard data.  the sequence number
@@ -238,6 +287,8 @@ extern const char*        kMsgDMouseWheel1_0;
 // sequence number from the most recent kMsgCEnter.  $1 = clipboard
 // identifier.
 extern const char*        kMsgDClipboard;
+typedef ProtocolLayout<ProtocolCode<'D','C','L','P'>,
+                       UInt8, UInt32, UInt8, String> MsgDClipboard;
 
 // client data:  secondary -> primary
 // $1 = coordinate of leftmost pixel on secondary screen,
@@ -254,11 +305,16 @@ extern const char*        kMsgDClipboard;
 // kMsgCInfoAck in order to prevent attempts to move the mouse off
 // the new screen area.
 extern const char*        kMsgDInfo;
+typedef ProtocolLayout<ProtocolCode<'D','I','N','F'>,
+                       SInt16, SInt16, SInt16, SInt16,
+                       SInt16, SInt16, SInt16> MsgDInfo;
 
 // set options:  primary -> secondary
 // client should set the given option/value pairs.  $1 = option/value
 // pairs.
 extern const char*        kMsgDSetOptions;
+typedef ProtocolLayout<ProtocolCode<'D','S','O','P'>,
+                       std::vector<UInt32>> MsgDSetOptions;
 
 // file data:  primary <-> secondary
 // transfer file data. A mark is used in the first byte.
@@ -266,12 +322,16 @@ extern const char*        kMsgDSetOptions;
 // 1 means the content followed is the chunk data.
 // 2 means the file transfer is finished.
 extern const char*        kMsgDFileTransfer;
+typedef ProtocolLayout<ProtocolCode<'D','F','T','R'>,
+                       UInt8, String> MsgDFileTransfer;
 
 // drag infomation:  primary <-> secondary
 // transfer drag infomation. The first 2 bytes are used for storing
 // the number of dragging objects. Then the following string consists
 // of each object's directory.
 extern const char*        kMsgDDragInfo;
+typedef ProtocolLayout<ProtocolCode<'D','D','R','G'>,
+                       UInt16, String> MsgDDragInfo;
 
 //
 // query codes
@@ -280,6 +340,7 @@ extern const char*        kMsgDDragInfo;
 // query screen info:  primary -> secondary
 // client should reply with a kMsgDInfo.
 extern const char*        kMsgQInfo;
+typedef ProtocolLayout<ProtocolCode<'Q','I','N','F'>> MsgQInfo;
 
 
 //
@@ -289,18 +350,67 @@ extern const char*        kMsgQInfo;
 // incompatible versions:  primary -> secondary
 // $1 = major version of primary, $2 = minor version of primary.
 extern const char*        kMsgEIncompatible;
+typedef ProtocolLayout<ProtocolCode<'E','I','C','V'>,
+                       SInt16, SInt16> MsgEIncompatible;
 
 // name provided when connecting is already in use:  primary -> secondary
 extern const char*        kMsgEBusy;
+typedef ProtocolLayout<ProtocolCode<'E','B','S','Y'>> MsgEBusy;
 
 // unknown client:  primary -> secondary
 // name provided when connecting is not in primary's screen
 // configuration map.
 extern const char*        kMsgEUnknown;
+typedef ProtocolLayout<ProtocolCode<'E','U','N','K'>> MsgEUnknown;
 
 // protocol violation:  primary -> secondary
 // primary should disconnect after sending this message.
 extern const char*        kMsgEBad;
+typedef ProtocolLayout<ProtocolCode<'E','B','A','D'>> MsgEBad;
+
+
+//
+// message identifiers
+//
+
+//! Message identifiers
+/*!
+Small integers for the 4 byte message codes so received messages can be
+dispatched through a table.  Messages that kept their code across
+protocol versions share an ID.  See ProtocolUtil::getMessageID().
+*/
+enum EMessageID {
+    kMsgIDUnknown,
+    kMsgIDCNoop,
+    kMsgIDCClose,
+    kMsgIDCEnter,
+    kMsgIDCLeave,
+    kMsgIDCClipboard,
+    kMsgIDCScreenSaver,
+    kMsgIDCResetOptions,
+    kMsgIDCInfoAck,
+    kMsgIDCKeepAlive,
+    kMsgIDDKeyDown,
+    kMsgIDDKeyRepeat,
+    kMsgIDDKeyUp,
+    kMsgIDDMouseDown,
+    kMsgIDDMouseUp,
+    kMsgIDDMouseMove,
+    kMsgIDDMouseRelMove,
+    kMsgIDDMotionSeq,
+    kMsgIDDMouseWheel,
+    kMsgIDDClipboard,
+    kMsgIDDInfo,
+    kMsgIDDSetOptions,
+    kMsgIDDFileTransfer,
+    kMsgIDDDragInfo,
+    kMsgIDQInfo,
+    kMsgIDEIncompatible,
+    kMsgIDEBusy,
+    kMsgIDEUnknown,
+    kMsgIDEBad,
+    kNumMessageIDs
+};
 
 
 //
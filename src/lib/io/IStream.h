@@ -33,6 +33,13 @@ Defines the interface for all streams.
 */
 class IStream : public IInterface {
 public:
+    //! A buffer for \c writeBuffers()
+    struct Buffer {
+    public:
+        const void*        m_data;
+        UInt32            m_size;
+    };
+
     IStream() { }
 
     //! @name manipulators
@@ -65,6 +72,39 @@ public:
     */
     virtual void        write(const void* buffer, UInt32 n) = 0;
 
+    //! Write several buffers to stream
+    /*!
+    Like \c write() for each of the \c count buffers in turn, except
+    they're written as one piece;  a packet filter frames them as a
+    single packet.  The default simply calls \c write() for each.
+    */
+    virtual void        writeBuffers(const Buffer* buffers, UInt32 count);
+
+    //! Write several buffers of bulk data to stream
+    /*!
+    Like \c writeBuffers() but for data that isn't urgent, such as
+    clipboard and file chunks.  Bulk writes stay in order with each
+    other but may be sent after data written later with \c write() or
+    \c writeBuffers(), so input doesn't wait behind them.  The default
+    simply calls \c writeBuffers().
+    */
+    virtual void        writeBulk(const Buffer* buffers, UInt32 count);
+
+    //! Hold back output
+    /*!
+    Until the matching \c uncork(), written data may be buffered
+    rather than sent so that several messages go out together.  Calls
+    nest.  The default does nothing.
+    */
+    virtual void        cork() { }
+
+    //! Release held back output
+    /*!
+    Undoes one \c cork().  When the last is undone any data buffered
+    in the meantime is sent.  The default does nothing.
+    */
+    virtual void        uncork() { }
+
     //! Flush the stream
     /*!
     Waits until all buffered data has been written to the stream.
@@ -114,7 +154,32 @@ public:
     */
     virtual UInt32        getSize() const = 0;
 
+    //! Test if output is backed up
+    /*!
+    Returns true if earlier writes are still waiting to be sent, so
+    anything written now will wait behind them.  A stream that returns
+    true sends an output drained event once that data has gone.  The
+    default returns false.
+    */
+    virtual bool        hasPendingOutput() const { return false; }
+
     //@}
 };
 
+inline
+void
+IStream::writeBuffers(const Buffer* buffers, UInt32 count)
+{
+    for (UInt32 i = 0; i < count; ++i) {
+        write(buffers[i].m_data, buffers[i].m_size);
+    }
+}
+
+inline
+void
+IStream::writeBulk(const Buffer* buffers, UInt32 count)
+{
+    writeBuffers(buffers, count);
+}
+
 }
@@ -18,78 +18,61 @@
 
 #include "io/StreamBuffer.h"
 
+#include <cassert>
+#include <cstring>
+
 //
 // StreamBuffer
 //
 
-const UInt32            StreamBuffer::kChunkSize = 4096;
+const UInt32            StreamBuffer::kMinCapacity     = 4096;
+const UInt32            StreamBuffer::kMaxIdleCapacity = 65536;
 
 StreamBuffer::StreamBuffer() :
-    m_size(0),
-    m_headUsed(0)
+    m_data(nullptr),
+    m_capacity(0),
+    m_head(0),
+    m_tail(0)
 {
     // do nothing
 }
 
 StreamBuffer::~StreamBuffer()
 {
-    // do nothing
+    delete[] m_data;
 }
 
 const void*
 StreamBuffer::peek(UInt32 n)
 {
-    assert(n <= m_size);
+    assert(n <= getSize());
 
-    // if requesting no data then return NULL so we don't try to access
-    // an empty list.
+    // if requesting no data then return NULL so we don't hand out a
+    // pointer into a buffer that may not exist.
     if (n == 0) {
         return nullptr;
     }
 
-    // reserve space in first chunk
-    auto head = m_chunks.begin();
-    head->reserve(n + m_headUsed);
-
-    // consolidate chunks into the first chunk until it has n bytes
-    auto scan = head;
-    ++scan;
-    while (head->size() - m_headUsed < n && scan != m_chunks.end()) {
-        head->insert(head->end(), scan->begin(), scan->end());
-        scan = m_chunks.erase(scan);
-    }
-
-    return static_cast<const void*>(&(head->begin()[m_headUsed]));
+    return m_data + m_head;
 }
 
 void
 StreamBuffer::pop(UInt32 n)
 {
-    // discard all chunks if n is greater than or equal to m_size
-    if (n >= m_size) {
-        m_size     = 0;
-        m_headUsed = 0;
-        m_chunks.clear();
+    // rewind to the start of the block when emptied so the next write
+    // doesn't have to move anything
+    if (n >= getSize()) {
+        m_head = 0;
+        m_tail = 0;
+
+        // don't hang on to a block grown for a burst of data
+        if (m_capacity > kMaxIdleCapacity) {
+            release();
+        }
         return;
     }
 
-    // update size
-    m_size -= n;
-
-    // discard chunks until more than n bytes would've been discarded
-    auto scan = m_chunks.begin();
-    assert(scan != m_chunks.end());
-    while (scan->size() - m_headUsed <= n) {
-        n         -= static_cast<UInt32>(scan->size()) - m_headUsed;
-        m_headUsed = 0;
-        scan       = m_chunks.erase(scan);
-        assert(scan != m_chunks.end());
-    }
-
-    // remove left over bytes from the head chunk
-    if (n > 0) {
-        m_headUsed += n;
-    }
+    m_head += n;
 }
 
 void
@@ -97,51 +80,71 @@ StreamBuffer::write(const void* vdata, UInt32 n)
 {
     assert(vdata != NULL);
 
-    // ignore if no data, otherwise update size
+    // ignore if no data
     if (n == 0) {
         return;
     }
-    m_size += n;
 
-    // cast data to bytes
-    const auto* data = static_cast<const UInt8*>(vdata);
+    memcpy(reserve(n), vdata, n);
+    commit(n);
+}
 
-    // point to last chunk if it has space, otherwise append an empty chunk
-    auto scan = m_chunks.end();
-    if (scan != m_chunks.begin()) {
-        --scan;
-        if (scan->size() >= kChunkSize) {
-            ++scan;
-        }
+void*
+StreamBuffer::reserve(UInt32 n)
+{
+    if (m_capacity - m_tail >= n) {
+        return m_data + m_tail;
     }
-    if (scan == m_chunks.end()) {
-        scan = m_chunks.insert(scan, Chunk());
+
+    UInt32 size = getSize();
+    assert(n <= 0x80000000u - size);
+
+    // slide the data down if that frees enough space.  only do so once
+    // there's more space in front of the data than data, so each byte
+    // is moved at most once for every byte that's been popped.
+    if (m_capacity - size >= n && m_head >= size) {
+        memmove(m_data, m_data + m_head, size);
+        m_head = 0;
+        m_tail = size;
+        return m_data + m_tail;
     }
 
-    // append data in chunks
-    while (n > 0) {
-        // choose number of bytes for next chunk
-        assert(scan->size() <= kChunkSize);
-        UInt32 count = kChunkSize - static_cast<UInt32>(scan->size());
-        if (count > n) {
-            count = n;
+    // otherwise grow the block
+    UInt32 capacity = (m_capacity == 0) ? kMinCapacity : 2 * m_capacity;
+    while (capacity - size < n) {
+        capacity <<= 1;
+    }
+    UInt8* data = new UInt8[capacity];
+    if (size > 0) {
+        memcpy(data, m_data + m_head, size);
+    }
+    delete[] m_data;
+    m_data     = data;
+    m_capacity = capacity;
+    m_head     = 0;
+    m_tail     = size;
+    return m_data + m_tail;
 }
 
-        // transfer data
-        scan->insert(scan->end(), data, data + count);
-        n    -= count;
-        data += count;
-
-        // append another empty chunk if we're not done yet
-        if (n > 0) {
-            ++scan;
-            scan = m_chunks.insert(scan, Chunk());
-        }
-    }
+void
+StreamBuffer::commit(UInt32 n)
+{
+    assert(n <= m_capacity - m_tail);
+    m_tail += n;
 }
 
 UInt32
 StreamBuffer::getSize() const
 {
-    return m_size;
+    return m_tail - m_head;
+}
+
+void
+StreamBuffer::release()
+{
+    delete[] m_data;
+    m_data     = nullptr;
+    m_capacity = 0;
+    m_head     = 0;
+    m_tail     = 0;
 }
@@ -18,13 +18,17 @@
 
 #pragma once
 
-#include "base/EventTypes.h"
-#include "common/stdlist.h"
-#include "common/stdvector.h"
+#include "common/basic_types.h"
 
 //! FIFO of bytes
 /*!
-This class maintains a FIFO (first-in, last-out) buffer of bytes.
+This class maintains a FIFO (first-in, first-out) buffer of bytes.  The
+bytes are kept contiguous in one power-of-two sized block, so peek()
+never has to copy, and writers can fill the buffer in place with
+reserve() and commit() instead of staging data elsewhere first.  Space
+freed at the front is reclaimed by sliding the remaining bytes down
+once they're outnumbered by the freed bytes, and the block only grows
+when that wouldn't make enough room.
 */
 class StreamBuffer {
 public:
@@ -38,7 +42,8 @@ public:
     /*!
     Return a pointer to memory with the next \c n bytes in the buffer
     (which must be <= getSize()).  The caller must not modify the returned
-    memory nor delete it.
+    memory nor delete it.  The pointer is valid until the buffer is next
+    changed.
     */
     const void*            peek(UInt32 n);
 
@@ -55,6 +60,21 @@ public:
     */
     void                write(const void* vdata, UInt32 n);
 
+    //! Reserve space at the end of the buffer
+    /*!
+    Returns a pointer to at least \c n writable bytes following the data
+    in the buffer.  The bytes aren't part of the buffer until commit()
+    is called.  The pointer is valid until the buffer is next changed.
+    */
+    void*                reserve(UInt32 n);
+
+    //! Append reserved data
+    /*!
+    Appends the first \c n bytes of the space returned by the last call
+    to reserve().  \c n must not be more than was reserved.
+    */
+    void                commit(UInt32 n);
+
     //@}
     //! @name accessors
     //@{
@@ -68,12 +88,17 @@ public:
     //@}
 
 private:
-    static const UInt32    kChunkSize;
+    StreamBuffer(const StreamBuffer&);
+    StreamBuffer&        operator=(const StreamBuffer&);
 
-    typedef std::vector<UInt8> Chunk;
-    typedef std::list<Chunk> ChunkList;
+    void                release();
+
+private:
+    static const UInt32    kMinCapacity;
+    static const UInt32    kMaxIdleCapacity;
 
-    ChunkList            m_chunks;
-    UInt32                m_size;
-    UInt32                m_headUsed;
+    UInt8*                m_data;
+    UInt32                m_capacity;
+    UInt32                m_head;
+    UInt32                m_tail;
 };
@@ -62,6 +62,30 @@ StreamFilter::write(const void* buffer, UInt32 n)
     getStream()->write(buffer, n);
 }
 
+void
+StreamFilter::writeBuffers(const Buffer* buffers, UInt32 count)
+{
+    getStream()->writeBuffers(buffers, count);
+}
+
+void
+StreamFilter::writeBulk(const Buffer* buffers, UInt32 count)
+{
+    getStream()->writeBulk(buffers, count);
+}
+
+void
+StreamFilter::cork()
+{
+    getStream()->cork();
+}
+
+void
+StreamFilter::uncork()
+{
+    getStream()->uncork();
+}
+
 void
 StreamFilter::flush()
 {
@@ -98,6 +122,12 @@ StreamFilter::getSize() const
     return getStream()->getSize();
 }
 
+bool
+StreamFilter::hasPendingOutput() const
+{
+    return getStream()->hasPendingOutput();
+}
+
 synergy::IStream*
 StreamFilter::getStream() const
 {
@@ -42,12 +42,17 @@ public:
     virtual void        close();
     virtual UInt32        read(void* buffer, UInt32 n);
     virtual void        write(const void* buffer, UInt32 n);
+    virtual void        writeBuffers(const Buffer* buffers, UInt32 count);
+    virtual void        writeBulk(const Buffer* buffers, UInt32 count);
+    virtual void        cork();
+    virtual void        uncork();
     virtual void        flush();
     virtual void        shutdownInput();
     virtual void        shutdownOutput();
     virtual void*        getEventTarget() const;
     virtual bool        isReady() const;
     virtual UInt32        getSize() const;
+    virtual bool        hasPendingOutput() const;
 
     //! Get the stream
     /*!
@@ -0,0 +1,291 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012-2016 Symless Ltd.
+ * Copyright (C) 2004 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "net/EpollSocketMultiplexer.h"
+
+#if HAVE_SYS_EPOLL_H
+
+#include "arch/unix/ArchNetworkBSD.h"
+#include "base/Log.h"
+#include "base/TMethodJob.h"
+#include "mt/Lock.h"
+#include "mt/Mutex.h"
+#include "mt/Thread.h"
+#include "net/ISocketMultiplexerJob.h"
+#include "net/XSocket.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// the multiplexer whose mutex the current thread holds while running
+// jobs.  jobs may add and remove other sockets.
+static thread_local EpollSocketMultiplexer* s_servicing = nullptr;
+
+static UInt32
+getEvents(const ISocketMultiplexerJob* job)
+{
+    // level triggered.  jobs do one read or write per run so they
+    // need to hear about a socket again if there's more to do.
+    UInt32 events = 0;
+    if (job->isReadable()) {
+        events |= EPOLLIN;
+    }
+    if (job->isWritable()) {
+        events |= EPOLLOUT;
+    }
+    return events;
+}
+
+static int
+getFD(const ISocketMultiplexerJob* job)
+{
+    return job->getSocket()->m_fd;
+}
+
+//
+// EpollSocketMultiplexer
+//
+
+EpollSocketMultiplexer::EpollSocketMultiplexer() :
+    m_epoll(-1),
+    m_wakeup(-1),
+    m_mutex(nullptr),
+    m_thread(nullptr)
+{
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll == -1) {
+        throw XSocketCreate(strerror(errno));
+    }
+
+    // the service thread is woken through an eventfd, which has a
+    // NULL entry
+    m_wakeup = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    struct epoll_event event = {};
+    event.events   = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (m_wakeup == -1 ||
+            epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup, &event) == -1) {
+        int error = errno;
+        if (m_wakeup != -1) {
+            close(m_wakeup);
+        }
+        close(m_epoll);
+        throw XSocketCreate(strerror(error));
+    }
+
+    m_mutex  = new Mutex;
+    m_thread = new Thread(new TMethodJob<EpollSocketMultiplexer>(
+                                this, &EpollSocketMultiplexer::serviceThread));
+}
+
+EpollSocketMultiplexer::~EpollSocketMultiplexer()
+{
+    m_thread->cancel();
+    uint64_t one = 1;
+    ssize_t n  = write(m_wakeup, &one, sizeof(one));
+    (void)n;
+    m_thread->wait();
+    delete m_thread;
+
+    for (auto& entry : m_entries) {
+        delete entry.second->m_job;
+        delete entry.second;
+    }
+    for (Entry* entry : m_removed) {
+        delete entry;
+    }
+    delete m_mutex;
+    close(m_wakeup);
+    close(m_epoll);
+}
+
+void
+EpollSocketMultiplexer::addSocket(ISocket* socket, ISocketMultiplexerJob* job)
+{
+    assert(socket != NULL);
+    assert(job    != NULL);
+
+    lock();
+    auto i = m_entries.find(socket);
+    if (i != m_entries.end()) {
+        setJob(i->second, job);
+    }
+    else {
+        auto* entry     = new Entry;
+        entry->m_socket = socket;
+        entry->m_job    = job;
+        entry->m_fd     = getFD(job);
+        entry->m_events = getEvents(job);
+
+        struct epoll_event event = {};
+        event.events   = entry->m_events;
+        event.data.ptr = entry;
+        if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, entry->m_fd, &event) == -1) {
+            LOG((CLOG_WARN "can't watch socket: %s", strerror(errno)));
+            delete job;
+            delete entry;
+        }
+        else {
+            m_entries.insert(std::make_pair(socket, entry));
+        }
+    }
+    unlock();
+}
+
+void
+EpollSocketMultiplexer::removeSocket(ISocket* socket)
+{
+    assert(socket != NULL);
+
+    lock();
+    auto i = m_entries.find(socket);
+    if (i != m_entries.end()) {
+        removeEntry(i);
+    }
+    unlock();
+}
+
+void
+EpollSocketMultiplexer::serviceThread(void* /*unused*/)
+{
+    struct epoll_event events[kMaxEvents];
+    for (;;) {
+        Thread::testCancel();
+
+        int n = epoll_wait(m_epoll, events, kMaxEvents, -1);
+        if (n == -1) {
+            if (errno != EINTR) {
+                LOG((CLOG_WARN "error in socket multiplexer: %s", strerror(errno)));
+            }
+            continue;
+        }
+
+        Lock lock(m_mutex);
+        s_servicing = this;
+        for (int i = 0; i < n; ++i) {
+            auto* entry = static_cast<Entry*>(events[i].data.ptr);
+            if (entry == nullptr) {
+                uint64_t count;
+                ssize_t size = read(m_wakeup, &count, sizeof(count));
+                (void)size;
+                continue;
+            }
+
+            // skip sockets removed since epoll_wait() returned
+            ISocketMultiplexerJob* job = entry->m_job;
+            if (job == nullptr) {
+                continue;
+            }
+
+            // a hang up is reported as readable so the job reads the
+            // end of the stream
+            UInt32 revents = events[i].events;
+            bool read  = ((revents & (EPOLLIN | EPOLLHUP)) != 0);
+            bool write = ((revents & EPOLLOUT) != 0);
+            bool error = ((revents & EPOLLERR) != 0);
+
+            ISocketMultiplexerJob* newJob = job->run(read, write, error);
+            if (newJob == nullptr) {
+                removeEntry(m_entries.find(entry->m_socket));
+            }
+            else if (newJob != job) {
+                setJob(entry, newJob);
+            }
+        }
+        s_servicing = nullptr;
+
+        // nothing can refer to removed entries any more
+        for (Entry* entry : m_removed) {
+            delete entry;
+        }
+        m_removed.clear();
+    }
+}
+
+void
+EpollSocketMultiplexer::setJob(Entry* entry, ISocketMultiplexerJob* job)
+{
+    if (entry->m_job == job) {
+        return;
+    }
+    delete entry->m_job;
+    entry->m_job = job;
+
+    // only tell the kernel if something changed
+    int fd        = getFD(job);
+    UInt32 events = getEvents(job);
+    if (fd != entry->m_fd) {
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, entry->m_fd, nullptr);
+        entry->m_fd     = fd;
+        entry->m_events = events;
+
+        struct epoll_event event = {};
+        event.events   = events;
+        event.data.ptr = entry;
+        if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) == -1) {
+            LOG((CLOG_WARN "can't watch socket: %s", strerror(errno)));
+        }
+    }
+    else if (events != entry->m_events) {
+        entry->m_events = events;
+
+        struct epoll_event event = {};
+        event.events   = events;
+        event.data.ptr = entry;
+        if (epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &event) == -1) {
+            LOG((CLOG_WARN "can't watch socket: %s", strerror(errno)));
+        }
+    }
+}
+
+void
+EpollSocketMultiplexer::removeEntry(EntryMap::iterator i)
+{
+    Entry* entry = i->second;
+    m_entries.erase(i);
+
+    // the socket may already be closed, in which case the kernel has
+    // forgotten it anyway
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, entry->m_fd, nullptr);
+
+    delete entry->m_job;
+    entry->m_job = nullptr;
+    m_removed.push_back(entry);
+}
+
+void
+EpollSocketMultiplexer::lock()
+{
+    if (s_servicing != this) {
+        m_mutex->lock();
+    }
+}
+
+void
+EpollSocketMultiplexer::unlock()
+{
+    if (s_servicing != this) {
+        m_mutex->unlock();
+    }
+}
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2012-2016 Symless Ltd.
+ * Copyright (C) 2004 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/basic_types.h"
+#include "common/stdvector.h"
+
+#include <unordered_map>
+
+class Mutex;
+class Thread;
+class ISocket;
+class ISocketMultiplexerJob;
+
+//! Socket multiplexer using epoll
+/*!
+Services sockets for SocketMultiplexer on Linux.  Sockets stay
+registered with the kernel from one iteration to the next so adding,
+removing or changing the job for a socket is a single epoll_ctl() that
+doesn't have to wake the service thread, and each iteration only
+visits the sockets that are ready.  Only built where <sys/epoll.h> is
+available.
+*/
+class EpollSocketMultiplexer {
+public:
+    /*!
+    Throws XSocketCreate if the epoll instance can't be created.
+    */
+    EpollSocketMultiplexer();
+    ~EpollSocketMultiplexer();
+
+    //! @name manipulators
+    //@{
+
+    //! Set the job for a socket
+    /*!
+    Adds \c socket or replaces its job.  The multiplexer adopts \c job.
+    */
+    void                addSocket(ISocket* socket, ISocketMultiplexerJob* job);
+
+    //! Stop servicing a socket
+    void                removeSocket(ISocket* socket);
+
+    //@}
+
+private:
+    // a registered socket.  the epoll events for the socket point at
+    // this so entries are only freed by the service thread, between
+    // iterations.
+    struct Entry {
+    public:
+        ISocket*               m_socket;
+        ISocketMultiplexerJob* m_job;
+        int                    m_fd;
+        UInt32                 m_events;
+    };
+    typedef std::unordered_map<ISocket*, Entry*> EntryMap;
+
+    void                serviceThread(void*);
+
+    // replace the job of an entry and update its registration.  the
+    // caller must hold m_mutex.
+    void                setJob(Entry*, ISocketMultiplexerJob*);
+
+    // unregister an entry and queue it for deletion.  the caller must
+    // hold m_mutex.
+    void                removeEntry(EntryMap::iterator);
+
+    // lock m_mutex unless the service thread already holds it
+    void                lock();
+    void                unlock();
+
+private:
+    // most events handled per epoll_wait()
+    static const int    kMaxEvents = 64;
+
+    int                 m_epoll;
+    int                 m_wakeup;
+    Mutex*              m_mutex;
+    Thread*             m_thread;
+    EntryMap            m_entries;
+    std::vector<Entry*> m_removed;
+};
@@ -0,0 +1,56 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "net/ISocket.h"
+
+//! Datagram socket interface
+/*!
+This interface defines the methods of sockets that send and receive
+unreliable datagrams.  Datagrams may be lost, duplicated or reordered.
+The socket sends an IStream input ready event when a datagram arrives
+and none were waiting, so a handler should receive until none are left.
+*/
+class IDatagramSocket : public ISocket {
+public:
+    //! @name manipulators
+    //@{
+
+    //! Send datagram
+    /*!
+    Sends \c n bytes from \c buffer to \c address.  A datagram that
+    can't be sent right away is dropped.
+    */
+    virtual void        sendTo(const void* buffer, UInt32 n,
+                            const NetworkAddress& address) = 0;
+
+    //! Receive datagram
+    /*!
+    Copies the oldest waiting datagram, truncated to \c n bytes, into
+    \c buffer, sets \c address to where it came from and returns its
+    size.  Returns 0 if no datagram is waiting.
+    */
+    virtual UInt32      receiveFrom(void* buffer, UInt32 n,
+                            NetworkAddress& address) = 0;
+
+    //@}
+
+    // ISocket overrides
+    virtual void        bind(const NetworkAddress&) = 0;
+    virtual void        close() = 0;
+    virtual void*       getEventTarget() const = 0;
+};
@@ -22,6 +22,7 @@
 #include "arch/IArchNetwork.h"
 
 class IDataSocket;
+class IDatagramSocket;
 class IListenSocket;
 
 //! Socket factory
@@ -40,5 +41,8 @@ public:
     //! Create listen socket
     virtual IListenSocket*    createListen(IArchNetwork::EAddressFamily family = IArchNetwork::kINET) const = 0;
 
+    //! Create datagram socket
+    virtual IDatagramSocket*    createDatagram(IArchNetwork::EAddressFamily family = IArchNetwork::kINET) const = 0;
+
     //@}
 };
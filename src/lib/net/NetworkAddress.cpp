@@ -48,6 +48,14 @@ NetworkAddress::NetworkAddress(int port) :
     ARCH->setAddrPort(m_address, m_port);
 }
 
+NetworkAddress::NetworkAddress(ArchNetAddress address) :
+    m_address(address),
+    m_hostname(ARCH->addrToString(address)),
+    m_port(ARCH->getAddrPort(address))
+{
+    // do nothing
+}
+
 NetworkAddress::NetworkAddress(const NetworkAddress& addr) :
     m_address(addr.m_address != nullptr ? ARCH->copyAddr(addr.m_address) : nullptr),
     m_hostname(addr.m_hostname),
@@ -51,6 +51,13 @@ public:
     */
     NetworkAddress(String  hostname, int port);
 
+    /*!
+    Construct the network address for the resolved \c address, such as
+    one a datagram came from.  \c address is adopted.  The hostname is
+    the address in numerical form.
+    */
+    explicit NetworkAddress(ArchNetAddress address);
+
     NetworkAddress(const NetworkAddress&);
 
     ~NetworkAddress();
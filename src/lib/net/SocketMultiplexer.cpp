@@ -27,13 +27,15 @@
 #include "mt/Lock.h"
 #include "mt/Mutex.h"
 #include "mt/Thread.h"
+#include "net/EpollSocketMultiplexer.h"
 #include "net/ISocketMultiplexerJob.h"
+#include "net/XSocket.h"
 
 //
 // SocketMultiplexer
 //
 
-SocketMultiplexer::SocketMultiplexer() :
+SocketMultiplexer::SocketMultiplexer(EBackend backend) :
     m_mutex(new Mutex),
     m_thread(nullptr),
     m_update(false),
@@ -41,7 +43,8 @@ SocketMultiplexer::SocketMultiplexer() :
     m_jobListLock(new CondVar<bool>(m_mutex, false)),
     m_jobListLockLocked(new CondVar<bool>(m_mutex, false)),
     m_jobListLocker(nullptr),
-    m_jobListLockLocker(nullptr)
+    m_jobListLockLocker(nullptr),
+    m_epoll(nullptr)
 {
     // this pointer just has to be unique and not NULL.  it will
     // never be dereferenced.  it's used to identify cursor nodes
@@ -49,6 +52,21 @@ SocketMultiplexer::SocketMultiplexer() :
     // TODO(andrew): Remove this evilness
     m_cursorMark = reinterpret_cast<ISocketMultiplexerJob*>(this);
 
+    if (backend == kEpoll) {
+#if HAVE_SYS_EPOLL_H
+        try {
+            m_epoll = new EpollSocketMultiplexer;
+            LOG((CLOG_DEBUG "using epoll socket multiplexer"));
+            return;
+        }
+        catch (XSocketCreate& e) {
+            LOG((CLOG_NOTE "can't use epoll, using poll: %s", e.what()));
+        }
+#else
+        LOG((CLOG_NOTE "epoll not supported, using poll"));
+#endif
+    }
+
     // start thread
     m_thread = new Thread(new TMethodJob<SocketMultiplexer>(
                                 this, &SocketMultiplexer::serviceThread));
@@ -56,10 +74,13 @@ SocketMultiplexer::SocketMultiplexer() :
 
 SocketMultiplexer::~SocketMultiplexer()
 {
-    m_thread->cancel();
-    m_thread->unblockPollSocket();
-    m_thread->wait();
-    delete m_thread;
+    if (m_thread != nullptr) {
+        m_thread->cancel();
+        m_thread->unblockPollSocket();
+        m_thread->wait();
+        delete m_thread;
+    }
+    delete m_epoll;
     delete m_jobsReady;
     delete m_jobListLock;
     delete m_jobListLockLocked;
@@ -79,6 +100,11 @@ SocketMultiplexer::addSocket(ISocket* socket, ISocketMultiplexerJob* job)
     assert(socket != NULL);
     assert(job    != NULL);
 
+    if (m_epoll != nullptr) {
+        m_epoll->addSocket(socket, job);
+        return;
+    }
+
     // prevent other threads from locking the job list
     lockJobListLock();
 
@@ -116,6 +142,11 @@ SocketMultiplexer::removeSocket(ISocket* socket)
 {
     assert(socket != NULL);
 
+    if (m_epoll != nullptr) {
+        m_epoll->removeSocket(socket);
+        return;
+    }
+
     // prevent other threads from locking the job list
     lockJobListLock();
 
@@ -28,6 +28,7 @@ class Mutex;
 class Thread;
 class ISocket;
 class ISocketMultiplexerJob;
+class EpollSocketMultiplexer;
 
 //! Socket multiplexer
 /*!
@@ -35,7 +36,17 @@ A socket multiplexer services multiple sockets simultaneously.
 */
 class SocketMultiplexer {
 public:
-    SocketMultiplexer();
+    //! Ways of waiting on sockets
+    enum EBackend {
+        kPoll,              //!< poll(), everywhere
+        kEpoll              //!< epoll, Linux only
+    };
+
+    /*!
+    Services sockets with \c backend, or with poll() if \c backend
+    isn't available.
+    */
+    SocketMultiplexer(EBackend backend = kPoll);
     ~SocketMultiplexer();
 
     //! @name manipulators
@@ -108,4 +119,7 @@ private:
     SocketJobMap        m_socketJobMap;
     ISocketMultiplexerJob*
                         m_cursorMark;
+
+    EpollSocketMultiplexer*
+                        m_epoll;
 };
@@ -65,7 +65,13 @@ TCPSocket::TCPSocket(IEventQueue* events, SocketMultiplexer* socketMultiplexer,
     // socket starts in connected state
     init();
     onConnected();
-    setJob(newJob());
+
+    ISocketMultiplexerJob* job;
+    {
+        Lock lock(&m_mutex);
+        job = newJob();
+    }
+    setJob(job);
 }
 
 TCPSocket::~TCPSocket()
@@ -152,7 +158,26 @@ TCPSocket::read(void* buffer, UInt32 n)
 void
 TCPSocket::write(const void* buffer, UInt32 n)
 {
-    bool wasEmpty;
+    Buffer data = { buffer, n };
+    writeBuffers(&data, 1);
+}
+
+void
+TCPSocket::writeBuffers(const Buffer* buffers, UInt32 count)
+{
+    writeData(buffers, count, false);
+}
+
+void
+TCPSocket::writeBulk(const Buffer* buffers, UInt32 count)
+{
+    writeData(buffers, count, true);
+}
+
+void
+TCPSocket::writeData(const Buffer* buffers, UInt32 count, bool bulk)
+{
+    ISocketMultiplexerJob* job;
     {
         Lock lock(&m_mutex);
 
@@ -163,27 +188,89 @@ TCPSocket::write(const void* buffer, UInt32 n)
         }
 
         // ignore empty writes
+        UInt32 n = 0;
+        for (UInt32 i = 0; i < count; ++i) {
+            n += buffers[i].m_size;
+        }
         if (n == 0) {
             return;
         }
 
-        // copy data to the output buffer
-        wasEmpty = (m_outputBuffer.getSize() == 0);
-        m_outputBuffer.write(buffer, n);
+        // copy data to the output buffer.  bulk data waits in its own
+        // buffer until doWrite() finds nothing else to send.
+        bool wasEmpty = !hasOutput();
+        StreamBuffer& output = bulk ? m_bulkBuffer : m_outputBuffer;
+        UInt8* data = static_cast<UInt8*>(output.reserve(n));
+        for (UInt32 i = 0; i < count; ++i) {
+            memcpy(data, buffers[i].m_data, buffers[i].m_size);
+            data += buffers[i].m_size;
+        }
+        output.commit(n);
+        if (bulk) {
+            m_bulkSizes.push_back(n);
+        }
 
         // there's data to write
         m_flushed = false;
+
+        // while corked, uncork() starts the write
+        if (m_corked > 0) {
+            m_corkedWrite = m_corkedWrite || wasEmpty;
+            return;
+        }
+
+        // make sure we're waiting to write
+        if (!wasEmpty) {
+            return;
+        }
+        job = newJob();
     }
+    setJob(job);
+}
+
+void
+TCPSocket::cork()
+{
+    Lock lock(&m_mutex);
+    ++m_corked;
+}
+
+void
+TCPSocket::uncork()
+{
+    ISocketMultiplexerJob* job;
+    {
+        Lock lock(&m_mutex);
+        assert(m_corked > 0);
+        if (--m_corked > 0 || !m_corkedWrite) {
+            return;
+        }
+        m_corkedWrite = false;
 
-    // make sure we're waiting to write
-    if (wasEmpty) {
-        setJob(newJob());
+        // start writing what was held back
+        job = newJob();
     }
+    setJob(job);
 }
 
 void
 TCPSocket::flush()
 {
+    // data held back by cork() has to go now
+    ISocketMultiplexerJob* job = nullptr;
+    bool corkedWrite;
+    {
+        Lock lock(&m_mutex);
+        corkedWrite   = m_corkedWrite;
+        m_corkedWrite = false;
+        if (corkedWrite) {
+            job = newJob();
+        }
+    }
+    if (corkedWrite) {
+        setJob(job);
+    }
+
     Lock lock(&m_mutex);
     while (!m_flushed) {
         m_flushed.wait();
@@ -193,6 +280,7 @@ TCPSocket::flush()
 void
 TCPSocket::shutdownInput()
 {
+    ISocketMultiplexerJob* job = nullptr;
     bool useNewJob = false;
     {
         Lock lock(&m_mutex);
@@ -210,16 +298,18 @@ TCPSocket::shutdownInput()
             sendEvent(m_events->forIStream().inputShutdown());
             onInputShutdown();
             useNewJob = true;
+            job       = newJob();
         }
     }
     if (useNewJob) {
-        setJob(newJob());
+        setJob(job);
     }
 }
 
 void
 TCPSocket::shutdownOutput()
 {
+    ISocketMultiplexerJob* job = nullptr;
     bool useNewJob = false;
     {
         Lock lock(&m_mutex);
@@ -237,10 +327,11 @@ TCPSocket::shutdownOutput()
             sendEvent(m_events->forIStream().outputShutdown());
             onOutputShutdown();
             useNewJob = true;
+            job       = newJob();
         }
     }
     if (useNewJob) {
-        setJob(newJob());
+        setJob(job);
     }
 }
 
@@ -264,9 +355,23 @@ TCPSocket::getSize() const
     return m_inputBuffer.getSize();
 }
 
+bool
+TCPSocket::hasPendingOutput() const
+{
+    Lock lock(&m_mutex);
+    if (m_outputBuffer.getSize() == 0) {
+        return false;
+    }
+
+    // the caller is now waiting for the buffer to empty
+    m_drainWanted = true;
+    return true;
+}
+
 void
 TCPSocket::connect(const NetworkAddress& addr)
 {
+    ISocketMultiplexerJob* job;
     {
         Lock lock(&m_mutex);
 
@@ -289,8 +394,9 @@ TCPSocket::connect(const NetworkAddress& addr)
         catch (XArchNetwork& e) {
             throw XSocketConnect(e.what());
         }
+        job = newJob();
     }
-    setJob(newJob());
+    setJob(job);
 }
 
 void
@@ -306,6 +412,10 @@ TCPSocket::init()
         // that should be sent without (much) delay.  for example, the
         // mouse motion messages are much less useful if they're delayed.
         ARCH->setNoDelayOnSocket(m_socket, true);
+
+        // likewise, don't let bulk data pile up in the kernel where we
+        // can't put input ahead of it.  not all platforms can do this.
+        ARCH->setUnsentLimitOnSocket(m_socket, kUnsentLimit);
     }
     catch (XArchNetwork& e) {
         try {
@@ -322,20 +432,18 @@ TCPSocket::init()
 TCPSocket::EJobResult
 TCPSocket::doRead()
 {
-    UInt8 buffer[4096];
-    memset(buffer, 0, sizeof(buffer));
-    size_t bytesRead = 0;
-    
-    bytesRead = ARCH->readSocket(m_socket, buffer, sizeof(buffer));
+    // read straight into the input buffer
+    bool wasEmpty = (m_inputBuffer.getSize() == 0);
+    void* buffer = m_inputBuffer.reserve(kReadSize);
+    size_t bytesRead = ARCH->readSocket(m_socket, buffer, kReadSize);
+    m_inputBuffer.commit(static_cast<UInt32>(bytesRead));
     
     if (bytesRead > 0) {
-        bool wasEmpty = (m_inputBuffer.getSize() == 0);
-        
         // slurp up as much as possible
         do {
-            m_inputBuffer.write(buffer, bytesRead);
-
-            bytesRead = ARCH->readSocket(m_socket, buffer, sizeof(buffer));
+            buffer    = m_inputBuffer.reserve(kReadSize);
+            bytesRead = ARCH->readSocket(m_socket, buffer, kReadSize);
+            m_inputBuffer.commit(static_cast<UInt32>(bytesRead));
         } while (bytesRead > 0);
         
         // send input ready if input buffer was empty
@@ -362,6 +470,11 @@ TCPSocket::doRead()
 TCPSocket::EJobResult
 TCPSocket::doWrite()
 {
+    // bulk data only goes out when there's nothing else to write
+    if (m_outputBuffer.getSize() == 0) {
+        queueBulk();
+    }
+
     // write data
     UInt32 bufferSize = 0;
     int bytesWrote = 0;
@@ -408,13 +521,36 @@ TCPSocket::newJob()
                                 m_socket, m_readable, m_writable);
     }
     else {
-        if (!(m_readable || (m_writable && (m_outputBuffer.getSize() > 0)))) {
+        if (!(m_readable || (m_writable && hasOutput()))) {
             return nullptr;
         }
         return new TSocketMultiplexerMethodJob<TCPSocket>(
                                 this, &TCPSocket::serviceConnected,
                                 m_socket, m_readable,
-                                m_writable && (m_outputBuffer.getSize() > 0));
+                                m_writable && hasOutput());
+    }
+}
+
+bool
+TCPSocket::hasOutput() const
+{
+    return m_outputBuffer.getSize() > 0 || !m_bulkSizes.empty();
+}
+
+void
+TCPSocket::queueBulk()
+{
+    // move whole bulk writes so nothing written later lands inside
+    // one, and stop at a slice so input isn't held up for long
+    UInt32 n = 0;
+    while (!m_bulkSizes.empty() && n < kBulkSlice) {
+        n += m_bulkSizes.front();
+        m_bulkSizes.pop_front();
+    }
+    if (n > 0) {
+        memcpy(m_outputBuffer.reserve(n), m_bulkBuffer.peek(n), n);
+        m_outputBuffer.commit(n);
+        m_bulkBuffer.pop(n);
     }
 }
 
@@ -436,7 +572,11 @@ void
 TCPSocket::discardWrittenData(int bytesWrote)
 {
     m_outputBuffer.pop(bytesWrote);
-    if (m_outputBuffer.getSize() == 0) {
+    if (m_drainWanted && m_outputBuffer.getSize() == 0) {
+        m_drainWanted = false;
+        sendEvent(m_events->forIStream().outputDrained());
+    }
+    if (!hasOutput()) {
         sendEvent(m_events->forIStream().outputFlushed());
         m_flushed = true;
         m_flushed.broadcast();
@@ -462,6 +602,8 @@ void
 TCPSocket::onOutputShutdown()
 {
     m_outputBuffer.pop(m_outputBuffer.getSize());
+    m_bulkBuffer.pop(m_bulkBuffer.getSize());
+    m_bulkSizes.clear();
     m_writable = false;
 
     // we're now flushed
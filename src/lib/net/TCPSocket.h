@@ -23,6 +23,7 @@
 #include "mt/CondVar.h"
 #include "mt/Mutex.h"
 #include "arch/IArchNetwork.h"
+#include "common/stddeque.h"
 
 class Mutex;
 class Thread;
@@ -48,12 +49,17 @@ public:
     // IStream overrides
     virtual UInt32        read(void* buffer, UInt32 n);
     virtual void        write(const void* buffer, UInt32 n);
+    virtual void        writeBuffers(const Buffer* buffers, UInt32 count);
+    virtual void        writeBulk(const Buffer* buffers, UInt32 count);
+    virtual void        cork();
+    virtual void        uncork();
     virtual void        flush();
     virtual void        shutdownInput();
     virtual void        shutdownOutput();
     virtual bool        isReady() const;
     virtual bool        isFatal() const;
     virtual UInt32        getSize() const;
+    virtual bool        hasPendingOutput() const;
 
     // IDataSocket overrides
     virtual void        connect(const NetworkAddress&);
@@ -86,6 +92,10 @@ protected:
 
 private:
     void                init();
+    void                writeData(const Buffer* buffers, UInt32 count,
+                            bool bulk);
+    bool                hasOutput() const;
+    void                queueBulk();
 
     void                sendConnectionFailedEvent(const char*);
     void                onConnected();
@@ -109,8 +119,23 @@ protected:
     StreamBuffer        m_outputBuffer;
     
 private:
+    // bytes to make room for before each socket read
+    static const UInt32    kReadSize = 4096;
+
+    // bulk data moved to the output buffer at a time.  input written
+    // while it's being sent waits for no more than this.
+    static const UInt32    kBulkSlice = 32 * 1024;
+
+    // unsent bytes the kernel may hold before we stop writing
+    static const UInt32    kUnsentLimit = 16 * 1024;
+
     Mutex                m_mutex;
     ArchSocket            m_socket;
     CondVar<bool>        m_flushed;
+    StreamBuffer        m_bulkBuffer;
+    std::deque<UInt32>    m_bulkSizes;
+    UInt32                m_corked{};
+    bool                m_corkedWrite{};
+    mutable bool        m_drainWanted{};
     SocketMultiplexer*    m_socketMultiplexer;
 };
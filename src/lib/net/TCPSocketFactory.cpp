@@ -21,6 +21,7 @@
 #include "base/Log.h"
 #include "net/TCPListenSocket.h"
 #include "net/TCPSocket.h"
+#include "net/UDPSocket.h"
 
 //
 // TCPSocketFactory
@@ -49,3 +50,9 @@ TCPSocketFactory::createListen(IArchNetwork::EAddressFamily family) const
 {
     return new TCPListenSocket(m_events, m_socketMultiplexer, family);
 }
+
+IDatagramSocket*
+TCPSocketFactory::createDatagram(IArchNetwork::EAddressFamily family) const
+{
+    return new UDPSocket(m_events, m_socketMultiplexer, family);
+}
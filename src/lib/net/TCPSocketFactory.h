@@ -24,7 +24,7 @@
 class IEventQueue;
 class SocketMultiplexer;
 
-//! Socket factory for TCP sockets
+//! Socket factory for TCP sockets, and UDP for datagrams
 class TCPSocketFactory : public ISocketFactory {
 public:
     TCPSocketFactory(IEventQueue* events, SocketMultiplexer* socketMultiplexer);
@@ -35,6 +35,8 @@ public:
                         create(IArchNetwork::EAddressFamily family = IArchNetwork::kINET) const;
     virtual IListenSocket*
                         createListen(IArchNetwork::EAddressFamily family = IArchNetwork::kINET) const;
+    virtual IDatagramSocket*
+                        createDatagram(IArchNetwork::EAddressFamily family = IArchNetwork::kINET) const;
 
 private:
     IEventQueue*        m_events;
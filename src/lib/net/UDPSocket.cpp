@@ -0,0 +1,225 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "net/UDPSocket.h"
+
+#include "arch/Arch.h"
+#include "arch/XArch.h"
+#include "base/IEventQueue.h"
+#include "base/Log.h"
+#include "io/XIO.h"
+#include "mt/Lock.h"
+#include "mt/Mutex.h"
+#include "net/NetworkAddress.h"
+#include "net/SocketMultiplexer.h"
+#include "net/TSocketMultiplexerMethodJob.h"
+#include "net/XSocket.h"
+
+#include <cstring>
+
+//
+// UDPSocket
+//
+
+UDPSocket::UDPSocket(IEventQueue* events, SocketMultiplexer* socketMultiplexer, IArchNetwork::EAddressFamily family) :
+    m_events(events),
+    m_socketMultiplexer(socketMultiplexer),
+    m_reading(false)
+{
+    m_mutex = new Mutex;
+    try {
+        m_socket = ARCH->newSocket(family, IArchNetwork::kDGRAM);
+    }
+    catch (XArchNetwork& e) {
+        delete m_mutex;
+        throw XSocketCreate(e.what());
+    }
+}
+
+UDPSocket::~UDPSocket()
+{
+    try {
+        if (m_socket != nullptr) {
+            m_socketMultiplexer->removeSocket(this);
+            ARCH->closeSocket(m_socket);
+        }
+    }
+    catch (...) {
+        // ignore
+    }
+    clearDatagrams();
+    delete m_mutex;
+}
+
+void
+UDPSocket::bind(const NetworkAddress& addr)
+{
+    try {
+        Lock lock(m_mutex);
+        ARCH->setReuseAddrOnSocket(m_socket, true);
+        ARCH->bindSocket(m_socket, addr.getAddress());
+    }
+    catch (XArchNetworkAddressInUse& e) {
+        throw XSocketAddressInUse(e.what());
+    }
+    catch (XArchNetwork& e) {
+        throw XSocketBind(e.what());
+    }
+    setReadJob();
+}
+
+void
+UDPSocket::close()
+{
+    // the multiplexer runs our job holding its own lock so don't hold
+    // ours while calling it
+    m_socketMultiplexer->removeSocket(this);
+
+    Lock lock(m_mutex);
+    if (m_socket == nullptr) {
+        throw XIOClosed();
+    }
+    try {
+        ARCH->closeSocket(m_socket);
+        m_socket = nullptr;
+    }
+    catch (XArchNetwork& e) {
+        throw XSocketIOClose(e.what());
+    }
+    clearDatagrams();
+}
+
+void*
+UDPSocket::getEventTarget() const
+{
+    return const_cast<void*>(static_cast<const void*>(this));
+}
+
+void
+UDPSocket::sendTo(const void* buffer, UInt32 n, const NetworkAddress& address)
+{
+    {
+        Lock lock(m_mutex);
+        if (m_socket == nullptr) {
+            return;
+        }
+        try {
+            ARCH->writeSocketTo(m_socket, buffer, n, address.getAddress());
+        }
+        catch (XArchNetwork& e) {
+            // datagrams are allowed to go missing
+            LOG((CLOG_DEBUG1 "dropped datagram: %s", e.what()));
+        }
+        if (m_reading) {
+            return;
+        }
+    }
+
+    // sending bound the socket so replies can arrive now
+    setReadJob();
+}
+
+UInt32
+UDPSocket::receiveFrom(void* buffer, UInt32 n, NetworkAddress& address)
+{
+    Lock lock(m_mutex);
+    if (m_datagrams.empty()) {
+        return 0;
+    }
+
+    Datagram& datagram = m_datagrams.front();
+    UInt32 size = static_cast<UInt32>(datagram.m_data.size());
+    memcpy(buffer, datagram.m_data.data(), size < n ? size : n);
+    address = NetworkAddress(datagram.m_address);
+    m_datagrams.pop_front();
+    return size;
+}
+
+void
+UDPSocket::setReadJob()
+{
+    ArchSocket socket;
+    {
+        Lock lock(m_mutex);
+        if (m_socket == nullptr) {
+            return;
+        }
+        m_reading = true;
+        socket    = m_socket;
+    }
+    m_socketMultiplexer->addSocket(this,
+                            new TSocketMultiplexerMethodJob<UDPSocket>(
+                                this, &UDPSocket::serviceReadable,
+                                socket, true, false));
+}
+
+void
+UDPSocket::clearDatagrams()
+{
+    for (auto& datagram : m_datagrams) {
+        ARCH->closeAddr(datagram.m_address);
+    }
+    m_datagrams.clear();
+}
+
+ISocketMultiplexerJob*
+UDPSocket::serviceReadable(ISocketMultiplexerJob* job,
+                            bool read, bool /*unused*/, bool error)
+{
+    if (!read && !error) {
+        return job;
+    }
+
+    Lock lock(m_mutex);
+    if (m_socket == nullptr) {
+        return nullptr;
+    }
+
+    // read everything waiting.  an error is usually an ICMP message for
+    // an earlier datagram and reading clears it.
+    bool wasEmpty = m_datagrams.empty();
+    UInt8 buffer[kMaxSize];
+    for (;;) {
+        ArchNetAddress from = nullptr;
+        size_t n;
+        try {
+            n = ARCH->readSocketFrom(m_socket, buffer, sizeof(buffer), &from);
+        }
+        catch (XArchNetwork& e) {
+            LOG((CLOG_DEBUG1 "error reading datagram: %s", e.what()));
+            break;
+        }
+        if (from == nullptr) {
+            break;
+        }
+
+        // the newest datagrams are the most useful
+        if (m_datagrams.size() == kMaxWaiting) {
+            ARCH->closeAddr(m_datagrams.front().m_address);
+            m_datagrams.pop_front();
+        }
+        Datagram datagram;
+        datagram.m_address = from;
+        datagram.m_data.assign(reinterpret_cast<const char*>(buffer), n);
+        m_datagrams.push_back(datagram);
+    }
+
+    if (wasEmpty && !m_datagrams.empty()) {
+        m_events->addEvent(Event(m_events->forIStream().inputReady(),
+                            getEventTarget(), nullptr));
+    }
+    return job;
+}
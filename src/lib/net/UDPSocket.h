@@ -0,0 +1,79 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "net/IDatagramSocket.h"
+#include "arch/IArchNetwork.h"
+#include "base/String.h"
+#include "common/stddeque.h"
+
+class Mutex;
+class ISocketMultiplexerJob;
+class IEventQueue;
+class SocketMultiplexer;
+
+//! UDP datagram socket
+/*!
+A datagram socket using UDP.  Datagrams are read as they arrive and
+held until receiveFrom();  if too many are waiting the oldest are
+dropped.
+*/
+class UDPSocket : public IDatagramSocket {
+public:
+    UDPSocket(IEventQueue* events, SocketMultiplexer* socketMultiplexer, IArchNetwork::EAddressFamily family);
+    virtual ~UDPSocket();
+
+    // ISocket overrides
+    virtual void        bind(const NetworkAddress&);
+    virtual void        close();
+    virtual void*       getEventTarget() const;
+
+    // IDatagramSocket overrides
+    virtual void        sendTo(const void* buffer, UInt32 n,
+                            const NetworkAddress& address);
+    virtual UInt32      receiveFrom(void* buffer, UInt32 n,
+                            NetworkAddress& address);
+
+private:
+    void                setReadJob();
+    void                clearDatagrams();
+
+    ISocketMultiplexerJob*
+                        serviceReadable(ISocketMultiplexerJob*,
+                            bool, bool, bool);
+
+private:
+    struct Datagram {
+    public:
+        ArchNetAddress  m_address;
+        String          m_data;
+    };
+    typedef std::deque<Datagram> DatagramList;
+
+    // largest datagram read
+    static const UInt32 kMaxSize = 1500;
+
+    // most datagrams held for receiveFrom()
+    static const UInt32 kMaxWaiting = 64;
+
+    ArchSocket          m_socket;
+    Mutex*              m_mutex;
+    IEventQueue*        m_events;
+    SocketMultiplexer*  m_socketMultiplexer;
+    bool                m_reading;
+    DatagramList        m_datagrams;
+};
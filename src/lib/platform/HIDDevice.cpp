@@ -2,40 +2,406 @@
 // Created by xela on 5/3/18.
 //
 
+#include "arch/Arch.h"
 #include "base/Log.h"
+#include "base/TMethodJob.h"
 #include "core/XScreen.h"
+#include "mt/CondVar.h"
+#include "mt/Lock.h"
+#include "mt/Mutex.h"
+#include "mt/Thread.h"
 #include "HIDDevice.h"
+#include "HIDReportCoalescer.h"
+#include "HIDReportQueue.h"
+#include "HIDReportSource.h"
+#include "HIDStats.h"
+#include "HIDUring.h"
 
-#include <unistd.h>
-#include <fcntl.h>
+#include <cassert>
+#include <cstring>
+
+// how long the host may go without polling before we stop waiting
+// for it and start collapsing reports into the device state.
+const double HIDDevice::s_stallTimeout = 0.25;
+
+// how long to wait between attempts to reopen a gadget that failed.
+const double HIDDevice::s_reopenInterval = 1.0;
+
+// upper bound on any single wait so cancellation is noticed promptly.
+static const double s_pollSlice = 0.1;
+
+HIDDevice::HIDDevice(
+        IHIDSink* sink,
+        const UInt8* defaultDescriptor,
+        UInt32 defaultSize) :
+    m_path(sink->getName()),
+    m_layout(loadLayout(sink, defaultDescriptor, defaultSize)),
+    m_reportSize(m_layout.getReportSize()),
+    m_sink(sink),
+    m_open(false),
+    m_queue(nullptr),
+    m_stats(nullptr),
+    m_coalescer(nullptr),
+    m_source(nullptr),
+    m_mutex(nullptr),
+    m_reportsReady(nullptr),
+    m_writerWaiting(false),
+    m_overflow(false),
+    m_overflowReport(nullptr),
+    m_overflowTime(0.0),
+    m_state(nullptr),
+    m_writer(nullptr),
+    m_uring(nullptr)
+{
+    init();
+}
 
 HIDDevice::HIDDevice(
-        const std::string &path,
+        IHIDSink* sink,
         UInt32 reportSize) :
-    m_path(path),
-    m_reportSize(reportSize)
+    m_path(sink->getName()),
+    m_reportSize(reportSize),
+    m_sink(sink),
+    m_open(false),
+    m_queue(nullptr),
+    m_stats(nullptr),
+    m_coalescer(nullptr),
+    m_source(nullptr),
+    m_mutex(nullptr),
+    m_reportsReady(nullptr),
+    m_writerWaiting(false),
+    m_overflow(false),
+    m_overflowReport(nullptr),
+    m_overflowTime(0.0),
+    m_state(nullptr),
+    m_writer(nullptr),
+    m_uring(nullptr)
 {
-    if ((m_fd = open(path.c_str(), O_RDWR, 0666)) == -1) {
+    init();
+}
+
+void HIDDevice::init() {
+    if (!m_sink->open()) {
+        delete m_sink;
         throw XScreenOpenFailure("failed to open HID device");
     }
+    m_open = true;
+
+    m_queue          = new HIDReportQueue(m_reportSize, QUEUE_SIZE);
+    m_stats          = new HIDStats;
+    m_mutex          = new Mutex;
+    m_reportsReady   = new CondVar<bool>(m_mutex, false);
+    m_overflowReport = new UInt8[m_reportSize]();
+    m_state          = new UInt8[m_reportSize]();
+    m_layout.clear(m_state);
+
+    // the sink holds a reference to the ring if it can use it
+    if (m_sink->getUringFd() != -1) {
+        m_uring = HIDUring::acquire();
+        m_uring->add(this);
+    }
+    else {
+        m_writer = new Thread(new TMethodJob<HIDDevice>(
+                                    this, &HIDDevice::writerThread));
+    }
+
+    LOG((CLOG_DEBUG "hid device created: %s", m_path.c_str()));
+}
+
+HIDReportLayout HIDDevice::loadLayout(
+        const IHIDSink* sink,
+        const UInt8* defaultDescriptor,
+        UInt32 defaultSize) {
+    HIDReportLayout layout;
+    const char* path = sink->getName().c_str();
+
+    std::vector<UInt8> descriptor;
+    if (sink->getDescriptor(descriptor)) {
+        if (layout.parse(&descriptor[0], static_cast<UInt32>(descriptor.size()))) {
+            LOG((CLOG_DEBUG "hid device %s: %u byte reports from gadget descriptor", path, layout.getReportSize()));
+            return layout;
+        }
+        LOG((CLOG_WARN "hid device %s: can't parse gadget report descriptor, using built-in", path));
+    }
+    else {
+        LOG((CLOG_DEBUG "hid device %s: no gadget report descriptor, using built-in", path));
+    }
 
-    LOG((CLOG_DEBUG "hid device created: %s", path.c_str()));
+    layout.parse(defaultDescriptor, defaultSize);
+    return layout;
 }
 
 HIDDevice::~HIDDevice()
 {
-    close(m_fd);
+    if (m_uring != nullptr) {
+        m_uring->remove(this);
+        HIDUring::release(m_uring);
+    }
+    else {
+        m_writer->cancel();
+        m_writer->wait();
+        delete m_writer;
+    }
+    delete[] m_state;
+    delete[] m_overflowReport;
+    delete m_reportsReady;
+    delete m_mutex;
+    delete m_queue;
+    delete m_stats;
+    delete m_coalescer;
+    delete m_source;
+    delete m_sink;
+}
+
+void HIDDevice::getStats(HIDStats::Snapshot& snapshot) const {
+    m_stats->getSnapshot(snapshot);
+}
+
+const std::string& HIDDevice::getPath() const {
+    return m_path;
+}
+
+void HIDDevice::setCoalescer(HIDReportCoalescer* coalescer) {
+    delete m_coalescer;
+    m_coalescer = coalescer;
+}
+
+void HIDDevice::setSource(HIDReportSource* source) {
+    // the writer is already running but never sees a source go away
+    assert(m_source.load() == nullptr);
+    m_source.store(source);
+}
+
+void HIDDevice::wakeWriter() const {
+    if (m_uring != nullptr) {
+        m_uring->wake();
+        return;
+    }
+    Lock lock(m_mutex);
+    m_reportsReady->signal();
+}
+
+void HIDDevice::update(const UInt8* data) const {
+    double now = ARCH->time();
+    m_stats->queued();
+    if (!m_overflow && m_queue->push(data, now)) {
+        // only pay for the mutex (or, with io_uring, a system call)
+        // when the writer has gone to sleep
+        if (m_uring != nullptr) {
+            m_uring->wake();
+        }
+        else if (m_writerWaiting) {
+            Lock lock(m_mutex);
+            m_reportsReady->signal();
+        }
+        return;
+    }
+
+    // the host isn't keeping up.  collapse everything into one report
+    // until the writer has drained the queue and collected it.  that
+    // loses motion but never the latest key and button state.
+    Lock lock(m_mutex);
+    if (!m_overflow) {
+        if (m_queue->push(data, now)) {
+            notifyWriter();
+            return;
+        }
+        LOG((CLOG_WARN "HID report queue full, collapsing reports: %s", m_path.c_str()));
+        memcpy(m_overflowReport, data, m_reportSize);
+        m_overflowTime = now;
+        m_overflow = true;
+    }
+    else if (m_coalescer == nullptr || !m_coalescer->merge(m_overflowReport, data)) {
+        memcpy(m_overflowReport, data, m_reportSize);
+    }
+    m_stats->collapsed();
+    notifyWriter();
+}
+
+void HIDDevice::notifyWriter() const {
+    // m_mutex is held
+    if (m_uring != nullptr) {
+        m_uring->wake();
+    }
+    else {
+        m_reportsReady->signal();
+    }
+}
+
+void HIDDevice::writerThread(void*) {
+    UInt8 report[HIDReportQueue::MAX_REPORT_SIZE];
+    double queuedTime;
+
+    for (;;) {
+        if (!nextReport(report, queuedTime)) {
+            // the producer checks m_writerWaiting after queueing so
+            // it must be set before we look at the queue again.
+            Lock lock(m_mutex);
+            m_writerWaiting = true;
+            while (m_queue->isEmpty() && !m_overflow && !isSourceReady()) {
+                m_reportsReady->wait();
+            }
+            m_writerWaiting = false;
+            continue;
+        }
+
+        send(report, queuedTime);
+    }
+}
+
+bool HIDDevice::nextReport(UInt8* report, double& queuedTime) {
+    if (!m_queue->pop(report, queuedTime)) {
+        if (!m_overflow) {
+            // generated reports only fill the gaps in real input
+            HIDReportSource* source = m_source;
+            if (source == nullptr || !source->read(report)) {
+                return false;
+            }
+            queuedTime = ARCH->time();
+            setState(report);
+            return true;
+        }
+
+        // the producer stops queueing while it has an overflow report
+        // so this is the newest report and nothing can follow it.
+        Lock lock(m_mutex);
+        memcpy(report, m_overflowReport, m_reportSize);
+        queuedTime = m_overflowTime;
+        m_overflow = false;
+        setState(report);
+        return true;
+    }
+
+    // fold in whatever queued up while the last write was waiting
+    // for the host to poll
+    if (m_coalescer != nullptr) {
+        const UInt8* next;
+        UInt32 merged = 0;
+        while ((next = m_queue->peek()) != nullptr &&
+                m_coalescer->merge(report, next)) {
+            m_queue->discard();
+            ++merged;
+        }
+        if (merged != 0) {
+            m_stats->coalesced(merged);
+        }
+    }
+
+    setState(report);
+    return true;
+}
+
+void HIDDevice::send(const UInt8* report, double queuedTime) {
+    double start    = ARCH->time();
+    double deadline = start + s_stallTimeout;
+
+    for (;;) {
+        switch (m_sink->write(report, static_cast<UInt32>(m_reportSize))) {
+        case IHIDSink::kWritten:
+            m_stats->written(queuedTime, start, ARCH->time());
+            return;
+
+        case IHIDSink::kBusy:
+            // the previous report hasn't been collected yet
+            if (!waitWritable(deadline - ARCH->time())) {
+                LOG((CLOG_NOTE "HID host stopped polling: %s", m_path.c_str()));
+                m_stats->stalled();
+                resync();
+                return;
+            }
+            break;
+
+        case IHIDSink::kFailed:
+            m_stats->failed();
+            m_open = false;
+            resync();
+            return;
+        }
+    }
 }
 
-void HIDDevice::update(char* report) const {
-    size_t written = 0;
+bool HIDDevice::waitWritable(double timeout) {
+    while (timeout > 0.0) {
+        Thread::testCancel();
 
-    while (written < m_reportSize) {
-        ssize_t result = write(m_fd, report + written, m_reportSize - written);
-        if (result < 0) {
-            LOG((CLOG_DEBUG "Failed to write to HID device: %s", m_path.c_str()));
-            throw std::runtime_error("failed to write to HID device");
+        double slice = (timeout < s_pollSlice) ? timeout : s_pollSlice;
+        if (m_sink->waitWritable(slice)) {
+            return true;
         }
-        written += result;
+        timeout -= slice;
     }
+    return false;
+}
+
+void HIDDevice::resync() {
+    UInt32 dropped = 0;
+    cancelSource();
+
+    for (;;) {
+        // collapse anything queued into the device state rather than
+        // replaying stale input to the host when it comes back
+        dropped += collapseReports();
+
+        if (!m_open) {
+            if (!m_sink->open()) {
+                ARCH->sleep(s_reopenInterval);
+                continue;
+            }
+            m_open = true;
+            LOG((CLOG_DEBUG "hid device reopened: %s", m_path.c_str()));
+        }
+
+        if (!waitWritable(s_pollSlice)) {
+            continue;
+        }
+
+        switch (m_sink->write(m_state, static_cast<UInt32>(m_reportSize))) {
+        case IHIDSink::kWritten:
+            m_stats->dropped(dropped);
+            LOG((CLOG_NOTE "HID host is back, resynced %s (%u stale reports dropped)", m_path.c_str(), dropped));
+            return;
+
+        case IHIDSink::kBusy:
+            break;
+
+        case IHIDSink::kFailed:
+            m_stats->failed();
+            m_open = false;
+            break;
+        }
+    }
+}
+
+UInt32 HIDDevice::collapseReports() {
+    UInt8 report[HIDReportQueue::MAX_REPORT_SIZE];
+    double queuedTime;
+    UInt32 collapsed = 0;
+    while (nextReport(report, queuedTime)) {
+        ++collapsed;
+    }
+    return collapsed;
+}
+
+bool HIDDevice::hasReports() const {
+    return !m_queue->isEmpty() || m_overflow || isSourceReady();
+}
+
+void HIDDevice::cancelSource() {
+    // don't leave a source to spew at the host when it comes back
+    HIDReportSource* source = m_source;
+    if (source != nullptr) {
+        source->cancel();
+    }
+}
+
+void HIDDevice::setState(const UInt8* report) {
+    memcpy(m_state, report, m_reportSize);
+    if (m_coalescer != nullptr) {
+        m_coalescer->toState(m_state);
+    }
+}
+
+bool HIDDevice::isSourceReady() const {
+    HIDReportSource* source = m_source;
+    return source != nullptr && source->isReady();
 }
@@ -5,19 +5,131 @@
 #pragma once
 
 #include "common/basic_types.h"
+#include "HIDReportLayout.h"
+#include "HIDStats.h"
+#include "IHIDSink.h"
 #include "fstream"
 #include "string"
 
+#include <atomic>
+
+template <class T>
+class CondVar;
+class HIDReportCoalescer;
+class HIDReportQueue;
+class HIDReportSource;
+class HIDUring;
+class Mutex;
+class Thread;
+
+//! HID gadget device
+/*!
+Reports passed to update() are queued and written to an IHIDSink,
+normally the USB gadget, by a writer thread owned by the device, so a
+host that is slow to poll the endpoint never stalls the caller.  If the
+queue fills, newer reports are collapsed into a single overflow report
+until the writer catches up, so the latest key and button state is
+never lost.  Reports queued while a write waits for the host to poll
+can be merged by a HIDReportCoalescer, so at most one report goes out
+per poll.
+
+If the sink can be written through io_uring (see HIDUring), the shared
+ring's driver thread writes the device's reports in place of the
+device's own writer thread, with the same coalescing, statistics and
+recovery.
+
+The gadget is written without blocking.  If the host stops polling
+(suspend) or the gadget goes away (unplug), queued reports are folded
+into the device state instead of piling up, the gadget is reopened if
+necessary, and the state is sent once the host is back so no key or
+button is left stuck.
+
+A device can also have a HIDReportSource, which the writer reads from
+whenever the queue is empty, for long runs of generated reports that
+must go out at the rate the host collects them.
+*/
 class HIDDevice {
 public:
-    HIDDevice(const std::string& path, UInt32 reportSize);
+    //! Open a device with a descriptor driven layout
+    /*!
+    Takes ownership of \c sink.  The report layout comes from the
+    descriptor the gadget was set up with or, if that can't be found,
+    from \c defaultDescriptor.
+    */
+    HIDDevice(IHIDSink* sink,
+              const UInt8* defaultDescriptor, UInt32 defaultSize);
+
+    //! Open a device with a fixed report size and no layout
+    HIDDevice(IHIDSink* sink, UInt32 reportSize);
     virtual ~HIDDevice();
 
+    //! Get output statistics
+    void getStats(HIDStats::Snapshot&) const;
+
+    //! Get the device path
+    const std::string& getPath() const;
+
 protected:
     std::string m_path;
+    HIDReportLayout m_layout;
     size_t m_reportSize;
-    void update(char* data) const;
+    void update(const UInt8* data) const;
+
+    //! Set the report merging strategy
+    /*!
+    Takes ownership of \c coalescer.  Must be called before the first
+    update().
+    */
+    void setCoalescer(HIDReportCoalescer* coalescer);
+
+    //! Set the source of generated reports
+    /*!
+    Takes ownership of \c source, which lives until the device is
+    destroyed.  The writer thread uses the source without locking, so it
+    can be set only once.
+    */
+    void setSource(HIDReportSource* source);
+
+    //! Wake the writer after the source became ready
+    void wakeWriter() const;
+
+private:
+    friend class HIDUring;
+
+    void init();
+    static HIDReportLayout loadLayout(const IHIDSink* sink,
+              const UInt8* defaultDescriptor, UInt32 defaultSize);
+
+    void notifyWriter() const;
+    void writerThread(void*);
+    bool nextReport(UInt8* report, double& queuedTime);
+    UInt32 collapseReports();
+    bool hasReports() const;
+    void cancelSource();
+    void send(const UInt8* report, double queuedTime);
+    bool waitWritable(double timeout);
+    void resync();
+    void setState(const UInt8* report);
+    bool isSourceReady() const;
 
 private:
-    int m_fd;
+    static const UInt32 QUEUE_SIZE = 64;
+    static const double s_stallTimeout;
+    static const double s_reopenInterval;
+
+    IHIDSink* m_sink;
+    bool m_open;
+    HIDReportQueue* m_queue;
+    HIDStats* m_stats;
+    HIDReportCoalescer* m_coalescer;
+    std::atomic<HIDReportSource*> m_source;
+    Mutex* m_mutex;
+    CondVar<bool>* m_reportsReady;
+    std::atomic<bool> m_writerWaiting;
+    mutable std::atomic<bool> m_overflow;
+    UInt8* m_overflowReport;
+    mutable double m_overflowTime;
+    UInt8* m_state;
+    Thread* m_writer;
+    HIDUring* m_uring;
 };
@@ -4,11 +4,12 @@
 
 #include <base/Log.h>
 #include "HIDKeyState.h"
+#include "HIDSink.h"
 
 HIDKeyState::HIDKeyState(
         IEventQueue* events) :
         KeyState(events),
-        m_keyboardDevice("/dev/null")
+        m_keyboardDevice(new HIDGadgetSink("/dev/null"))
 {
     init();
 }
@@ -16,15 +17,15 @@ HIDKeyState::HIDKeyState(
 HIDKeyState::HIDKeyState(
         IEventQueue* events, synergy::KeyMap& keyMap) :
         KeyState(events, keyMap),
-        m_keyboardDevice("/dev/null")
+        m_keyboardDevice(new HIDGadgetSink("/dev/null"))
 {
     init();
 }
 
 HIDKeyState::HIDKeyState(
-        IEventQueue *events, synergy::KeyMap& keyMap, const std::string& keyboardDevice) :
+        IEventQueue *events, synergy::KeyMap& keyMap, IHIDSink* keyboardSink) :
         KeyState(events, keyMap),
-        m_keyboardDevice(keyboardDevice)
+        m_keyboardDevice(keyboardSink)
 {
     init();
 }
@@ -36,7 +37,9 @@ HIDKeyState::~HIDKeyState()
 
 void HIDKeyState::init()
 {
-    // TODO
+    for (UInt32 i = 0; i < kNumButtons; ++i) {
+        m_serverIDToKeyID[i] = kKeyNone;
+    }
 }
 
 bool HIDKeyState::fakeCtrlAltDel()
@@ -68,20 +71,29 @@ void HIDKeyState::getKeyMap(synergy::KeyMap &keyMap)
 
 void HIDKeyState::fakeKeyDown(KeyID id, KeyModifierMask mask, KeyButton serverID) {
     LOG((CLOG_DEBUG "fakeKeyDown (%d, %d)", serverID, id));
-    m_serverIDToKeyIDMap[serverID] = id;
+    if (serverID >= kNumButtons) {
+        return;
+    }
+    m_serverIDToKeyID[serverID] = id;
     m_keyboardDevice.pressKey(id);
 }
 
 bool HIDKeyState::fakeKeyUp(KeyButton serverID) {
     LOG((CLOG_DEBUG "fakeKeyUp (%d)", serverID));
-    auto id = m_serverIDToKeyIDMap.find(serverID);
-    if (id == m_serverIDToKeyIDMap.end()) {
+    if (serverID >= kNumButtons || m_serverIDToKeyID[serverID] == kKeyNone) {
         return false;
-    } else {
-        m_keyboardDevice.releaseKey(id->second);
-        m_serverIDToKeyIDMap.erase(serverID);
-        return true;
     }
+    m_keyboardDevice.releaseKey(m_serverIDToKeyID[serverID]);
+    m_serverIDToKeyID[serverID] = kKeyNone;
+    return true;
+}
+
+UInt32 HIDKeyState::typeText(const String& text) {
+    return m_keyboardDevice.typeText(text);
+}
+
+const HIDKeyboard& HIDKeyState::getKeyboard() const {
+    return m_keyboardDevice;
 }
 
 void HIDKeyState::fakeKey(const KeyState::Keystroke &keystroke)
@@ -11,7 +11,7 @@ class HIDKeyState : public KeyState {
 public:
     HIDKeyState(IEventQueue* events);
     HIDKeyState(IEventQueue* events, synergy::KeyMap& keyMap);
-    HIDKeyState(IEventQueue *events, synergy::KeyMap& keyMap, const std::string& keyboardDevice);
+    HIDKeyState(IEventQueue *events, synergy::KeyMap& keyMap, IHIDSink* keyboardSink);
     ~HIDKeyState();
 
     // IKeyState overrides
@@ -23,6 +23,12 @@ public:
                                     KeyButton serverID);
     virtual bool        fakeKeyUp(KeyButton serverID);
 
+    //! Type text on the keyboard
+    UInt32              typeText(const String& text);
+
+    //! Get the keyboard device
+    const HIDKeyboard&  getKeyboard() const;
+
 protected:
     // KeyState overrides
     virtual void        getKeyMap(synergy::KeyMap& keyMap);
@@ -31,6 +37,7 @@ protected:
 private:
     void                init();
     HIDKeyboard         m_keyboardDevice;
-    std::map<KeyButton, KeyID> m_serverIDToKeyIDMap;
+    // the key each server button is holding down, kKeyNone if it's up
+    KeyID               m_serverIDToKeyID[kNumButtons];
 };
 
@@ -3,220 +3,241 @@
 //
 
 #include <base/Log.h>
+#include <core/XScreen.h>
 #include <X11/keysym.h>
 #include "HIDKeyboard.h"
+#include "HIDReportQueue.h"
+#include "HIDTyper.h"
 
-std::map<KeyID, unsigned char> HIDKeyboard::KEY_TO_USB_MODIFIER = {
-        {kKeyControl_L, 0x01},
-        {kKeyControl_R, 0x10},
-        {kKeyShift_L, 0x02},
-        {kKeyShift_R, 0x20},
-        {kKeyAlt_L, 0x04},
-        {kKeyAlt_R, 0x40},
-        {kKeyMeta_L, 0x08},
-        {kKeyMeta_R, 0x80},
+#include <cstring>
+
+// boot protocol keyboard:  modifiers, reserved byte, LEDs and 6 keys.
+// matches hid/hid.sh.
+const UInt8 HIDKeyboard::DEFAULT_DESCRIPTOR[] = {
+    0x05, 0x01, 0x09, 0x06, 0xa1, 0x01, 0x05, 0x07, 0x19, 0xe0,
+    0x29, 0xe7, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x08,
+    0x81, 0x02, 0x95, 0x01, 0x75, 0x08, 0x81, 0x03, 0x95, 0x05,
+    0x75, 0x01, 0x05, 0x08, 0x19, 0x01, 0x29, 0x05, 0x91, 0x02,
+    0x95, 0x01, 0x75, 0x03, 0x91, 0x03, 0x95, 0x06, 0x75, 0x08,
+    0x15, 0x00, 0x25, 0x65, 0x05, 0x07, 0x19, 0x00, 0x29, 0x65,
+    0x81, 0x00, 0xc0
+};
+
+// HID usages for the modifier keys.  the modifier byte of a report has
+// one bit per usage, starting at kUsageLeftControl.
+static const UInt8 kUsageLeftControl = 0xe0;
+static const UInt8 kUsageRightGUI = 0xe7;
+
+// HID usage for a KeyID, or 0 if the key has none.  only evaluated at
+// compile time, to fill in s_usageTable.
+static constexpr UInt8 keyToUsage(KeyID id) {
+    if (id >= XK_a && id <= XK_z) {
+        return static_cast<UInt8>(0x04 + (id - XK_a));
+    }
+    if (id >= XK_A && id <= XK_Z) {
+        return static_cast<UInt8>(0x04 + (id - XK_A));
+    }
+    if (id >= XK_1 && id <= XK_9) {
+        return static_cast<UInt8>(0x1e + (id - XK_1));
+    }
+    if (id >= kKeyF1 && id <= kKeyF12) {
+        return static_cast<UInt8>(0x3a + (id - kKeyF1));
+    }
+    if (id >= kKeyF13 && id <= kKeyF24) {
+        return static_cast<UInt8>(0x68 + (id - kKeyF13));
+    }
+    if (id >= kKeyKP_1 && id <= kKeyKP_9) {
+        return static_cast<UInt8>(0x59 + (id - kKeyKP_1));
+    }
+
+    switch (id) {
+    case XK_exclam:         return 0x1e;
+    case XK_at:             return 0x1f;
+    case XK_numbersign:     return 0x20;
+    case XK_dollar:         return 0x21;
+    case XK_percent:        return 0x22;
+    case XK_asciicircum:    return 0x23;
+    case XK_ampersand:      return 0x24;
+    case XK_asterisk:       return 0x25;
+    case XK_parenleft:      return 0x26;
+    case XK_0:
+    case XK_parenright:     return 0x27;
+    case kKeyReturn:        return 0x28;
+    case kKeyEscape:        return 0x29;
+    case kKeyBackSpace:     return 0x2a;
+    case kKeyTab:           return 0x2b;
+    case XK_space:          return 0x2c;
+    case XK_minus:
+    case XK_underscore:     return 0x2d;
+    case XK_equal:
+    case XK_plus:           return 0x2e;
+    case XK_bracketleft:
+    case XK_braceleft:      return 0x2f;
+    case XK_bracketright:
+    case XK_braceright:     return 0x30;
+    case XK_backslash:
+    case XK_bar:            return 0x31;
+    case XK_semicolon:
+    case XK_colon:          return 0x33;
+    case XK_apostrophe:
+    case XK_quotedbl:       return 0x34;
+    case XK_quoteleft:
+    case XK_asciitilde:     return 0x35;
+    case XK_comma:
+    case XK_less:           return 0x36;
+    case XK_period:
+    case XK_greater:        return 0x37;
+    case XK_slash:
+    case XK_question:       return 0x38;
+    case kKeyCapsLock:      return 0x39;
+    case kKeyPrint:         return 0x46;
+    case kKeyScrollLock:    return 0x47;
+    case kKeyPause:         return 0x48;
+    case kKeyInsert:        return 0x49;
+    case kKeyHome:          return 0x4a;
+    case kKeyPageUp:        return 0x4b;
+    case kKeyDelete:        return 0x4c;
+    case kKeyEnd:           return 0x4d;
+    case kKeyPageDown:      return 0x4e;
+    case kKeyRight:         return 0x4f;
+    case kKeyLeft:          return 0x50;
+    case kKeyDown:          return 0x51;
+    case kKeyUp:            return 0x52;
+    case kKeyNumLock:       return 0x53;
+    case kKeyKP_Divide:     return 0x54;
+    case kKeyKP_Multiply:   return 0x55;
+    case kKeyKP_Subtract:   return 0x56;
+    case kKeyKP_Add:        return 0x57;
+    case kKeyKP_Enter:      return 0x58;
+    case kKeyKP_0:          return 0x62;
+    case kKeyKP_Decimal:    return 0x63;
+    case kKeyKP_Equal:      return 0x67;
+    case kKeyExecute:       return 0x74;
+    case kKeyHelp:          return 0x75;
+    case kKeyMenu:          return 0x76;
+    case kKeySelect:        return 0x77;
+    case kKeyCancel:        return 0x78;
+    case kKeyRedo:          return 0x79;
+    case kKeyUndo:          return 0x7a;
+    case kKeyFind:          return 0x7e;
+    case kKeyAudioMute:     return 0x7f;
+    case kKeyControl_L:     return 0xe0;
+    case kKeyShift_L:       return 0xe1;
+    case kKeyAlt_L:         return 0xe2;
+    case kKeyMeta_L:        return 0xe3;
+    case kKeyControl_R:     return 0xe4;
+    case kKeyShift_R:       return 0xe5;
+    case kKeyAlt_R:         return 0xe6;
+    case kKeyMeta_R:        return 0xe7;
+    default:                return 0;
+    }
+}
+
+// the only KeyIDs with a usage are Latin-1 keysyms, the synergy
+// function keys at 0xef00 and the extra keys at 0xe000.  each of those
+// gets a 256 entry page in the table.
+enum {
+    kPageLatin1,
+    kPageExtra,
+    kPageFunction,
+    kNumPages
 };
 
-std::map<KeyID, unsigned char> HIDKeyboard::KEY_TO_USB_VALUE = {
-        {XK_a, 0x04},
-        {XK_A, 0x04},
-        {XK_b, 0x05},
-        {XK_B, 0x05},
-        {XK_c, 0x06},
-        {XK_C, 0x06},
-        {XK_d, 0x07},
-        {XK_D, 0x07},
-        {XK_e, 0x08},
-        {XK_E, 0x08},
-        {XK_f, 0x09},
-        {XK_F, 0x09},
-        {XK_g, 0x0a},
-        {XK_G, 0x0a},
-        {XK_h, 0x0b},
-        {XK_H, 0x0b},
-        {XK_i, 0x0c},
-        {XK_I, 0x0c},
-        {XK_j, 0x0d},
-        {XK_J, 0x0d},
-        {XK_k, 0x0e},
-        {XK_K, 0x0e},
-        {XK_l, 0x0f},
-        {XK_L, 0x0f},
-        {XK_m, 0x10},
-        {XK_M, 0x10},
-        {XK_n, 0x11},
-        {XK_N, 0x11},
-        {XK_o, 0x12},
-        {XK_O, 0x12},
-        {XK_p, 0x13},
-        {XK_P, 0x13},
-        {XK_q, 0x14},
-        {XK_Q, 0x14},
-        {XK_r, 0x15},
-        {XK_R, 0x15},
-        {XK_s, 0x16},
-        {XK_S, 0x16},
-        {XK_t, 0x17},
-        {XK_T, 0x17},
-        {XK_u, 0x18},
-        {XK_U, 0x18},
-        {XK_v, 0x19},
-        {XK_V, 0x19},
-        {XK_w, 0x1a},
-        {XK_W, 0x1a},
-        {XK_x, 0x1b},
-        {XK_X, 0x1b},
-        {XK_y, 0x1c},
-        {XK_Y, 0x1c},
-        {XK_z, 0x1d},
-        {XK_Z, 0x1d},
-        {XK_1, 0x1e},
-        {XK_exclam, 0x1e},
-        {XK_2, 0x1f},
-        {XK_at, 0x1f},
-        {XK_3, 0x20},
-        {XK_numbersign, 0x20},
-        {XK_4, 0x21},
-        {XK_dollar, 0x21},
-        {XK_5, 0x22},
-        {XK_percent, 0x22},
-        {XK_6, 0x23},
-        {XK_asciicircum, 0x23},
-        {XK_7, 0x24},
-        {XK_ampersand, 0x24},
-        {XK_8, 0x25},
-        {XK_asterisk, 0x25},
-        {XK_9, 0x26},
-        {XK_parenleft, 0x26},
-        {XK_0, 0x27},
-        {XK_parenright, 0x27},
-        {kKeyReturn, 0x28},
-        {kKeyEscape, 0x29},
-        {kKeyBackSpace, 0x2a},
-        {kKeyTab, 0x2b},
-        {XK_space, 0x2c},
-        {XK_minus, 0x2d},
-        {XK_underscore, 0x2d},
-        {XK_equal, 0x2e},
-        {XK_plus, 0x2e},
-        {XK_bracketleft, 0x2f},
-        {XK_braceleft, 0x2f},
-        {XK_bracketright, 0x30},
-        {XK_braceright, 0x30},
-        {XK_backslash, 0x31},
-        {XK_bar, 0x31},
-        {XK_semicolon, 0x33},
-        {XK_colon, 0x33},
-        {XK_apostrophe, 0x34},
-        {XK_quotedbl, 0x34},
-        {XK_quoteleft, 0x35},
-        {XK_asciitilde, 0x35},
-        {XK_comma, 0x36},
-        {XK_less, 0x36},
-        {XK_period, 0x37},
-        {XK_greater, 0x37},
-        {XK_slash, 0x38},
-        {XK_question, 0x38},
-        {kKeyCapsLock, 0x39},
-        {kKeyF1, 0x3a},
-        {kKeyF2, 0x3b},
-        {kKeyF3, 0x3c},
-        {kKeyF4, 0x3d},
-        {kKeyF5, 0x3e},
-        {kKeyF6, 0x3f},
-        {kKeyF7, 0x40},
-        {kKeyF8, 0x41},
-        {kKeyF9, 0x42},
-        {kKeyF10, 0x43},
-        {kKeyF11, 0x44},
-        {kKeyF12, 0x45},
-        {kKeyPrint, 0x46},
-        {kKeyScrollLock, 0x47},
-        {kKeyPause, 0x48},
-        {kKeyInsert, 0x49},
-        {kKeyHome, 0x4a},
-        {kKeyPageUp, 0x4b},
-        {kKeyDelete, 0x4c},
-        {kKeyEnd, 0x4d},
-        {kKeyPageDown, 0x4e},
-        {kKeyRight, 0x4f},
-        {kKeyLeft, 0x50},
-        {kKeyDown, 0x51},
-        {kKeyUp, 0x52},
-        {kKeyNumLock, 0x53},
-        {kKeyKP_Divide, 0x54},
-        {kKeyKP_Multiply, 0x55},
-        {kKeyKP_Subtract, 0x56},
-        {kKeyKP_Add, 0x57},
-        {kKeyKP_Enter, 0x58},
-        {kKeyKP_1, 0x59},
-        {kKeyKP_2, 0x5a},
-        {kKeyKP_3, 0x5b},
-        {kKeyKP_4, 0x5c},
-        {kKeyKP_5, 0x5d},
-        {kKeyKP_6, 0x5e},
-        {kKeyKP_7, 0x5f},
-        {kKeyKP_8, 0x60},
-        {kKeyKP_9, 0x61},
-        {kKeyKP_0, 0x62},
-        {kKeyKP_Decimal, 0x63},
-        //{"application", 0x65},
-        //{"power", 0x66},
-        {kKeyKP_Equal, 0x67},
-        {kKeyF13, 0x68},
-        {kKeyF14, 0x69},
-        {kKeyF15, 0x6a},
-        {kKeyF16, 0x6b},
-        {kKeyF17, 0x6c},
-        {kKeyF18, 0x6d},
-        {kKeyF19, 0x6e},
-        {kKeyF20, 0x6f},
-        {kKeyF21, 0x70},
-        {kKeyF22, 0x71},
-        {kKeyF23, 0x72},
-        {kKeyF24, 0x73},
-        {kKeyExecute, 0x74},
-        {kKeyHelp, 0x75},
-        {kKeyMenu, 0x76},
-        {kKeySelect, 0x77},
-        {kKeyCancel, 0x78},
-        {kKeyRedo, 0x79},
-        {kKeyUndo, 0x7a},
-        //{"cut", 0x7b},
-        //{"copy", 0x7c},
-        //{"paste", 0x7d},
-        {kKeyFind, 0x7e},
-        {kKeyAudioMute, 0x7f},
+struct UsageTable {
+    UInt8 m_usage[kNumPages][256];
 };
 
+static constexpr UsageTable makeUsageTable() {
+    UsageTable table{};
+    const KeyID base[kNumPages] = { 0x0000, 0xe000, 0xef00 };
+    for (int page = 0; page < kNumPages; ++page) {
+        for (KeyID i = 0; i < 256; ++i) {
+            table.m_usage[page][i] = keyToUsage(base[page] + i);
+        }
+    }
+    return table;
+}
+
+static constexpr UsageTable s_usageTable = makeUsageTable();
+
 HIDKeyboard::HIDKeyboard(
-        const std::string& path) :
-        HIDDevice(path, REPORT_SIZE)
+        IHIDSink* sink) :
+        HIDDevice(sink, DEFAULT_DESCRIPTOR, sizeof(DEFAULT_DESCRIPTOR)),
+        m_nkro(false),
+        m_numKeys(0),
+        m_keysHeld(false),
+        m_liveReports(0),
+        m_typer(nullptr)
 {
+    if (!m_layout.findBits(kHIDPageKeyboard, 0xe0, 0xe7, m_modifierField)) {
+        throw XScreenOpenFailure("unsupported HID keyboard report descriptor");
+    }
+
+    // prefer a bitmap of every key (n-key rollover) to the boot
+    // protocol's array of 6
+    if (m_layout.findBitmap(kHIDPageKeyboard, 0x00,
+                            kUsageLeftControl - 1, m_keysField)) {
+        m_nkro = true;
+        m_layout.clear(m_report);
+        LOG((CLOG_DEBUG "%s: n-key rollover keyboard", m_path.c_str()));
+    }
+    else if (m_layout.findArray(kHIDPageKeyboard, m_keysField)) {
+        m_numKeys = (m_keysField.m_count < MAX_KEYS) ? m_keysField.m_count : MAX_KEYS;
+        LOG((CLOG_DEBUG "%s: %d key rollover keyboard", m_path.c_str(), m_numKeys));
+    }
+    else {
+        throw XScreenOpenFailure("unsupported HID keyboard report descriptor");
+    }
 
+    m_layout.clear(m_idleReport);
+    m_typer = new HIDTyper(*this);
+    setSource(m_typer);
 }
 
 HIDKeyboard::~HIDKeyboard() {
 
 }
 
+UInt8 HIDKeyboard::getUsage(KeyID id) {
+    int page;
+    switch (id >> 8) {
+    case 0x00: page = kPageLatin1;   break;
+    case 0xe0: page = kPageExtra;    break;
+    case 0xef: page = kPageFunction; break;
+    default:   return 0;
+    }
+    return s_usageTable.m_usage[page][id & 0xff];
+}
+
+UInt8 HIDKeyboard::getModifier(UInt8 usage) {
+    if (usage < kUsageLeftControl || usage > kUsageRightGUI) {
+        return 0;
+    }
+    return static_cast<UInt8>(1u << (usage - kUsageLeftControl));
+}
+
 void HIDKeyboard::pressKey(KeyID button) {
-    auto modifierIter = KEY_TO_USB_MODIFIER.find(button);
-    if (modifierIter != KEY_TO_USB_MODIFIER.end()) {
-        unsigned char modifier = modifierIter->second;
+    UInt8 usage = getUsage(button);
+    if (usage == 0) {
+        return;
+    }
+
+    UInt8 modifier = getModifier(usage);
+    if (modifier != 0) {
         m_modifier |= modifier;
         updateKeys();
         return;
     }
 
-    auto valueIter = KEY_TO_USB_VALUE.find(button);
-    if (valueIter == KEY_TO_USB_VALUE.end()) {
+    if (m_nkro) {
+        HIDReportLayout::setFlag(m_report, m_keysField, usage, true);
+        sendLive(m_report);
         return;
     }
-    unsigned char value = valueIter->second;
-    for (unsigned char &pressedKey : m_pressedKeys) {
-        if (pressedKey == 0) {
-            pressedKey = value;
+
+    for (UInt32 i = 0; i < m_numKeys; ++i) {
+        if (m_pressedKeys[i] == 0) {
+            m_pressedKeys[i] = usage;
             updateKeys();
             return;
         }
@@ -224,39 +245,86 @@ void HIDKeyboard::pressKey(KeyID button) {
 }
 
 void HIDKeyboard::releaseKey(KeyID button) {
-    auto modifierIter = KEY_TO_USB_MODIFIER.find(button);
-    if (modifierIter != KEY_TO_USB_MODIFIER.end()) {
-        unsigned char modifier = modifierIter->second;
-        m_modifier |= modifier;
-        m_modifier ^= modifier;
+    UInt8 usage = getUsage(button);
+    if (usage == 0) {
+        return;
+    }
+
+    UInt8 modifier = getModifier(usage);
+    if (modifier != 0) {
+        m_modifier &= static_cast<UInt8>(~modifier);
         updateKeys();
         return;
     }
 
-    auto valueIter = KEY_TO_USB_VALUE.find(button);
-    if (valueIter == KEY_TO_USB_VALUE.end()) {
+    if (m_nkro) {
+        HIDReportLayout::setFlag(m_report, m_keysField, usage, false);
+        sendLive(m_report);
         return;
     }
-    unsigned char key = valueIter->second;
-    for (unsigned char &pressedKey : m_pressedKeys) {
-        if (pressedKey == key) {
-            pressedKey = 0;
+
+    for (UInt32 i = 0; i < m_numKeys; ++i) {
+        if (m_pressedKeys[i] == usage) {
+            m_pressedKeys[i] = 0;
             updateKeys();
             return;
         }
     }
 }
 
-void HIDKeyboard::updateKeys() const {
-    // Report
-    char report[m_reportSize];
-    memset(report,0,m_reportSize);
+void HIDKeyboard::updateKeys() {
+    if (m_nkro) {
+        // m_report already holds the keys
+        HIDReportLayout::set(m_report, m_modifierField, m_modifier);
+        sendLive(m_report);
+        return;
+    }
+
+    UInt8 report[HIDReportQueue::MAX_REPORT_SIZE];
+    m_layout.clear(report);
 
-    report[0] = m_modifier;
-    for (int i = 0; i < 6; ++i) {
-        report[i + 2] = m_pressedKeys[i];
+    HIDReportLayout::set(report, m_modifierField, m_modifier);
+    for (UInt32 i = 0; i < m_numKeys; ++i) {
+        HIDReportLayout::setSlot(report, m_keysField, i, m_pressedKeys[i]);
     }
 
+    sendLive(report);
+}
+
+void HIDKeyboard::sendLive(const UInt8* report) {
+    // the writer reads these after taking the report off the queue so
+    // they must be set before it's queued
+    m_keysHeld = (memcmp(report, m_idleReport, m_reportSize) != 0);
+    ++m_liveReports;
     update(report);
 }
 
+bool HIDKeyboard::isHoldingKeys() const {
+    return m_keysHeld;
+}
+
+UInt32 HIDKeyboard::getLiveReports() const {
+    return m_liveReports;
+}
+
+UInt32 HIDKeyboard::typeText(const std::string& text) {
+    UInt32 count = m_typer->type(text);
+    if (count != 0) {
+        wakeWriter();
+    }
+    return count;
+}
+
+void HIDKeyboard::buildReport(UInt8* report, UInt8 modifier, UInt8 usage) const {
+    m_layout.clear(report);
+    HIDReportLayout::set(report, m_modifierField, modifier);
+    if (usage == 0) {
+        return;
+    }
+    if (m_nkro) {
+        HIDReportLayout::setFlag(report, m_keysField, usage, true);
+    }
+    else {
+        HIDReportLayout::setSlot(report, m_keysField, 0, usage);
+    }
+}
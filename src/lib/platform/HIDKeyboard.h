@@ -4,24 +4,81 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <core/key_types.h>
-#include <map>
 #include "HIDDevice.h"
+#include "HIDReportQueue.h"
 
+class HIDTyper;
+
+//! HID keyboard
+/*!
+Writes boot protocol reports (up to 6 keys at once) unless the gadget's
+report descriptor has a bitmap with a bit for every key, in which case
+any number of keys can be down at once (n-key rollover).
+*/
 class HIDKeyboard : public HIDDevice {
 public:
-    HIDKeyboard(const std::string &path);
+    HIDKeyboard(IHIDSink* sink);
     ~HIDKeyboard();
 
     void pressKey(KeyID button);
     void releaseKey(KeyID button);
-    void updateKeys() const;
+    void updateKeys();
+
+    //! Type text
+    /*!
+    Queues \c text (UTF-8) to be typed as fast as the host takes key
+    reports.  Returns the number of characters queued.
+    */
+    UInt32 typeText(const std::string& text);
+
+    //! Build a report holding down \c modifier and \c usage
+    /*!
+    \c usage may be 0 for no key.  Safe to call from any thread.
+    */
+    void buildReport(UInt8* report, UInt8 modifier, UInt8 usage) const;
+
+    //! Check for live keys held down
+    /*!
+    True if the last report from pressKey() or releaseKey() held any key
+    or modifier down.  Safe to call from any thread.
+    */
+    bool isHoldingKeys() const;
+
+    //! Count the live reports
+    /*!
+    Goes up with every report sent by pressKey(), releaseKey() or
+    updateKeys(), so the typer can tell when live input has replaced
+    what it held down.  Safe to call from any thread.
+    */
+    UInt32 getLiveReports() const;
+
+    //! Get the HID keyboard usage for a key, 0 if it has none
+    static UInt8 getUsage(KeyID id);
+
+    //! Get the modifier bit for a usage, 0 if it isn't a modifier
+    static UInt8 getModifier(UInt8 usage);
+
+private:
+    void sendLive(const UInt8* report);
 
 private:
+    static const UInt32 MAX_KEYS = 6;
+    static const UInt8 DEFAULT_DESCRIPTOR[];
+    HIDReportField m_modifierField;
+    HIDReportField m_keysField;
+    bool m_nkro;
+    UInt32 m_numKeys;
     unsigned char m_modifier = 0;
-    unsigned char m_pressedKeys[6] = {0};
-    static const UInt32 REPORT_SIZE = 8;
-    static std::map<KeyID, unsigned char> KEY_TO_USB_VALUE;
-    static std::map<KeyID, unsigned char> KEY_TO_USB_MODIFIER;
+    unsigned char m_pressedKeys[MAX_KEYS] = {0};
+    // n-key rollover keeps its state in the report itself
+    UInt8 m_report[HIDReportQueue::MAX_REPORT_SIZE];
+    // the report with nothing held down
+    UInt8 m_idleReport[HIDReportQueue::MAX_REPORT_SIZE];
+    std::atomic<bool> m_keysHeld;
+    std::atomic<UInt32> m_liveReports;
+    // owned by HIDDevice
+    HIDTyper* m_typer;
 };
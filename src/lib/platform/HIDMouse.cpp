@@ -3,21 +3,52 @@
 //
 
 #include <base/Log.h>
+#include <core/XScreen.h>
 #include "HIDMouse.h"
+#include "HIDReportCoalescer.h"
+#include "HIDReportQueue.h"
+
+// 3 buttons and 16-bit X, Y and wheel.  matches hid/hid.sh.
+const UInt8 HIDMouse::DEFAULT_DESCRIPTOR[] = {
+    0x05, 0x01, 0x09, 0x02, 0xa1, 0x01, 0x09, 0x01, 0xa1, 0x00,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x03, 0x15, 0x00, 0x25, 0x01,
+    0x95, 0x03, 0x75, 0x01, 0x81, 0x02, 0x95, 0x01, 0x75, 0x05,
+    0x81, 0x03, 0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x38,
+    0x16, 0x01, 0x80, 0x26, 0xff, 0x7f, 0x75, 0x10, 0x95, 0x03,
+    0x81, 0x06, 0xc0, 0xc0
+};
+
+static SInt32 clampAxis(SInt32 delta, const HIDReportField& axis) {
+    if (delta < axis.m_logicalMin) {
+        return axis.m_logicalMin;
+    }
+    if (delta > axis.m_logicalMax) {
+        return axis.m_logicalMax;
+    }
+    return delta;
+}
 
 /**
  * @brief Construct a new HIDMouse::HIDMouse object
- * [B]
- * [X][X]
- * [Y][Y]
- * [W][W]
- * @param path 
+ * The report layout comes from the gadget's report descriptor;  it
+ * needs buttons 1 to 3 and relative X and Y.  A wheel is optional.
+ * @param sink where reports go
  */
 HIDMouse::HIDMouse(
-        const std::string& path) :
-    m_buttons(0x00),
-    HIDDevice(path, REPORT_SIZE)
+        IHIDSink* sink) :
+    HIDDevice(sink, DEFAULT_DESCRIPTOR, sizeof(DEFAULT_DESCRIPTOR)),
+    m_hasWheel(false),
+    m_buttons(0x00)
 {
+    if (!m_layout.findBits(kHIDPageButton, 1, 3, m_buttonsField) ||
+            !m_layout.findUsage(kHIDPageGenericDesktop, kHIDUsageX, m_xField) ||
+            !m_layout.findUsage(kHIDPageGenericDesktop, kHIDUsageY, m_yField)) {
+        throw XScreenOpenFailure("unsupported HID mouse report descriptor");
+    }
+    m_hasWheel = m_layout.findUsage(kHIDPageGenericDesktop, kHIDUsageWheel, m_wheelField);
+
+    HIDReportField axes[] = { m_xField, m_yField, m_wheelField };
+    setCoalescer(new HIDRelativeCoalescer(m_buttonsField, axes, m_hasWheel ? 3 : 2));
 }
 
 HIDMouse::~HIDMouse() {
@@ -53,84 +84,50 @@ void HIDMouse::updateButton(ButtonID button, bool press) {
         m_buttons ^= mask;
     }
 
-    // Report
-    char report[m_reportSize];
-    memset(report,0,m_reportSize);
-
-    // Buttons
-    report[0] = m_buttons;
-
-    // X
-    report[1] = 0x00;
-    report[2] = 0x00;
-
-    // Y
-    report[3] = 0x00;
-    report[4] = 0x00;
-
-    // Wheel
-    report[5] = 0x00;
-    report[6] = 0x00;
-
-    update(report);
+    report(0, 0, 0);
 }
 
 
 void HIDMouse::relativeMove(SInt32 dx, SInt32 dy) const {
 
-    // Convert to SInt16
-    SInt16 dx16 = (SInt16)dx;
-    SInt16 dy16 = (SInt16)dy;
-
-    LOG((CLOG_DEBUG "HIDMouse::relativeMove(%i, %i)", (SInt32)dx16, (SInt32)dy16));
-
-    // Report
-    char report[m_reportSize];
-    memset(report,0,m_reportSize);
-
-    // Buttons
-    report[0] = m_buttons;
-
-    // X
-    report[1] = dx16 & 0xFF;
-    report[2] = (dx16 >> 8) & 0xFF;
+    LOG((CLOG_DEBUG "HIDMouse::relativeMove(%i, %i)", dx, dy));
 
-    // Y
-    report[3] = dy16 & 0xFF;
-    report[4] = (dy16 >> 8) & 0xFF;
+    // Split moves that don't fit the axes rather than truncating them
+    do {
+        SInt32 stepX = clampAxis(dx, m_xField);
+        SInt32 stepY = clampAxis(dy, m_yField);
 
-    // Wheel
-    report[5] = 0x00;
-    report[6] = 0x00;
+        report(stepX, stepY, 0);
 
-    update(report);
+        dx -= stepX;
+        dy -= stepY;
+    } while (dx != 0 || dy != 0);
 }
 
 
 void HIDMouse::wheel(SInt32 dy) const {
-    // Convert to SInt16
-    SInt16 dy16 = (SInt16)(dy/WHEEL_SCALE);
+    if (!m_hasWheel) {
+        return;
+    }
 
-    LOG((CLOG_DEBUG "HIDMouse::wheel(%i)", (SInt32)dy16));
+    SInt32 steps = clampAxis(dy/(SInt32)WHEEL_SCALE, m_wheelField);
 
-    // Report
-    char report[m_reportSize];
-    memset(report,0,m_reportSize);
+    LOG((CLOG_DEBUG "HIDMouse::wheel(%i)", steps));
 
-    // Buttons
-    report[0] = m_buttons;
+    report(0, 0, steps);
+}
 
-    // X
-    report[1] = 0x00;
-    report[2] = 0x00;
 
-    // Y
-    report[3] = 0x00;
-    report[4] = 0x00;
+void HIDMouse::report(SInt32 dx, SInt32 dy, SInt32 wheel) const {
+    UInt8 report[HIDReportQueue::MAX_REPORT_SIZE];
+    m_layout.clear(report);
 
-    // Wheel
-    report[5] = dy16 & 0xFF;
-    report[6] = (dy16 >> 8) & 0xFF;
+    HIDReportLayout::set(report, m_buttonsField, (UInt8)m_buttons);
+    HIDReportLayout::set(report, m_xField, dx);
+    HIDReportLayout::set(report, m_yField, dy);
+    if (m_hasWheel) {
+        HIDReportLayout::set(report, m_wheelField, wheel);
+    }
 
     update(report);
-}
\ No newline at end of file
+}
@@ -9,7 +9,7 @@
 
 class HIDMouse : public HIDDevice {
 public:
-    HIDMouse(const std::string& path);
+    HIDMouse(IHIDSink* sink);
     ~HIDMouse();
 
     void updateButton(ButtonID button, bool press);
@@ -17,8 +17,15 @@ public:
     void wheel(SInt32 dy) const;
 
 private:
-    static const UInt32 REPORT_SIZE = 7;
-    static const UInt32 LOGICAL_MAX = 0x7FFF;
+    void report(SInt32 dx, SInt32 dy, SInt32 wheel) const;
+
+private:
     static const UInt32 WHEEL_SCALE = 32;
+    static const UInt8 DEFAULT_DESCRIPTOR[];
+    HIDReportField m_buttonsField;
+    HIDReportField m_xField;
+    HIDReportField m_yField;
+    HIDReportField m_wheelField;
+    bool m_hasWheel;
     char m_buttons;
 };
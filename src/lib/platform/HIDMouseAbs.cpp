@@ -1,13 +1,34 @@
 
 #include <base/Log.h>
+#include <core/XScreen.h>
 #include "HIDMouseAbs.h"
+#include "HIDReportCoalescer.h"
+#include "HIDReportQueue.h"
+
+// 3 buttons and 15-bit absolute X and Y.  matches hid/hid.sh.
+const UInt8 HIDMouseAbs::DEFAULT_DESCRIPTOR[] = {
+    0x05, 0x01, 0x09, 0x02, 0xa1, 0x01, 0x09, 0x01, 0xa1, 0x00,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x03, 0x15, 0x00, 0x25, 0x01,
+    0x95, 0x03, 0x75, 0x01, 0x81, 0x02, 0x95, 0x01, 0x75, 0x05,
+    0x81, 0x03, 0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x15, 0x00,
+    0x26, 0xff, 0x7f, 0x75, 0x10, 0x95, 0x02, 0x81, 0x02, 0xc0,
+    0xc0
+};
 
 HIDMouseAbs::HIDMouseAbs(
-        const std::string& path) :
-    m_buttons(0x00),
-    HIDDevice(path, REPORT_SIZE)
+        IHIDSink* sink) :
+    HIDDevice(sink, DEFAULT_DESCRIPTOR, sizeof(DEFAULT_DESCRIPTOR)),
+    m_x(0),
+    m_y(0),
+    m_buttons(0x00)
 {
+    if (!m_layout.findBits(kHIDPageButton, 1, 3, m_buttonsField) ||
+            !m_layout.findUsage(kHIDPageGenericDesktop, kHIDUsageX, m_xField) ||
+            !m_layout.findUsage(kHIDPageGenericDesktop, kHIDUsageY, m_yField)) {
+        throw XScreenOpenFailure("unsupported HID absolute mouse report descriptor");
+    }
 
+    setCoalescer(new HIDAbsoluteCoalescer(m_buttonsField, (UInt32)m_reportSize));
 }
 
 HIDMouseAbs::~HIDMouseAbs() {
@@ -44,22 +65,7 @@ void HIDMouseAbs::updateButton(ButtonID button, bool press) {
         m_buttons ^= mask;
     }
 
-    // Report
-    char report[m_reportSize];
-    memset(report,0,m_reportSize);
-
-    // Buttons
-    report[0] = m_buttons;
-
-    // X
-    report[1] = 0x00;
-    report[2] = 0x00;
-
-    // Y
-    report[3] = 0x00;
-    report[4] = 0x00;
-
-    update(report);
+    report();
 }
 
 
@@ -69,27 +75,23 @@ void HIDMouseAbs::updateButton(ButtonID button, bool press) {
 // 0.0 < fy <= 1.0
 // Note: 0.0 is invalid
 void HIDMouseAbs::move(float fx, float fy) {
-    // Scale
-    UInt32 x = fx * LOGICAL_MAX; // 0 is invalid
-    UInt32 y = fy * LOGICAL_MAX; // 0 is invalid
+    // Scale to the logical range of each axis
+    m_x = (SInt32)(fx * m_xField.m_logicalMax); // 0 is invalid
+    m_y = (SInt32)(fy * m_yField.m_logicalMax); // 0 is invalid
 
     LOG((CLOG_DEBUG "HIDMouseAbs::move(%f, %f)", fx, fy));
 
-    // Report
-    char report[m_reportSize];
-    memset(report,0,m_reportSize);
-
-    // Buttons
-    report[0] = m_buttons;
+    report();
+}
 
-    // X
-    report[1] = x & 0xFF;
-    report[2] = (x >> 8) & 0xFF;
 
-    // Y
-    report[3] = y & 0xFF;
-    report[4] = (y >> 8) & 0xFF;
+void HIDMouseAbs::report() const {
+    UInt8 report[HIDReportQueue::MAX_REPORT_SIZE];
+    m_layout.clear(report);
 
+    HIDReportLayout::set(report, m_buttonsField, (UInt8)m_buttons);
+    HIDReportLayout::set(report, m_xField, m_x);
+    HIDReportLayout::set(report, m_yField, m_y);
 
     update(report);
-}
\ No newline at end of file
+}
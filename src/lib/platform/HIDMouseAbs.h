@@ -5,7 +5,7 @@
 
 class HIDMouseAbs : public HIDDevice {
 public:
-    HIDMouseAbs(const std::string& path);
+    HIDMouseAbs(IHIDSink* sink);
     ~HIDMouseAbs();
 
     void move(float fx, float fy);
@@ -13,7 +13,13 @@ public:
     void updateButton(ButtonID button, bool press);
 
 private:
-    static const UInt32 REPORT_SIZE = 5;
-    static const UInt32 LOGICAL_MAX = 0x7FFF;
+    void report() const;
+
+private:
+    static const UInt8 DEFAULT_DESCRIPTOR[];
+    HIDReportField m_buttonsField;
+    HIDReportField m_xField;
+    HIDReportField m_yField;
+    SInt32 m_x, m_y;
     char m_buttons;
 };
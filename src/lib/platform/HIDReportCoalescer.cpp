@@ -0,0 +1,103 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "platform/HIDReportCoalescer.h"
+
+#include <cassert>
+#include <cstring>
+
+//
+// HIDReportCoalescer
+//
+
+void
+HIDReportCoalescer::toState(UInt8* /*report*/) const
+{
+    // do nothing
+}
+
+//
+// HIDRelativeCoalescer
+//
+
+HIDRelativeCoalescer::HIDRelativeCoalescer(
+        const HIDReportField& buttons,
+        const HIDReportField* axes, UInt32 numAxes) :
+    m_buttons(buttons),
+    m_numAxes(numAxes)
+{
+    assert(numAxes <= MAX_AXES);
+    for (UInt32 i = 0; i < numAxes; ++i) {
+        m_axes[i] = axes[i];
+    }
+}
+
+bool
+HIDRelativeCoalescer::merge(UInt8* pending, const UInt8* next) const
+{
+    if (HIDReportLayout::get(pending, m_buttons) !=
+            HIDReportLayout::get(next, m_buttons)) {
+        return false;
+    }
+
+    // check every axis before touching any of them
+    SInt32 sums[MAX_AXES];
+    for (UInt32 i = 0; i < m_numAxes; ++i) {
+        const HIDReportField& axis = m_axes[i];
+        sums[i] = HIDReportLayout::get(pending, axis) +
+                  HIDReportLayout::get(next, axis);
+        if (sums[i] < axis.m_logicalMin || sums[i] > axis.m_logicalMax) {
+            return false;
+        }
+    }
+
+    for (UInt32 i = 0; i < m_numAxes; ++i) {
+        HIDReportLayout::set(pending, m_axes[i], sums[i]);
+    }
+    return true;
+}
+
+void
+HIDRelativeCoalescer::toState(UInt8* report) const
+{
+    // deltas were meant for the host that went away
+    for (UInt32 i = 0; i < m_numAxes; ++i) {
+        HIDReportLayout::set(report, m_axes[i], 0);
+    }
+}
+
+//
+// HIDAbsoluteCoalescer
+//
+
+HIDAbsoluteCoalescer::HIDAbsoluteCoalescer(
+        const HIDReportField& buttons, UInt32 reportSize) :
+    m_buttons(buttons),
+    m_reportSize(reportSize)
+{
+}
+
+bool
+HIDAbsoluteCoalescer::merge(UInt8* pending, const UInt8* next) const
+{
+    if (HIDReportLayout::get(pending, m_buttons) !=
+            HIDReportLayout::get(next, m_buttons)) {
+        return false;
+    }
+
+    memcpy(pending, next, m_reportSize);
+    return true;
+}
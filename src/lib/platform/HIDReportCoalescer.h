@@ -0,0 +1,91 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/basic_types.h"
+#include "HIDReportLayout.h"
+
+//! HID report merging strategy
+/*!
+A device's writer thread drains every report queued while the previous
+write was waiting for the host to poll, and asks the coalescer to fold
+each one into the report it is about to send.  Reports are only merged
+when the host can't tell the difference, so button edges are never
+lost.
+*/
+class HIDReportCoalescer {
+public:
+    virtual ~HIDReportCoalescer() { }
+
+    //! Merge \c next into \c pending
+    /*!
+    Returns true if \c next was folded into \c pending, false if
+    \c pending must be sent first.  \c pending is left unchanged when
+    false is returned.
+    */
+    virtual bool        merge(UInt8* pending, const UInt8* next) const = 0;
+
+    //! Reduce a report to device state
+    /*!
+    Strips anything from \c report that must not be replayed to a host
+    that has been away, leaving only the state it describes (buttons,
+    position).  The default leaves the report as is.
+    */
+    virtual void        toState(UInt8* report) const;
+};
+
+//! Coalescer for relative pointer reports
+/*!
+Sums the relative axes of reports whose buttons match, as long as every
+sum stays within the axis' logical range.
+*/
+class HIDRelativeCoalescer : public HIDReportCoalescer {
+public:
+    /*!
+    \c buttons is the field holding all the buttons and \c axes are the
+    \c numAxes relative axes.
+    */
+    HIDRelativeCoalescer(const HIDReportField& buttons,
+                            const HIDReportField* axes, UInt32 numAxes);
+
+    // HIDReportCoalescer overrides
+    virtual bool        merge(UInt8* pending, const UInt8* next) const;
+    virtual void        toState(UInt8* report) const;
+
+private:
+    static const UInt32 MAX_AXES = 4;
+
+    HIDReportField      m_buttons;
+    HIDReportField      m_axes[MAX_AXES];
+    UInt32              m_numAxes;
+};
+
+//! Coalescer for absolute pointer reports
+/*!
+Keeps only the newest of consecutive reports whose buttons match.
+*/
+class HIDAbsoluteCoalescer : public HIDReportCoalescer {
+public:
+    HIDAbsoluteCoalescer(const HIDReportField& buttons, UInt32 reportSize);
+
+    // HIDReportCoalescer overrides
+    virtual bool        merge(UInt8* pending, const UInt8* next) const;
+
+private:
+    HIDReportField      m_buttons;
+    UInt32              m_reportSize;
+};
@@ -0,0 +1,609 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "platform/HIDReportLayout.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <glob.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+// where configfs gadget HID functions live
+static const char* s_configfsFunctions =
+    "/sys/kernel/config/usb_gadget/*/functions/hid.*/dev";
+
+// report descriptor item types and tags (HID 1.11, section 6.2.2)
+enum {
+    kItemMain   = 0,
+    kItemGlobal = 1,
+    kItemLocal  = 2
+};
+
+enum {
+    kMainInput          = 0x8,
+    kMainOutput         = 0x9,
+    kMainCollection     = 0xA,
+    kMainFeature        = 0xB,
+    kMainEndCollection  = 0xC
+};
+
+enum {
+    kGlobalUsagePage    = 0x0,
+    kGlobalLogicalMin   = 0x1,
+    kGlobalLogicalMax   = 0x2,
+    kGlobalReportSize   = 0x7,
+    kGlobalReportID     = 0x8,
+    kGlobalReportCount  = 0x9,
+    kGlobalPush         = 0xA,
+    kGlobalPop          = 0xB
+};
+
+enum {
+    kLocalUsage         = 0x0,
+    kLocalUsageMin      = 0x1,
+    kLocalUsageMax      = 0x2
+};
+
+// input item flags
+enum {
+    kInputConstant      = 0x01,
+    kInputVariable      = 0x02,
+    kInputRelative      = 0x04
+};
+
+static const UInt8 s_longItem = 0xFE;
+
+// largest input report we'll describe, in bits (a full-speed packet)
+static const UInt32 s_maxReportBits = 8 * 64;
+
+namespace {
+
+struct Globals {
+public:
+    Globals() :
+        m_usagePage(0),
+        m_logicalMin(0),
+        m_logicalMax(0),
+        m_logicalMaxUnsigned(0),
+        m_reportSize(0),
+        m_reportCount(0),
+        m_reportID(0) { }
+
+    // logical maximum is signed only if the minimum is negative.
+    // plenty of descriptors say 0..255 as 0x15 0x00 0x25 0xFF.
+    SInt32              getLogicalMax() const
+    {
+        if (m_logicalMin < 0) {
+            return m_logicalMax;
+        }
+        return static_cast<SInt32>(m_logicalMaxUnsigned);
+    }
+
+public:
+    UInt16              m_usagePage;
+    SInt32              m_logicalMin;
+    SInt32              m_logicalMax;
+    UInt32              m_logicalMaxUnsigned;
+    UInt32              m_reportSize;
+    UInt32              m_reportCount;
+    UInt8               m_reportID;
+};
+
+struct Locals {
+public:
+    Locals() : m_usageMin(0), m_usageMax(0), m_range(false) { }
+
+    // usage of the index'th element of a variable item.  returns
+    // the usage with its page in the high 16 bits.
+    UInt32              getUsage(UInt32 index) const
+    {
+        if (!m_usages.empty()) {
+            return m_usages[index < m_usages.size() ? index : m_usages.size() - 1];
+        }
+        if (m_range) {
+            UInt32 usage = m_usageMin + index;
+            return (usage > m_usageMax) ? m_usageMax : usage;
+        }
+        return 0;
+    }
+
+public:
+    std::vector<UInt32> m_usages;
+    UInt32              m_usageMin;
+    UInt32              m_usageMax;
+    bool                m_range;
+};
+
+}
+
+static
+HIDReportField::EPacking
+getPacking(UInt32 bitOffset, UInt32 bitSize)
+{
+    if ((bitOffset & 7) == 0) {
+        if (bitSize == 8) {
+            return HIDReportField::kPackByte;
+        }
+        if (bitSize == 16) {
+            return HIDReportField::kPackWord;
+        }
+    }
+    return HIDReportField::kPackBits;
+}
+
+// qualify a usage with the current page unless it carries its own
+static
+UInt32
+qualifyUsage(UInt32 data, UInt32 size, UInt16 page)
+{
+    if (size == 4) {
+        return data;
+    }
+    return (static_cast<UInt32>(page) << 16) | (data & 0xFFFF);
+}
+
+static
+bool
+readFile(const std::string& path, std::vector<UInt8>& data)
+{
+    std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    data.assign(std::istreambuf_iterator<char>(file),
+                std::istreambuf_iterator<char>());
+    return !data.empty();
+}
+
+//
+// HIDReportField
+//
+
+HIDReportField::HIDReportField() :
+    m_usagePage(0),
+    m_usageMin(0),
+    m_usageMax(0),
+    m_bitOffset(0),
+    m_bitSize(0),
+    m_count(0),
+    m_logicalMin(0),
+    m_logicalMax(0),
+    m_array(false),
+    m_relative(false),
+    m_packing(kPackBits)
+{
+}
+
+//
+// HIDReportLayout
+//
+
+HIDReportLayout::HIDReportLayout() :
+    m_reportSize(0),
+    m_reportID(0)
+{
+}
+
+bool
+HIDReportLayout::parse(const UInt8* descriptor, UInt32 size)
+{
+    FieldList fields;
+    std::vector<Globals> stack;
+    Globals globals;
+    Locals locals;
+    bool haveReportID = false;
+    UInt8 reportID    = 0;
+    UInt32 bitOffset  = 0;
+
+    for (UInt32 i = 0; i < size; ) {
+        UInt8 prefix = descriptor[i++];
+
+        if (prefix == s_longItem) {
+            // long items carry nothing we use
+            if (i + 2 > size) {
+                return false;
+            }
+            i += 2 + descriptor[i];
+            continue;
+        }
+
+        UInt32 dataSize = prefix & 0x03;
+        if (dataSize == 3) {
+            dataSize = 4;
+        }
+        UInt32 type = (prefix >> 2) & 0x03;
+        UInt32 tag  = (prefix >> 4) & 0x0F;
+        if (i + dataSize > size) {
+            return false;
+        }
+
+        UInt32 data = 0;
+        for (UInt32 j = 0; j < dataSize; ++j) {
+            data |= static_cast<UInt32>(descriptor[i + j]) << (8 * j);
+        }
+        SInt32 signedData = static_cast<SInt32>(data);
+        if (dataSize == 1) {
+            signedData = static_cast<SInt8>(data);
+        }
+        else if (dataSize == 2) {
+            signedData = static_cast<SInt16>(data);
+        }
+        i += dataSize;
+
+        switch (type) {
+        case kItemMain:
+            if (tag == kMainInput) {
+                if (globals.m_reportID != 0 && !haveReportID) {
+                    haveReportID = true;
+                    reportID     = globals.m_reportID;
+                    bitOffset    = 8;
+                }
+                if (globals.m_reportID != reportID) {
+                    // some other input report.  ignore it.
+                    locals = Locals();
+                    break;
+                }
+
+                // check the size before building any fields so a
+                // corrupt Report Count can't have us push billions,
+                // even of empty fields.  fields are packed into 32 bits.
+                if (globals.m_reportSize > 32 ||
+                        globals.m_reportCount > s_maxReportBits) {
+                    return false;
+                }
+                unsigned long long bits =
+                    static_cast<unsigned long long>(globals.m_reportSize) *
+                                                    globals.m_reportCount;
+                if (bitOffset + bits > s_maxReportBits) {
+                    return false;
+                }
+
+                if ((data & kInputConstant) != 0) {
+                    // padding
+                }
+                else if ((data & kInputVariable) != 0) {
+                    for (UInt32 n = 0; n < globals.m_reportCount; ++n) {
+                        UInt32 usage = locals.getUsage(n);
+                        HIDReportField field;
+                        field.m_usagePage  = static_cast<UInt16>(usage >> 16);
+                        field.m_usageMin   = static_cast<UInt16>(usage);
+                        field.m_usageMax   = field.m_usageMin;
+                        field.m_bitOffset  = bitOffset + n * globals.m_reportSize;
+                        field.m_bitSize    = globals.m_reportSize;
+                        field.m_count      = 1;
+                        field.m_logicalMin = globals.m_logicalMin;
+                        field.m_logicalMax = globals.getLogicalMax();
+                        field.m_relative   = ((data & kInputRelative) != 0);
+                        field.m_packing    = getPacking(field.m_bitOffset, field.m_bitSize);
+                        fields.push_back(field);
+                    }
+                }
+                else {
+                    UInt32 first = locals.getUsage(0);
+                    UInt32 last  = locals.m_range ? locals.m_usageMax :
+                                                    locals.getUsage(globals.m_reportCount);
+                    if (locals.m_range) {
+                        first = locals.m_usageMin;
+                    }
+
+                    HIDReportField field;
+                    field.m_usagePage  = static_cast<UInt16>(first >> 16);
+                    field.m_usageMin   = static_cast<UInt16>(first);
+                    field.m_usageMax   = static_cast<UInt16>(last);
+                    field.m_bitOffset  = bitOffset;
+                    field.m_bitSize    = globals.m_reportSize;
+                    field.m_count      = globals.m_reportCount;
+                    field.m_logicalMin = globals.m_logicalMin;
+                    field.m_logicalMax = globals.getLogicalMax();
+                    field.m_array      = true;
+                    field.m_packing    = getPacking(field.m_bitOffset, field.m_bitSize);
+                    fields.push_back(field);
+                }
+                bitOffset += static_cast<UInt32>(bits);
+            }
+            else if (tag != kMainOutput && tag != kMainFeature &&
+                        tag != kMainCollection && tag != kMainEndCollection) {
+                return false;
+            }
+            locals = Locals();
+            break;
+
+        case kItemGlobal:
+            switch (tag) {
+            case kGlobalUsagePage:
+                globals.m_usagePage = static_cast<UInt16>(data);
+                break;
+
+            case kGlobalLogicalMin:
+                globals.m_logicalMin = signedData;
+                break;
+
+            case kGlobalLogicalMax:
+                globals.m_logicalMax         = signedData;
+                globals.m_logicalMaxUnsigned = data;
+                break;
+
+            case kGlobalReportSize:
+                globals.m_reportSize = data;
+                break;
+
+            case kGlobalReportID:
+                globals.m_reportID = static_cast<UInt8>(data);
+                break;
+
+            case kGlobalReportCount:
+                globals.m_reportCount = data;
+                break;
+
+            case kGlobalPush:
+                stack.push_back(globals);
+                break;
+
+            case kGlobalPop:
+                if (stack.empty()) {
+                    return false;
+                }
+                globals = stack.back();
+                stack.pop_back();
+                break;
+
+            default:
+                // physical ranges and units don't affect the layout
+                break;
+            }
+            break;
+
+        case kItemLocal:
+            switch (tag) {
+            case kLocalUsage:
+                locals.m_usages.push_back(
+                    qualifyUsage(data, dataSize, globals.m_usagePage));
+                break;
+
+            case kLocalUsageMin:
+                locals.m_usageMin = qualifyUsage(data, dataSize, globals.m_usagePage);
+                locals.m_range    = true;
+                break;
+
+            case kLocalUsageMax:
+                locals.m_usageMax = qualifyUsage(data, dataSize, globals.m_usagePage);
+                locals.m_range    = true;
+                break;
+
+            default:
+                break;
+            }
+            break;
+
+        default:
+            return false;
+        }
+    }
+
+    if (bitOffset == 0) {
+        return false;
+    }
+
+    m_fields.swap(fields);
+    m_reportSize = (bitOffset + 7) / 8;
+    m_reportID   = reportID;
+    return true;
+}
+
+void
+HIDReportLayout::clear(UInt8* report) const
+{
+    memset(report, 0, m_reportSize);
+    if (m_reportID != 0) {
+        report[0] = m_reportID;
+    }
+}
+
+void
+HIDReportLayout::setSlot(UInt8* report, const HIDReportField& field,
+                UInt32 index, SInt32 value)
+{
+    // clamping would turn an unsupported usage into some other key
+    if (value < field.m_logicalMin || value > field.m_logicalMax) {
+        value = 0;
+    }
+
+    HIDReportField slot(field);
+    slot.m_bitOffset += index * field.m_bitSize;
+    slot.m_packing    = getPacking(slot.m_bitOffset, slot.m_bitSize);
+    set(report, slot, value);
+}
+
+bool
+HIDReportLayout::findUsage(UInt16 page, UInt16 usage,
+                HIDReportField& field) const
+{
+    for (const auto& candidate : m_fields) {
+        if (!candidate.m_array &&
+                candidate.m_usagePage == page &&
+                candidate.m_usageMin == usage) {
+            field = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+HIDReportLayout::findBits(UInt16 page, UInt16 first, UInt16 last,
+                HIDReportField& field) const
+{
+    HIDReportField start;
+    if (last < first || last - first >= 32 ||
+            !findUsage(page, first, start) || start.m_bitSize != 1) {
+        return false;
+    }
+
+    for (UInt16 usage = first + 1; usage <= last; ++usage) {
+        HIDReportField next;
+        if (!findUsage(page, usage, next) || next.m_bitSize != 1 ||
+                next.m_bitOffset != start.m_bitOffset + (usage - first)) {
+            return false;
+        }
+    }
+
+    field              = start;
+    field.m_usageMax   = last;
+    field.m_bitSize    = last - first + 1;
+    field.m_logicalMin = 0;
+    field.m_logicalMax = static_cast<SInt32>((1ull << field.m_bitSize) - 1);
+    field.m_packing    = getPacking(field.m_bitOffset, field.m_bitSize);
+    return true;
+}
+
+bool
+HIDReportLayout::findBitmap(UInt16 page, UInt16 first, UInt16 last,
+                HIDReportField& field) const
+{
+    size_t index = 0;
+    while (index < m_fields.size() && (m_fields[index].m_array ||
+            m_fields[index].m_usagePage != page ||
+            m_fields[index].m_usageMin != first)) {
+        ++index;
+    }
+    if (last < first || index == m_fields.size() ||
+            m_fields[index].m_bitSize != 1) {
+        return false;
+    }
+
+    // variable items are stored in usage order, so the rest of the
+    // bitmap must directly follow the first bit
+    const HIDReportField& start = m_fields[index];
+    for (UInt32 usage = first + 1; usage <= last; ++usage) {
+        if (++index == m_fields.size()) {
+            return false;
+        }
+        const HIDReportField& next = m_fields[index];
+        if (next.m_array || next.m_usagePage != page ||
+                next.m_usageMin != usage || next.m_bitSize != 1 ||
+                next.m_bitOffset != start.m_bitOffset + (usage - first)) {
+            return false;
+        }
+    }
+
+    field            = start;
+    field.m_usageMax = last;
+    field.m_count    = last - first + 1;
+    return true;
+}
+
+bool
+HIDReportLayout::findArray(UInt16 page, HIDReportField& field) const
+{
+    for (const auto& candidate : m_fields) {
+        if (candidate.m_array && candidate.m_usagePage == page) {
+            field = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+UInt32
+HIDReportLayout::getReportSize() const
+{
+    return m_reportSize;
+}
+
+UInt8
+HIDReportLayout::getReportID() const
+{
+    return m_reportID;
+}
+
+bool
+HIDReportLayout::loadDescriptor(const std::string& devicePath,
+                std::vector<UInt8>& descriptor)
+{
+    struct stat info;
+    if (stat(devicePath.c_str(), &info) != 0 || !S_ISCHR(info.st_mode)) {
+        return false;
+    }
+
+    // configfs HID functions list the major:minor of their device node
+    char dev[32];
+    snprintf(dev, sizeof(dev), "%u:%u",
+                major(info.st_rdev), minor(info.st_rdev));
+
+    glob_t matches;
+    if (glob(s_configfsFunctions, 0, nullptr, &matches) != 0) {
+        return false;
+    }
+
+    bool found = false;
+    for (size_t i = 0; i < matches.gl_pathc && !found; ++i) {
+        std::string path(matches.gl_pathv[i]);
+        std::vector<UInt8> contents;
+        if (!readFile(path, contents)) {
+            continue;
+        }
+
+        std::string value(contents.begin(), contents.end());
+        value.erase(value.find_last_not_of(" \n") + 1);
+        if (value == dev) {
+            std::string dir = path.substr(0, path.rfind('/'));
+            found = readFile(dir + "/report_desc", descriptor);
+        }
+    }
+    globfree(&matches);
+
+    return found;
+}
+
+bool
+HIDReportLayout::loadDescriptorFile(const std::string& path,
+                std::vector<UInt8>& descriptor)
+{
+    return readFile(path, descriptor);
+}
+
+void
+HIDReportLayout::setBits(UInt8* report, UInt32 bitOffset,
+                UInt32 bitSize, UInt32 value)
+{
+    for (UInt32 i = 0; i < bitSize; ++i) {
+        UInt32 bit  = bitOffset + i;
+        UInt8  mask = static_cast<UInt8>(1u << (bit & 7));
+        if ((value & (1u << i)) != 0) {
+            report[bit >> 3] |= mask;
+        }
+        else {
+            report[bit >> 3] &= static_cast<UInt8>(~mask);
+        }
+    }
+}
+
+UInt32
+HIDReportLayout::getBits(const UInt8* report, UInt32 bitOffset, UInt32 bitSize)
+{
+    UInt32 value = 0;
+    for (UInt32 i = 0; i < bitSize; ++i) {
+        UInt32 bit = bitOffset + i;
+        if ((report[bit >> 3] & (1u << (bit & 7))) != 0) {
+            value |= (1u << i);
+        }
+    }
+    return value;
+}
@@ -0,0 +1,258 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/basic_types.h"
+#include "common/stdvector.h"
+
+#include <string>
+
+//! HID usage pages and usages used by the devices (HID Usage Tables 1.12)
+enum {
+    kHIDPageGenericDesktop  = 0x01,
+    kHIDPageKeyboard        = 0x07,
+    kHIDPageButton          = 0x09
+};
+
+enum {
+    kHIDUsageX              = 0x30,
+    kHIDUsageY              = 0x31,
+    kHIDUsageWheel          = 0x38
+};
+
+//! A field in a HID input report
+/*!
+Describes where one usage (or, for array fields, a run of slots) lives
+in the report.  The packing is worked out once when the descriptor is
+parsed so HIDReportLayout::set() doesn't have to.
+*/
+struct HIDReportField {
+public:
+    enum EPacking {
+        kPackByte,          //!< One whole byte
+        kPackWord,          //!< Two whole bytes, little-endian
+        kPackBits           //!< Anything else
+    };
+
+    HIDReportField();
+
+    bool                isSigned() const { return m_logicalMin < 0; }
+
+public:
+    UInt16              m_usagePage;
+    UInt16              m_usageMin;
+    UInt16              m_usageMax;
+    UInt32              m_bitOffset;
+    UInt32              m_bitSize;
+    UInt32              m_count;
+    SInt32              m_logicalMin;
+    SInt32              m_logicalMax;
+    bool                m_array;
+    bool                m_relative;
+    EPacking            m_packing;
+};
+
+//! HID input report layout
+/*!
+Built from a HID report descriptor, normally the one the gadget was
+configured with, so the byte layout of the reports we write always
+matches what the host expects.  Only the input report is described;  if
+the descriptor uses report IDs, the first input report is used.
+*/
+class HIDReportLayout {
+public:
+    HIDReportLayout();
+
+    //! @name manipulators
+    //@{
+
+    //! Parse a report descriptor
+    /*!
+    Replaces the layout with the one described by \c descriptor.
+    Returns false if the descriptor is malformed.
+    */
+    bool                parse(const UInt8* descriptor, UInt32 size);
+
+    //! Zero a report
+    /*!
+    Clears getReportSize() bytes of \c report and fills in the report ID,
+    if any.
+    */
+    void                clear(UInt8* report) const;
+
+    //! Set a field
+    /*!
+    Stores \c value, clamped to the field's logical range, in \c report.
+    For array fields this sets the first slot.
+    */
+    static void         set(UInt8* report, const HIDReportField&, SInt32 value);
+
+    //! Set a slot of an array field
+    /*!
+    Values outside the field's logical range are stored as 0 (no usage).
+    */
+    static void         setSlot(UInt8* report, const HIDReportField&,
+                            UInt32 index, SInt32 value);
+
+    //! Set or clear a usage in a bitmap field
+    /*!
+    \c field must come from findBitmap().  Usages outside the bitmap are
+    ignored.
+    */
+    static void         setFlag(UInt8* report, const HIDReportField& field,
+                            UInt16 usage, bool on);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Find a variable field by usage
+    bool                findUsage(UInt16 page, UInt16 usage,
+                            HIDReportField&) const;
+
+    //! Find a run of one bit fields
+    /*!
+    Finds the fields for usages \c first to \c last and, if they're
+    contiguous one bit fields in usage order, returns a single field
+    spanning all of them so they can be set at once.
+    */
+    bool                findBits(UInt16 page, UInt16 first, UInt16 last,
+                            HIDReportField&) const;
+
+    //! Find a bitmap of one bit fields
+    /*!
+    Like findBits() but for any number of usages.  The returned field
+    has one bit per usage, starting at \c first, and can only be used
+    with setFlag().
+    */
+    bool                findBitmap(UInt16 page, UInt16 first, UInt16 last,
+                            HIDReportField&) const;
+
+    //! Find an array field by usage page
+    bool                findArray(UInt16 page, HIDReportField&) const;
+
+    //! Get a field
+    static SInt32       get(const UInt8* report, const HIDReportField&);
+
+    //! Get the report size in bytes, including any report ID
+    UInt32              getReportSize() const;
+
+    //! Get the report ID, 0 if the descriptor doesn't use them
+    UInt8               getReportID() const;
+
+    //! Load a gadget's report descriptor
+    /*!
+    Looks up the configfs HID function backing the device node at
+    \c devicePath and reads its report descriptor.  Returns false if
+    the device isn't a configfs gadget.
+    */
+    static bool         loadDescriptor(const std::string& devicePath,
+                            std::vector<UInt8>& descriptor);
+
+    //! Load a report descriptor from a file
+    static bool         loadDescriptorFile(const std::string& path,
+                            std::vector<UInt8>& descriptor);
+
+    //@}
+
+private:
+    static void         setBits(UInt8* report, UInt32 bitOffset,
+                            UInt32 bitSize, UInt32 value);
+    static UInt32       getBits(const UInt8* report, UInt32 bitOffset,
+                            UInt32 bitSize);
+
+private:
+    typedef std::vector<HIDReportField> FieldList;
+
+    FieldList           m_fields;
+    UInt32              m_reportSize;
+    UInt8               m_reportID;
+};
+
+inline
+void
+HIDReportLayout::set(UInt8* report, const HIDReportField& field, SInt32 value)
+{
+    if (value < field.m_logicalMin) {
+        value = field.m_logicalMin;
+    }
+    else if (value > field.m_logicalMax) {
+        value = field.m_logicalMax;
+    }
+
+    UInt8* byte = report + (field.m_bitOffset >> 3);
+    switch (field.m_packing) {
+    case HIDReportField::kPackByte:
+        byte[0] = static_cast<UInt8>(value);
+        break;
+
+    case HIDReportField::kPackWord:
+        byte[0] = static_cast<UInt8>(value);
+        byte[1] = static_cast<UInt8>(value >> 8);
+        break;
+
+    case HIDReportField::kPackBits:
+        setBits(report, field.m_bitOffset, field.m_bitSize,
+                            static_cast<UInt32>(value));
+        break;
+    }
+}
+
+inline
+void
+HIDReportLayout::setFlag(UInt8* report, const HIDReportField& field,
+                UInt16 usage, bool on)
+{
+    if (usage < field.m_usageMin || usage > field.m_usageMax) {
+        return;
+    }
+
+    UInt32 bit  = field.m_bitOffset + (usage - field.m_usageMin);
+    UInt8 mask  = static_cast<UInt8>(1u << (bit & 7));
+    if (on) {
+        report[bit >> 3] |= mask;
+    }
+    else {
+        report[bit >> 3] &= static_cast<UInt8>(~mask);
+    }
+}
+
+inline
+SInt32
+HIDReportLayout::get(const UInt8* report, const HIDReportField& field)
+{
+    const UInt8* byte = report + (field.m_bitOffset >> 3);
+    switch (field.m_packing) {
+    case HIDReportField::kPackByte:
+        return field.isSigned() ? static_cast<SInt8>(byte[0]) : byte[0];
+
+    case HIDReportField::kPackWord: {
+        UInt16 word = static_cast<UInt16>(byte[0] | (byte[1] << 8));
+        return field.isSigned() ? static_cast<SInt16>(word) : word;
+    }
+
+    case HIDReportField::kPackBits:
+        break;
+    }
+
+    UInt32 bits = getBits(report, field.m_bitOffset, field.m_bitSize);
+    if (field.isSigned() && field.m_bitSize < 32 &&
+            (bits & (1u << (field.m_bitSize - 1))) != 0) {
+        return static_cast<SInt32>(bits | ~((1u << field.m_bitSize) - 1));
+    }
+    return static_cast<SInt32>(bits);
+}
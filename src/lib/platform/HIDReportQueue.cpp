@@ -0,0 +1,114 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "platform/HIDReportQueue.h"
+
+#include <cassert>
+#include <cstring>
+
+HIDReportQueue::HIDReportQueue(UInt32 reportSize, UInt32 capacity) :
+    m_reportSize(reportSize),
+    m_mask(0),
+    m_slots(nullptr),
+    m_times(nullptr),
+    m_head(0),
+    m_tail(0)
+{
+    assert(reportSize > 0 && reportSize <= MAX_REPORT_SIZE);
+
+    UInt32 size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    m_mask  = size - 1;
+    m_slots = new UInt8[size * m_reportSize];
+    m_times = new double[size];
+}
+
+HIDReportQueue::~HIDReportQueue()
+{
+    delete[] m_times;
+    delete[] m_slots;
+}
+
+bool
+HIDReportQueue::push(const UInt8* report, double time)
+{
+    UInt32 tail = m_tail.load(std::memory_order_relaxed);
+    UInt32 head = m_head.load(std::memory_order_acquire);
+    if (tail - head > m_mask) {
+        return false;
+    }
+
+    memcpy(m_slots + (tail & m_mask) * m_reportSize, report, m_reportSize);
+    m_times[tail & m_mask] = time;
+    m_tail.store(tail + 1, std::memory_order_seq_cst);
+    return true;
+}
+
+bool
+HIDReportQueue::pop(UInt8* report, double& time)
+{
+    UInt32 head = m_head.load(std::memory_order_relaxed);
+    UInt32 tail = m_tail.load(std::memory_order_seq_cst);
+    if (head == tail) {
+        return false;
+    }
+
+    memcpy(report, m_slots + (head & m_mask) * m_reportSize, m_reportSize);
+    time = m_times[head & m_mask];
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+void
+HIDReportQueue::discard()
+{
+    UInt32 head = m_head.load(std::memory_order_relaxed);
+    assert(head != m_tail.load(std::memory_order_acquire));
+    m_head.store(head + 1, std::memory_order_release);
+}
+
+const UInt8*
+HIDReportQueue::peek() const
+{
+    UInt32 head = m_head.load(std::memory_order_relaxed);
+    UInt32 tail = m_tail.load(std::memory_order_seq_cst);
+    if (head == tail) {
+        return nullptr;
+    }
+    return m_slots + (head & m_mask) * m_reportSize;
+}
+
+bool
+HIDReportQueue::isEmpty() const
+{
+    return m_head.load(std::memory_order_acquire) ==
+           m_tail.load(std::memory_order_seq_cst);
+}
+
+UInt32
+HIDReportQueue::getSize() const
+{
+    return m_tail.load(std::memory_order_acquire) -
+           m_head.load(std::memory_order_acquire);
+}
+
+UInt32
+HIDReportQueue::getReportSize() const
+{
+    return m_reportSize;
+}
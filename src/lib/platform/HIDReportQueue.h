@@ -0,0 +1,105 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/basic_types.h"
+
+#include <atomic>
+
+//! Bounded queue of HID reports
+/*!
+A single-producer/single-consumer ring of fixed-size HID reports, each
+with the time it was queued.  The producer is the thread that builds
+reports (the event loop) and the consumer is the device's writer thread.
+Neither side ever blocks or allocates;  push() fails when the ring is
+full and pop() fails when it is empty.
+*/
+class HIDReportQueue {
+public:
+    //! Largest report a queue can hold (a full-speed interrupt packet)
+    static const UInt32 MAX_REPORT_SIZE = 64;
+
+    /*!
+    \c capacity is rounded up to a power of two.  Every report pushed
+    must be exactly \c reportSize bytes.
+    */
+    HIDReportQueue(UInt32 reportSize, UInt32 capacity);
+    ~HIDReportQueue();
+
+    //! @name manipulators
+    //@{
+
+    //! Append a report (producer only)
+    /*!
+    Copies \c report, queued at \c time, into the ring.  Returns false,
+    leaving the ring unchanged, if the ring is full.
+    */
+    bool                push(const UInt8* report, double time);
+
+    //! Remove the oldest report (consumer only)
+    /*!
+    Copies the oldest report into \c report, which must hold at least
+    getReportSize() bytes, and sets \c time to when it was queued.
+    Returns false if the ring is empty.
+    */
+    bool                pop(UInt8* report, double& time);
+
+    //! Discard the oldest report (consumer only)
+    /*!
+    Removes the report returned by peek().  The ring must not be empty.
+    */
+    void                discard();
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Look at the oldest report (consumer only)
+    /*!
+    Returns the oldest report without removing it, or NULL if the ring
+    is empty.  The pointer is valid until the report is discarded.
+    */
+    const UInt8*        peek() const;
+
+    //! Test if the ring is empty
+    bool                isEmpty() const;
+
+    //! Get the number of queued reports
+    UInt32              getSize() const;
+
+    //! Get the size of each report
+    UInt32              getReportSize() const;
+
+    //@}
+
+private:
+    HIDReportQueue(const HIDReportQueue&);
+    HIDReportQueue&     operator=(const HIDReportQueue&);
+
+private:
+    const UInt32        m_reportSize;
+    UInt32              m_mask;
+    UInt8*              m_slots;
+    double*             m_times;
+
+    // m_head is only written by the consumer and m_tail only by the
+    // producer.  a cache line of padding keeps them apart so the two
+    // threads don't fight over one, however the queue was allocated.
+    std::atomic<UInt32> m_head;
+    UInt8               m_pad[64];
+    std::atomic<UInt32> m_tail;
+};
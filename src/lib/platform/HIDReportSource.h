@@ -0,0 +1,50 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "common/basic_types.h"
+
+//! Generator of HID reports
+/*!
+A device's writer thread reads from its source whenever no reports
+are queued, so the source goes exactly as fast as the host collects
+reports and input from update() always goes first.
+*/
+class HIDReportSource {
+public:
+    virtual ~HIDReportSource() { }
+
+    //! Test if read() has anything to return
+    /*!
+    Called by the writer thread with the device mutex held, and may be
+    called while another thread adds work to the source.
+    */
+    virtual bool        isReady() const = 0;
+
+    //! Get the next report
+    /*!
+    Called by the writer thread.  Returns false, leaving \c report
+    unchanged, when the source has nothing left.
+    */
+    virtual bool        read(UInt8* report) = 0;
+
+    //! Abandon pending work
+    /*!
+    Called by the writer thread when the host has gone away.  read()
+    may still return reports that put the device back in a rest state.
+    */
+    virtual void        cancel() = 0;
+};
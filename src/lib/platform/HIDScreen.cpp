@@ -3,8 +3,11 @@
 //
 
 #include "base/Log.h"
+#include "mt/Lock.h"
 #include "base/TMethodEventJob.h"
+#include "core/IClipboard.h"
 #include "HIDScreen.h"
+#include "HIDSink.h"
 
 HIDScreen::HIDScreen(
         const std::string& keyboardDevice,
@@ -14,28 +17,35 @@ HIDScreen::HIDScreen(
         SInt32 screenHeight,
         SInt32 screenX,
         SInt32 screenY,
+        bool autoType,
+        const std::string& sinkType,
         IEventQueue *events) :
     PlatformScreen(events),
-    m_mouseDevice(mouseDevice),
-    m_mouseAbsDevice(mouseAbsDevice),
+    m_mouseDevice(HIDSinkFactory::create(sinkType, mouseDevice)),
+    m_mouseAbsDevice(HIDSinkFactory::create(sinkType, mouseAbsDevice)),
     m_width(screenWidth),
     m_height(screenHeight),
     m_x(screenX),
     m_y(screenY),
     m_mouseX(-1),
     m_mouseY(-1),
+    m_autoType(autoType),
     m_events(events),
     m_keyState(nullptr)
 {
     // TODO
 
-    m_keyState = new HIDKeyState(events, m_keyMap, keyboardDevice);
+    m_keyState = new HIDKeyState(events, m_keyMap,
+                            HIDSinkFactory::create(sinkType, keyboardDevice));
 
     // install event handlers
     m_events->adoptHandler(Event::kSystem, m_events->getSystemTarget(),
                            new TMethodEventJob<HIDScreen>(this,
                                &HIDScreen::handleSystemEvent));
 
+    // SIGUSR1 is taken for waking threads
+    ARCH->setSignalHandler(Arch::kUSER, &HIDScreen::handleStatsSignal, this);
+
     LOG((CLOG_DEBUG "HIDScreen constructed"));
 
 }
@@ -43,11 +53,48 @@ HIDScreen::HIDScreen(
 HIDScreen::~HIDScreen()
 {
     // TODO
+    ARCH->setSignalHandler(Arch::kUSER, nullptr, nullptr);
     delete m_keyState;
 
     m_events->removeHandler(Event::kSystem, m_events->getSystemTarget());
 }
 
+void HIDScreen::logStats()
+{
+    Lock lock(&m_statsMutex);
+    for (int i = 0; i < kNumHIDDevices; ++i) {
+        const HIDDevice& device = getDevice(static_cast<EHIDDevice>(i));
+        HIDStats::Snapshot snapshot;
+        device.getStats(snapshot);
+        HIDStats::log(device.getPath(), snapshot, &m_lastStats[i]);
+        m_lastStats[i] = snapshot;
+    }
+}
+
+void HIDScreen::getStats(EHIDDevice id, HIDStats::Snapshot& snapshot) const
+{
+    getDevice(id).getStats(snapshot);
+}
+
+const HIDDevice& HIDScreen::getDevice(EHIDDevice id) const
+{
+    switch (id) {
+    case kHIDKeyboard:
+        return m_keyState->getKeyboard();
+
+    case kHIDMouse:
+        return m_mouseDevice;
+
+    default:
+        return m_mouseAbsDevice;
+    }
+}
+
+void HIDScreen::handleStatsSignal(Arch::ESignal, void* screen)
+{
+    static_cast<HIDScreen*>(screen)->logStats();
+}
+
 void *HIDScreen::getEventTarget() const
 {
     return const_cast<HIDScreen*>(this);
@@ -175,10 +222,28 @@ bool HIDScreen::leave()
     return true;
 }
 
-bool HIDScreen::setClipboard(ClipboardID, const IClipboard *)
+bool HIDScreen::setClipboard(ClipboardID id, const IClipboard* clipboard)
 {
-    // Not supported
-    return false;
+    // the host has no clipboard we can reach.  the best we can do is
+    // type the text into it, and only when asked to.
+    if (!m_autoType || id != kClipboardClipboard || clipboard == nullptr) {
+        return false;
+    }
+
+    String text;
+    if (clipboard->open(0)) {
+        if (clipboard->has(IClipboard::kText)) {
+            text = clipboard->get(IClipboard::kText);
+        }
+        clipboard->close();
+    }
+    if (text.empty()) {
+        return false;
+    }
+
+    UInt32 count = m_keyState->typeText(text);
+    LOG((CLOG_DEBUG "typing %u characters from the clipboard", count));
+    return true;
 }
 
 void HIDScreen::checkClipboards()
@@ -9,20 +9,48 @@
 #include "HIDKeyState.h"
 #include "HIDMouse.h"
 #include "HIDMouseAbs.h"
+#include "HIDStats.h"
+
+#include "arch/Arch.h"
+#include "mt/Mutex.h"
 
 class HIDScreen : public PlatformScreen {
 public:
+    //! HID devices the screen writes to
+    enum EHIDDevice {
+        kHIDKeyboard,
+        kHIDMouse,
+        kHIDMouseAbs,
+        kNumHIDDevices
+    };
+
     HIDScreen(const std::string & keyboardDevice,
               const std::string & mouseDevice,
               const std::string & mouseAbsDevice,
               int screenWidth, int screenHeight,
               int screenX, int screenY,
+              bool autoType,
+              const std::string & sinkType,
               IEventQueue *events);
     virtual ~HIDScreen();
 
     //! @name manipulators
     //@{
 
+    //! Log the output statistics of every device
+    /*!
+    Rates are worked out over the time since the last call.  Also done
+    on SIGUSR2.
+    */
+    void                logStats();
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get the output statistics of a device
+    void                getStats(EHIDDevice, HIDStats::Snapshot&) const;
+
     //@}
 
     // IScreen overrides
@@ -70,16 +98,24 @@ protected:
     virtual void        updateButtons();
     virtual IKeyState*    getKeyState() const;
 
+private:
+    const HIDDevice&    getDevice(EHIDDevice) const;
+    static void         handleStatsSignal(Arch::ESignal, void*);
+
 private:
     HIDMouse            m_mouseDevice;
     HIDMouseAbs         m_mouseAbsDevice;
     SInt32              m_width, m_height;
     SInt32              m_x, m_y;
     int                 m_mouseX, m_mouseY;
+    bool                m_autoType;
 
     IEventQueue*        m_events;
     synergy::KeyMap     m_keyMap;
 
     HIDKeyState*        m_keyState;
+
+    Mutex               m_statsMutex;
+    HIDStats::Snapshot  m_lastStats[kNumHIDDevices];
 };
 
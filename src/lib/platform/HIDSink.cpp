@@ -0,0 +1,361 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "platform/HIDSink.h"
+
+#include "platform/HIDReportLayout.h"
+#include "platform/HIDUring.h"
+#include "arch/Arch.h"
+#include "base/Log.h"
+#include "mt/Lock.h"
+#include "mt/Mutex.h"
+#include "mt/Thread.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// how long to wait for a stream socket to take the rest of a report
+// it took part of
+static const double s_partialTimeout = 1.0;
+
+//
+// HIDFdSink
+//
+
+HIDFdSink::HIDFdSink(const std::string& path, bool uring) :
+    m_path(path),
+    m_fd(-1),
+    m_uring(uring ? HIDUring::acquire() : nullptr)
+{
+}
+
+HIDFdSink::~HIDFdSink()
+{
+    closeFd();
+    if (m_uring != nullptr) {
+        HIDUring::release(m_uring);
+    }
+}
+
+IHIDSink::EResult
+HIDFdSink::write(const UInt8* report, UInt32 size)
+{
+    for (;;) {
+        ssize_t result = ::write(m_fd, report, size);
+        if (result >= 0) {
+            // gadgets and pipes take whole reports or nothing
+            return kWritten;
+        }
+
+        switch (errno) {
+        case EINTR:
+            // may have been woken to be cancelled
+            Thread::testCancel();
+            break;
+
+        case EAGAIN:
+            return kBusy;
+
+        default:
+            // ESHUTDOWN and friends:  the host went away
+            LOG((CLOG_WARN "failed to write to HID device %s: %s", m_path.c_str(), strerror(errno)));
+            closeFd();
+            return kFailed;
+        }
+    }
+}
+
+bool
+HIDFdSink::waitWritable(double timeout)
+{
+    struct pollfd pfd;
+    pfd.fd      = m_fd;
+    pfd.events  = POLLOUT;
+    pfd.revents = 0;
+    int result = poll(&pfd, 1, static_cast<int>(timeout * 1000.0) + 1);
+
+    // errors are reported by the write
+    return (result > 0 || (result < 0 && errno != EINTR));
+}
+
+const std::string&
+HIDFdSink::getName() const
+{
+    return m_path;
+}
+
+int
+HIDFdSink::getUringFd() const
+{
+    return (m_uring != nullptr) ? m_fd : -1;
+}
+
+void
+HIDFdSink::closeFd()
+{
+    if (m_fd != -1) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+//
+// HIDGadgetSink
+//
+
+HIDGadgetSink::HIDGadgetSink(const std::string& path, bool uring) :
+    HIDFdSink(path, uring)
+{
+}
+
+bool
+HIDGadgetSink::open()
+{
+    // io_uring completes a blocking write when the host collects the
+    // report instead of failing it with EAGAIN
+    closeFd();
+    int flags = (m_uring != nullptr) ? O_RDWR : (O_RDWR | O_NONBLOCK);
+    m_fd = ::open(m_path.c_str(), flags, 0666);
+    if (m_fd == -1) {
+        LOG((CLOG_DEBUG1 "failed to open HID device %s: %s", m_path.c_str(), strerror(errno)));
+        return false;
+    }
+    return true;
+}
+
+bool
+HIDGadgetSink::getDescriptor(std::vector<UInt8>& descriptor) const
+{
+    return HIDReportLayout::loadDescriptor(m_path, descriptor);
+}
+
+//
+// HIDPipeSink
+//
+
+HIDPipeSink::HIDPipeSink(const std::string& path, bool uring) :
+    HIDFdSink(path, uring),
+    m_stream(false)
+{
+}
+
+bool
+HIDPipeSink::open()
+{
+    closeFd();
+
+    struct stat info;
+    m_stream = (stat(m_path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode));
+    if (!m_stream) {
+        // fails until something opens the other end
+        m_fd = ::open(m_path.c_str(), O_WRONLY | O_NONBLOCK);
+        if (m_fd == -1) {
+            LOG((CLOG_DEBUG1 "failed to open HID pipe %s: %s", m_path.c_str(), strerror(errno)));
+            return false;
+        }
+        if (m_uring != nullptr && fcntl(m_fd, F_SETFL, 0) != 0) {
+            LOG((CLOG_DEBUG1 "failed to open HID pipe %s: %s", m_path.c_str(), strerror(errno)));
+            closeFd();
+            return false;
+        }
+        return true;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (m_path.size() >= sizeof(addr.sun_path)) {
+        LOG((CLOG_WARN "HID socket path too long: %s", m_path.c_str()));
+        return false;
+    }
+    strcpy(addr.sun_path, m_path.c_str());
+
+    m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_fd == -1 ||
+            connect(m_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            fcntl(m_fd, F_SETFL, O_NONBLOCK) != 0) {
+        LOG((CLOG_DEBUG1 "failed to connect to HID socket %s: %s", m_path.c_str(), strerror(errno)));
+        closeFd();
+        return false;
+    }
+    return true;
+}
+
+IHIDSink::EResult
+HIDPipeSink::write(const UInt8* report, UInt32 size)
+{
+    if (!m_stream) {
+        return HIDFdSink::write(report, size);
+    }
+
+    // a stream may take part of a report.  the rest has to follow
+    // before anything else can.
+    UInt32 done = 0;
+    double deadline = 0.0;
+    while (done < size) {
+        ssize_t result = send(m_fd, report + done, size - done, MSG_NOSIGNAL);
+        if (result > 0) {
+            done += static_cast<UInt32>(result);
+            continue;
+        }
+
+        if (result < 0 && errno == EINTR) {
+            Thread::testCancel();
+            continue;
+        }
+        if (result < 0 && errno == EAGAIN) {
+            if (done == 0) {
+                return kBusy;
+            }
+            if (deadline == 0.0) {
+                deadline = ARCH->time() + s_partialTimeout;
+            }
+            if (ARCH->time() < deadline) {
+                Thread::testCancel();
+                waitWritable(deadline - ARCH->time());
+                continue;
+            }
+        }
+
+        LOG((CLOG_WARN "failed to write to HID socket %s", m_path.c_str()));
+        closeFd();
+        return kFailed;
+    }
+    return kWritten;
+}
+
+bool
+HIDPipeSink::getDescriptor(std::vector<UInt8>&) const
+{
+    return false;
+}
+
+int
+HIDPipeSink::getUringFd() const
+{
+    // partial writes to a socket are left to write()
+    return m_stream ? -1 : HIDFdSink::getUringFd();
+}
+
+//
+// HIDMemorySink
+//
+
+HIDMemorySink::HIDMemorySink(const std::string& name, UInt32 capacity) :
+    m_name(name),
+    m_capacity(capacity),
+    m_mutex(new Mutex),
+    m_count(0),
+    m_first(0.0),
+    m_last(0.0)
+{
+}
+
+HIDMemorySink::~HIDMemorySink()
+{
+    if (m_count > 1 && m_last > m_first) {
+        LOG((CLOG_INFO "HID sink %s: %u reports in %.3f seconds, %.0f reports/s",
+                m_name.c_str(), m_count, m_last - m_first,
+                (m_count - 1) / (m_last - m_first)));
+    }
+    delete m_mutex;
+}
+
+void
+HIDMemorySink::getRecords(RecordList& records) const
+{
+    Lock lock(m_mutex);
+    records = m_records;
+}
+
+UInt32
+HIDMemorySink::getCount() const
+{
+    Lock lock(m_mutex);
+    return m_count;
+}
+
+bool
+HIDMemorySink::open()
+{
+    return true;
+}
+
+IHIDSink::EResult
+HIDMemorySink::write(const UInt8* report, UInt32 size)
+{
+    double now = ARCH->time();
+
+    Lock lock(m_mutex);
+    if (m_count++ == 0) {
+        m_first = now;
+    }
+    m_last = now;
+    if (m_records.size() < m_capacity) {
+        m_records.push_back(Record());
+        m_records.back().m_time = now;
+        m_records.back().m_report.assign(report, report + size);
+    }
+    return kWritten;
+}
+
+bool
+HIDMemorySink::waitWritable(double)
+{
+    return true;
+}
+
+bool
+HIDMemorySink::getDescriptor(std::vector<UInt8>&) const
+{
+    return false;
+}
+
+const std::string&
+HIDMemorySink::getName() const
+{
+    return m_name;
+}
+
+int
+HIDMemorySink::getUringFd() const
+{
+    return -1;
+}
+
+//
+// HIDSinkFactory
+//
+
+IHIDSink*
+HIDSinkFactory::create(const std::string& type, const std::string& path)
+{
+    if (type == "pipe") {
+        return new HIDPipeSink(path);
+    }
+    if (type == "memory") {
+        return new HIDMemorySink(path);
+    }
+    if (type == "uring") {
+        return new HIDGadgetSink(path, true);
+    }
+    return new HIDGadgetSink(path);
+}
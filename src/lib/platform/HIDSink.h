@@ -0,0 +1,149 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "platform/IHIDSink.h"
+
+class HIDUring;
+class Mutex;
+
+//! Sink for a file descriptor
+/*!
+Writes reports to a non-blocking file descriptor.  Subclasses say how
+to open it.  If \c uring is true and io_uring is available the
+descriptor blocks instead and HIDUring writes to it.
+*/
+class HIDFdSink : public IHIDSink {
+public:
+    HIDFdSink(const std::string& path, bool uring = false);
+    virtual ~HIDFdSink();
+
+    // IHIDSink overrides
+    virtual EResult     write(const UInt8* report, UInt32 size);
+    virtual bool        waitWritable(double timeout);
+    virtual const std::string&
+                        getName() const;
+    virtual int         getUringFd() const;
+
+protected:
+    //! Close the descriptor, if open
+    void                closeFd();
+
+protected:
+    std::string         m_path;
+    int                 m_fd;
+    HIDUring*           m_uring;
+};
+
+//! Sink for a USB gadget HID function
+/*!
+Writes to a /dev/hidgN node.  The report descriptor is the one the
+gadget was configured with.
+*/
+class HIDGadgetSink : public HIDFdSink {
+public:
+    HIDGadgetSink(const std::string& path, bool uring = false);
+
+    // IHIDSink overrides
+    virtual bool        open();
+    virtual bool        getDescriptor(std::vector<UInt8>&) const;
+};
+
+//! Loopback sink
+/*!
+Writes to a named pipe or connects to a UNIX domain socket, whichever
+\c path is, so another process can stand in for the USB host.  Stream
+sockets carry the reports back to back.
+*/
+class HIDPipeSink : public HIDFdSink {
+public:
+    HIDPipeSink(const std::string& path, bool uring = false);
+
+    // IHIDSink overrides
+    virtual bool        open();
+    virtual EResult     write(const UInt8* report, UInt32 size);
+    virtual bool        getDescriptor(std::vector<UInt8>&) const;
+    virtual int         getUringFd() const;
+
+private:
+    bool                m_stream;
+};
+
+//! Recording sink
+/*!
+Takes every report at once and keeps it, with the time it was taken,
+for tests and benchmarks.  Once \c capacity reports have been kept the
+rest are only counted.
+*/
+class HIDMemorySink : public IHIDSink {
+public:
+    //! A recorded report
+    class Record {
+    public:
+        double          m_time;
+        std::vector<UInt8> m_report;
+    };
+    typedef std::vector<Record> RecordList;
+
+    HIDMemorySink(const std::string& name, UInt32 capacity = 65536);
+    virtual ~HIDMemorySink();
+
+    //! @name accessors
+    //@{
+
+    //! Get the recorded reports
+    /*!
+    Copies the reports recorded so far, which may still be growing,
+    into \c records.
+    */
+    void                getRecords(RecordList& records) const;
+
+    //! Get the number of reports taken, including any not kept
+    UInt32              getCount() const;
+
+    //@}
+
+    // IHIDSink overrides
+    virtual bool        open();
+    virtual EResult     write(const UInt8* report, UInt32 size);
+    virtual bool        waitWritable(double timeout);
+    virtual bool        getDescriptor(std::vector<UInt8>&) const;
+    virtual const std::string&
+                        getName() const;
+    virtual int         getUringFd() const;
+
+private:
+    std::string         m_name;
+    const UInt32        m_capacity;
+    Mutex*              m_mutex;
+    RecordList          m_records;
+    UInt32              m_count;
+    double              m_first;
+    double              m_last;
+};
+
+//! HID sink factory
+class HIDSinkFactory {
+public:
+    //! Create a sink
+    /*!
+    \c type is "gadget", "uring" (a gadget written through io_uring
+    where available), "pipe" or "memory".  \c path is the device, pipe
+    or socket path or, for memory sinks, a name for log messages.
+    */
+    static IHIDSink*    create(const std::string& type,
+                            const std::string& path);
+};
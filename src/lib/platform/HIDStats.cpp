@@ -0,0 +1,232 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "platform/HIDStats.h"
+
+#include "arch/Arch.h"
+#include "base/Log.h"
+
+#include <cstring>
+
+//
+// HIDStats::Histogram
+//
+
+HIDStats::Histogram::Histogram() :
+    m_max(0.0)
+{
+    memset(m_buckets, 0, sizeof(m_buckets));
+}
+
+HIDStats::Count
+HIDStats::Histogram::getCount() const
+{
+    Count count = 0;
+    for (UInt32 i = 0; i < NUM_BUCKETS; ++i) {
+        count += m_buckets[i];
+    }
+    return count;
+}
+
+double
+HIDStats::Histogram::getPercentile(double percent) const
+{
+    Count count = getCount();
+    if (count == 0) {
+        return 0.0;
+    }
+
+    Count rank = static_cast<Count>(count * percent / 100.0);
+    Count seen = 0;
+    for (UInt32 i = 0; i < NUM_BUCKETS - 1; ++i) {
+        seen += m_buckets[i];
+        if (seen > rank) {
+            double bound = static_cast<double>(2ull << i) * 1.0e-6;
+            return (bound < m_max) ? bound : m_max;
+        }
+    }
+    return m_max;
+}
+
+//
+// HIDStats::Snapshot
+//
+
+HIDStats::Snapshot::Snapshot() :
+    m_elapsed(0.0),
+    m_queued(0),
+    m_collapsed(0),
+    m_coalesced(0),
+    m_written(0),
+    m_dropped(0),
+    m_stalls(0),
+    m_failures(0)
+{
+}
+
+//
+// HIDStats::AtomicHistogram
+//
+
+HIDStats::AtomicHistogram::AtomicHistogram() :
+    m_max(0.0)
+{
+    for (UInt32 i = 0; i < NUM_BUCKETS; ++i) {
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void
+HIDStats::AtomicHistogram::add(double seconds)
+{
+    Count us = (seconds > 0.0) ? static_cast<Count>(seconds * 1.0e6) : 0;
+    UInt32 bucket = 0;
+    while (us > 1 && bucket < NUM_BUCKETS - 1) {
+        us >>= 1;
+        ++bucket;
+    }
+    bump(m_buckets[bucket]);
+
+    if (seconds > m_max.load(std::memory_order_relaxed)) {
+        m_max.store(seconds, std::memory_order_relaxed);
+    }
+}
+
+void
+HIDStats::AtomicHistogram::get(Histogram& histogram) const
+{
+    for (UInt32 i = 0; i < NUM_BUCKETS; ++i) {
+        histogram.m_buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    }
+    histogram.m_max = m_max.load(std::memory_order_relaxed);
+}
+
+//
+// HIDStats
+//
+
+HIDStats::HIDStats() :
+    m_start(ARCH->time()),
+    m_queued(0),
+    m_collapsed(0),
+    m_coalesced(0),
+    m_written(0),
+    m_dropped(0),
+    m_stalls(0),
+    m_failures(0)
+{
+}
+
+void
+HIDStats::queued()
+{
+    bump(m_queued);
+}
+
+void
+HIDStats::collapsed()
+{
+    bump(m_collapsed);
+}
+
+void
+HIDStats::coalesced(UInt32 count)
+{
+    bump(m_coalesced, count);
+}
+
+void
+HIDStats::written(double queuedTime, double startTime, double endTime)
+{
+    bump(m_written);
+    m_latency.add(endTime - queuedTime);
+    m_writeTime.add(endTime - startTime);
+}
+
+void
+HIDStats::dropped(UInt32 count)
+{
+    bump(m_dropped, count);
+}
+
+void
+HIDStats::stalled()
+{
+    bump(m_stalls);
+}
+
+void
+HIDStats::failed()
+{
+    bump(m_failures);
+}
+
+void
+HIDStats::getSnapshot(Snapshot& snapshot) const
+{
+    snapshot.m_elapsed   = ARCH->time() - m_start;
+    snapshot.m_queued    = m_queued.load(std::memory_order_relaxed);
+    snapshot.m_collapsed = m_collapsed.load(std::memory_order_relaxed);
+    snapshot.m_coalesced = m_coalesced.load(std::memory_order_relaxed);
+    snapshot.m_written   = m_written.load(std::memory_order_relaxed);
+    snapshot.m_dropped   = m_dropped.load(std::memory_order_relaxed);
+    snapshot.m_stalls    = m_stalls.load(std::memory_order_relaxed);
+    snapshot.m_failures  = m_failures.load(std::memory_order_relaxed);
+    m_latency.get(snapshot.m_latency);
+    m_writeTime.get(snapshot.m_writeTime);
+}
+
+void
+HIDStats::log(const std::string& name, const Snapshot& snapshot,
+                const Snapshot* previous)
+{
+    double elapsed = snapshot.m_elapsed;
+    Count written  = snapshot.m_written;
+    if (previous != nullptr) {
+        elapsed -= previous->m_elapsed;
+        written -= previous->m_written;
+    }
+    double rate = (elapsed > 0.0) ? written / elapsed : 0.0;
+
+    LOG((CLOG_NOTE "HID %s: %.0f reports/s, %llu queued, %llu written, "
+            "%llu coalesced, %llu collapsed, %llu dropped, %llu stalls, %llu failures",
+            name.c_str(), rate,
+            snapshot.m_queued,
+            snapshot.m_written,
+            snapshot.m_coalesced,
+            snapshot.m_collapsed,
+            snapshot.m_dropped,
+            snapshot.m_stalls,
+            snapshot.m_failures));
+    LOG((CLOG_NOTE "HID %s: latency p50 %.3fms p99 %.3fms max %.3fms, "
+            "write p50 %.3fms p99 %.3fms max %.3fms",
+            name.c_str(),
+            snapshot.m_latency.getPercentile(50.0) * 1000.0,
+            snapshot.m_latency.getPercentile(99.0) * 1000.0,
+            snapshot.m_latency.m_max * 1000.0,
+            snapshot.m_writeTime.getPercentile(50.0) * 1000.0,
+            snapshot.m_writeTime.getPercentile(99.0) * 1000.0,
+            snapshot.m_writeTime.m_max * 1000.0));
+}
+
+void
+HIDStats::bump(Counter& counter, Count n)
+{
+    // only one thread writes each counter so there's no need for an
+    // atomic read-modify-write
+    counter.store(counter.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+}
@@ -0,0 +1,180 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/basic_types.h"
+
+#include <atomic>
+#include <string>
+
+//! HID output statistics
+/*!
+Counters and latency histograms for one HIDDevice.  Each counter is
+only ever written by one thread, the producer (the thread calling
+HIDDevice::update()) or the device's writer (its own thread or the
+HIDUring driver), and the two threads' slots live on separate cache
+lines, so recording is a relaxed load and store with no locked
+instructions.  Any thread may take a snapshot.
+*/
+class HIDStats {
+public:
+    //! Number of histogram buckets
+    /*!
+    Bucket \c i counts durations of [2^i, 2^(i+1)) microseconds, except
+    that bucket 0 also counts anything shorter.  The last bucket counts
+    everything from about 17 seconds up.
+    */
+    static const UInt32 NUM_BUCKETS = 25;
+
+    //! A count of reports or events
+    typedef unsigned long long Count;
+
+    //! A log-scale latency histogram
+    class Histogram {
+    public:
+        Histogram();
+
+        //! Get the number of samples
+        Count           getCount() const;
+
+        //! Estimate a percentile, in seconds
+        /*!
+        Returns the upper bound of the bucket holding the \c percent'th
+        percentile, 0 if there are no samples.
+        */
+        double          getPercentile(double percent) const;
+
+    public:
+        Count           m_buckets[NUM_BUCKETS];
+        double          m_max;
+    };
+
+    //! Copy of the statistics at one time
+    class Snapshot {
+    public:
+        Snapshot();
+
+    public:
+        //! Seconds since the statistics were started
+        double          m_elapsed;
+        //! Reports passed to HIDDevice::update()
+        Count           m_queued;
+        //! Reports collapsed into the overflow report (queue full)
+        Count           m_collapsed;
+        //! Reports merged into another by the coalescer
+        Count           m_coalesced;
+        //! Reports written
+        Count           m_written;
+        //! Reports folded into the device state while the host was away
+        Count           m_dropped;
+        //! Times the host stopped polling
+        Count           m_stalls;
+        //! Times the sink failed and had to be reopened
+        Count           m_failures;
+        //! Time from update() to the report being written
+        Histogram       m_latency;
+        //! Time spent writing each report, including waiting for the host
+        Histogram       m_writeTime;
+    };
+
+    HIDStats();
+
+    //! @name producer
+    //@{
+
+    //! Count a report passed to update()
+    void                queued();
+
+    //! Count a report collapsed into the overflow report
+    void                collapsed();
+
+    //@}
+    //! @name writer
+    //@{
+
+    //! Count reports merged by the coalescer
+    void                coalesced(UInt32 count);
+
+    //! Record a written report
+    /*!
+    \c queuedTime is when the oldest report merged into it was queued,
+    \c startTime and \c endTime bracket the write.
+    */
+    void                written(double queuedTime, double startTime,
+                            double endTime);
+
+    //! Count reports folded into the device state
+    void                dropped(UInt32 count);
+
+    //! Count a stall
+    void                stalled();
+
+    //! Count a sink failure
+    void                failed();
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Take a snapshot
+    void                getSnapshot(Snapshot&) const;
+
+    //! Log a snapshot
+    /*!
+    Logs \c snapshot for the device called \c name.  Rates are worked
+    out over the time since \c previous, which may be NULL.
+    */
+    static void         log(const std::string& name, const Snapshot& snapshot,
+                            const Snapshot* previous);
+
+    //@}
+
+private:
+    typedef std::atomic<Count> Counter;
+
+    class AtomicHistogram {
+    public:
+        AtomicHistogram();
+        void            add(double seconds);
+        void            get(Histogram&) const;
+
+    private:
+        Counter         m_buckets[NUM_BUCKETS];
+        std::atomic<double> m_max;
+    };
+
+    static void         bump(Counter& counter, Count n = 1);
+
+private:
+    const double        m_start;
+
+    // written by the producer only
+    Counter             m_queued;
+    Counter             m_collapsed;
+
+    // keeps the two threads' counters on separate cache lines
+    UInt8               m_pad[64];
+
+    // written by the writer thread only
+    Counter             m_coalesced;
+    Counter             m_written;
+    Counter             m_dropped;
+    Counter             m_stalls;
+    Counter             m_failures;
+    AtomicHistogram     m_latency;
+    AtomicHistogram     m_writeTime;
+};
@@ -6,8 +6,8 @@
 #include "HIDTouch.h"
 
 HIDTouch::HIDTouch(
-        const std::string& path) :
-    HIDDevice(path, REPORT_SIZE)
+        IHIDSink* sink) :
+    HIDDevice(sink, REPORT_SIZE)
 {
 
 }
@@ -24,7 +24,7 @@ void HIDTouch::move(float fx, float fy) {
     LOG((CLOG_DEBUG "%u %u", x, y));
 
     // Report
-    char report[m_reportSize];
+    UInt8 report[m_reportSize];
     memset(report,0,m_reportSize);
 
     // Butons??
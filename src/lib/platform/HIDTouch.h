@@ -8,7 +8,7 @@
 
 class HIDTouch : public HIDDevice {
 public:
-    HIDTouch(const std::string& path);
+    HIDTouch(IHIDSink* sink);
     ~HIDTouch();
 
     void move(float fx, float fy);
@@ -0,0 +1,159 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "platform/HIDTyper.h"
+
+#include "platform/HIDKeyboard.h"
+#include "base/Log.h"
+#include "mt/Lock.h"
+#include "mt/Mutex.h"
+
+#include <cstring>
+
+// characters that need shift on a US keyboard, besides the capitals
+static const char* s_usShifted = "~!@#$%^&*()_+{}|:\"<>?";
+
+HIDTyper::HIDTyper(const HIDKeyboard& keyboard) :
+    m_keyboard(keyboard),
+    m_mutex(new Mutex),
+    m_ready(false)
+{
+    const UInt8 shift = HIDKeyboard::getModifier(
+                            HIDKeyboard::getUsage(kKeyShift_L));
+
+    // printable ASCII are keysyms.  clipboard text newlines are LF.
+    memset(m_table, 0, sizeof(m_table));
+    for (UInt32 c = 0x20; c < 0x7f; ++c) {
+        m_table[c].m_usage = HIDKeyboard::getUsage(c);
+        if ((c >= 'A' && c <= 'Z') || strchr(s_usShifted, c) != nullptr) {
+            m_table[c].m_modifier = shift;
+        }
+    }
+    m_table['\n'].m_usage = HIDKeyboard::getUsage(kKeyReturn);
+    m_table['\t'].m_usage = HIDKeyboard::getUsage(kKeyTab);
+
+    m_current.m_modifier = 0;
+    m_current.m_usage    = 0;
+    m_liveReports        = m_keyboard.getLiveReports();
+}
+
+HIDTyper::~HIDTyper()
+{
+    delete m_mutex;
+}
+
+UInt32
+HIDTyper::type(const String& text)
+{
+    StrokeList strokes;
+    UInt32 skipped = 0;
+    for (String::const_iterator i = text.begin(); i != text.end(); ++i) {
+        UInt8 c = static_cast<UInt8>(*i);
+        if (c < TABLE_SIZE && m_table[c].m_usage != 0) {
+            strokes.push_back(m_table[c]);
+        }
+        else if (c < 0x80 || c >= 0xc0) {
+            // count UTF-8 lead bytes, not continuation bytes
+            ++skipped;
+        }
+    }
+    if (skipped != 0) {
+        LOG((CLOG_WARN "can't type %u characters, skipping them", skipped));
+    }
+
+    Lock lock(m_mutex);
+    if (m_pending.size() + strokes.size() > MAX_PENDING) {
+        LOG((CLOG_WARN "too much text to type, dropping %u characters", static_cast<UInt32>(strokes.size())));
+        return 0;
+    }
+    m_pending.insert(m_pending.end(), strokes.begin(), strokes.end());
+    if (!m_pending.empty()) {
+        m_ready = true;
+    }
+    return static_cast<UInt32>(strokes.size());
+}
+
+bool
+HIDTyper::isReady() const
+{
+    // releasing the keys queues a live report, which wakes the writer
+    return m_ready && !m_keyboard.isHoldingKeys();
+}
+
+bool
+HIDTyper::read(UInt8* report)
+{
+    // a live report has replaced whatever we held down on the host
+    UInt32 liveReports = m_keyboard.getLiveReports();
+    if (liveReports != m_liveReports) {
+        m_liveReports        = liveReports;
+        m_current.m_modifier = 0;
+        m_current.m_usage    = 0;
+    }
+
+    // don't release the user's keys or type with their modifiers
+    if (m_keyboard.isHoldingKeys()) {
+        return false;
+    }
+
+    Stroke next;
+    bool haveNext;
+    {
+        Lock lock(m_mutex);
+        haveNext = !m_pending.empty();
+        if (haveNext) {
+            next = m_pending.front();
+        }
+        else if (m_current.m_modifier == 0 && m_current.m_usage == 0) {
+            // done and everything is released
+            m_ready = false;
+            return false;
+        }
+    }
+
+    if (!haveNext) {
+        m_current.m_modifier = 0;
+        m_current.m_usage    = 0;
+    }
+    else if (next.m_modifier != m_current.m_modifier) {
+        // change the modifiers on their own, releasing the last key, so
+        // the host never sees the next key with the old modifiers
+        m_current.m_modifier = next.m_modifier;
+        m_current.m_usage    = 0;
+    }
+    else if (next.m_usage == m_current.m_usage) {
+        // the same key twice needs a release in between
+        m_current.m_usage = 0;
+    }
+    else {
+        // release the last key and press the next in one report
+        m_current = next;
+        Lock lock(m_mutex);
+        m_pending.pop_front();
+    }
+
+    m_keyboard.buildReport(report, m_current.m_modifier, m_current.m_usage);
+    return true;
+}
+
+void
+HIDTyper::cancel()
+{
+    Lock lock(m_mutex);
+    if (!m_pending.empty()) {
+        LOG((CLOG_NOTE "abandoned typing %u characters", static_cast<UInt32>(m_pending.size())));
+        m_pending.clear();
+    }
+}
@@ -0,0 +1,87 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "HIDReportSource.h"
+#include "base/String.h"
+#include "common/stddeque.h"
+
+#include <atomic>
+
+class HIDKeyboard;
+class Mutex;
+
+//! Types text on a HID keyboard
+/*!
+Turns text into key strokes through a table built for the host's
+keyboard layout (US) and hands them to the keyboard's writer thread
+one report at a time.  Consecutive keys with the same modifiers are
+pipelined, the previous key being released in the same report that
+presses the next, and modifiers are only reported when they change, so
+most characters cost a single report.
+
+Typing pauses while the user holds any key or modifier down, so typed
+reports never release live keys or combine with live modifiers.  Live
+reports always take priority over typed ones in the keyboard's queue.
+*/
+class HIDTyper : public HIDReportSource {
+public:
+    HIDTyper(const HIDKeyboard& keyboard);
+    virtual ~HIDTyper();
+
+    //! @name manipulators
+    //@{
+
+    //! Queue text to type
+    /*!
+    \c text is UTF-8.  Characters the layout can't type are skipped.
+    Returns the number of characters queued.  The caller must wake the
+    keyboard's writer thread afterwards.
+    */
+    UInt32              type(const String& text);
+
+    //@}
+
+    // HIDReportSource overrides
+    virtual bool        isReady() const;
+    virtual bool        read(UInt8* report);
+    virtual void        cancel();
+
+private:
+    struct Stroke {
+    public:
+        UInt8           m_modifier;
+        UInt8           m_usage;
+    };
+    typedef std::deque<Stroke> StrokeList;
+
+    static const UInt32 TABLE_SIZE = 128;
+    static const UInt32 MAX_PENDING = 65536;
+
+private:
+    const HIDKeyboard&  m_keyboard;
+    Stroke              m_table[TABLE_SIZE];
+
+    // shared with the writer thread
+    Mutex*              m_mutex;
+    StrokeList          m_pending;
+    std::atomic<bool>   m_ready;
+
+    // writer thread only:  what the last report held down, and the
+    // keyboard's live report count when we sent it
+    Stroke              m_current;
+    UInt32              m_liveReports;
+};
@@ -0,0 +1,870 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "platform/HIDUring.h"
+
+#include "platform/HIDDevice.h"
+#include "platform/HIDReportQueue.h"
+#include "platform/HIDStats.h"
+#include "platform/IHIDSink.h"
+#include "arch/Arch.h"
+#include "base/Log.h"
+#include "base/TMethodJob.h"
+#include "mt/CondVar.h"
+#include "mt/Lock.h"
+#include "mt/Mutex.h"
+#include "mt/Thread.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+
+#if HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_register) && \
+    defined(IORING_FEAT_EXT_ARG)
+#define HID_HAVE_URING 1
+#endif
+#endif
+
+static Mutex*
+getLock()
+{
+    // never destroyed so devices can go away during static destruction
+    static Mutex* s_lock = new Mutex;
+    return s_lock;
+}
+
+#if HID_HAVE_URING
+
+// each device has at most a write or poll and two cancels in flight,
+// so this leaves plenty of room for the three gadgets
+static const unsigned s_ringEntries = 32;
+
+// what an operation is for, in the low bits of its user_data.  the rest
+// is the slot, which is at least 4 byte aligned.
+enum {
+    kOpWrite,
+    kOpPoll,
+    kOpCancel,
+    kOpWake,
+    kOpMask = 3
+};
+
+// the kernel's 64-bit form of a pointer
+static __u64
+toAddr(const void* p)
+{
+    return static_cast<__u64>(reinterpret_cast<uintptr_t>(p));
+}
+
+static HIDUring*    s_instance    = nullptr;
+static UInt32       s_refs        = 0;
+static bool         s_unavailable = false;
+
+//
+// HIDUring::Ring
+//
+
+class HIDUring::Ring {
+public:
+    Ring() :
+        m_fd(-1),
+        m_sq(MAP_FAILED),
+        m_cq(MAP_FAILED),
+        m_sqes(MAP_FAILED),
+        m_sqSize(0),
+        m_cqSize(0),
+        m_sqesSize(0),
+        m_sqEntries(0),
+        m_sqeTail(0),
+        m_unsubmitted(0) { }
+
+    ~Ring()
+    {
+        if (m_sqes != MAP_FAILED) {
+            munmap(m_sqes, m_sqesSize);
+        }
+        if (m_cq != MAP_FAILED && m_cq != m_sq) {
+            munmap(m_cq, m_cqSize);
+        }
+        if (m_sq != MAP_FAILED) {
+            munmap(m_sq, m_sqSize);
+        }
+        if (m_fd != -1) {
+            close(m_fd);
+        }
+    }
+
+    // create and map the rings.  returns a reason on failure, NULL on
+    // success.
+    const char*         setup()
+    {
+        // the driver waits with a timeout, which needs EXT_ARG (5.11)
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        m_fd = static_cast<int>(syscall(__NR_io_uring_setup,
+                                        s_ringEntries, &params));
+        if (m_fd == -1) {
+            return strerror(errno);
+        }
+        if ((params.features & IORING_FEAT_EXT_ARG) == 0) {
+            return "kernel can't wait with a timeout";
+        }
+
+        m_sqSize   = params.sq_off.array + params.sq_entries * sizeof(__u32);
+        m_cqSize   = params.cq_off.cqes +
+                        params.cq_entries * sizeof(struct io_uring_cqe);
+        m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+        bool single = ((params.features & IORING_FEAT_SINGLE_MMAP) != 0);
+        if (single && m_cqSize > m_sqSize) {
+            m_sqSize = m_cqSize;
+        }
+
+        m_sq = mmap(nullptr, m_sqSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+        if (m_sq == MAP_FAILED) {
+            return strerror(errno);
+        }
+        m_cq = single ? m_sq :
+               mmap(nullptr, m_cqSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+        m_sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+        if (m_cq == MAP_FAILED || m_sqes == MAP_FAILED) {
+            return strerror(errno);
+        }
+
+        UInt8* sq   = static_cast<UInt8*>(m_sq);
+        UInt8* cq   = static_cast<UInt8*>(m_cq);
+        m_sqHead    = reinterpret_cast<__u32*>(sq + params.sq_off.head);
+        m_sqTail    = reinterpret_cast<__u32*>(sq + params.sq_off.tail);
+        m_sqMask    = reinterpret_cast<__u32*>(sq + params.sq_off.ring_mask);
+        m_sqArray   = reinterpret_cast<__u32*>(sq + params.sq_off.array);
+        m_cqHead    = reinterpret_cast<__u32*>(cq + params.cq_off.head);
+        m_cqTail    = reinterpret_cast<__u32*>(cq + params.cq_off.tail);
+        m_cqMask    = reinterpret_cast<__u32*>(cq + params.cq_off.ring_mask);
+        m_cqes      = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+        m_sqEntries = params.sq_entries;
+        m_sqeTail   = *m_sqTail;
+        return nullptr;
+    }
+
+    // check the kernel has every operation the driver uses.  returns
+    // the first one missing, NULL if there's none.
+    const char*         probe()
+    {
+        static const struct {
+            UInt8       m_op;
+            const char* m_name;
+        } s_ops[] = {
+            { IORING_OP_WRITE,        "write" },
+            { IORING_OP_READ,         "read" },
+            { IORING_OP_POLL_ADD,     "poll" },
+            { IORING_OP_ASYNC_CANCEL, "cancel" }
+        };
+        static const unsigned s_maxOps = 256;
+
+        size_t size = sizeof(struct io_uring_probe) +
+                        s_maxOps * sizeof(struct io_uring_probe_op);
+        struct io_uring_probe* probe =
+            static_cast<struct io_uring_probe*>(calloc(1, size));
+        if (syscall(__NR_io_uring_register, m_fd,
+                    IORING_REGISTER_PROBE, probe, s_maxOps) != 0) {
+            free(probe);
+            return "probe";
+        }
+
+        const char* missing = nullptr;
+        for (size_t i = 0; i < sizeof(s_ops) / sizeof(s_ops[0]); ++i) {
+            UInt8 op = s_ops[i].m_op;
+            if (op > probe->last_op ||
+                    (probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0) {
+                missing = s_ops[i].m_name;
+                break;
+            }
+        }
+        free(probe);
+        return missing;
+    }
+
+    // get a cleared submission entry, submitting what's queued if the
+    // queue is full.  returns NULL if there's still no room.
+    struct io_uring_sqe* getSqe()
+    {
+        if (m_sqeTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries) {
+            enter(false, -1.0);
+            if (m_sqeTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) >= m_sqEntries) {
+                return nullptr;
+            }
+        }
+        __u32 index = m_sqeTail & *m_sqMask;
+        struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(m_sqes) + index;
+        memset(sqe, 0, sizeof(*sqe));
+        m_sqArray[index] = index;
+        ++m_sqeTail;
+        ++m_unsubmitted;
+        return sqe;
+    }
+
+    // submit everything queued and, if \c wait, wait up to \c timeout
+    // seconds (forever if negative) for a completion.  returns 0 or an
+    // errno.
+    int                 enter(bool wait, double timeout)
+    {
+        if (!wait && m_unsubmitted == 0) {
+            return 0;
+        }
+        __atomic_store_n(m_sqTail, m_sqeTail, __ATOMIC_RELEASE);
+
+        unsigned flags = 0;
+        struct io_uring_getevents_arg arg;
+        struct __kernel_timespec ts;
+        void* argp     = nullptr;
+        size_t argSize = 0;
+        if (wait) {
+            flags |= IORING_ENTER_GETEVENTS;
+            if (timeout >= 0.0) {
+                ts.tv_sec  = static_cast<long long>(timeout);
+                ts.tv_nsec = static_cast<long long>((timeout - ts.tv_sec) * 1.0e9);
+                memset(&arg, 0, sizeof(arg));
+                arg.ts  = toAddr(&ts);
+                flags  |= IORING_ENTER_EXT_ARG;
+                argp    = &arg;
+                argSize = sizeof(arg);
+            }
+        }
+
+        long result = syscall(__NR_io_uring_enter, m_fd, m_unsubmitted,
+                              wait ? 1 : 0, flags, argp, argSize);
+        if (result >= 0) {
+            m_unsubmitted -= static_cast<UInt32>(result);
+            return 0;
+        }
+        switch (errno) {
+        case EINTR:
+        case ETIME:
+        case EAGAIN:
+        case EBUSY:
+            // timed out, or no room to complete more until we reap
+            return 0;
+
+        default:
+            return errno;
+        }
+    }
+
+    // collect one completion.  returns false if there's none.
+    bool                reap(unsigned long long& userData, SInt32& result)
+    {
+        __u32 head = *m_cqHead;
+        if (head == __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        const struct io_uring_cqe& cqe = m_cqes[head & *m_cqMask];
+        userData = cqe.user_data;
+        result   = cqe.res;
+        __atomic_store_n(m_cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    int                 m_fd;
+    void*               m_sq;
+    void*               m_cq;
+    void*               m_sqes;
+    size_t              m_sqSize;
+    size_t              m_cqSize;
+    size_t              m_sqesSize;
+    __u32               m_sqEntries;
+    __u32               m_sqeTail;
+    UInt32              m_unsubmitted;
+    __u32*              m_sqHead;
+    __u32*              m_sqTail;
+    __u32*              m_sqMask;
+    __u32*              m_sqArray;
+    __u32*              m_cqHead;
+    __u32*              m_cqTail;
+    __u32*              m_cqMask;
+    struct io_uring_cqe* m_cqes;
+};
+
+//
+// HIDUring::Slot
+//
+
+class HIDUring::Slot {
+public:
+    enum EState {
+        kIdle,          // nothing in flight
+        kWriting,       // a report is in flight
+        kStalled,       // the host didn't collect it and it's being cancelled
+        kResyncing,     // waiting for the gadget to be writable
+        kClosed         // the gadget failed and must be reopened
+    };
+
+    explicit Slot(HIDDevice* device) :
+        m_device(device),
+        m_state(kIdle),
+        m_ops(0),
+        m_removing(false),
+        m_cancelled(false),
+        m_resyncWrite(false),
+        m_dropped(0),
+        m_queuedTime(0.0),
+        m_submitTime(0.0),
+        m_deadline(0.0) { }
+
+    HIDDevice*          m_device;
+    EState              m_state;
+
+    // operations in flight, cancels included.  the slot can't go away
+    // until they've all completed.
+    UInt32              m_ops;
+
+    // m_removing is set by remove() under the lock.  the rest is only
+    // touched by the driver.
+    bool                m_removing;
+    bool                m_cancelled;
+    bool                m_resyncWrite;
+    UInt32              m_dropped;
+    double              m_queuedTime;
+    double              m_submitTime;
+
+    // when a write stalls or, when closed, when to try reopening
+    double              m_deadline;
+
+    UInt8               m_report[HIDReportQueue::MAX_REPORT_SIZE];
+};
+
+//
+// HIDUring
+//
+
+HIDUring*
+HIDUring::acquire()
+{
+    Lock lock(getLock());
+    if (s_instance == nullptr) {
+        if (s_unavailable) {
+            return nullptr;
+        }
+
+        Ring* ring = new Ring;
+        const char* error = ring->setup();
+        if (error == nullptr && (error = ring->probe()) != nullptr) {
+            LOG((CLOG_NOTE "io_uring has no %s operation, writing HID reports with write()", error));
+        }
+        else if (error != nullptr) {
+            LOG((CLOG_NOTE "io_uring not available, writing HID reports with write(): %s", error));
+        }
+        int eventFd = -1;
+        if (error == nullptr &&
+                (eventFd = eventfd(0, EFD_CLOEXEC)) == -1) {
+            error = strerror(errno);
+            LOG((CLOG_NOTE "can't create io_uring wake event, writing HID reports with write(): %s", error));
+        }
+        if (error != nullptr) {
+            delete ring;
+            s_unavailable = true;
+            return nullptr;
+        }
+
+        s_instance = new HIDUring(ring, eventFd);
+        LOG((CLOG_DEBUG "writing HID reports through io_uring"));
+    }
+    ++s_refs;
+    return s_instance;
+}
+
+void
+HIDUring::release(HIDUring* uring)
+{
+    Lock lock(getLock());
+    assert(uring == s_instance && s_refs > 0);
+    if (--s_refs == 0) {
+        delete s_instance;
+        s_instance = nullptr;
+    }
+}
+
+HIDUring::HIDUring(Ring* ring, int eventFd) :
+    m_ring(ring),
+    m_eventFd(eventFd),
+    m_eventCount(0),
+    m_wakeArmed(false),
+    m_mutex(new Mutex),
+    m_removed(new CondVar<bool>(m_mutex, false)),
+    m_quit(false),
+    m_waiting(false),
+    m_driver(nullptr)
+{
+    m_driver = new Thread(new TMethodJob<HIDUring>(
+                                this, &HIDUring::driverThread));
+}
+
+HIDUring::~HIDUring()
+{
+    {
+        Lock lock(m_mutex);
+        m_quit = true;
+    }
+    kick();
+    m_driver->wait();
+    delete m_driver;
+    delete m_removed;
+    delete m_mutex;
+    close(m_eventFd);
+    delete m_ring;
+}
+
+void
+HIDUring::add(HIDDevice* device)
+{
+    {
+        Lock lock(m_mutex);
+        m_slots.push_back(new Slot(device));
+    }
+    kick();
+}
+
+void
+HIDUring::remove(HIDDevice* device)
+{
+    Lock lock(m_mutex);
+    SlotList::iterator i = m_slots.begin();
+    while (i != m_slots.end() && (*i)->m_device != device) {
+        ++i;
+    }
+    if (i == m_slots.end()) {
+        return;
+    }
+
+    // the driver deletes the slot once nothing is in flight for it
+    Slot* slot = *i;
+    slot->m_removing = true;
+    kick();
+    while (std::find(m_slots.begin(), m_slots.end(), slot) != m_slots.end()) {
+        m_removed->wait();
+    }
+}
+
+void
+HIDUring::wake()
+{
+    // pairs with the fence in driverThread().  either the driver sees
+    // the report or we see it waiting.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiting.load(std::memory_order_relaxed) && m_waiting.exchange(false)) {
+        kick();
+    }
+}
+
+void
+HIDUring::driverThread(void*)
+{
+    SlotList slots;
+    unsigned long long userData;
+    SInt32 result;
+
+    for (;;) {
+        if (update(slots)) {
+            break;
+        }
+        if (!m_wakeArmed) {
+            submitWake();
+        }
+
+        double now      = ARCH->time();
+        double deadline = -1.0;
+        bool idle       = false;
+        for (SlotList::iterator i = slots.begin(); i != slots.end(); ++i) {
+            Slot* slot = *i;
+            if (slot->m_removing) {
+                if (!slot->m_cancelled) {
+                    slot->m_cancelled = true;
+                    if (slot->m_ops != 0) {
+                        submitCancel(slot, kOpWrite);
+                        submitCancel(slot, kOpPoll);
+                    }
+                }
+                continue;
+            }
+
+            service(slot, now);
+            switch (slot->m_state) {
+            case Slot::kIdle:
+                idle = true;
+                break;
+
+            case Slot::kWriting:
+            case Slot::kClosed:
+                if (deadline < 0.0 || slot->m_deadline < deadline) {
+                    deadline = slot->m_deadline;
+                }
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        // producers only wake us while we say we're waiting, so say so
+        // before the last look for reports
+        bool wait = true;
+        if (idle) {
+            m_waiting.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            for (SlotList::iterator i = slots.begin(); i != slots.end(); ++i) {
+                Slot* slot = *i;
+                if (slot->m_state == Slot::kIdle && !slot->m_removing &&
+                        slot->m_device->hasReports()) {
+                    wait = false;
+                }
+            }
+        }
+
+        double timeout = (deadline < 0.0) ? -1.0 : std::max(0.0, deadline - now);
+        int error = m_ring->enter(wait, timeout);
+        m_waiting.store(false, std::memory_order_relaxed);
+        if (error != 0) {
+            LOG((CLOG_ERR "io_uring_enter failed: %s", strerror(error)));
+            ARCH->sleep(HIDDevice::s_reopenInterval);
+        }
+
+        now = ARCH->time();
+        while (m_ring->reap(userData, result)) {
+            complete(userData, result, now);
+        }
+    }
+
+    // cancel the wake event read so the kernel is done with
+    // m_eventCount before we go away
+    if (m_wakeArmed && submitCancel(nullptr, kOpWake)) {
+        while (m_wakeArmed && m_ring->enter(true, -1.0) == 0) {
+            while (m_ring->reap(userData, result)) {
+                complete(userData, result, ARCH->time());
+            }
+        }
+    }
+}
+
+bool
+HIDUring::update(SlotList& slots)
+{
+    Lock lock(m_mutex);
+
+    // let go of removed devices once nothing's in flight for them
+    bool removed = false;
+    for (SlotList::iterator i = m_slots.begin(); i != m_slots.end(); ) {
+        Slot* slot = *i;
+        if (slot->m_removing && slot->m_ops == 0) {
+            i = m_slots.erase(i);
+            delete slot;
+            removed = true;
+        }
+        else {
+            ++i;
+        }
+    }
+    if (removed) {
+        m_removed->broadcast();
+    }
+
+    slots = m_slots;
+    return (m_quit && m_slots.empty());
+}
+
+void
+HIDUring::service(Slot* slot, double now)
+{
+    HIDDevice* device = slot->m_device;
+
+    switch (slot->m_state) {
+    case Slot::kIdle:
+        if (device->nextReport(slot->m_report, slot->m_queuedTime)) {
+            if (submitWrite(slot, slot->m_report)) {
+                slot->m_state      = Slot::kWriting;
+                slot->m_submitTime = now;
+                slot->m_deadline   = now + HIDDevice::s_stallTimeout;
+            }
+            else {
+                fail(slot, -EAGAIN, now);
+            }
+        }
+        break;
+
+    case Slot::kWriting:
+        if (now >= slot->m_deadline) {
+            LOG((CLOG_NOTE "HID host stopped polling: %s", device->m_path.c_str()));
+            device->m_stats->stalled();
+            device->cancelSource();
+            submitCancel(slot, kOpWrite);
+            slot->m_state = Slot::kStalled;
+        }
+        break;
+
+    case Slot::kStalled:
+    case Slot::kResyncing:
+        // collapse anything queued into the device state rather than
+        // replaying stale input to the host when it comes back
+        slot->m_dropped += device->collapseReports();
+        break;
+
+    case Slot::kClosed:
+        slot->m_dropped += device->collapseReports();
+        if (now >= slot->m_deadline) {
+            if (device->m_sink->open()) {
+                device->m_open = true;
+                LOG((CLOG_DEBUG "hid device reopened: %s", device->m_path.c_str()));
+                resync(slot, now);
+            }
+            else {
+                slot->m_deadline = now + HIDDevice::s_reopenInterval;
+            }
+        }
+        break;
+    }
+}
+
+void
+HIDUring::complete(unsigned long long userData, SInt32 result, double now)
+{
+    Slot* slot = reinterpret_cast<Slot*>(
+                    static_cast<uintptr_t>(userData & ~static_cast<unsigned long long>(kOpMask)));
+    UInt32 op  = static_cast<UInt32>(userData & kOpMask);
+
+    if (op == kOpWake) {
+        // re-armed on the next pass
+        m_wakeArmed = false;
+        return;
+    }
+    if (slot == nullptr) {
+        return;
+    }
+    --slot->m_ops;
+    if (slot->m_removing) {
+        return;
+    }
+
+    HIDDevice* device = slot->m_device;
+    switch (op) {
+    case kOpWrite:
+        if (result >= 0) {
+            if (slot->m_resyncWrite) {
+                device->m_stats->dropped(slot->m_dropped);
+                LOG((CLOG_NOTE "HID host is back, resynced %s (%u stale reports dropped)", device->m_path.c_str(), slot->m_dropped));
+                slot->m_resyncWrite = false;
+                slot->m_dropped     = 0;
+            }
+            else {
+                device->m_stats->written(slot->m_queuedTime, slot->m_submitTime, now);
+            }
+
+            // if the host took it just as we gave up waiting, whatever
+            // was collapsed since must still be sent
+            if (slot->m_state == Slot::kStalled) {
+                resync(slot, now);
+            }
+            else {
+                slot->m_state = Slot::kIdle;
+            }
+        }
+        else if (slot->m_state == Slot::kStalled &&
+                    (result == -ECANCELED || result == -EINTR)) {
+            resync(slot, now);
+        }
+        else {
+            fail(slot, result, now);
+        }
+        break;
+
+    case kOpPoll:
+        if (result < 0 || (result & (POLLERR | POLLHUP)) != 0) {
+            fail(slot, (result < 0) ? result : -EPIPE, now);
+            break;
+        }
+
+        // send the state in place of everything that queued up
+        slot->m_dropped += device->collapseReports();
+        memcpy(slot->m_report, device->m_state, device->m_reportSize);
+        if (submitWrite(slot, slot->m_report)) {
+            slot->m_resyncWrite = true;
+            slot->m_state       = Slot::kWriting;
+            slot->m_submitTime  = now;
+            slot->m_deadline    = now + HIDDevice::s_stallTimeout;
+        }
+        else {
+            fail(slot, -EAGAIN, now);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void
+HIDUring::fail(Slot* slot, SInt32 error, double now)
+{
+    HIDDevice* device = slot->m_device;
+    LOG((CLOG_WARN "failed to write to HID device %s: %s", device->m_path.c_str(), strerror(-error)));
+    device->m_stats->failed();
+    device->m_open = false;
+    device->cancelSource();
+
+    // try reopening at once.  the resync write covers what's dropped.
+    slot->m_resyncWrite = false;
+    slot->m_state       = Slot::kClosed;
+    slot->m_deadline    = now;
+}
+
+void
+HIDUring::resync(Slot* slot, double now)
+{
+    if (submitPoll(slot)) {
+        slot->m_state = Slot::kResyncing;
+    }
+    else {
+        fail(slot, -EAGAIN, now);
+    }
+}
+
+bool
+HIDUring::submitWrite(Slot* slot, const UInt8* report)
+{
+    struct io_uring_sqe* sqe = m_ring->getSqe();
+    if (sqe == nullptr) {
+        return false;
+    }
+    HIDDevice* device = slot->m_device;
+    sqe->opcode    = IORING_OP_WRITE;
+    sqe->fd        = device->m_sink->getUringFd();
+    sqe->addr      = toAddr(report);
+    sqe->len       = static_cast<__u32>(device->m_reportSize);
+    sqe->user_data = toAddr(slot) | kOpWrite;
+    ++slot->m_ops;
+    return true;
+}
+
+bool
+HIDUring::submitPoll(Slot* slot)
+{
+    struct io_uring_sqe* sqe = m_ring->getSqe();
+    if (sqe == nullptr) {
+        return false;
+    }
+    __u32 events = POLLOUT;
+#if __BYTE_ORDER == __BIG_ENDIAN
+    // the kernel reads the 32-bit mask as two swapped halves
+    events = (events << 16) | (events >> 16);
+#endif
+    sqe->opcode        = IORING_OP_POLL_ADD;
+    sqe->fd            = slot->m_device->m_sink->getUringFd();
+    sqe->poll32_events = events;
+    sqe->user_data     = toAddr(slot) | kOpPoll;
+    ++slot->m_ops;
+    return true;
+}
+
+bool
+HIDUring::submitCancel(Slot* slot, UInt32 op)
+{
+    struct io_uring_sqe* sqe = m_ring->getSqe();
+    if (sqe == nullptr) {
+        return false;
+    }
+    sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+    sqe->fd        = -1;
+    sqe->addr      = toAddr(slot) | op;
+    sqe->user_data = toAddr(slot) | kOpCancel;
+    if (slot != nullptr) {
+        ++slot->m_ops;
+    }
+    return true;
+}
+
+bool
+HIDUring::submitWake()
+{
+    struct io_uring_sqe* sqe = m_ring->getSqe();
+    if (sqe == nullptr) {
+        return false;
+    }
+    sqe->opcode    = IORING_OP_READ;
+    sqe->fd        = m_eventFd;
+    sqe->addr      = toAddr(&m_eventCount);
+    sqe->len       = sizeof(m_eventCount);
+    sqe->user_data = kOpWake;
+    m_wakeArmed    = true;
+    return true;
+}
+
+void
+HIDUring::kick()
+{
+    unsigned long long one = 1;
+    if (::write(m_eventFd, &one, sizeof(one)) < 0) {
+        // only fails if the count would overflow, and then the driver
+        // has been woken anyway
+    }
+}
+
+#else // !HID_HAVE_URING
+
+//
+// HIDUring
+//
+
+HIDUring*
+HIDUring::acquire()
+{
+    static bool s_logged = false;
+    Lock lock(getLock());
+    if (!s_logged) {
+        s_logged = true;
+        LOG((CLOG_NOTE "built without io_uring, writing HID reports with write()"));
+    }
+    return nullptr;
+}
+
+void
+HIDUring::release(HIDUring*)
+{
+}
+
+void
+HIDUring::add(HIDDevice*)
+{
+}
+
+void
+HIDUring::remove(HIDDevice*)
+{
+}
+
+void
+HIDUring::wake()
+{
+}
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/basic_types.h"
+#include "common/stdvector.h"
+
+#include <atomic>
+
+template <class T>
+class CondVar;
+class HIDDevice;
+class Mutex;
+class Thread;
+
+//! Shared io_uring writer for HID devices
+/*!
+One ring and one driver thread write the reports of every device whose
+sink gives a descriptor for it (IHIDSink::getUringFd()), in place of
+each device's own writer thread.  Each report is an asynchronous write
+on a blocking descriptor that completes when the gadget takes it, and
+the writes for every device are submitted, and their completions
+collected, by a single io_uring_enter() per pass.  Producers only make
+a system call to wake the driver when it's waiting for input with a
+device idle, so while the host keeps up a report costs no system call
+of its own.
+
+The driver does for its devices what HIDDevice's writer thread does for
+the others:  it coalesces queued reports, records each report's
+completion time in the device's statistics, cancels a write the host
+hasn't collected after a stall timeout, and then waits for the gadget
+to be writable (or reopens it, if it failed) before sending the device
+state in place of everything that queued up meanwhile.
+
+There is one shared instance, created by the first acquire().
+*/
+class HIDUring {
+public:
+    //! @name manipulators
+    //@{
+
+    //! Get the shared ring
+    /*!
+    Creates the ring and its driver thread if this is the first
+    reference.  Returns NULL if io_uring can't be used (no kernel
+    support, blocked by seccomp, or missing one of the operations the
+    driver needs), in which case devices must use write().
+    */
+    static HIDUring*    acquire();
+
+    //! Release a reference to the shared ring
+    /*!
+    The ring and its driver go away with the last reference.
+    */
+    static void         release(HIDUring*);
+
+    //! Start writing a device's reports
+    /*!
+    \c device's sink must be open and give a descriptor from
+    getUringFd().
+    */
+    void                add(HIDDevice* device);
+
+    //! Stop writing a device's reports
+    /*!
+    Cancels anything in flight for \c device and waits for the driver
+    to let go of it.
+    */
+    void                remove(HIDDevice* device);
+
+    //! Tell the driver a device may have reports
+    /*!
+    Cheap unless the driver is waiting for input, in which case it's
+    woken.  Safe to call from any thread.
+    */
+    void                wake();
+
+    //@}
+
+private:
+    class Ring;
+    class Slot;
+    typedef std::vector<Slot*> SlotList;
+
+    HIDUring(Ring* ring, int eventFd);
+    ~HIDUring();
+
+    void                driverThread(void*);
+    bool                update(SlotList& slots);
+    void                service(Slot* slot, double now);
+    void                complete(unsigned long long userData, SInt32 result, double now);
+    void                fail(Slot* slot, SInt32 error, double now);
+    void                resync(Slot* slot, double now);
+    bool                submitWrite(Slot* slot, const UInt8* report);
+    bool                submitPoll(Slot* slot);
+    bool                submitCancel(Slot* slot, UInt32 op);
+    bool                submitWake();
+    void                kick();
+
+private:
+    Ring*               m_ring;
+    int                 m_eventFd;
+    unsigned long long  m_eventCount;
+    bool                m_wakeArmed;
+
+    // shared with add() and remove()
+    Mutex*              m_mutex;
+    CondVar<bool>*      m_removed;
+    SlotList            m_slots;
+    bool                m_quit;
+
+    // set while the driver waits for input
+    std::atomic<bool>   m_waiting;
+
+    Thread*             m_driver;
+};
@@ -0,0 +1,86 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "common/IInterface.h"
+#include "common/basic_types.h"
+#include "common/stdvector.h"
+
+#include <string>
+
+//! HID report sink interface
+/*!
+Where a HIDDevice's writer thread sends its reports.  Normally that's a
+USB gadget but it can be anything that takes reports one at a time,
+which lets the whole HID path run without gadget hardware.  All methods
+but getName() and getUringFd() are only called by the writer thread.
+*/
+class IHIDSink : public IInterface {
+public:
+    //! Write results
+    enum EResult {
+        kWritten,           //!< The report was taken
+        kBusy,              //!< The previous report hasn't been collected
+        kFailed             //!< The sink closed;  open() must be called
+    };
+
+    //! @name manipulators
+    //@{
+
+    //! Open or reopen the sink
+    /*!
+    Returns false if the sink can't be opened (yet).
+    */
+    virtual bool        open() = 0;
+
+    //! Write a report
+    /*!
+    Never blocks for long.  Whole reports are taken or nothing is.
+    */
+    virtual EResult     write(const UInt8* report, UInt32 size) = 0;
+
+    //! Wait for the sink to take a report
+    /*!
+    Waits up to \c timeout seconds.  Returns true if write() may now
+    succeed (or fail), false on timeout.
+    */
+    virtual bool        waitWritable(double timeout) = 0;
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get the report descriptor the other end expects
+    /*!
+    Returns false if the sink doesn't know, in which case the device's
+    built-in descriptor is used.
+    */
+    virtual bool        getDescriptor(std::vector<UInt8>&) const = 0;
+
+    //! Get a name for log messages
+    virtual const std::string&
+                        getName() const = 0;
+
+    //! Get the descriptor to write through io_uring
+    /*!
+    Returns a blocking descriptor for HIDUring to write reports to, or
+    -1 if the sink must be written with write().  Only asked once, after
+    the first open(), which must then keep the same kind of descriptor.
+    */
+    virtual int         getUringFd() const = 0;
+
+    //@}
+};
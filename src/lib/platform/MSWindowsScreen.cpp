@@ -1381,9 +1381,9 @@ MSWindowsScreen::onMouseMove(SInt32 mx, SInt32 my)
     if (m_isOnScreen) {
         
         // motion on primary screen
-        sendEvent(
+        m_events->addEvent(MotionInfo::makeEvent(
             m_events->forIPrimaryScreen().motionOnPrimary(),
-            MotionInfo::alloc(m_xCursor, m_yCursor));
+            getEventTarget(), m_xCursor, m_yCursor));
 
         if (m_buttons[kButtonLeft] == true && m_draggingStarted == false) {
             m_draggingStarted = true;
@@ -1413,7 +1413,9 @@ MSWindowsScreen::onMouseMove(SInt32 mx, SInt32 my)
         }
         else {
             // send motion
-            sendEvent(m_events->forIPrimaryScreen().motionOnSecondary(), MotionInfo::alloc(x, y));
+            m_events->addEvent(MotionInfo::makeEvent(
+                m_events->forIPrimaryScreen().motionOnSecondary(),
+                getEventTarget(), x, y));
         }
     }
 
@@ -1426,7 +1428,9 @@ MSWindowsScreen::onMouseWheel(SInt32 xDelta, SInt32 yDelta)
     // ignore message if posted prior to last mark change
     if (!ignore()) {
         LOG((CLOG_DEBUG1 "event: button wheel delta=%+d,%+d", xDelta, yDelta));
-        sendEvent(m_events->forIPrimaryScreen().wheel(), WheelInfo::alloc(xDelta, yDelta));
+        m_events->addEvent(WheelInfo::makeEvent(
+            m_events->forIPrimaryScreen().wheel(),
+            getEventTarget(), xDelta, yDelta));
     }
     return true;
 }
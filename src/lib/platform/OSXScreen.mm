@@ -1048,8 +1048,9 @@ OSXScreen::onMouseMove(CGFloat mx, CGFloat my)
 
 	if (m_isOnScreen) {
 		// motion on primary screen
-		sendEvent(m_events->forIPrimaryScreen().motionOnPrimary(),
-							MotionInfo::alloc(m_xCursor, m_yCursor));
+		m_events->addEvent(MotionInfo::makeEvent(
+							m_events->forIPrimaryScreen().motionOnPrimary(),
+							getEventTarget(), m_xCursor, m_yCursor));
 		if (m_buttonState.test(0)) {
 			m_draggingStarted = true;
 		}
@@ -1087,7 +1088,9 @@ OSXScreen::onMouseMove(CGFloat mx, CGFloat my)
 			// And keep only the fractional part
 			m_xFractionalMove -= intX;
 			m_yFractionalMove -= intY;
-			sendEvent(m_events->forIPrimaryScreen().motionOnSecondary(), MotionInfo::alloc(intX, intY));
+			m_events->addEvent(MotionInfo::makeEvent(
+							m_events->forIPrimaryScreen().motionOnSecondary(),
+							getEventTarget(), intX, intY));
 		}
 	}
 
@@ -1155,7 +1158,9 @@ bool
 OSXScreen::onMouseWheel(SInt32 xDelta, SInt32 yDelta) const
 {
 	LOG((CLOG_DEBUG1 "event: button wheel delta=%+d,%+d", xDelta, yDelta));
-	sendEvent(m_events->forIPrimaryScreen().wheel(), WheelInfo::alloc(xDelta, yDelta));
+	m_events->addEvent(WheelInfo::makeEvent(
+							m_events->forIPrimaryScreen().wheel(),
+							getEventTarget(), xDelta, yDelta));
 	return true;
 }
 
@@ -1573,11 +1573,15 @@ XWindowsScreen::onMouseRelease(const XButtonEvent& xbutton)
 	}
 	else if (xbutton.button == 4) {
 		// wheel forward (away from user)
-		sendEvent(m_events->forIPrimaryScreen().wheel(), WheelInfo::alloc(0, 120));
+		m_events->addEvent(WheelInfo::makeEvent(
+							m_events->forIPrimaryScreen().wheel(),
+							getEventTarget(), 0, 120));
 	}
 	else if (xbutton.button == 5) {
 		// wheel backward (toward user)
-		sendEvent(m_events->forIPrimaryScreen().wheel(), WheelInfo::alloc(0, -120));
+		m_events->addEvent(WheelInfo::makeEvent(
+							m_events->forIPrimaryScreen().wheel(),
+							getEventTarget(), 0, -120));
 	}
 	// XXX -- support x-axis scrolling
 }
@@ -1615,8 +1619,9 @@ XWindowsScreen::onMouseMove(const XMotionEvent& xmotion)
 	}
 	else if (m_isOnScreen) {
 		// motion on primary screen
-		sendEvent(m_events->forIPrimaryScreen().motionOnPrimary(),
-							MotionInfo::alloc(m_xCursor, m_yCursor));
+		m_events->addEvent(MotionInfo::makeEvent(
+							m_events->forIPrimaryScreen().motionOnPrimary(),
+							getEventTarget(), m_xCursor, m_yCursor));
 	}
 	else {
 		// motion on secondary screen.  warp mouse back to
@@ -1646,7 +1651,9 @@ XWindowsScreen::onMouseMove(const XMotionEvent& xmotion)
 		// warping to the primary screen's enter position,
 		// effectively overriding it.
 		if (x != 0 || y != 0) {
-			sendEvent(m_events->forIPrimaryScreen().motionOnSecondary(), MotionInfo::alloc(x, y));
+			m_events->addEvent(MotionInfo::makeEvent(
+							m_events->forIPrimaryScreen().motionOnSecondary(),
+							getEventTarget(), x, y));
 		}
 	}
 }
@@ -28,6 +28,7 @@
 #include "net/XSocket.h"
 #include "server/ClientProxy.h"
 #include "server/ClientProxyUnknown.h"
+#include "server/MotionChannel.h"
 
 //
 // ClientListener
@@ -37,6 +38,7 @@ ClientListener::ClientListener(const NetworkAddress& address,
                 ISocketFactory* socketFactory,
                 IEventQueue* events) :
     m_socketFactory(socketFactory),
+    m_motionChannel(nullptr),
     m_server(nullptr),
     m_events(events)
 {
@@ -66,6 +68,10 @@ ClientListener::ClientListener(const NetworkAddress& address,
         throw;
     }
     LOG((CLOG_DEBUG1 "listening for clients"));
+
+    // the motion channel shares the listen address and only opens its
+    // socket once a client asks for it
+    m_motionChannel = new MotionChannel(address, m_socketFactory, m_events);
 }
 
 ClientListener::~ClientListener()
@@ -92,6 +98,9 @@ ClientListener::~ClientListener()
 
     m_events->removeHandler(m_events->forIListenSocket().connecting(), m_listen);
     cleanupListenSocket();
+
+    // clients hold the motion channel until they're deleted
+    delete m_motionChannel;
     delete m_socketFactory;
 }
 
@@ -174,6 +183,7 @@ ClientListener::handleUnknownClient(const Event& /*unused*/, void* vclient)
     bool handshakeOk = true;
     if (client != nullptr) {
         // handshake was successful
+        client->setMotionChannel(m_motionChannel);
         m_waitingClients.push_back(client);
         m_events->addEvent(Event(m_events->forClientListener().connected(),
                                  this));
@@ -29,6 +29,7 @@ class ClientProxyUnknown;
 class NetworkAddress;
 class IListenSocket;
 class ISocketFactory;
+class MotionChannel;
 class Server;
 class IEventQueue;
 
@@ -78,6 +79,7 @@ private:
 
     IListenSocket*        m_listen;
     ISocketFactory*        m_socketFactory;
+    MotionChannel*      m_motionChannel;
     NewClients            m_newClients;
     WaitingClients        m_waitingClients;
     Server*                m_server;
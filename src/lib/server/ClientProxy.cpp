@@ -29,7 +29,8 @@
 
 ClientProxy::ClientProxy(const String& name, synergy::IStream* stream) :
     BaseClientProxy(name),
-    m_stream(stream)
+    m_stream(stream),
+    m_motionChannel(nullptr)
 {
 }
 
@@ -42,18 +43,30 @@ void
 ClientProxy::close(const char* msg)
 {
     LOG((CLOG_DEBUG1 "send close \"%s\" to \"%s\"", msg, getName().c_str()));
-    ProtocolUtil::writef(getStream(), msg);
+    ProtocolUtil::writeCode(getStream(), msg);
 
     // force the close to be sent before we return
     getStream()->flush();
 }
 
+void
+ClientProxy::setMotionChannel(MotionChannel* channel)
+{
+    m_motionChannel = channel;
+}
+
 synergy::IStream*
 ClientProxy::getStream() const
 {
     return m_stream;
 }
 
+MotionChannel*
+ClientProxy::getMotionChannel() const
+{
+    return m_motionChannel;
+}
+
 void*
 ClientProxy::getEventTarget() const
 {
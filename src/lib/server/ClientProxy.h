@@ -23,6 +23,7 @@
 #include "base/String.h"
 #include "base/EventTypes.h"
 
+class MotionChannel;
 namespace synergy { class IStream; }
 
 //! Generic proxy for client
@@ -43,6 +44,13 @@ public:
     */
     void                close(const char* msg);
 
+    //! Set the motion channel
+    /*!
+    Pointer motion may be sent over \p channel, if the client enables
+    it, instead of the stream.  The channel must outlive the proxy.
+    */
+    void                setMotionChannel(MotionChannel* channel);
+
     //@}
     //! @name accessors
     //@{
@@ -53,6 +61,12 @@ public:
     */
     synergy::IStream*    getStream() const;
 
+    //! Get the motion channel
+    /*!
+    Returns the channel passed to setMotionChannel(), or NULL.
+    */
+    MotionChannel*      getMotionChannel() const;
+
     //@}
 
     // IScreen
@@ -88,4 +102,5 @@ public:
 
 private:
     synergy::IStream*    m_stream;
+    MotionChannel*      m_motionChannel;
 };
@@ -24,6 +24,7 @@
 #include "core/ProtocolUtil.h"
 #include "core/XSynergy.h"
 #include "io/IStream.h"
+#include "server/MotionChannel.h"
 
 #include <cstring>
 
@@ -35,6 +36,15 @@ ClientProxy1_0::ClientProxy1_0(const String& name, synergy::IStream* stream, IEv
     ClientProxy(name, stream),
     m_heartbeatTimer(nullptr),
     m_parser(&ClientProxy1_0::parseHandshakeMessage),
+    m_motionToken(0),
+    m_motionSent(false),
+    m_motionPending(false),
+    m_motionHeld(false),
+    m_xMotion(0),
+    m_yMotion(0),
+    m_relMotionHeld(false),
+    m_dxMotion(0),
+    m_dyMotion(0),
     m_events(events)
 {
     // install event handlers
@@ -54,19 +64,37 @@ ClientProxy1_0::ClientProxy1_0(const String& name, synergy::IStream* stream, IEv
                             stream->getEventTarget(),
                             new TMethodEventJob<ClientProxy1_0>(this,
                                 &ClientProxy1_0::handleWriteError, nullptr));
+    m_events->adoptHandler(m_events->forIStream().outputDrained(),
+                            stream->getEventTarget(),
+                            new TMethodEventJob<ClientProxy1_0>(this,
+                                &ClientProxy1_0::handleOutputDrained, nullptr));
     m_events->adoptHandler(Event::kTimer, this,
                             new TMethodEventJob<ClientProxy1_0>(this,
                                 &ClientProxy1_0::handleFlatline, nullptr));
 
     setHeartbeatRate(kHeartRate, kHeartRate * kHeartBeatsUntilDeath);
 
+    // messages we accept after the handshake.  later protocol versions
+    // add theirs in their constructors.
+    for (UInt32 i = 0; i < kNumMessageIDs; ++i) {
+        m_handlers[i] = nullptr;
+    }
+    setMessageHandler(kMsgIDDInfo, &ClientProxy1_0::recvInfoChanged);
+    setMessageHandler(kMsgIDCNoop, &ClientProxy1_0::recvNoop);
+    setMessageHandler(kMsgIDCClipboard, &ClientProxy1_0::recvGrabClipboard);
+    setMessageHandler(kMsgIDDClipboard, &ClientProxy1_0::recvClipboard);
+
     LOG((CLOG_DEBUG1 "querying client \"%s\" info", getName().c_str()));
-    ProtocolUtil::writef(getStream(), kMsgQInfo);
+    ProtocolUtil::write<MsgQInfo>(getStream());
 }
 
 ClientProxy1_0::~ClientProxy1_0()
 {
+    LOG((CLOG_DEBUG1 "messages from \"%s\": %s", getName().c_str(), ProtocolUtil::formatMessageCounts(m_received).c_str()));
     removeHandlers();
+    if (getMotionChannel() != nullptr) {
+        getMotionChannel()->removeClient(m_motionToken);
+    }
 }
 
 void
@@ -89,6 +117,8 @@ ClientProxy1_0::removeHandlers()
                             getStream()->getEventTarget());
     m_events->removeHandler(m_events->forIStream().outputShutdown(),
                             getStream()->getEventTarget());
+    m_events->removeHandler(m_events->forIStream().outputDrained(),
+                            getStream()->getEventTarget());
     m_events->removeHandler(Event::kTimer, this);
 
     // remove timer
@@ -115,9 +145,14 @@ ClientProxy1_0::removeHeartbeatTimer()
 void
 ClientProxy1_0::resetHeartbeatTimer()
 {
-    // reset the alarm
-    removeHeartbeatTimer();
-    addHeartbeatTimer();
+    // reset the alarm, reusing the timer if we have one.  this happens
+    // on every message so it mustn't allocate.
+    if (m_heartbeatTimer != nullptr && m_heartbeatAlarm > 0.0) {
+        m_events->rearmTimer(m_heartbeatTimer, m_heartbeatAlarm);
+        return;
+    }
+    ClientProxy1_0::removeHeartbeatTimer();
+    ClientProxy1_0::addHeartbeatTimer();
 }
 
 void
@@ -135,6 +170,9 @@ ClientProxy1_0::setHeartbeatRate(double /*unused*/, double alarm)
 void
 ClientProxy1_0::handleData(const Event& /*unused*/, void* /*unused*/)
 {
+    // replies to everything we read go out together
+    getStream()->cork();
+
     // handle messages until there are no more.  first read message code.
     UInt8 code[4];
     UInt32 n = getStream()->read(code, 4);
@@ -143,14 +181,18 @@ ClientProxy1_0::handleData(const Event& /*unused*/, void* /*unused*/)
         if (n != 4) {
             LOG((CLOG_ERR "incomplete message from \"%s\": %d bytes", getName().c_str(), n));
             disconnect();
+            getStream()->uncork();
             return;
         }
 
         // parse message
         LOG((CLOG_DEBUG2 "msg from \"%s\": %c%c%c%c", getName().c_str(), code[0], code[1], code[2], code[3]));
-        if (!(this->*m_parser)(code)) {
+        EMessageID id = ProtocolUtil::getMessageID(code);
+        ++m_received[id];
+        if (!(this->*m_parser)(id)) {
             LOG((CLOG_ERR "invalid message from client \"%s\": %c%c%c%c", getName().c_str(), code[0], code[1], code[2], code[3]));
             disconnect();
+            getStream()->uncork();
             return;
         }
 
@@ -158,19 +200,20 @@ ClientProxy1_0::handleData(const Event& /*unused*/, void* /*unused*/)
         n = getStream()->read(code, 4);
     }
 
+    getStream()->uncork();
+
     // restart heartbeat timer
     resetHeartbeatTimer();
 }
 
 bool
-ClientProxy1_0::parseHandshakeMessage(const UInt8* code)
+ClientProxy1_0::parseHandshakeMessage(EMessageID id)
 {
-    if (memcmp(code, kMsgCNoop, 4) == 0) {
-        // discard no-ops
-        LOG((CLOG_DEBUG2 "no-op from", getName().c_str()));
-        return true;
-    }
-    if (memcmp(code, kMsgDInfo, 4) == 0) {
+    switch (id) {
+    case kMsgIDCNoop:
+        return recvNoop();
+
+    case kMsgIDDInfo:
         // future messages get parsed by parseMessage
         m_parser = &ClientProxy1_0::parseMessage;
         if (recvInfo()) {
@@ -178,33 +221,21 @@ ClientProxy1_0::parseHandshakeMessage(const UInt8* code)
             addHeartbeatTimer();
             return true;
         }
+        return false;
+
+    default:
+        return false;
     }
-    return false;
 }
 
 bool
-ClientProxy1_0::parseMessage(const UInt8* code)
+ClientProxy1_0::parseMessage(EMessageID id)
 {
-    if (memcmp(code, kMsgDInfo, 4) == 0) {
-        if (recvInfo()) {
-            m_events->addEvent(
-                            Event(m_events->forIScreen().shapeChanged(), getEventTarget()));
-            return true;
-        }
+    MessageHandler handler = m_handlers[id];
+    if (handler == nullptr) {
         return false;
     }
-    if (memcmp(code, kMsgCNoop, 4) == 0) {
-        // discard no-ops
-        LOG((CLOG_DEBUG2 "no-op from", getName().c_str()));
-        return true;
-    }
-    else if (memcmp(code, kMsgCClipboard, 4) == 0) {
-        return recvGrabClipboard();
-    }
-    else if (memcmp(code, kMsgDClipboard, 4) == 0) {
-        return recvClipboard();
-    }
-    return false;
+    return (this->*handler)();
 }
 
 void
@@ -229,6 +260,15 @@ ClientProxy1_0::handleFlatline(const Event& /*unused*/, void* /*unused*/)
     disconnect();
 }
 
+void
+ClientProxy1_0::handleOutputDrained(const Event&, void*)
+{
+    // the stream caught up so send the motion we held back
+    if (m_motionHeld || m_relMotionHeld) {
+        flushMotion();
+    }
+}
+
 bool
 ClientProxy1_0::getClipboard(ClipboardID id, IClipboard* clipboard) const
 {
@@ -258,7 +298,11 @@ ClientProxy1_0::enter(SInt32 xAbs, SInt32 yAbs,
                 UInt32 seqNum, KeyModifierMask mask, bool /*forScreensaver*/)
 {
     LOG((CLOG_DEBUG1 "send enter to \"%s\", %d,%d %d %04x", getName().c_str(), xAbs, yAbs, seqNum, mask));
-    ProtocolUtil::writef(getStream(), kMsgCEnter,
+    m_motionPending = false;
+    m_motionHeld    = false;
+    m_relMotionHeld = false;
+    fenceMotion();
+    ProtocolUtil::write<MsgCEnter>(getStream(),
                                 xAbs, yAbs, seqNum, mask);
 }
 
@@ -266,7 +310,8 @@ bool
 ClientProxy1_0::leave()
 {
     LOG((CLOG_DEBUG1 "send leave to \"%s\"", getName().c_str()));
-    ProtocolUtil::writef(getStream(), kMsgCLeave);
+    flushMotion();
+    ProtocolUtil::write<MsgCLeave>(getStream());
 
     // we can never prevent the user from leaving
     return true;
@@ -282,7 +327,7 @@ void
 ClientProxy1_0::grabClipboard(ClipboardID id)
 {
     LOG((CLOG_DEBUG "send grab clipboard %d to \"%s\"", id, getName().c_str()));
-    ProtocolUtil::writef(getStream(), kMsgCClipboard, id, 0);
+    ProtocolUtil::write<MsgCClipboard>(getStream(), id, 0);
 
     // this clipboard is now dirty
     m_clipboard[id].m_dirty = true;
@@ -298,7 +343,8 @@ void
 ClientProxy1_0::keyDown(KeyID key, KeyModifierMask mask, KeyButton /*unused*/)
 {
     LOG((CLOG_DEBUG1 "send key down to \"%s\" id=%d, mask=0x%04x", getName().c_str(), key, mask));
-    ProtocolUtil::writef(getStream(), kMsgDKeyDown1_0, key, mask);
+    flushMotion();
+    ProtocolUtil::write<MsgDKeyDown1_0>(getStream(), key, mask);
 }
 
 void
@@ -306,39 +352,133 @@ ClientProxy1_0::keyRepeat(KeyID key, KeyModifierMask mask,
                 SInt32 count, KeyButton /*unused*/)
 {
     LOG((CLOG_DEBUG1 "send key repeat to \"%s\" id=%d, mask=0x%04x, count=%d", getName().c_str(), key, mask, count));
-    ProtocolUtil::writef(getStream(), kMsgDKeyRepeat1_0, key, mask, count);
+    flushMotion();
+    ProtocolUtil::write<MsgDKeyRepeat1_0>(getStream(), key, mask, count);
 }
 
 void
 ClientProxy1_0::keyUp(KeyID key, KeyModifierMask mask, KeyButton /*unused*/)
 {
     LOG((CLOG_DEBUG1 "send key up to \"%s\" id=%d, mask=0x%04x", getName().c_str(), key, mask));
-    ProtocolUtil::writef(getStream(), kMsgDKeyUp1_0, key, mask);
+    flushMotion();
+    ProtocolUtil::write<MsgDKeyUp1_0>(getStream(), key, mask);
 }
 
 void
 ClientProxy1_0::mouseDown(ButtonID button)
 {
     LOG((CLOG_DEBUG1 "send mouse down to \"%s\" id=%d", getName().c_str(), button));
-    ProtocolUtil::writef(getStream(), kMsgDMouseDown, button);
+    flushMotion();
+    ProtocolUtil::write<MsgDMouseDown>(getStream(), button);
 }
 
 void
 ClientProxy1_0::mouseUp(ButtonID button)
 {
     LOG((CLOG_DEBUG1 "send mouse up to \"%s\" id=%d", getName().c_str(), button));
-    ProtocolUtil::writef(getStream(), kMsgDMouseUp, button);
+    flushMotion();
+    ProtocolUtil::write<MsgDMouseUp>(getStream(), button);
 }
 
 void
 ClientProxy1_0::mouseMove(SInt32 xAbs, SInt32 yAbs)
+{
+    if (m_motionToken != 0 &&
+            getMotionChannel()->sendMove(m_motionToken, xAbs, yAbs)) {
+        LOG((CLOG_DEBUG2 "send mouse move datagram to \"%s\" %d,%d", getName().c_str(), xAbs, yAbs));
+        m_motionSent    = true;
+        m_motionPending = true;
+        m_xMotion       = xAbs;
+        m_yMotion       = yAbs;
+        return;
+    }
+
+    // a relative move still held back has to go out first
+    if (m_relMotionHeld) {
+        flushMotion();
+    }
+
+    // while the stream is backed up only the latest position matters,
+    // so keep replacing it until the stream drains
+    if (getStream()->hasPendingOutput()) {
+        LOG((CLOG_DEBUG2 "hold mouse move to \"%s\" %d,%d", getName().c_str(), xAbs, yAbs));
+        m_motionPending = true;
+        m_motionHeld    = true;
+        m_xMotion       = xAbs;
+        m_yMotion       = yAbs;
+        return;
+    }
+
+    m_motionPending = false;
+    m_motionHeld    = false;
+    fenceMotion();
+    sendMouseMove(xAbs, yAbs);
+}
+
+void
+ClientProxy1_0::flushMotion()
+{
+    // datagrams can be lost so anything that depends on the position,
+    // like a click, needs the position to come first on the stream
+    if (m_relMotionHeld) {
+        m_relMotionHeld = false;
+        sendMouseRelativeMove(m_dxMotion, m_dyMotion);
+    }
+    if (m_motionPending) {
+        m_motionPending = false;
+        m_motionHeld    = false;
+        fenceMotion();
+        sendMouseMove(m_xMotion, m_yMotion);
+    }
+}
+
+void
+ClientProxy1_0::fenceMotion()
+{
+    if (m_motionSent) {
+        m_motionSent = false;
+        UInt32 seq   = getMotionChannel()->getSeq(m_motionToken);
+        LOG((CLOG_DEBUG2 "send motion fence to \"%s\" seq=%u", getName().c_str(), seq));
+        ProtocolUtil::write<MsgDMotionSeq>(getStream(), seq);
+    }
+}
+
+void
+ClientProxy1_0::sendMouseMove(SInt32 xAbs, SInt32 yAbs)
 {
     LOG((CLOG_DEBUG2 "send mouse move to \"%s\" %d,%d", getName().c_str(), xAbs, yAbs));
-    ProtocolUtil::writef(getStream(), kMsgDMouseMove, xAbs, yAbs);
+    ProtocolUtil::write<MsgDMouseMove>(getStream(), xAbs, yAbs);
+}
+
+void
+ClientProxy1_0::mouseRelativeMove(SInt32 xRel, SInt32 yRel)
+{
+    // an absolute move still waiting has to go out first
+    if (m_motionPending) {
+        flushMotion();
+    }
+
+    // while the stream is backed up add up the deltas
+    if (getStream()->hasPendingOutput()) {
+        LOG((CLOG_DEBUG2 "hold mouse relative move to \"%s\" %d,%d", getName().c_str(), xRel, yRel));
+        if (!m_relMotionHeld) {
+            m_relMotionHeld = true;
+            m_dxMotion      = 0;
+            m_dyMotion      = 0;
+        }
+        m_dxMotion += xRel;
+        m_dyMotion += yRel;
+        return;
+    }
+
+    if (m_relMotionHeld) {
+        flushMotion();
+    }
+    sendMouseRelativeMove(xRel, yRel);
 }
 
 void
-ClientProxy1_0::mouseRelativeMove(SInt32 /*xRel*/, SInt32 /*yRel*/)
+ClientProxy1_0::sendMouseRelativeMove(SInt32 /*xRel*/, SInt32 /*yRel*/)
 {
     // ignore -- not supported in protocol 1.0
 }
@@ -348,7 +488,8 @@ ClientProxy1_0::mouseWheel(SInt32 /*xDelta*/, SInt32 yDelta)
 {
     // clients prior to 1.3 only support the y axis
     LOG((CLOG_DEBUG2 "send mouse wheel to \"%s\" %+d", getName().c_str(), yDelta));
-    ProtocolUtil::writef(getStream(), kMsgDMouseWheel1_0, yDelta);
+    flushMotion();
+    ProtocolUtil::write<MsgDMouseWheel1_0>(getStream(), yDelta);
 }
 
 void
@@ -369,14 +510,23 @@ void
 ClientProxy1_0::screensaver(bool on)
 {
     LOG((CLOG_DEBUG1 "send screen saver to \"%s\" on=%d", getName().c_str(), on ? 1 : 0));
-    ProtocolUtil::writef(getStream(), kMsgCScreenSaver, on ? 1 : 0);
+    ProtocolUtil::write<MsgCScreenSaver>(getStream(), on ? 1 : 0);
 }
 
 void
 ClientProxy1_0::resetOptions()
 {
     LOG((CLOG_DEBUG1 "send reset options to \"%s\"", getName().c_str()));
-    ProtocolUtil::writef(getStream(), kMsgCResetOptions);
+    flushMotion();
+    ProtocolUtil::write<MsgCResetOptions>(getStream());
+
+    // the client closes its end of the motion channel
+    if (getMotionChannel() != nullptr) {
+        getMotionChannel()->removeClient(m_motionToken);
+    }
+    m_motionToken   = 0;
+    m_motionSent    = false;
+    m_motionPending = false;
 
     // reset heart rate and death
     resetHeartbeatRate();
@@ -387,8 +537,25 @@ ClientProxy1_0::resetOptions()
 void
 ClientProxy1_0::setOptions(const OptionsList& options)
 {
-    LOG((CLOG_DEBUG1 "send set options to \"%s\" size=%d", getName().c_str(), options.size()));
-    ProtocolUtil::writef(getStream(), kMsgDSetOptions, &options);
+    // the motion channel option is true or false in the config but the
+    // client gets its token, or 0 if the channel isn't available
+    OptionsList sent(options);
+    for (UInt32 i = 0, n = static_cast<UInt32>(sent.size()); i < n; i += 2) {
+        if (sent[i] == kOptionMotionChannel) {
+            if (getMotionChannel() != nullptr) {
+                getMotionChannel()->removeClient(m_motionToken);
+            }
+            m_motionToken = 0;
+            m_motionSent  = false;
+            if (sent[i + 1] != 0 && getMotionChannel() != nullptr) {
+                m_motionToken = getMotionChannel()->addClient();
+            }
+            sent[i + 1] = m_motionToken;
+        }
+    }
+
+    LOG((CLOG_DEBUG1 "send set options to \"%s\" size=%d", getName().c_str(), sent.size()));
+    ProtocolUtil::write<MsgDSetOptions>(getStream(), sent);
 
     // check options
     for (UInt32 i = 0, n = static_cast<UInt32>(options.size()); i < n; i += 2) {
@@ -404,13 +571,32 @@ ClientProxy1_0::setOptions(const OptionsList& options)
     }
 }
 
+bool
+ClientProxy1_0::recvNoop()
+{
+    // discard no-ops
+    LOG((CLOG_DEBUG2 "no-op from", getName().c_str()));
+    return true;
+}
+
+bool
+ClientProxy1_0::recvInfoChanged()
+{
+    if (recvInfo()) {
+        m_events->addEvent(
+                        Event(m_events->forIScreen().shapeChanged(), getEventTarget()));
+        return true;
+    }
+    return false;
+}
+
 bool
 ClientProxy1_0::recvInfo()
 {
     // parse the message
     SInt16 x, y, w, h, dummy1, mx, my;
-    if (!ProtocolUtil::readf(getStream(), kMsgDInfo + 4,
-                            &x, &y, &w, &h, &dummy1, &mx, &my)) {
+    if (!ProtocolUtil::read<MsgDInfo>(getStream(),
+                            x, y, w, h, dummy1, mx, my)) {
         return false;
     }
     LOG((CLOG_DEBUG "received client \"%s\" info shape=%d,%d %dx%d at %d,%d", getName().c_str(), x, y, w, h, mx, my));
@@ -434,7 +620,7 @@ ClientProxy1_0::recvInfo()
 
     // acknowledge receipt
     LOG((CLOG_DEBUG1 "send info ack to \"%s\"", getName().c_str()));
-    ProtocolUtil::writef(getStream(), kMsgCInfoAck);
+    ProtocolUtil::write<MsgCInfoAck>(getStream());
     return true;
 }
 
@@ -451,7 +637,7 @@ ClientProxy1_0::recvGrabClipboard()
     // parse message
     ClipboardID id;
     UInt32 seqNum;
-    if (!ProtocolUtil::readf(getStream(), kMsgCClipboard + 4, &id, &seqNum)) {
+    if (!ProtocolUtil::read<MsgCClipboard>(getStream(), id, seqNum)) {
         return false;
     }
     LOG((CLOG_DEBUG "received client \"%s\" grabbed clipboard %d seqnum=%d", getName().c_str(), id, seqNum));
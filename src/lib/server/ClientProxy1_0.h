@@ -62,8 +62,15 @@ public:
     virtual void        fileChunkSending(UInt8 mark, char* data, size_t dataSize);
 
 protected:
-    virtual bool        parseHandshakeMessage(const UInt8* code);
-    virtual bool        parseMessage(const UInt8* code);
+    typedef bool (ClientProxy1_0::*MessageHandler)();
+
+    //! Accept a message
+    /*!
+    Dispatches messages with \c id to \c handler once the handshake is
+    done.  The handler returns false if the message was malformed.
+    */
+    template <class T>
+    void                setMessageHandler(EMessageID id, bool (T::*handler)());
 
     virtual void        resetHeartbeatRate();
     virtual void        setHeartbeatRate(double rate, double alarm);
@@ -71,6 +78,33 @@ protected:
     virtual void        addHeartbeatTimer();
     virtual void        removeHeartbeatTimer();
     virtual bool        recvClipboard();
+
+    //! Send the last motion over the stream
+    /*!
+    If the last absolute move went over the motion channel, or motion
+    is being held back because the stream is backed up, send it over
+    the stream so the client is at the right position before whatever
+    is written next.  Must be called before writing any other pointer
+    or key input.
+    */
+    void                flushMotion();
+
+    //! Fence off motion datagrams
+    /*!
+    Tells the client to ignore any motion datagram still in flight, so
+    one arriving late can't undo a move about to go out on the stream.
+    Does nothing if no datagram has been sent since the last fence.
+    */
+    void                fenceMotion();
+
+    //! Send an absolute move over the stream
+    virtual void        sendMouseMove(SInt32 xAbs, SInt32 yAbs);
+
+    //! Send a relative move over the stream
+    /*!
+    Does nothing;  relative moves aren't supported in protocol 1.0.
+    */
+    virtual void        sendMouseRelativeMove(SInt32 xRel, SInt32 yRel);
 private:
     void                disconnect();
     void                removeHandlers();
@@ -79,8 +113,14 @@ private:
     void                handleDisconnect(const Event&, void*);
     void                handleWriteError(const Event&, void*);
     void                handleFlatline(const Event&, void*);
+    void                handleOutputDrained(const Event&, void*);
+
+    bool                parseHandshakeMessage(EMessageID);
+    bool                parseMessage(EMessageID);
 
     bool                recvInfo();
+    bool                recvInfoChanged();
+    bool                recvNoop();
     bool                recvGrabClipboard();
 
 protected:
@@ -97,11 +137,28 @@ protected:
     ClientClipboard    m_clipboard[kClipboardEnd];
 
 private:
-    typedef bool (ClientProxy1_0::*MessageParser)(const UInt8*);
+    typedef bool (ClientProxy1_0::*MessageParser)(EMessageID);
 
     ClientInfo            m_info{};
     double                m_heartbeatAlarm{};
     EventQueueTimer*    m_heartbeatTimer;
     MessageParser        m_parser;
+    MessageHandler        m_handlers[kNumMessageIDs];
+    UInt32                m_received[kNumMessageIDs]{};
+    UInt32              m_motionToken;
+    bool                m_motionSent;
+    bool                m_motionPending;
+    bool                m_motionHeld;
+    SInt32              m_xMotion, m_yMotion;
+    bool                m_relMotionHeld;
+    SInt32              m_dxMotion, m_dyMotion;
     IEventQueue*        m_events;
 };
+
+template <class T>
+inline
+void
+ClientProxy1_0::setMessageHandler(EMessageID id, bool (T::*handler)())
+{
+    m_handlers[id] = static_cast<MessageHandler>(handler);
+}
@@ -28,6 +28,7 @@ public:
     ClientProxy1_2(const String& name, synergy::IStream* stream, IEventQueue* events);
     ~ClientProxy1_2();
 
-    // IClient overrides
-    virtual void        mouseRelativeMove(SInt32 xRel, SInt32 yRel);
+protected:
+    // ClientProxy1_0 overrides
+    virtual void        sendMouseRelativeMove(SInt32 xRel, SInt32 yRel);
 };
@@ -37,6 +37,7 @@ ClientProxy1_3::ClientProxy1_3(const String& name, synergy::IStream* stream, IEv
     m_events(events)
 {
     setHeartbeatRate(kKeepAliveRate, kKeepAliveRate * kKeepAlivesUntilDeath);
+    setMessageHandler(kMsgIDCKeepAlive, &ClientProxy1_3::recvKeepAlive);
 }
 
 ClientProxy1_3::~ClientProxy1_3()
@@ -49,21 +50,16 @@ void
 ClientProxy1_3::mouseWheel(SInt32 xDelta, SInt32 yDelta)
 {
     LOG((CLOG_DEBUG2 "send mouse wheel to \"%s\" %+d,%+d", getName().c_str(), xDelta, yDelta));
-    ProtocolUtil::writef(getStream(), kMsgDMouseWheel, xDelta, yDelta);
+    flushMotion();
+    ProtocolUtil::write<MsgDMouseWheel>(getStream(), xDelta, yDelta);
 }
 
 bool
-ClientProxy1_3::parseMessage(const UInt8* code)
+ClientProxy1_3::recvKeepAlive()
 {
-    // process message
-    if (memcmp(code, kMsgCKeepAlive, 4) == 0) {
-        // reset alarm
-        resetHeartbeatTimer();
-        return true;
-    }
-    
-        return ClientProxy1_2::parseMessage(code);
-    
+    // reset alarm
+    resetHeartbeatTimer();
+    return true;
 }
 
 void
@@ -83,8 +79,7 @@ void
 ClientProxy1_3::resetHeartbeatTimer()
 {
     // reset the alarm but not the keep alive timer
-    ClientProxy1_2::removeHeartbeatTimer();
-    ClientProxy1_2::addHeartbeatTimer();
+    ClientProxy1_2::resetHeartbeatTimer();
 }
 
 void
@@ -125,5 +120,5 @@ ClientProxy1_3::handleKeepAlive(const Event& /*unused*/, void* /*unused*/)
 void
 ClientProxy1_3::keepAlive()
 {
-    ProtocolUtil::writef(getStream(), kMsgCKeepAlive);
+    ProtocolUtil::write<MsgCKeepAlive>(getStream());
 }
@@ -33,7 +33,6 @@ public:
 
 protected:
     // ClientProxy overrides
-    virtual bool        parseMessage(const UInt8* code);
     virtual void        resetHeartbeatRate();
     virtual void        setHeartbeatRate(double rate, double alarm);
     virtual void        resetHeartbeatTimer();
@@ -41,6 +40,9 @@ protected:
     virtual void        removeHeartbeatTimer();
     virtual void        keepAlive();
 
+private:
+    bool                recvKeepAlive();
+
 private:
     double                m_keepAliveRate;
     EventQueueTimer*    m_keepAliveTimer;
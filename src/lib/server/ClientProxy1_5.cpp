@@ -35,6 +35,8 @@ ClientProxy1_5::ClientProxy1_5(const String& name, synergy::IStream* stream, Ser
     ClientProxy1_4(name, stream, server, events),
     m_events(events)
 {
+    setMessageHandler(kMsgIDDFileTransfer, &ClientProxy1_5::fileChunkReceived);
+    setMessageHandler(kMsgIDDDragInfo, &ClientProxy1_5::dragInfoReceived);
 
     m_events->adoptHandler(m_events->forFile().keepAlive(),
                             this,
@@ -52,7 +54,7 @@ ClientProxy1_5::sendDragInfo(UInt32 fileCount, const char* info, size_t size)
 {
     String data(info, size);
 
-    ProtocolUtil::writef(getStream(), kMsgDDragInfo, fileCount, &data);
+    ProtocolUtil::write<MsgDDragInfo>(getStream(), fileCount, data);
 }
 
 void
@@ -62,22 +64,6 @@ ClientProxy1_5::fileChunkSending(UInt8 mark, char* data, size_t dataSize)
 }
 
 bool
-ClientProxy1_5::parseMessage(const UInt8* code)
-{
-    if (memcmp(code, kMsgDFileTransfer, 4) == 0) {
-        fileChunkReceived();
-    }
-    else if (memcmp(code, kMsgDDragInfo, 4) == 0) {
-        dragInfoReceived();
-    }
-    else {
-        return ClientProxy1_4::parseMessage(code);
-    }
-
-    return true;
-}
-
-void
 ClientProxy1_5::fileChunkReceived()
 {
     Server* server = getServer();
@@ -96,15 +82,17 @@ ClientProxy1_5::fileChunkReceived()
             LOG((CLOG_DEBUG "start receiving %s", filename.c_str()));
         }
     }
+    return true;
 }
 
-void
+bool
 ClientProxy1_5::dragInfoReceived()
 {
     // parse
     UInt32 fileNum = 0;
     String content;
-    ProtocolUtil::readf(getStream(), kMsgDDragInfo + 4, &fileNum, &content);
+    ProtocolUtil::read<MsgDDragInfo>(getStream(), fileNum, content);
     
     m_server->dragInfoReceived(fileNum, content);
+    return true;
 }
@@ -0,0 +1,226 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ClientProxy1_7.h"
+
+#include "base/IEventQueue.h"
+#include "base/Log.h"
+#include "base/TMethodEventJob.h"
+#include "io/IStream.h"
+
+//
+// ClientProxy1_7
+//
+
+ClientProxy1_7::ClientProxy1_7(const String& name, synergy::IStream* stream, Server* server, IEventQueue* events) :
+    ClientProxy1_6(name, stream, server, events),
+    m_flushQueued(false),
+    m_events(events)
+{
+    m_events->adoptHandler(m_events->forClientProxy().flushInput(), this,
+                            new TMethodEventJob<ClientProxy1_7>(this,
+                                &ClientProxy1_7::handleFlushInput));
+}
+
+ClientProxy1_7::~ClientProxy1_7()
+{
+    m_events->removeHandler(m_events->forClientProxy().flushInput(), this);
+}
+
+void
+ClientProxy1_7::enter(SInt32 xAbs, SInt32 yAbs,
+                UInt32 seqNum, KeyModifierMask mask, bool forScreensaver)
+{
+    flushInput();
+    ClientProxy1_6::enter(xAbs, yAbs, seqNum, mask, forScreensaver);
+
+    // moves are sent relative to where the pointer entered
+    m_frame.setPosition(xAbs, yAbs);
+}
+
+bool
+ClientProxy1_7::leave()
+{
+    flushMotion();
+    flushInput();
+    return ClientProxy1_6::leave();
+}
+
+void
+ClientProxy1_7::grabClipboard(ClipboardID id)
+{
+    flushInput();
+    ClientProxy1_6::grabClipboard(id);
+}
+
+void
+ClientProxy1_7::keyDown(KeyID key, KeyModifierMask mask, KeyButton button)
+{
+    LOG((CLOG_DEBUG1 "send key down to \"%s\" id=%d, mask=0x%04x, button=0x%04x", getName().c_str(), key, mask, button));
+    flushMotion();
+    CompactInput input{};
+    input.m_op     = kCompactKeyDown;
+    input.m_id     = key;
+    input.m_mask   = mask;
+    input.m_button = button;
+    addInput(input);
+}
+
+void
+ClientProxy1_7::keyRepeat(KeyID key, KeyModifierMask mask,
+                SInt32 count, KeyButton button)
+{
+    LOG((CLOG_DEBUG1 "send key repeat to \"%s\" id=%d, mask=0x%04x, count=%d, button=0x%04x", getName().c_str(), key, mask, count, button));
+    flushMotion();
+    CompactInput input{};
+    input.m_op     = kCompactKeyRepeat;
+    input.m_id     = key;
+    input.m_mask   = mask;
+    input.m_count  = static_cast<UInt32>(count);
+    input.m_button = button;
+    addInput(input);
+}
+
+void
+ClientProxy1_7::keyUp(KeyID key, KeyModifierMask mask, KeyButton button)
+{
+    LOG((CLOG_DEBUG1 "send key up to \"%s\" id=%d, mask=0x%04x, button=0x%04x", getName().c_str(), key, mask, button));
+    flushMotion();
+    CompactInput input{};
+    input.m_op     = kCompactKeyUp;
+    input.m_id     = key;
+    input.m_mask   = mask;
+    input.m_button = button;
+    addInput(input);
+}
+
+void
+ClientProxy1_7::mouseDown(ButtonID button)
+{
+    LOG((CLOG_DEBUG1 "send mouse down to \"%s\" id=%d", getName().c_str(), button));
+    flushMotion();
+    CompactInput input{};
+    input.m_op = kCompactMouseDown;
+    input.m_id = button;
+    addInput(input);
+}
+
+void
+ClientProxy1_7::mouseUp(ButtonID button)
+{
+    LOG((CLOG_DEBUG1 "send mouse up to \"%s\" id=%d", getName().c_str(), button));
+    flushMotion();
+    CompactInput input{};
+    input.m_op = kCompactMouseUp;
+    input.m_id = button;
+    addInput(input);
+}
+
+void
+ClientProxy1_7::sendMouseMove(SInt32 xAbs, SInt32 yAbs)
+{
+    LOG((CLOG_DEBUG2 "send mouse move to \"%s\" %d,%d", getName().c_str(), xAbs, yAbs));
+    CompactInput input{};
+    input.m_op = kCompactMouseMove;
+    input.m_x  = xAbs;
+    input.m_y  = yAbs;
+    addInput(input);
+}
+
+void
+ClientProxy1_7::sendMouseRelativeMove(SInt32 xRel, SInt32 yRel)
+{
+    LOG((CLOG_DEBUG2 "send mouse relative move to \"%s\" %d,%d", getName().c_str(), xRel, yRel));
+    CompactInput input{};
+    input.m_op = kCompactMouseRelMove;
+    input.m_x  = xRel;
+    input.m_y  = yRel;
+    addInput(input);
+}
+
+void
+ClientProxy1_7::mouseWheel(SInt32 xDelta, SInt32 yDelta)
+{
+    LOG((CLOG_DEBUG2 "send mouse wheel to \"%s\" %+d,%+d", getName().c_str(), xDelta, yDelta));
+    flushMotion();
+    CompactInput input{};
+    input.m_op = kCompactMouseWheel;
+    input.m_x  = xDelta;
+    input.m_y  = yDelta;
+    addInput(input);
+}
+
+void
+ClientProxy1_7::screensaver(bool on)
+{
+    flushInput();
+    ClientProxy1_6::screensaver(on);
+}
+
+void
+ClientProxy1_7::resetOptions()
+{
+    flushMotion();
+    flushInput();
+    ClientProxy1_6::resetOptions();
+}
+
+void
+ClientProxy1_7::setOptions(const OptionsList& options)
+{
+    flushInput();
+    ClientProxy1_6::setOptions(options);
+}
+
+void
+ClientProxy1_7::sendDragInfo(UInt32 fileCount, const char* info, size_t size)
+{
+    flushInput();
+    ClientProxy1_6::sendDragInfo(fileCount, info, size);
+}
+
+void
+ClientProxy1_7::addInput(const CompactInput& input)
+{
+    if (!m_frame.hasRoom()) {
+        flushInput();
+    }
+    m_frame.add(input);
+
+    // anything already queued goes in this frame too
+    if (!m_flushQueued) {
+        m_flushQueued = true;
+        m_events->addEvent(Event(m_events->forClientProxy().flushInput(),
+                            this));
+    }
+}
+
+void
+ClientProxy1_7::flushInput()
+{
+    if (!m_frame.isEmpty()) {
+        LOG((CLOG_DEBUG2 "send input frame to \"%s\" size=%d", getName().c_str(), m_frame.getSize()));
+        getStream()->write(m_frame.getData(), m_frame.getSize());
+        m_frame.clear();
+    }
+}
+
+void
+ClientProxy1_7::handleFlushInput(const Event& /*unused*/, void* /*unused*/)
+{
+    m_flushQueued = false;
+    flushInput();
+}
@@ -0,0 +1,70 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "server/ClientProxy1_6.h"
+#include "core/CompactInput.h"
+
+class Server;
+class IEventQueue;
+
+//! Proxy for client implementing protocol version 1.7
+/*!
+Key and pointer input is packed into compact frames.  A frame is
+started by the first input after the last one was written and is
+written once the events that were queued before it have been handled,
+or sooner if it fills up or something else has to be written.
+*/
+class ClientProxy1_7 : public ClientProxy1_6 {
+public:
+    ClientProxy1_7(const String& name, synergy::IStream* stream, Server* server, IEventQueue* events);
+    ~ClientProxy1_7();
+
+    // IClient overrides
+    virtual void        enter(SInt32 xAbs, SInt32 yAbs,
+                            UInt32 seqNum, KeyModifierMask mask,
+                            bool forScreensaver);
+    virtual bool        leave();
+    virtual void        grabClipboard(ClipboardID);
+    virtual void        keyDown(KeyID, KeyModifierMask, KeyButton);
+    virtual void        keyRepeat(KeyID, KeyModifierMask,
+                            SInt32 count, KeyButton);
+    virtual void        keyUp(KeyID, KeyModifierMask, KeyButton);
+    virtual void        mouseDown(ButtonID);
+    virtual void        mouseUp(ButtonID);
+    virtual void        mouseWheel(SInt32 xDelta, SInt32 yDelta);
+    virtual void        screensaver(bool on);
+    virtual void        resetOptions();
+    virtual void        setOptions(const OptionsList& options);
+    virtual void        sendDragInfo(UInt32 fileCount, const char* info, size_t size);
+
+protected:
+    // ClientProxy1_0 overrides
+    virtual void        sendMouseMove(SInt32 xAbs, SInt32 yAbs);
+    virtual void        sendMouseRelativeMove(SInt32 xRel, SInt32 yRel);
+
+private:
+    void                addInput(const CompactInput&);
+    void                flushInput();
+
+    void                handleFlushInput(const Event&, void*);
+
+private:
+    CompactInputWriter  m_frame;
+    bool                m_flushQueued;
+    IEventQueue*        m_events;
+};
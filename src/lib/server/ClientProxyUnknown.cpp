@@ -34,6 +34,7 @@
 #include "server/ClientProxy1_4.h"
 #include "server/ClientProxy1_5.h"
 #include "server/ClientProxy1_6.h"
+#include "server/ClientProxy1_7.h"
 #include "server/Server.h"
 
 //
@@ -56,7 +57,7 @@ ClientProxyUnknown::ClientProxyUnknown(synergy::IStream* stream, double timeout,
     addStreamHandlers();
 
     LOG((CLOG_DEBUG1 "saying hello"));
-    ProtocolUtil::writef(m_stream, kMsgHello,
+    ProtocolUtil::write<MsgHello>(m_stream,
                             kProtocolMajorVersion,
                             kProtocolMinorVersion);
 }
@@ -187,8 +188,8 @@ ClientProxyUnknown::handleData(const Event& /*unused*/, void* /*unused*/)
 
         // parse the reply to hello
         SInt16 major, minor;
-        if (!ProtocolUtil::readf(m_stream, kMsgHelloBack,
-                                    &major, &minor, &name)) {
+        if (!ProtocolUtil::readMessage<MsgHelloBack>(m_stream,
+                                    major, minor, name)) {
             throw XBadClient();
         }
 
@@ -232,6 +233,10 @@ ClientProxyUnknown::handleData(const Event& /*unused*/, void* /*unused*/)
             case 6:
                 m_proxy = new ClientProxy1_6(name, m_stream, m_server, m_events);
                 break;
+
+            case 7:
+                m_proxy = new ClientProxy1_7(name, m_stream, m_server, m_events);
+                break;
             }
         }
 
@@ -251,14 +256,13 @@ ClientProxyUnknown::handleData(const Event& /*unused*/, void* /*unused*/)
     catch (XIncompatibleClient& e) {
         // client is incompatible
         LOG((CLOG_WARN "client \"%s\" has incompatible version %d.%d)", name.c_str(), e.getMajor(), e.getMinor()));
-        ProtocolUtil::writef(m_stream,
-                            kMsgEIncompatible,
+        ProtocolUtil::write<MsgEIncompatible>(m_stream,
                             kProtocolMajorVersion, kProtocolMinorVersion);
     }
     catch (XBadClient&) {
         // client not behaving
         LOG((CLOG_WARN "protocol error from client \"%s\"", name.c_str()));
-        ProtocolUtil::writef(m_stream, kMsgEBad);
+        ProtocolUtil::write<MsgEBad>(m_stream);
     }
     catch (XBase& e) {
         // misc error
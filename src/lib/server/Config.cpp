@@ -768,6 +768,12 @@ Config::readSectionOptions(ConfigReadContext& s)
 		else if (name == "clipboardSharingSize") {
 			addOption("", kOptionClipboardSharingSize, s.parseInt(value));
 		}
+		else if (name == "noopAck") {
+			addOption("", kOptionNoopAck, s.parseNoopAck(value));
+		}
+		else if (name == "motionChannel") {
+			addOption("", kOptionMotionChannel, s.parseBoolean(value));
+		}
 		else {
 			handled = false;
 		}
@@ -1388,6 +1394,12 @@ Config::getOptionName(OptionID id)
 	if (id == kOptionClipboardSharingSize) {
 		return "clipboardSharingSize";
 	}
+	if (id == kOptionNoopAck) {
+		return "noopAck";
+	}
+	if (id == kOptionMotionChannel) {
+		return "motionChannel";
+	}
 	return NULL;
 }
 
@@ -1406,7 +1418,8 @@ Config::getOptionValue(OptionID id, OptionValue value)
 		id == kOptionWin32KeepForeground ||
 		id == kOptionScreenPreserveFocus ||
 		id == kOptionClipboardSharing ||
-		id == kOptionClipboardSharingSize) {
+		id == kOptionClipboardSharingSize ||
+		id == kOptionMotionChannel) {
 		return (value != 0) ? "true" : "false";
 	}
 	if (id == kOptionModifierMapForShift ||
@@ -1460,6 +1473,18 @@ Config::getOptionValue(OptionID id, OptionValue value)
 		}
 		return result;
 	}
+	if (id == kOptionNoopAck) {
+		switch (value) {
+		case kNoopAckMessage:
+			return "message";
+
+		case kNoopAckRead:
+			return "read";
+
+		default:
+			return "none";
+		}
+	}
 
 	return "";
 }
@@ -2083,6 +2108,21 @@ ConfigReadContext::parseCorners(const String& args) const
 	return corners;
 }
 
+OptionValue
+ConfigReadContext::parseNoopAck(const String& arg) const
+{
+	if (CaselessCmp::equal(arg, "message")) {
+		return kNoopAckMessage;
+	}
+	if (CaselessCmp::equal(arg, "read")) {
+		return kNoopAckRead;
+	}
+	if (CaselessCmp::equal(arg, "none")) {
+		return kNoopAckNone;
+	}
+	throw XConfigRead(*this, "invalid argument \"%{1}\"", arg);
+}
+
 Config::Interval
 ConfigReadContext::parseInterval(const ArgList& args) const
 {
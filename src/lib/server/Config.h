@@ -502,6 +502,7 @@ public:
     OptionValue            parseModifierKey(const String&) const;
     OptionValue            parseCorner(const String&) const;
     OptionValue            parseCorners(const String&) const;
+    OptionValue            parseNoopAck(const String&) const;
     Config::Interval
                         parseInterval(const ArgList& args) const;
     void                parseNameWithArgs(
@@ -17,6 +17,7 @@
  */
 
 #include "server/InputFilter.h"
+#include "base/EventDataPool.h"
 #include "base/EventQueue.h"
 #include "base/Log.h"
 #include "base/TMethodEventJob.h"
@@ -24,6 +25,7 @@
 #include "server/PrimaryClient.h"
 #include "server/Server.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <utility>
@@ -60,7 +62,7 @@ InputFilter::KeystrokeCondition::KeystrokeCondition(
     m_mask(info->m_mask),
     m_events(events)
 {
-    free(info);
+    EventDataPool::release(info);
 }
 
 InputFilter::KeystrokeCondition::KeystrokeCondition(
@@ -149,7 +151,7 @@ InputFilter::MouseButtonCondition::MouseButtonCondition(
     m_mask(info->m_mask),
     m_events(events)
 {
-    free(info);
+    EventDataPool::release(info);
 }
 
 InputFilter::MouseButtonCondition::MouseButtonCondition(
@@ -497,13 +499,13 @@ InputFilter::KeystrokeAction::KeystrokeAction(
 
 InputFilter::KeystrokeAction::~KeystrokeAction()
 {
-    free(m_keyInfo);
+    EventDataPool::release(m_keyInfo);
 }
 
 void
 InputFilter::KeystrokeAction::adoptInfo(IPlatformScreen::KeyInfo* info)
 {
-    free(m_keyInfo);
+    EventDataPool::release(m_keyInfo);
     m_keyInfo = info;
 }
 
@@ -585,7 +587,7 @@ InputFilter::MouseButtonAction::MouseButtonAction(
 
 InputFilter::MouseButtonAction::~MouseButtonAction()
 {
-    free(m_buttonInfo);
+    EventDataPool::release(m_buttonInfo);
 }
 
 const IPlatformScreen::ButtonInfo*
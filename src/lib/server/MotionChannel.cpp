@@ -0,0 +1,178 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/MotionChannel.h"
+
+#include "arch/Arch.h"
+#include "base/IEventQueue.h"
+#include "base/Log.h"
+#include "base/TMethodEventJob.h"
+#include "core/MotionDatagram.h"
+#include "net/IDatagramSocket.h"
+#include "net/ISocketFactory.h"
+#include "net/XSocket.h"
+
+//
+// MotionChannel::Peer
+//
+
+MotionChannel::Peer::Peer() :
+    m_ready(false),
+    m_seq(0)
+{
+    // do nothing
+}
+
+
+//
+// MotionChannel
+//
+
+MotionChannel::MotionChannel(const NetworkAddress& address,
+                ISocketFactory* socketFactory,
+                IEventQueue* events) :
+    m_address(address),
+    m_socketFactory(socketFactory),
+    m_events(events),
+    m_socket(nullptr),
+    m_random(std::random_device()())
+{
+    assert(m_socketFactory != NULL);
+}
+
+MotionChannel::~MotionChannel()
+{
+    close();
+}
+
+UInt32
+MotionChannel::addClient()
+{
+    if (m_socket == nullptr && !open()) {
+        return 0;
+    }
+
+    UInt32 token;
+    do {
+        token = static_cast<UInt32>(m_random());
+    } while (token == 0 || m_peers.count(token) != 0);
+    m_peers[token] = Peer();
+    return token;
+}
+
+void
+MotionChannel::removeClient(UInt32 token)
+{
+    if (token == 0) {
+        return;
+    }
+    m_peers.erase(token);
+    if (m_peers.empty()) {
+        close();
+    }
+}
+
+bool
+MotionChannel::sendMove(UInt32 token, SInt32 x, SInt32 y)
+{
+    auto i = m_peers.find(token);
+    if (i == m_peers.end() || !i->second.m_ready) {
+        return false;
+    }
+
+    MotionDatagram move;
+    move.m_type  = MotionDatagram::kMove;
+    move.m_token = token;
+    move.m_seq   = ++i->second.m_seq;
+    move.m_x     = static_cast<SInt16>(x);
+    move.m_y     = static_cast<SInt16>(y);
+
+    UInt8 buffer[MotionDatagram::kMaxSize];
+    m_socket->sendTo(buffer, move.encode(buffer), i->second.m_address);
+    return true;
+}
+
+UInt32
+MotionChannel::getSeq(UInt32 token) const
+{
+    auto i = m_peers.find(token);
+    if (i == m_peers.end()) {
+        return 0;
+    }
+    return i->second.m_seq;
+}
+
+bool
+MotionChannel::open()
+{
+    IDatagramSocket* socket = nullptr;
+    try {
+        socket = m_socketFactory->createDatagram(
+                            ARCH->getAddrFamily(m_address.getAddress()));
+        socket->bind(m_address);
+    }
+    catch (XSocket& e) {
+        LOG((CLOG_WARN "cannot open motion channel: %s", e.what()));
+        delete socket;
+        return false;
+    }
+
+    LOG((CLOG_DEBUG "motion channel open"));
+    m_socket = socket;
+    m_events->adoptHandler(m_events->forIStream().inputReady(),
+                            m_socket->getEventTarget(),
+                            new TMethodEventJob<MotionChannel>(this,
+                                &MotionChannel::handleDatagram));
+    return true;
+}
+
+void
+MotionChannel::close()
+{
+    if (m_socket != nullptr) {
+        LOG((CLOG_DEBUG "motion channel closed"));
+        m_events->removeHandler(m_events->forIStream().inputReady(),
+                            m_socket->getEventTarget());
+        delete m_socket;
+        m_socket = nullptr;
+    }
+}
+
+void
+MotionChannel::handleDatagram(const Event&, void*)
+{
+    UInt8 buffer[MotionDatagram::kMaxSize];
+    NetworkAddress from;
+    UInt32 n;
+    while (m_socket != nullptr &&
+            (n = m_socket->receiveFrom(buffer, sizeof(buffer), from)) != 0) {
+        MotionDatagram hello;
+        if (!hello.decode(buffer, n) || hello.m_type != MotionDatagram::kHello) {
+            continue;
+        }
+
+        // a client's address can change if it's behind NAT, so the
+        // latest hello always wins
+        auto i = m_peers.find(hello.m_token);
+        if (i != m_peers.end()) {
+            if (!i->second.m_ready) {
+                LOG((CLOG_DEBUG "motion channel hello from %s:%d", from.getHostname().c_str(), from.getPort()));
+            }
+            i->second.m_address = from;
+            i->second.m_ready   = true;
+        }
+    }
+}
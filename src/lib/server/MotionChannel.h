@@ -0,0 +1,107 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "net/NetworkAddress.h"
+#include "base/Event.h"
+#include "common/basic_types.h"
+#include "common/stdmap.h"
+
+#include <random>
+
+class IDatagramSocket;
+class IEventQueue;
+class ISocketFactory;
+
+//! Server end of the pointer motion channel
+/*!
+Sends absolute pointer motion to clients over UDP, alongside their TCP
+connections, so a lost or late move never holds up the moves after it.
+Each client that has the channel enabled gets a token with addClient()
+and sends it back in kHello datagrams from its own socket;  until its
+hello arrives sendMove() fails and the caller should use TCP.  The
+socket is bound to the listen address, so one port serves TCP and UDP.
+*/
+class MotionChannel {
+public:
+    //! The socket factory is not adopted
+    MotionChannel(const NetworkAddress& address,
+                            ISocketFactory* socketFactory,
+                            IEventQueue* events);
+    ~MotionChannel();
+
+    //! @name manipulators
+    //@{
+
+    //! Add a client
+    /*!
+    Opens the socket if necessary and returns the client's token, or
+    0 if the socket couldn't be opened.
+    */
+    UInt32              addClient();
+
+    //! Remove a client
+    /*!
+    Forgets the client with \c token.  Ignored if \c token is 0.
+    */
+    void                removeClient(UInt32 token);
+
+    //! Send a move
+    /*!
+    Sends an absolute move to the client with \c token.  Returns false,
+    sending nothing, if the client hasn't said hello yet.
+    */
+    bool                sendMove(UInt32 token, SInt32 x, SInt32 y);
+
+    //@}
+    //! @name accessors
+    //@{
+
+    //! Get the last sequence number
+    /*!
+    Returns the sequence number of the last move sent to the client with
+    \c token, or 0 if none has been sent.
+    */
+    UInt32              getSeq(UInt32 token) const;
+
+    //@}
+
+private:
+    bool                open();
+    void                close();
+
+    void                handleDatagram(const Event&, void*);
+
+private:
+    struct Peer {
+    public:
+        Peer();
+
+    public:
+        NetworkAddress  m_address;
+        bool            m_ready;
+        UInt32          m_seq;
+    };
+    typedef std::map<UInt32, Peer> PeerMap;
+
+    NetworkAddress      m_address;
+    ISocketFactory*     m_socketFactory;
+    IEventQueue*        m_events;
+    IDatagramSocket*    m_socket;
+    PeerMap             m_peers;
+    std::mt19937        m_random;
+};
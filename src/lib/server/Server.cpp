@@ -19,6 +19,7 @@
 #include "server/Server.h"
 
 #include "arch/Arch.h"
+#include "base/EventDataPool.h"
 #include "base/IEventQueue.h"
 #include "base/Log.h"
 #include "base/TMethodEventJob.h"
@@ -1127,6 +1128,7 @@ Server::sendOptions(BaseClientProxy* client) const
 	}
 
 	// look up global options
+	bool noopAck = false;
 	options = m_config->getOptions("");
 	if (options != nullptr) {
 		// convert options to a more convenient form for sending
@@ -1134,9 +1136,17 @@ Server::sendOptions(BaseClientProxy* client) const
 		for (auto option : *options) {
 			optionsList.push_back(option.first);
 			optionsList.push_back(static_cast<UInt32>(option.second));
+			noopAck = noopAck || option.first == kOptionNoopAck;
 		}
 	}
 
+	// we don't need a no-op for every message.  one per read is enough
+	// to carry the client's delayed ACKs.
+	if (!noopAck) {
+		optionsList.push_back(kOptionNoopAck);
+		optionsList.push_back(static_cast<UInt32>(kNoopAckRead));
+	}
+
 	// send the options
 	client->resetOptions();
 	client->setOptions(optionsList);
@@ -2316,6 +2326,23 @@ Server::ClipboardInfo::ClipboardInfo() :
 }
 
 
+//
+// Server::*Info pools
+//
+// these events come from hot keys so the pools are small.  the screen
+// names in the variable size types get 32 bytes before they overflow.
+//
+
+static TypedEventDataPool<Server::LockCursorToScreenInfo>
+						s_lockCursorInfoPool("LockCursorToScreenInfo", 0, 16);
+static TypedEventDataPool<Server::SwitchToScreenInfo>
+						s_switchToScreenInfoPool("SwitchToScreenInfo", 32, 16);
+static TypedEventDataPool<Server::SwitchInDirectionInfo>
+						s_switchInDirectionInfoPool("SwitchInDirectionInfo", 0, 16);
+static TypedEventDataPool<Server::KeyboardBroadcastInfo>
+						s_keyboardBroadcastInfoPool("KeyboardBroadcastInfo", 32, 16);
+
+
 //
 // Server::LockCursorToScreenInfo
 //
@@ -2323,8 +2350,7 @@ Server::ClipboardInfo::ClipboardInfo() :
 Server::LockCursorToScreenInfo*
 Server::LockCursorToScreenInfo::alloc(State state)
 {
-	auto* info =
-		static_cast<LockCursorToScreenInfo*>(malloc(sizeof(LockCursorToScreenInfo)));
+	auto* info = s_lockCursorInfoPool.alloc();
 	info->m_state = state;
 	return info;
 }
@@ -2338,8 +2364,7 @@ Server::SwitchToScreenInfo*
 Server::SwitchToScreenInfo::alloc(const String& screen)
 {
 	auto* info =
-		static_cast<SwitchToScreenInfo*>(malloc(sizeof(SwitchToScreenInfo) +
-								screen.size()));
+		s_switchToScreenInfoPool.alloc(static_cast<UInt32>(screen.size()));
 	strcpy(info->m_screen, screen.c_str());
 	return info;
 }
@@ -2352,8 +2377,7 @@ Server::SwitchToScreenInfo::alloc(const String& screen)
 Server::SwitchInDirectionInfo*
 Server::SwitchInDirectionInfo::alloc(EDirection direction)
 {
-	auto* info =
-		static_cast<SwitchInDirectionInfo*>(malloc(sizeof(SwitchInDirectionInfo)));
+	auto* info = s_switchInDirectionInfoPool.alloc();
 	info->m_direction = direction;
 	return info;
 }
@@ -2365,8 +2389,7 @@ Server::SwitchInDirectionInfo::alloc(EDirection direction)
 Server::KeyboardBroadcastInfo*
 Server::KeyboardBroadcastInfo::alloc(State state)
 {
-	auto* info =
-		static_cast<KeyboardBroadcastInfo*>(malloc(sizeof(KeyboardBroadcastInfo)));
+	auto* info = s_keyboardBroadcastInfoPool.alloc();
 	info->m_state      = state;
 	info->m_screens[0] = '\0';
 	return info;
@@ -2376,8 +2399,7 @@ Server::KeyboardBroadcastInfo*
 Server::KeyboardBroadcastInfo::alloc(State state, const String& screens)
 {
 	auto* info =
-		static_cast<KeyboardBroadcastInfo*>(malloc(sizeof(KeyboardBroadcastInfo) +
-								screens.size()));
+		s_keyboardBroadcastInfoPool.alloc(static_cast<UInt32>(screens.size()));
 	info->m_state = state;
 	strcpy(info->m_screens, screens.c_str());
 	return info;
@@ -0,0 +1,525 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_ENV
+
+#include "arch/Arch.h"
+#include "base/TMethodEventJob.h"
+#include "client/Client.h"
+#include "client/ServerProxy.h"
+#include "core/MotionDatagram.h"
+#include "core/ProtocolUtil.h"
+#include "core/option_types.h"
+#include "core/protocol_types.h"
+#include "net/IDatagramSocket.h"
+#include "net/NetworkAddress.h"
+#include "net/SocketMultiplexer.h"
+#include "net/TCPSocketFactory.h"
+#include "net/UDPSocket.h"
+#include "server/MotionChannel.h"
+#include "test/global/TestEventQueue.h"
+#include "test/mock/io/MockStream.h"
+
+#include "test/global/gtest.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+#define TEST_PORT 24805
+#define TEST_HOST "localhost"
+
+static const UInt32 kMoves = 100;
+static const UInt32 kDropEvery = 3;
+
+// datagram socket that drops every nth datagram it sends
+class LossyDatagramSocket : public IDatagramSocket {
+public:
+    LossyDatagramSocket(IDatagramSocket* socket, UInt32 dropEvery) :
+        m_socket(socket), m_dropEvery(dropEvery), m_sends(0) { }
+    ~LossyDatagramSocket() override { delete m_socket; }
+
+    void                sendTo(const void* buffer, UInt32 n,
+                            const NetworkAddress& address) override
+    {
+        if (++m_sends % m_dropEvery != 0) {
+            m_socket->sendTo(buffer, n, address);
+        }
+    }
+    UInt32              receiveFrom(void* buffer, UInt32 n,
+                            NetworkAddress& address) override
+    {
+        return m_socket->receiveFrom(buffer, n, address);
+    }
+    void                bind(const NetworkAddress& address) override
+    {
+        m_socket->bind(address);
+    }
+    void                close() override { m_socket->close(); }
+    void*               getEventTarget() const override
+    {
+        return m_socket->getEventTarget();
+    }
+
+private:
+    IDatagramSocket*    m_socket;
+    UInt32              m_dropEvery;
+    UInt32              m_sends;
+};
+
+class LossySocketFactory : public ISocketFactory {
+public:
+    LossySocketFactory(ISocketFactory* factory) : m_factory(factory) { }
+
+    IDataSocket*        create(IArchNetwork::EAddressFamily family) const override
+    {
+        return m_factory->create(family);
+    }
+    IListenSocket*      createListen(IArchNetwork::EAddressFamily family) const override
+    {
+        return m_factory->createListen(family);
+    }
+    IDatagramSocket*    createDatagram(IArchNetwork::EAddressFamily family) const override
+    {
+        return new LossyDatagramSocket(
+                            m_factory->createDatagram(family), kDropEvery);
+    }
+
+private:
+    ISocketFactory*     m_factory;
+};
+
+class MotionChannelTests : public ::testing::Test {
+public:
+    MotionChannelTests() :
+        m_channel(nullptr),
+        m_client(nullptr),
+        m_token(0),
+        m_sent(false),
+        m_received(0),
+        m_accepted(0),
+        m_lastSeq(0),
+        m_x(0),
+        m_y(0),
+        m_ordered(true) { }
+
+    void                handleTimer(const Event&, void*);
+    void                handleClientData(const Event&, void*);
+
+public:
+    TestEventQueue      m_events;
+    NetworkAddress      m_serverAddress;
+    MotionChannel*      m_channel;
+    UDPSocket*          m_client;
+    UInt32              m_token;
+    bool                m_sent;
+    UInt32              m_received;
+    UInt32              m_accepted;
+    UInt32              m_lastSeq;
+    SInt32              m_x, m_y;
+    bool                m_ordered;
+};
+
+TEST_F(MotionChannelTests, sendMove_lossy_receiverOnlyMovesForward)
+{
+    m_serverAddress = NetworkAddress(TEST_HOST, TEST_PORT);
+    m_serverAddress.resolve();
+    IArchNetwork::EAddressFamily family =
+                            ARCH->getAddrFamily(m_serverAddress.getAddress());
+
+    SocketMultiplexer multiplexer;
+    TCPSocketFactory socketFactory(&m_events, &multiplexer);
+    LossySocketFactory lossyFactory(&socketFactory);
+
+    MotionChannel channel(m_serverAddress, &lossyFactory, &m_events);
+    m_channel = &channel;
+    m_token   = channel.addClient();
+    ASSERT_NE(0, m_token);
+
+    // nothing can be sent until the client has said hello
+    EXPECT_FALSE(channel.sendMove(m_token, 1, 1));
+    EXPECT_EQ(0, channel.getSeq(m_token));
+
+    UDPSocket client(&m_events, &multiplexer, family);
+    m_client = &client;
+    m_events.adoptHandler(m_events.forIStream().inputReady(),
+                            client.getEventTarget(),
+                            new TMethodEventJob<MotionChannelTests>(this,
+                                &MotionChannelTests::handleClientData));
+
+    EventQueueTimer* timer = m_events.newTimer(0.01, nullptr);
+    m_events.adoptHandler(Event::kTimer, timer,
+                            new TMethodEventJob<MotionChannelTests>(this,
+                                &MotionChannelTests::handleTimer));
+
+    m_events.initQuitTimeout(10);
+    m_events.loop();
+    m_events.cleanupQuitTimeout();
+
+    m_events.removeHandler(Event::kTimer, timer);
+    m_events.deleteTimer(timer);
+    m_events.removeHandler(m_events.forIStream().inputReady(),
+                            client.getEventTarget());
+
+    // the first move went out with the hello reply
+    EXPECT_EQ(kMoves + 1, channel.getSeq(m_token));
+    channel.removeClient(m_token);
+    EXPECT_EQ(0, channel.getSeq(m_token));
+
+    EXPECT_TRUE(m_sent);
+    EXPECT_TRUE(m_ordered);
+    EXPECT_LT(m_received, kMoves);
+    EXPECT_EQ(m_received, m_accepted);
+    EXPECT_EQ(static_cast<SInt32>(kMoves), m_x);
+    EXPECT_EQ(-static_cast<SInt32>(kMoves), m_y);
+}
+
+void
+MotionChannelTests::handleTimer(const Event&, void*)
+{
+    if (m_sent) {
+        return;
+    }
+
+    // the hello can be lost too, so keep sending it until moves go out
+    if (!m_channel->sendMove(m_token, 0, 0)) {
+        MotionDatagram hello;
+        hello.m_type  = MotionDatagram::kHello;
+        hello.m_token = m_token;
+        UInt8 buffer[MotionDatagram::kMaxSize];
+        m_client->sendTo(buffer, hello.encode(buffer), m_serverAddress);
+        return;
+    }
+
+    for (UInt32 i = 1; i <= kMoves; ++i) {
+        m_channel->sendMove(m_token, static_cast<SInt32>(i),
+                            -static_cast<SInt32>(i));
+    }
+    m_sent = true;
+}
+
+void
+MotionChannelTests::handleClientData(const Event&, void*)
+{
+    UInt8 buffer[MotionDatagram::kMaxSize];
+    NetworkAddress from;
+    UInt32 n;
+    while ((n = m_client->receiveFrom(buffer, sizeof(buffer), from)) != 0) {
+        MotionDatagram move;
+        if (!move.decode(buffer, n) || move.m_type != MotionDatagram::kMove ||
+                move.m_token != m_token || move.m_x == 0) {
+            continue;
+        }
+
+        // this checks the channel sends in order;  MotionReceiverTests
+        // checks the client drops anything stale
+        ++m_received;
+        if (m_lastSeq != 0 && !MotionDatagram::isNewer(move.m_seq, m_lastSeq)) {
+            m_ordered = false;
+            continue;
+        }
+        ++m_accepted;
+        m_lastSeq = move.m_seq;
+        m_x       = move.m_x;
+        m_y       = move.m_y;
+        if (m_x == static_cast<SInt32>(kMoves)) {
+            m_events.raiseQuitEvent();
+        }
+    }
+}
+
+// datagram socket that counts the datagrams taken from it
+class CountingDatagramSocket : public IDatagramSocket {
+public:
+    CountingDatagramSocket(IDatagramSocket* socket, UInt32* received) :
+        m_socket(socket), m_received(received) { }
+    ~CountingDatagramSocket() override { delete m_socket; }
+
+    void                sendTo(const void* buffer, UInt32 n,
+                            const NetworkAddress& address) override
+    {
+        m_socket->sendTo(buffer, n, address);
+    }
+    UInt32              receiveFrom(void* buffer, UInt32 n,
+                            NetworkAddress& address) override
+    {
+        UInt32 size = m_socket->receiveFrom(buffer, n, address);
+        if (size != 0) {
+            ++*m_received;
+        }
+        return size;
+    }
+    void                bind(const NetworkAddress& address) override
+    {
+        m_socket->bind(address);
+    }
+    void                close() override { m_socket->close(); }
+    void*               getEventTarget() const override
+    {
+        return m_socket->getEventTarget();
+    }
+
+private:
+    IDatagramSocket*    m_socket;
+    UInt32*             m_received;
+};
+
+class CountingSocketFactory : public ISocketFactory {
+public:
+    CountingSocketFactory(ISocketFactory* factory, UInt32* received) :
+        m_factory(factory), m_received(received) { }
+
+    IDataSocket*        create(IArchNetwork::EAddressFamily family) const override
+    {
+        return m_factory->create(family);
+    }
+    IListenSocket*      createListen(IArchNetwork::EAddressFamily family) const override
+    {
+        return m_factory->createListen(family);
+    }
+    IDatagramSocket*    createDatagram(IArchNetwork::EAddressFamily family) const override
+    {
+        return new CountingDatagramSocket(
+                            m_factory->createDatagram(family), m_received);
+    }
+
+private:
+    ISocketFactory*     m_factory;
+    UInt32*             m_received;
+};
+
+// records the pointer moves the server proxy forwards
+class MoveRecordingClient : public Client {
+public:
+    MoveRecordingClient(const NetworkAddress& address,
+                            ISocketFactory* socketFactory) :
+        Client(address, socketFactory) { }
+
+    void                handshakeComplete() override { }
+    void                setOptions(const OptionsList&) override { }
+    void                enter(SInt32, SInt32, UInt32,
+                            KeyModifierMask, bool) override { }
+    void                mouseMove(SInt32 x, SInt32) override
+    {
+        m_moves.push_back(x);
+    }
+
+public:
+    std::vector<SInt32> m_moves;
+};
+
+// the server end of the reliable stream.  writes to one end are read
+// from the other.
+class StreamPipe {
+public:
+    StreamPipe() : m_offset(0)
+    {
+        ON_CALL(m_server, write(_, _)).WillByDefault(Invoke(this, &StreamPipe::write));
+        ON_CALL(m_client, read(_, _)).WillByDefault(Invoke(this, &StreamPipe::read));
+    }
+
+    void                write(const void* data, UInt32 n)
+    {
+        m_data.append(static_cast<const char*>(data), n);
+    }
+
+    UInt32              read(void* data, UInt32 n)
+    {
+        if (n > m_data.size() - m_offset) {
+            n = static_cast<UInt32>(m_data.size() - m_offset);
+        }
+        memcpy(data, m_data.data() + m_offset, n);
+        m_offset += n;
+        return n;
+    }
+
+public:
+    NiceMock<MockStream> m_server;
+    NiceMock<MockStream> m_client;
+    String              m_data;
+    size_t              m_offset;
+};
+
+// a scripted server talking to a real ServerProxy:  moves arrive out of
+// order, behind a fence on the stream and from a stranger
+class MotionReceiverTests : public ::testing::Test {
+public:
+    MotionReceiverTests() :
+        m_proxy(nullptr),
+        m_server(nullptr),
+        m_stranger(nullptr),
+        m_client(nullptr),
+        m_received(0),
+        m_phase(0),
+        m_movesBeforeFence(0) { }
+
+    void                handleTimer(const Event&, void*);
+    void                handleServerData(const Event&, void*);
+    void                sendMove(IDatagramSocket* socket, UInt32 seq);
+
+public:
+    static const UInt32 kToken = 0x1234;
+
+    TestEventQueue      m_events;
+    NetworkAddress      m_serverAddress;
+    NetworkAddress      m_clientAddress;
+    StreamPipe          m_stream;
+    ServerProxy*        m_proxy;
+    UDPSocket*          m_server;
+    UDPSocket*          m_stranger;
+    MoveRecordingClient* m_client;
+    UInt32              m_received;
+    int                 m_phase;
+    size_t              m_movesBeforeFence;
+};
+
+const UInt32 MotionReceiverTests::kToken;
+
+TEST_F(MotionReceiverTests, handleMotion_stale_ignored)
+{
+    m_serverAddress = NetworkAddress(TEST_HOST, TEST_PORT);
+    m_serverAddress.resolve();
+    IArchNetwork::EAddressFamily family =
+                            ARCH->getAddrFamily(m_serverAddress.getAddress());
+
+    SocketMultiplexer multiplexer;
+    TCPSocketFactory socketFactory(&m_events, &multiplexer);
+    CountingSocketFactory countingFactory(&socketFactory, &m_received);
+
+    UDPSocket server(&m_events, &multiplexer, family);
+    server.bind(m_serverAddress);
+    m_server = &server;
+    m_events.adoptHandler(m_events.forIStream().inputReady(),
+                            server.getEventTarget(),
+                            new TMethodEventJob<MotionReceiverTests>(this,
+                                &MotionReceiverTests::handleServerData));
+    UDPSocket stranger(&m_events, &multiplexer, family);
+    m_stranger = &stranger;
+
+    // the handshake opens the motion channel, which says hello
+    MoveRecordingClient client(m_serverAddress, &countingFactory);
+    m_client = &client;
+    ServerProxy proxy(&client, &m_stream.m_client, &m_events);
+    m_proxy = &proxy;
+    OptionsList options;
+    options.push_back(kOptionMotionChannel);
+    options.push_back(kToken);
+    ProtocolUtil::write<MsgDSetOptions>(&m_stream.m_server, options);
+    ProtocolUtil::write<MsgCEnter>(&m_stream.m_server, 0, 0, 1, 0);
+    proxy.handleDataForTest();
+
+    EventQueueTimer* timer = m_events.newTimer(0.01, nullptr);
+    m_events.adoptHandler(Event::kTimer, timer,
+                            new TMethodEventJob<MotionReceiverTests>(this,
+                                &MotionReceiverTests::handleTimer));
+
+    m_events.initQuitTimeout(10);
+    m_events.loop();
+    m_events.cleanupQuitTimeout();
+
+    m_events.removeHandler(Event::kTimer, timer);
+    m_events.deleteTimer(timer);
+    m_events.removeHandler(m_events.forIStream().inputReady(),
+                            server.getEventTarget());
+
+    // 3 and 4 were overtaken by 5, 6 and 7 are behind the fence at 8
+    // and 10 came from the wrong address
+    const std::vector<SInt32>& moves = client.m_moves;
+    ASSERT_EQ(3, m_phase);
+    ASSERT_FALSE(moves.empty());
+    EXPECT_EQ(9, moves.back());
+    ASSERT_LE(1, m_movesBeforeFence);
+    EXPECT_EQ(5, moves[m_movesBeforeFence - 1]);
+    EXPECT_EQ(m_movesBeforeFence + 1, moves.size());
+    EXPECT_TRUE(std::is_sorted(moves.begin(), moves.end()));
+    for (SInt32 x : moves) {
+        EXPECT_TRUE(x == 1 || x == 2 || x == 5 || x == 9) << "moved to " << x;
+    }
+}
+
+void
+MotionReceiverTests::handleTimer(const Event&, void*)
+{
+    switch (m_phase) {
+    case 0:
+        // wait for the hello
+        if (m_clientAddress.getAddress() == nullptr) {
+            return;
+        }
+        sendMove(m_server, 1);
+        sendMove(m_server, 2);
+        sendMove(m_server, 5);
+        sendMove(m_server, 3);
+        sendMove(m_server, 4);
+        m_phase = 1;
+        break;
+
+    case 1:
+        // wait for the proxy to have taken every one
+        if (m_received < 5) {
+            return;
+        }
+        m_movesBeforeFence = m_client->m_moves.size();
+        ProtocolUtil::write<MsgDMotionSeq>(&m_stream.m_server, 8);
+        m_proxy->handleDataForTest();
+        sendMove(m_server, 6);
+        sendMove(m_server, 7);
+        sendMove(m_stranger, 10);
+        sendMove(m_server, 9);
+        m_phase = 2;
+        break;
+
+    case 2:
+        if (m_received < 9) {
+            return;
+        }
+        m_phase = 3;
+        m_events.raiseQuitEvent();
+        break;
+    }
+}
+
+void
+MotionReceiverTests::handleServerData(const Event&, void*)
+{
+    UInt8 buffer[MotionDatagram::kMaxSize];
+    NetworkAddress from;
+    UInt32 n;
+    while ((n = m_server->receiveFrom(buffer, sizeof(buffer), from)) != 0) {
+        MotionDatagram hello;
+        if (hello.decode(buffer, n) && hello.m_type == MotionDatagram::kHello &&
+                hello.m_token == kToken) {
+            m_clientAddress = from;
+        }
+    }
+}
+
+void
+MotionReceiverTests::sendMove(IDatagramSocket* socket, UInt32 seq)
+{
+    MotionDatagram move;
+    move.m_type  = MotionDatagram::kMove;
+    move.m_token = kToken;
+    move.m_seq   = seq;
+    move.m_x     = static_cast<SInt32>(seq);
+    move.m_y     = 0;
+    UInt8 buffer[MotionDatagram::kMaxSize];
+    socket->sendTo(buffer, move.encode(buffer), m_clientAddress);
+}
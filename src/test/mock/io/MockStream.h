@@ -31,6 +31,10 @@ public:
     MOCK_METHOD0(close, void());
     MOCK_METHOD2(read, UInt32(void*, UInt32));
     MOCK_METHOD2(write, void(const void*, UInt32));
+    MOCK_METHOD2(writeBuffers, void(const Buffer*, UInt32));
+    MOCK_METHOD2(writeBulk, void(const Buffer*, UInt32));
+    MOCK_METHOD0(cork, void());
+    MOCK_METHOD0(uncork, void());
     MOCK_METHOD0(flush, void());
     MOCK_METHOD0(shutdownInput, void());
     MOCK_METHOD0(shutdownOutput, void());
@@ -41,4 +45,5 @@ public:
     MOCK_CONST_METHOD0(getEventTarget, void*());
     MOCK_CONST_METHOD0(isReady, bool());
     MOCK_CONST_METHOD0(getSize, UInt32());
+    MOCK_CONST_METHOD0(hasPendingOutput, bool());
 };
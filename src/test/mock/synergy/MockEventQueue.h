@@ -30,7 +30,7 @@ public:
     MOCK_METHOD2(newTimer, EventQueueTimer*(double, void*));
     MOCK_METHOD2(getEvent, bool(Event&, double));
     MOCK_METHOD1(adoptBuffer, void(IEventQueueBuffer*));
-    MOCK_METHOD2(registerTypeOnce, Event::Type(Event::Type&, const char*));
+    MOCK_METHOD2(registerTypeOnce, Event::Type(std::atomic<Event::Type>&, const char*));
     MOCK_METHOD1(removeHandlers, void(void*));
     MOCK_METHOD1(registerType, Event::Type(const char*));
     MOCK_CONST_METHOD0(isEmpty, bool());
@@ -41,6 +41,7 @@ public:
     MOCK_METHOD1(dispatchEvent, bool(const Event&));
     MOCK_CONST_METHOD2(getHandler, IEventJob*(Event::Type, void*));
     MOCK_METHOD1(deleteTimer, void(EventQueueTimer*));
+    MOCK_METHOD2(rearmTimer, void(EventQueueTimer*, double));
     MOCK_CONST_METHOD1(getRegisteredType, Event::Type(const String&));
     MOCK_METHOD0(getSystemTarget, void*());
     MOCK_METHOD0(forClient, ClientEvents&());
@@ -0,0 +1,123 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/EventDataPool.h"
+#include "base/Event.h"
+
+#include "test/global/gtest.h"
+
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+struct TestInfo {
+    SInt32              m_x;
+    SInt32              m_y;
+};
+
+TEST(EventDataPoolTests, release_pooledBlock_reused)
+{
+    TypedEventDataPool<TestInfo> pool("TestInfo", 0, 4);
+    TestInfo* first = pool.alloc();
+    EventDataPool::release(first);
+
+    EXPECT_EQ(first, pool.alloc());
+    EXPECT_EQ(1, pool.getInUse());
+    EXPECT_EQ(1, pool.getHighWater());
+    EXPECT_EQ(0, pool.getOverflows());
+}
+
+TEST(EventDataPoolTests, alloc_exhausted_fallsBackToMalloc)
+{
+    TypedEventDataPool<TestInfo> pool("TestInfo", 0, 2);
+    std::vector<TestInfo*> infos;
+    for (int i = 0; i < 3; ++i) {
+        infos.push_back(pool.alloc());
+    }
+    EXPECT_EQ(2, pool.getInUse());
+    EXPECT_EQ(1, pool.getOverflows());
+
+    for (auto info : infos) {
+        EventDataPool::release(info);
+    }
+    EXPECT_EQ(0, pool.getInUse());
+    EXPECT_EQ(2, pool.getHighWater());
+}
+
+TEST(EventDataPoolTests, alloc_tooBig_fallsBackToMalloc)
+{
+    TypedEventDataPool<TestInfo> pool("TestInfo", 8, 2);
+    EventDataPool::release(pool.alloc(8));
+    EXPECT_EQ(0, pool.getOverflows());
+
+    EventDataPool::release(pool.alloc(9));
+    EXPECT_EQ(1, pool.getOverflows());
+    EXPECT_EQ(1, pool.getHighWater());
+}
+
+TEST(EventDataPoolTests, release_mallocData_freed)
+{
+    TypedEventDataPool<TestInfo> pool("TestInfo", 0, 2);
+    EventDataPool::release(malloc(sizeof(TestInfo)));
+    EventDataPool::release(nullptr);
+    EXPECT_EQ(0, pool.getInUse());
+}
+
+TEST(EventDataPoolTests, alloc_manyThreads_blocksNotShared)
+{
+    TypedEventDataPool<TestInfo> pool("TestInfo", 0, 64);
+    std::vector<std::thread> threads;
+    std::vector<int> failures(4, 0);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&pool, &failures, t] {
+            for (SInt32 i = 0; i < 10000; ++i) {
+                TestInfo* info = pool.alloc();
+                info->m_x = t;
+                info->m_y = i;
+                std::this_thread::yield();
+                if (info->m_x != t || info->m_y != i) {
+                    ++failures[t];
+                }
+                EventDataPool::release(info);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (auto failed : failures) {
+        EXPECT_EQ(0, failed);
+    }
+    EXPECT_EQ(0, pool.getInUse());
+    EXPECT_LE(pool.getHighWater(), 4);
+}
+
+TEST(EventDataPoolTests, setInlineData_copiedEvent_carriesData)
+{
+    TestInfo info = { 3, -4 };
+    Event event(Event::kLast);
+    event.setInlineData(&info, sizeof(info));
+
+    Event copy = event;
+    auto* data = static_cast<TestInfo*>(copy.getData());
+    EXPECT_NE(event.getData(), copy.getData());
+    EXPECT_EQ(3, data->m_x);
+    EXPECT_EQ(-4, data->m_y);
+
+    // nothing to free
+    Event::deleteData(copy);
+}
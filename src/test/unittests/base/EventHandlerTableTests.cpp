@@ -0,0 +1,90 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/EventHandlerTable.h"
+#include "base/IEventJob.h"
+
+#include "test/global/gtest.h"
+
+#include <atomic>
+#include <thread>
+
+class NullEventJob : public IEventJob {
+public:
+    virtual void        run(const Event&) { }
+};
+
+static int s_targets[64];
+
+TEST(EventHandlerTableTests, adopt_replacesAndReturnsOldHandler)
+{
+    EventHandlerTable table;
+    NullEventJob first, second;
+
+    EXPECT_EQ(nullptr, table.adopt(Event::kTimer, &s_targets[0], &first));
+    EXPECT_EQ(&first, table.adopt(Event::kTimer, &s_targets[0], &second));
+    EXPECT_EQ(&second, table.get(Event::kTimer, &s_targets[0]));
+    EXPECT_EQ(nullptr, table.get(Event::kQuit, &s_targets[0]));
+    EXPECT_EQ(nullptr, table.get(Event::kTimer, &s_targets[1]));
+}
+
+TEST(EventHandlerTableTests, removeAll_manyHandlers_onlyTargetRemoved)
+{
+    EventHandlerTable table;
+    NullEventJob jobs[64][4];
+    for (UInt32 t = 0; t < 64; ++t) {
+        for (UInt32 type = 0; type < 4; ++type) {
+            table.adopt(Event::kLast + type, &s_targets[t], &jobs[t][type]);
+        }
+    }
+
+    std::vector<IEventJob*> removed;
+    table.removeAll(&s_targets[5], removed);
+    EXPECT_EQ(4, removed.size());
+    EXPECT_EQ(&jobs[6][2], table.remove(Event::kLast + 2, &s_targets[6]));
+    EXPECT_EQ(nullptr, table.remove(Event::kLast + 2, &s_targets[6]));
+
+    for (UInt32 t = 0; t < 64; ++t) {
+        for (UInt32 type = 0; type < 4; ++type) {
+            IEventJob* expected = &jobs[t][type];
+            if (t == 5 || (t == 6 && type == 2)) {
+                expected = nullptr;
+            }
+            EXPECT_EQ(expected, table.get(Event::kLast + type, &s_targets[t]));
+        }
+    }
+}
+
+TEST(EventHandlerTableTests, get_whileChanging_alwaysSeesStableHandler)
+{
+    EventHandlerTable table;
+    NullEventJob stable, churn;
+    table.adopt(Event::kLast, &s_targets[0], &stable);
+
+    std::atomic<bool> done(false);
+    std::thread writer([&] {
+        for (UInt32 i = 0; i < 20000; ++i) {
+            table.adopt(Event::kLast, &s_targets[1 + (i & 31)], &churn);
+            table.remove(Event::kLast, &s_targets[1 + ((i + 16) & 31)]);
+        }
+        done = true;
+    });
+
+    while (!done) {
+        ASSERT_EQ(&stable, table.get(Event::kLast, &s_targets[0]));
+    }
+    writer.join();
+}
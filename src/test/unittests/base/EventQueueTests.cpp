@@ -0,0 +1,46 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/EventQueue.h"
+#include "base/EventTypes.h"
+
+#include "test/global/gtest.h"
+
+#include <thread>
+#include <vector>
+
+TEST(EventQueueTests, eventType_manyThreads_registeredOnce)
+{
+    EventQueue events;
+    std::vector<Event::Type> types(8, Event::kUnknown);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < types.size(); ++i) {
+        threads.emplace_back([&events, &types, i] {
+            types[i] = events.forIStream().inputReady();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (auto type : types) {
+        EXPECT_EQ(types[0], type);
+    }
+    EXPECT_NE(Event::kUnknown, types[0]);
+    EXPECT_STREQ("inputReady", events.getTypeName(types[0]));
+    EXPECT_EQ(types[0], events.getRegisteredType("inputReady"));
+    EXPECT_NE(types[0], events.forIStream().outputFlushed());
+}
@@ -0,0 +1,117 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/EventSlab.h"
+#include "base/SimpleEventQueueBuffer.h"
+
+#include "test/global/gtest.h"
+
+#include <thread>
+#include <vector>
+
+static int s_target;
+
+TEST(EventSlabTests, remove_returnsStoredEventOnce)
+{
+    EventSlab slab;
+    UInt32 id = slab.add(Event(Event::kLast, &s_target));
+    ASSERT_NE(EventSlab::kNoID, id);
+
+    Event event = slab.remove(id);
+    EXPECT_EQ(Event::kLast, event.getType());
+    EXPECT_EQ(&s_target, event.getTarget());
+    EXPECT_EQ(Event::kUnknown, slab.remove(id).getType());
+}
+
+TEST(EventSlabTests, add_pastFirstChunk_grows)
+{
+    EventSlab slab;
+    UInt32 initial = slab.getCapacity();
+
+    std::vector<UInt32> ids;
+    for (UInt32 i = 0; i <= initial; ++i) {
+        ids.push_back(slab.add(Event(Event::kLast)));
+    }
+    EXPECT_NE(EventSlab::kNoID, ids.back());
+    EXPECT_GT(slab.getCapacity(), initial);
+}
+
+TEST(EventSlabTests, add_full_returnsNoID)
+{
+    EventSlab slab;
+    for (UInt32 i = 0; i < EventSlab::kMaxEvents; ++i) {
+        ASSERT_LT(slab.add(Event(Event::kLast)), EventSlab::kMaxEvents);
+    }
+    EXPECT_EQ(EventSlab::kNoID, slab.add(Event(Event::kLast)));
+
+    slab.remove(7);
+    EXPECT_EQ(7, slab.add(Event(Event::kLast)));
+}
+
+TEST(SimpleEventQueueBufferTests, getEvent_manyProducers_everyIDOnceInOrder)
+{
+    static const UInt32 kThreads   = 4;
+    static const UInt32 kPerThread = 20000;
+
+    // each producer posts its own ids in order through a shared slab,
+    // the way EventQueue does
+    EventSlab slab;
+    SimpleEventQueueBuffer buffer;
+    std::vector<std::thread> producers;
+    for (UInt32 t = 0; t < kThreads; ++t) {
+        producers.emplace_back([&slab, &buffer, t] {
+            for (UInt32 i = 0; i < kPerThread; ++i) {
+                UInt32 id;
+                while ((id = slab.add(Event(Event::kLast, nullptr,
+                            reinterpret_cast<void*>(t * kPerThread + i),
+                            Event::kDontFreeData))) == EventSlab::kNoID) {
+                    std::this_thread::yield();
+                }
+                buffer.addEvent(id);
+            }
+        });
+    }
+
+    std::vector<UInt32> next(kThreads, 0);
+    Event unused;
+    for (UInt32 n = 0; n < kThreads * kPerThread; ++n) {
+        UInt32 id;
+        while (buffer.getEvent(unused, id) != IEventQueueBuffer::kUser) {
+            buffer.waitForEvent(-1.0);
+        }
+        UInt32 value = static_cast<UInt32>(reinterpret_cast<size_t>(
+                            slab.remove(id).getData()));
+        UInt32 t = value / kPerThread;
+        ASSERT_LT(t, kThreads);
+        ASSERT_EQ(next[t], value % kPerThread);
+        ++next[t];
+    }
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_TRUE(buffer.isEmpty());
+}
+
+TEST(SimpleEventQueueBufferTests, waitForEvent_empty_timesOut)
+{
+    SimpleEventQueueBuffer buffer;
+    buffer.waitForEvent(0.01);
+
+    UInt32 id;
+    Event unused;
+    EXPECT_EQ(IEventQueueBuffer::kNone, buffer.getEvent(unused, id));
+}
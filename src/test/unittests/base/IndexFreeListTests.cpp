@@ -0,0 +1,90 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/IndexFreeList.h"
+
+#include "test/global/gtest.h"
+
+#include <thread>
+#include <vector>
+
+TEST(IndexFreeListTests, pop_pushedRun_inOrderThenEmpty)
+{
+    std::atomic<UInt32> links[4];
+    for (UInt32 i = 0; i < 4; ++i) {
+        links[i].store(i + 1);
+    }
+
+    IndexFreeList list;
+    EXPECT_TRUE(list.isEmpty());
+    EXPECT_EQ(IndexFreeList::kNone, list.pop(links));
+
+    list.push(links, 1, 3);
+    list.push(links, 0, 0);
+    EXPECT_FALSE(list.isEmpty());
+    for (UInt32 i = 0; i < 4; ++i) {
+        EXPECT_EQ(i, list.pop(links));
+    }
+    EXPECT_TRUE(list.isEmpty());
+    EXPECT_EQ(IndexFreeList::kNone, list.pop(links));
+}
+
+TEST(IndexFreeListTests, pop_manyThreads_neverSharesAnIndex)
+{
+    static const UInt32 kIndices   = 64;
+    static const UInt32 kThreads   = 4;
+    static const UInt32 kPerThread = 50000;
+
+    std::atomic<UInt32> links[kIndices];
+    for (UInt32 i = 0; i < kIndices; ++i) {
+        links[i].store(i + 1);
+    }
+    IndexFreeList list;
+    list.push(links, 0, kIndices - 1);
+
+    // each index is owned by whoever popped it until it's pushed back
+    std::atomic<bool> owned[kIndices];
+    for (auto& flag : owned) {
+        flag.store(false);
+    }
+    std::atomic<bool> shared(false);
+    std::vector<std::thread> threads;
+    for (UInt32 t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&] {
+            for (UInt32 i = 0; i < kPerThread; ++i) {
+                UInt32 index = list.pop(links);
+                if (index == IndexFreeList::kNone) {
+                    continue;
+                }
+                if (owned[index].exchange(true)) {
+                    shared.store(true);
+                }
+                owned[index].store(false);
+                list.push(links, index, index);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_FALSE(shared.load());
+
+    UInt32 count = 0;
+    while (list.pop(links) != IndexFreeList::kNone) {
+        ++count;
+    }
+    EXPECT_EQ(kIndices, count);
+}
@@ -0,0 +1,95 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/TimerWheel.h"
+
+#include "test/global/gtest.h"
+
+TEST(TimerWheelTests, expire_beforeDue_nothing)
+{
+    TimerWheel wheel;
+    TimerWheel::Timer timer;
+    wheel.arm(&timer, 100.0, 0.5);
+
+    double late;
+    EXPECT_EQ(nullptr, wheel.expire(100.499, late));
+    EXPECT_EQ(&timer, wheel.expire(100.5, late));
+    EXPECT_FALSE(timer.isArmed());
+    EXPECT_EQ(0, wheel.getSize());
+}
+
+TEST(TimerWheelTests, expire_longDelay_cascadesDownAndReportsLateness)
+{
+    TimerWheel wheel;
+    TimerWheel::Timer shortTimer, longTimer;
+    wheel.arm(&longTimer, 10.0, 3600.0);
+    wheel.arm(&shortTimer, 10.0, 15.0);
+
+    double late;
+    EXPECT_EQ(nullptr, wheel.expire(24.9, late));
+    EXPECT_EQ(&shortTimer, wheel.expire(25.0, late));
+    EXPECT_EQ(nullptr, wheel.expire(3609.99, late));
+    EXPECT_EQ(&longTimer, wheel.expire(3612.0, late));
+    EXPECT_NEAR(2.0, late, 0.002);
+}
+
+TEST(TimerWheelTests, arm_armedTimer_movesExpiry)
+{
+    TimerWheel wheel;
+    TimerWheel::Timer timer;
+    wheel.arm(&timer, 0.0, 5.0);
+    wheel.arm(&timer, 4.0, 5.0);
+    EXPECT_EQ(1, wheel.getSize());
+
+    double late;
+    EXPECT_EQ(nullptr, wheel.expire(8.0, late));
+    EXPECT_EQ(&timer, wheel.expire(9.0, late));
+}
+
+TEST(TimerWheelTests, cancel_dueTimer_notReturned)
+{
+    TimerWheel wheel;
+    TimerWheel::Timer first, second;
+    wheel.arm(&first, 0.0, 1.0);
+    wheel.arm(&second, 0.0, 1.0);
+
+    double late;
+    EXPECT_EQ(&first, wheel.expire(2.0, late));
+    wheel.cancel(&second);
+    EXPECT_EQ(nullptr, wheel.expire(2.0, late));
+    EXPECT_EQ(-1.0, wheel.getTimeout(2.0));
+}
+
+TEST(TimerWheelTests, getTimeout_neverLaterThanExpiry)
+{
+    TimerWheel wheel;
+    TimerWheel::Timer timer;
+    wheel.arm(&timer, 50.0, 30.0);
+
+    // step through the wake ups the event loop would make
+    double now = 50.0;
+    double late;
+    int wakeups = 0;
+    while (wheel.expire(now, late) == nullptr) {
+        double timeout = wheel.getTimeout(now);
+        ASSERT_GT(timeout, 0.0);
+        ASSERT_LE(now + timeout, 80.001);
+        now += timeout;
+        ++wakeups;
+    }
+    EXPECT_NEAR(80.0, now, 0.002);
+    EXPECT_LE(wakeups, 4);
+}
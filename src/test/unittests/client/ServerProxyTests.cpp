@@ -0,0 +1,308 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_ENV
+
+#include "client/ServerProxy.h"
+#include "base/EventQueue.h"
+#include "client/Client.h"
+#include "core/ProtocolUtil.h"
+#include "core/protocol_types.h"
+#include "server/ClientProxy1_7.h"
+#include "test/mock/io/MockStream.h"
+#include "test/mock/server/MockServer.h"
+
+#include "test/global/gtest.h"
+
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+// records the input the server proxy forwards
+class RecordingClient : public Client {
+public:
+    virtual void        handshakeComplete() { }
+    virtual void        setOptions(const OptionsList&) { }
+    virtual void        resetOptions() { }
+    virtual void        enter(SInt32 xAbs, SInt32 yAbs, UInt32 seqNum,
+                            KeyModifierMask mask, bool)
+    {
+        record() << "enter " << xAbs << "," << yAbs << " " << seqNum
+                            << " " << mask;
+    }
+    virtual void        keyDown(KeyID id, KeyModifierMask mask,
+                            KeyButton button)
+    {
+        record() << "keyDown " << id << " " << mask << " " << button;
+    }
+    virtual void        keyRepeat(KeyID id, KeyModifierMask mask,
+                            SInt32 count, KeyButton button)
+    {
+        record() << "keyRepeat " << id << " " << mask << " " << count
+                            << " " << button;
+    }
+    virtual void        keyUp(KeyID id, KeyModifierMask mask,
+                            KeyButton button)
+    {
+        record() << "keyUp " << id << " " << mask << " " << button;
+    }
+    virtual void        mouseDown(ButtonID id)
+    {
+        record() << "mouseDown " << static_cast<int>(id);
+    }
+    virtual void        mouseUp(ButtonID id)
+    {
+        record() << "mouseUp " << static_cast<int>(id);
+    }
+    virtual void        mouseMove(SInt32 x, SInt32 y)
+    {
+        record() << "mouseMove " << x << "," << y;
+    }
+    virtual void        mouseRelativeMove(SInt32 dx, SInt32 dy)
+    {
+        record() << "mouseRelativeMove " << dx << "," << dy;
+    }
+    virtual void        mouseWheel(SInt32 xDelta, SInt32 yDelta)
+    {
+        record() << "mouseWheel " << xDelta << "," << yDelta;
+    }
+
+    std::vector<String> getCalls() const
+    {
+        std::vector<String> calls;
+        for (const auto& call : m_calls) {
+            calls.push_back(call.str());
+        }
+        return calls;
+    }
+
+private:
+    std::ostringstream& record()
+    {
+        m_calls.emplace_back();
+        return m_calls.back();
+    }
+
+private:
+    std::vector<std::ostringstream> m_calls;
+};
+
+// collects writes and serves reads from a byte string
+class WireData {
+public:
+    WireData() : m_offset(0) { }
+
+    void                write(const void* data, UInt32 n)
+    {
+        m_data.append(static_cast<const char*>(data), n);
+    }
+
+    UInt32              read(void* data, UInt32 n)
+    {
+        if (n > m_data.size() - m_offset) {
+            n = static_cast<UInt32>(m_data.size() - m_offset);
+        }
+        memcpy(data, m_data.data() + m_offset, n);
+        m_offset += n;
+        return n;
+    }
+
+    void                attach(MockStream& stream)
+    {
+        ON_CALL(stream, write(_, _)).WillByDefault(Invoke(this, &WireData::write));
+        ON_CALL(stream, read(_, _)).WillByDefault(Invoke(this, &WireData::read));
+    }
+
+public:
+    String              m_data;
+    size_t              m_offset;
+};
+
+TEST(ServerProxyTests, compactInput_fromClientProxy1_7_roundTrips)
+{
+    EventQueue events;
+    MockServer server;
+
+    // the server end.  the proxy adopts its stream.
+    WireData wire;
+    NiceMock<MockStream>* serverStream = new NiceMock<MockStream>;
+    wire.attach(*serverStream);
+    ClientProxy1_7 proxy("client", serverStream, &server, &events);
+
+    // the handshake is over once the client has its options
+    wire.m_data.clear();
+    ProtocolUtil::write<MsgDSetOptions>(serverStream, OptionsList());
+
+    proxy.enter(500, 400, 1, 0x0002, false);
+    proxy.mouseMove(510, 380);
+    proxy.keyDown(0x61, 0x0002, 38);
+    proxy.keyRepeat(0x61, 0x0002, 3, 38);
+    proxy.keyUp(0x61, 0x0002, 38);
+    proxy.mouseMove(-20, 70000);
+    proxy.mouseDown(1);
+    proxy.mouseUp(1);
+    proxy.mouseWheel(0, -120);
+    proxy.mouseRelativeMove(-5, 7);
+    proxy.mouseDown(3);
+
+    // the frame goes out once the events queued before it are handled
+    events.dispatchEvent(Event(events.forClientProxy().flushInput(), &proxy));
+
+    // the client end
+    RecordingClient client;
+    NiceMock<MockStream> clientStream;
+    WireData replies;
+    replies.attach(clientStream);
+    ON_CALL(clientStream, read(_, _)).WillByDefault(Invoke(&wire, &WireData::read));
+    ServerProxy serverProxy(&client, &clientStream, &events);
+    serverProxy.handleDataForTest();
+
+    EXPECT_EQ(wire.m_data.size(), wire.m_offset);
+    std::vector<String> expected;
+    expected.push_back("enter 500,400 1 2");
+    expected.push_back("mouseMove 510,380");
+    expected.push_back("keyDown 97 2 38");
+    expected.push_back("keyRepeat 97 2 3 38");
+    expected.push_back("keyUp 97 2 38");
+    expected.push_back("mouseMove -20,70000");
+    expected.push_back("mouseDown 1");
+    expected.push_back("mouseUp 1");
+    expected.push_back("mouseWheel 0,-120");
+    expected.push_back("mouseRelativeMove -5,7");
+    expected.push_back("mouseDown 3");
+    EXPECT_EQ(expected, client.getCalls());
+}
+
+// drives a ServerProxy that has finished its handshake
+class NoopAckTests : public ::testing::Test {
+protected:
+    NoopAckTests() :
+        m_proxy(nullptr) { }
+
+    virtual void SetUp()
+    {
+        m_wire.attach(m_server);
+        m_replies.attach(m_stream);
+        ON_CALL(m_stream, read(_, _)).WillByDefault(Invoke(&m_wire, &WireData::read));
+        m_proxy = new ServerProxy(&m_client, &m_stream, &m_events);
+    }
+
+    virtual void TearDown()
+    {
+        delete m_proxy;
+    }
+
+    // the options that end the handshake
+    void handshake(OptionsList options)
+    {
+        ProtocolUtil::write<MsgDSetOptions>(&m_server, options);
+        m_proxy->handleDataForTest();
+        m_replies.m_data.clear();
+    }
+
+    void setNoopAck(UInt32 mode)
+    {
+        OptionsList options;
+        options.push_back(kOptionNoopAck);
+        options.push_back(mode);
+        ProtocolUtil::write<MsgDSetOptions>(&m_server, options);
+    }
+
+    void mouseDown(UInt8 button)
+    {
+        ProtocolUtil::write<MsgDMouseDown>(&m_server, button);
+    }
+
+    // read everything sent so far and count the no-ops sent back
+    size_t read()
+    {
+        m_replies.m_data.clear();
+        m_proxy->handleDataForTest();
+        EXPECT_EQ(m_wire.m_data.size(), m_wire.m_offset);
+
+        size_t noops = 0;
+        for (size_t i = 0; (i = m_replies.m_data.find("CNOP", i)) != String::npos; i += 4) {
+            ++noops;
+        }
+        return noops;
+    }
+
+protected:
+    EventQueue m_events;
+    RecordingClient m_client;
+    NiceMock<MockStream> m_stream;
+    WireData m_wire;
+    WireData m_replies;
+    ServerProxy* m_proxy;
+
+    // the server end, writing to m_wire
+    NiceMock<MockStream> m_server;
+};
+
+TEST_F(NoopAckTests, message_acksEveryMessage)
+{
+    handshake(OptionsList());
+    mouseDown(1);
+    mouseDown(2);
+    mouseDown(3);
+    EXPECT_EQ(3, read());
+}
+
+TEST_F(NoopAckTests, read_acksOncePerRead)
+{
+    handshake(OptionsList());
+    setNoopAck(kNoopAckRead);
+    mouseDown(1);
+    mouseDown(2);
+    EXPECT_EQ(1, read());
+
+    mouseDown(3);
+    mouseDown(4);
+    mouseDown(5);
+    EXPECT_EQ(1, read());
+
+    // nothing to acknowledge
+    EXPECT_EQ(0, read());
+}
+
+TEST_F(NoopAckTests, none_neverAcks)
+{
+    OptionsList options;
+    options.push_back(kOptionNoopAck);
+    options.push_back(kNoopAckNone);
+    handshake(options);
+    mouseDown(1);
+    mouseDown(2);
+    EXPECT_EQ(0, read());
+}
+
+TEST_F(NoopAckTests, resetOptions_backToEveryMessage)
+{
+    OptionsList options;
+    options.push_back(kOptionNoopAck);
+    options.push_back(kNoopAckNone);
+    handshake(options);
+
+    // the reset itself is acknowledged under the new mode
+    ProtocolUtil::write<MsgCResetOptions>(&m_server);
+    mouseDown(1);
+    mouseDown(2);
+    EXPECT_EQ(3, read());
+}
@@ -0,0 +1,86 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "io/StreamBuffer.h"
+
+#include "test/global/gtest.h"
+
+#include <cstring>
+
+TEST(StreamBufferTests, peek_acrossWrites_contiguous)
+{
+    StreamBuffer buffer;
+    UInt8 data[6000];
+    for (UInt32 i = 0; i < sizeof(data); ++i) {
+        data[i] = static_cast<UInt8>(i * 7);
+    }
+
+    buffer.write(data, 3000);
+    buffer.write(data + 3000, 3000);
+    buffer.pop(100);
+
+    ASSERT_EQ(5900, buffer.getSize());
+    EXPECT_EQ(0, memcmp(data + 100, buffer.peek(5900), 5900));
+    EXPECT_EQ(nullptr, buffer.peek(0));
+}
+
+TEST(StreamBufferTests, reserve_commitPartial_appendsCommittedOnly)
+{
+    StreamBuffer buffer;
+    buffer.write("ab", 2);
+
+    char* space = static_cast<char*>(buffer.reserve(100));
+    memcpy(space, "cdefg", 5);
+    buffer.commit(3);
+
+    ASSERT_EQ(5, buffer.getSize());
+    EXPECT_EQ(0, memcmp("abcde", buffer.peek(5), 5));
+}
+
+TEST(StreamBufferTests, write_afterPops_keepsOrder)
+{
+    StreamBuffer buffer;
+    UInt32 next = 0;
+    UInt32 expected = 0;
+
+    // keep a few hundred bytes in flight so the data has to slide down
+    for (int i = 0; i < 1000; ++i) {
+        UInt8 data[97];
+        for (UInt32 j = 0; j < sizeof(data); ++j) {
+            data[j] = static_cast<UInt8>(next++);
+        }
+        buffer.write(data, sizeof(data));
+
+        UInt32 n = buffer.getSize() > 300 ? 150 : 10;
+        const UInt8* out = static_cast<const UInt8*>(buffer.peek(n));
+        for (UInt32 j = 0; j < n; ++j) {
+            ASSERT_EQ(static_cast<UInt8>(expected++), out[j]);
+        }
+        buffer.pop(n);
+    }
+    EXPECT_EQ(next - expected, buffer.getSize());
+}
+
+TEST(StreamBufferTests, pop_all_empties)
+{
+    StreamBuffer buffer;
+    buffer.write("abc", 3);
+    buffer.pop(10);
+    EXPECT_EQ(0, buffer.getSize());
+
+    buffer.write("d", 1);
+    EXPECT_EQ('d', *static_cast<const char*>(buffer.peek(1)));
+}
@@ -0,0 +1,147 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "net/EpollSocketMultiplexer.h"
+
+#if HAVE_SYS_EPOLL_H
+
+#include "arch/unix/ArchNetworkBSD.h"
+#include "mt/CondVar.h"
+#include "mt/Lock.h"
+#include "mt/Mutex.h"
+#include "net/ISocketMultiplexerJob.h"
+
+#include "test/global/gtest.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+// a socketpair with a job that counts how often it saw the first end
+// become readable
+class EpollTestSocket {
+public:
+    EpollTestSocket() : m_readable(&m_mutex, 0)
+    {
+        int fds[2];
+        socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+        m_impl.m_fd       = fds[0];
+        m_impl.m_refCount = 1;
+        m_peer            = fds[1];
+    }
+
+    ~EpollTestSocket()
+    {
+        close(m_impl.m_fd);
+        close(m_peer);
+    }
+
+    ISocket*            getKey() { return reinterpret_cast<ISocket*>(this); }
+
+    // wait for at least \c count readable runs
+    bool                waitReadable(int count, double timeout)
+    {
+        Lock lock(&m_mutex);
+        while (m_readable < count) {
+            if (!m_readable.wait(timeout)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int                 getReadable()
+    {
+        Lock lock(&m_mutex);
+        return m_readable;
+    }
+
+public:
+    class Job : public ISocketMultiplexerJob {
+    public:
+        Job(EpollTestSocket* socket, bool once) :
+            m_socket(socket), m_once(once) { }
+
+        virtual ISocketMultiplexerJob*
+                            run(bool readable, bool, bool)
+        {
+            if (readable) {
+                char c;
+                ssize_t n = read(m_socket->m_impl.m_fd, &c, 1);
+                (void)n;
+                Lock lock(&m_socket->m_mutex);
+                m_socket->m_readable = m_socket->m_readable + 1;
+                m_socket->m_readable.broadcast();
+            }
+            return m_once ? nullptr : this;
+        }
+        virtual ArchSocket  getSocket() const { return &m_socket->m_impl; }
+        virtual bool        isReadable() const { return true; }
+        virtual bool        isWritable() const { return false; }
+
+    private:
+        EpollTestSocket*    m_socket;
+        bool                m_once;
+    };
+
+    ArchSocketImpl      m_impl;
+    int                 m_peer;
+    Mutex               m_mutex;
+    CondVar<int>        m_readable;
+};
+
+}
+
+TEST(EpollSocketMultiplexerTests, addSocket_dataArrives_jobRuns)
+{
+    EpollSocketMultiplexer multiplexer;
+    EpollTestSocket socket;
+    multiplexer.addSocket(socket.getKey(),
+                            new EpollTestSocket::Job(&socket, false));
+
+    ASSERT_EQ(2, write(socket.m_peer, "ab", 2));
+
+    // level triggered, so the second byte gets its own run
+    EXPECT_TRUE(socket.waitReadable(2, 5.0));
+}
+
+TEST(EpollSocketMultiplexerTests, run_returnsNull_socketRemoved)
+{
+    EpollSocketMultiplexer multiplexer;
+    EpollTestSocket socket;
+    multiplexer.addSocket(socket.getKey(),
+                            new EpollTestSocket::Job(&socket, true));
+
+    ASSERT_EQ(2, write(socket.m_peer, "ab", 2));
+    EXPECT_TRUE(socket.waitReadable(1, 5.0));
+    EXPECT_FALSE(socket.waitReadable(2, 0.2));
+    EXPECT_EQ(1, socket.getReadable());
+}
+
+TEST(EpollSocketMultiplexerTests, removeSocket_beforeData_jobNeverRuns)
+{
+    EpollSocketMultiplexer multiplexer;
+    EpollTestSocket socket;
+    multiplexer.addSocket(socket.getKey(),
+                            new EpollTestSocket::Job(&socket, false));
+    multiplexer.removeSocket(socket.getKey());
+
+    ASSERT_EQ(1, write(socket.m_peer, "a", 1));
+    EXPECT_FALSE(socket.waitReadable(1, 0.2));
+}
+
+#endif
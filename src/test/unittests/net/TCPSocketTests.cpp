@@ -0,0 +1,116 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "net/TCPSocket.h"
+
+#if SYSAPI_UNIX
+
+#include "arch/unix/ArchNetworkBSD.h"
+#include "base/EventQueue.h"
+#include "net/SocketMultiplexer.h"
+
+#include "test/global/gtest.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+namespace {
+
+// a loopback TCP connection.  the TCPSocket gets one end and the test
+// reads what it sends from the other.
+class TCPSocketTestPeer {
+public:
+    TCPSocketTestPeer() : m_client(-1), m_peer(-1)
+    {
+        int listener = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t size = sizeof(addr);
+        bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        listen(listener, 1);
+        getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &size);
+
+        m_client = socket(AF_INET, SOCK_STREAM, 0);
+        connect(m_client, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        m_peer = accept(listener, nullptr, nullptr);
+        close(listener);
+    }
+
+    ~TCPSocketTestPeer()
+    {
+        close(m_peer);
+    }
+
+    // hands the client end to the caller, who must close it
+    ArchSocket          takeClient()
+    {
+        auto* impl       = new ArchSocketImpl;
+        impl->m_fd       = m_client;
+        impl->m_refCount = 1;
+        m_client         = -1;
+        return impl;
+    }
+
+    // read until \c size bytes arrive or nothing does for a while
+    std::string         read(size_t size)
+    {
+        std::string data;
+        while (data.size() < size) {
+            pollfd pfd = { m_peer, POLLIN, 0 };
+            if (poll(&pfd, 1, 5000) <= 0) {
+                break;
+            }
+            char buffer[64];
+            ssize_t n = recv(m_peer, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                break;
+            }
+            data.append(buffer, static_cast<size_t>(n));
+        }
+        return data;
+    }
+
+private:
+    int                 m_client;
+    int                 m_peer;
+};
+
+}
+
+TEST(TCPSocketTests, write_behindQueuedBulk_goesFirst)
+{
+    EventQueue events;
+    SocketMultiplexer multiplexer;
+    TCPSocketTestPeer peer;
+    TCPSocket socket(&events, &multiplexer, peer.takeClient());
+
+    // hold both writes back so they're queued together
+    socket.cork();
+    synergy::IStream::Buffer bulk = { "bulk", 4 };
+    socket.writeBulk(&bulk, 1);
+    socket.write("input", 5);
+    socket.uncork();
+
+    EXPECT_EQ("inputbulk", peer.read(9));
+}
+
+#endif
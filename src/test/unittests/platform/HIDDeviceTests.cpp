@@ -0,0 +1,281 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "arch/Arch.h"
+#include "platform/HIDDevice.h"
+#include "platform/HIDStats.h"
+#include "platform/IHIDSink.h"
+
+#include "test/global/gtest.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <unistd.h>
+
+namespace {
+
+//! A sink the test controls
+/*!
+Can hold the writer inside write() until released, and report the host
+busy or the gadget gone.  Records the reports it accepted.
+*/
+class ScriptedSink : public IHIDSink {
+public:
+    typedef std::vector<UInt8> Report;
+
+    ScriptedSink() :
+        m_name("scripted"),
+        m_hold(false),
+        m_holding(false),
+        m_result(kWritten),
+        m_writable(true),
+        m_openOk(true),
+        m_opens(0),
+        m_waits(0) { }
+
+    // IHIDSink overrides
+    virtual bool open()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_opens;
+        return m_openOk;
+    }
+
+    virtual EResult write(const UInt8* report, UInt32 size)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_holding = true;
+        m_changed.notify_all();
+        m_changed.wait(lock, [this] { return !m_hold; });
+        m_holding = false;
+        if (m_result == kWritten) {
+            m_reports.push_back(Report(report, report + size));
+        }
+        return m_result;
+    }
+
+    virtual bool waitWritable(double timeout)
+    {
+        bool writable;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_waits;
+            writable = m_writable;
+        }
+        if (!writable) {
+            usleep(static_cast<useconds_t>(timeout * 1000000.0));
+        }
+        return writable;
+    }
+
+    virtual bool getDescriptor(std::vector<UInt8>&) const { return false; }
+    virtual const std::string& getName() const { return m_name; }
+    virtual int getUringFd() const { return -1; }
+
+    // script
+    void hold()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_hold = true;
+    }
+
+    void release()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_hold = false;
+        m_changed.notify_all();
+    }
+
+    bool waitHolding()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_changed.wait_for(lock, std::chrono::seconds(5),
+                                  [this] { return m_holding; });
+    }
+
+    void setHost(EResult result, bool writable)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_result   = result;
+        m_writable = writable;
+    }
+
+    void setOpenOk(bool ok)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_openOk = ok;
+    }
+
+    int getOpens()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_opens;
+    }
+
+    int getWaits()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_waits;
+    }
+
+    std::vector<Report> getReports()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_reports;
+    }
+
+private:
+    std::string m_name;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    bool m_hold;
+    bool m_holding;
+    EResult m_result;
+    bool m_writable;
+    bool m_openOk;
+    int m_opens;
+    int m_waits;
+    std::vector<Report> m_reports;
+};
+
+//! A device that takes raw one byte reports
+class ByteDevice : public HIDDevice {
+public:
+    ByteDevice(IHIDSink* sink) : HIDDevice(sink, 1) { }
+
+    void send(UInt8 value) const { update(&value); }
+};
+
+// poll for up to 5 seconds
+bool
+waitFor(const std::function<bool()>& done)
+{
+    for (int i = 0; i < 5000; ++i) {
+        if (done()) {
+            return true;
+        }
+        usleep(1000);
+    }
+    return done();
+}
+
+HIDStats::Snapshot
+getStats(const HIDDevice& device)
+{
+    HIDStats::Snapshot snapshot;
+    device.getStats(snapshot);
+    return snapshot;
+}
+
+}
+
+TEST(HIDDeviceTests, update_queueOverflows_onlyNewestFollowsQueue)
+{
+    ScriptedSink* sink = new ScriptedSink;
+    ByteDevice device(sink);
+
+    // park the writer on the first report so the rest pile up
+    sink->hold();
+    device.send(0);
+    ASSERT_TRUE(sink->waitHolding());
+    for (int i = 1; i <= 100; ++i) {
+        device.send(static_cast<UInt8>(i));
+    }
+    sink->release();
+
+    // the first report, the 64 that fit in the queue, then the newest
+    ASSERT_TRUE(waitFor([sink] { return sink->getReports().size() >= 66; }));
+    usleep(50000);
+    std::vector<ScriptedSink::Report> reports = sink->getReports();
+    ASSERT_EQ(66, reports.size());
+    for (int i = 0; i <= 64; ++i) {
+        EXPECT_EQ(i, reports[i][0]);
+    }
+    EXPECT_EQ(100, reports[65][0]);
+
+    HIDStats::Snapshot stats = getStats(device);
+    EXPECT_EQ(101, stats.m_queued);
+    EXPECT_EQ(36, stats.m_collapsed);
+    EXPECT_EQ(66, stats.m_written);
+    EXPECT_EQ(0, stats.m_dropped);
+}
+
+TEST(HIDDeviceTests, send_hostStopsPolling_collapsesAndResyncsOnce)
+{
+    ScriptedSink* sink = new ScriptedSink;
+    ByteDevice device(sink);
+
+    sink->setHost(IHIDSink::kBusy, false);
+    double start = ARCH->time();
+    device.send(1);
+    ASSERT_TRUE(waitFor([&device] { return getStats(device).m_stalls == 1; }));
+    EXPECT_GE(ARCH->time() - start, 0.2);
+
+    // make sure the resync loop has been round once since these
+    // were queued before letting the host back
+    device.send(2);
+    device.send(3);
+    device.send(4);
+    int waits = sink->getWaits();
+    ASSERT_TRUE(waitFor([sink, waits] { return sink->getWaits() >= waits + 2; }));
+    EXPECT_TRUE(sink->getReports().empty());
+    sink->setHost(IHIDSink::kWritten, true);
+
+    ASSERT_TRUE(waitFor([sink] { return !sink->getReports().empty(); }));
+    usleep(50000);
+    std::vector<ScriptedSink::Report> reports = sink->getReports();
+    ASSERT_EQ(1, reports.size());
+    EXPECT_EQ(4, reports[0][0]);
+
+    HIDStats::Snapshot stats = getStats(device);
+    EXPECT_EQ(1, stats.m_stalls);
+    EXPECT_EQ(3, stats.m_dropped);
+    EXPECT_EQ(0, stats.m_failures);
+}
+
+TEST(HIDDeviceTests, send_sinkFails_reopensAndResyncsOnce)
+{
+    ScriptedSink* sink = new ScriptedSink;
+    ByteDevice device(sink);
+
+    // queue up behind a write that will fail and stay failed
+    sink->hold();
+    device.send(1);
+    ASSERT_TRUE(sink->waitHolding());
+    device.send(2);
+    device.send(3);
+    sink->setOpenOk(false);
+    sink->setHost(IHIDSink::kFailed, true);
+    sink->release();
+
+    ASSERT_TRUE(waitFor([sink] { return sink->getOpens() >= 2; }));
+    EXPECT_TRUE(sink->getReports().empty());
+    sink->setHost(IHIDSink::kWritten, true);
+    sink->setOpenOk(true);
+
+    ASSERT_TRUE(waitFor([sink] { return !sink->getReports().empty(); }));
+    usleep(50000);
+    std::vector<ScriptedSink::Report> reports = sink->getReports();
+    ASSERT_EQ(1, reports.size());
+    EXPECT_EQ(3, reports[0][0]);
+    EXPECT_EQ(3, sink->getOpens());
+
+    HIDStats::Snapshot stats = getStats(device);
+    EXPECT_EQ(1, stats.m_failures);
+    EXPECT_EQ(2, stats.m_dropped);
+    EXPECT_EQ(0, stats.m_stalls);
+}
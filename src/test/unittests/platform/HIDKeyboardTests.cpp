@@ -0,0 +1,58 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "platform/HIDKeyboard.h"
+
+#include "test/global/gtest.h"
+
+TEST(HIDKeyboardTests, getUsage_latin1_bothCasesShareUsage)
+{
+    EXPECT_EQ(0x04, HIDKeyboard::getUsage('a'));
+    EXPECT_EQ(0x04, HIDKeyboard::getUsage('A'));
+    EXPECT_EQ(0x1d, HIDKeyboard::getUsage('z'));
+    EXPECT_EQ(0x1e, HIDKeyboard::getUsage('1'));
+    EXPECT_EQ(0x1e, HIDKeyboard::getUsage('!'));
+    EXPECT_EQ(0x27, HIDKeyboard::getUsage('0'));
+    EXPECT_EQ(0x38, HIDKeyboard::getUsage('?'));
+}
+
+TEST(HIDKeyboardTests, getUsage_functionKeys_mapped)
+{
+    EXPECT_EQ(0x28, HIDKeyboard::getUsage(kKeyReturn));
+    EXPECT_EQ(0x3a, HIDKeyboard::getUsage(kKeyF1));
+    EXPECT_EQ(0x45, HIDKeyboard::getUsage(kKeyF12));
+    EXPECT_EQ(0x73, HIDKeyboard::getUsage(kKeyF24));
+    EXPECT_EQ(0x61, HIDKeyboard::getUsage(kKeyKP_9));
+    EXPECT_EQ(0x7f, HIDKeyboard::getUsage(kKeyAudioMute));
+}
+
+TEST(HIDKeyboardTests, getUsage_unmapped_returnsZero)
+{
+    EXPECT_EQ(0, HIDKeyboard::getUsage(kKeyNone));
+    EXPECT_EQ(0, HIDKeyboard::getUsage(0xe9));
+    EXPECT_EQ(0, HIDKeyboard::getUsage(kKeyAudioUp));
+    EXPECT_EQ(0, HIDKeyboard::getUsage(0x20ac));
+    EXPECT_EQ(0, HIDKeyboard::getUsage(0x1ef08));
+}
+
+TEST(HIDKeyboardTests, getModifier_modifierKeys_reportBits)
+{
+    EXPECT_EQ(0x01, HIDKeyboard::getModifier(HIDKeyboard::getUsage(kKeyControl_L)));
+    EXPECT_EQ(0x02, HIDKeyboard::getModifier(HIDKeyboard::getUsage(kKeyShift_L)));
+    EXPECT_EQ(0x40, HIDKeyboard::getModifier(HIDKeyboard::getUsage(kKeyAlt_R)));
+    EXPECT_EQ(0x80, HIDKeyboard::getModifier(HIDKeyboard::getUsage(kKeyMeta_R)));
+    EXPECT_EQ(0, HIDKeyboard::getModifier(HIDKeyboard::getUsage('a')));
+}
@@ -0,0 +1,183 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "platform/HIDReportCoalescer.h"
+
+#include "test/global/gtest.h"
+
+#include <cstring>
+
+// 3 buttons, 8-bit relative X and Y
+static const UInt8 s_relative[] = {
+    0x05, 0x01, 0x09, 0x02, 0xa1, 0x01, 0x05, 0x09, 0x19, 0x01,
+    0x29, 0x03, 0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01,
+    0x81, 0x02, 0x95, 0x01, 0x75, 0x05, 0x81, 0x03, 0x05, 0x01,
+    0x09, 0x30, 0x09, 0x31, 0x15, 0x81, 0x25, 0x7f, 0x75, 0x08,
+    0x95, 0x02, 0x81, 0x06, 0xc0
+};
+
+// 3 buttons, 16-bit absolute X and Y
+static const UInt8 s_absolute[] = {
+    0x05, 0x01, 0x09, 0x02, 0xa1, 0x01, 0x05, 0x09, 0x19, 0x01,
+    0x29, 0x03, 0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01,
+    0x81, 0x02, 0x95, 0x01, 0x75, 0x05, 0x81, 0x03, 0x05, 0x01,
+    0x09, 0x30, 0x09, 0x31, 0x15, 0x00, 0x26, 0xff, 0x7f, 0x75,
+    0x10, 0x95, 0x02, 0x81, 0x02, 0xc0
+};
+
+class HIDRelativeCoalescerTests : public ::testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        ASSERT_TRUE(m_layout.parse(s_relative, sizeof(s_relative)));
+        ASSERT_EQ(3, m_layout.getReportSize());
+        ASSERT_TRUE(m_layout.findBits(kHIDPageButton, 1, 3, m_buttons));
+        ASSERT_TRUE(m_layout.findUsage(kHIDPageGenericDesktop, kHIDUsageX, m_axes[0]));
+        ASSERT_TRUE(m_layout.findUsage(kHIDPageGenericDesktop, kHIDUsageY, m_axes[1]));
+    }
+
+    void report(UInt8* report, SInt32 buttons, SInt32 x, SInt32 y) const
+    {
+        memset(report, 0, 3);
+        HIDReportLayout::set(report, m_buttons, buttons);
+        HIDReportLayout::set(report, m_axes[0], x);
+        HIDReportLayout::set(report, m_axes[1], y);
+    }
+
+    HIDReportLayout m_layout;
+    HIDReportField m_buttons;
+    HIDReportField m_axes[2];
+};
+
+TEST_F(HIDRelativeCoalescerTests, merge_sameButtons_sumsDeltas)
+{
+    HIDRelativeCoalescer coalescer(m_buttons, m_axes, 2);
+    UInt8 pending[3], next[3];
+    report(pending, 1, 10, -20);
+    report(next, 1, 5, -7);
+
+    EXPECT_TRUE(coalescer.merge(pending, next));
+    EXPECT_EQ(1, HIDReportLayout::get(pending, m_buttons));
+    EXPECT_EQ(15, HIDReportLayout::get(pending, m_axes[0]));
+    EXPECT_EQ(-27, HIDReportLayout::get(pending, m_axes[1]));
+}
+
+TEST_F(HIDRelativeCoalescerTests, merge_buttonsDiffer_leavesPending)
+{
+    HIDRelativeCoalescer coalescer(m_buttons, m_axes, 2);
+    UInt8 pending[3], next[3], before[3];
+    report(pending, 0, 10, 10);
+    report(next, 1, 5, 5);
+    memcpy(before, pending, 3);
+
+    EXPECT_FALSE(coalescer.merge(pending, next));
+    EXPECT_EQ(0, memcmp(before, pending, 3));
+}
+
+TEST_F(HIDRelativeCoalescerTests, merge_sumOutOfRange_leavesPending)
+{
+    HIDRelativeCoalescer coalescer(m_buttons, m_axes, 2);
+    UInt8 pending[3], next[3], before[3];
+
+    // only Y overflows, X must not be touched either
+    report(pending, 0, 1, 100);
+    report(next, 0, 1, 28);
+    memcpy(before, pending, 3);
+    EXPECT_FALSE(coalescer.merge(pending, next));
+    EXPECT_EQ(0, memcmp(before, pending, 3));
+
+    report(pending, 0, -100, 0);
+    report(next, 0, -28, 0);
+    memcpy(before, pending, 3);
+    EXPECT_FALSE(coalescer.merge(pending, next));
+    EXPECT_EQ(0, memcmp(before, pending, 3));
+
+    // right up to the limits is fine
+    report(next, 0, -27, 0);
+    EXPECT_TRUE(coalescer.merge(pending, next));
+    EXPECT_EQ(-127, HIDReportLayout::get(pending, m_axes[0]));
+}
+
+TEST_F(HIDRelativeCoalescerTests, toState_zeroesAxesKeepsButtons)
+{
+    HIDRelativeCoalescer coalescer(m_buttons, m_axes, 2);
+    UInt8 state[3];
+    report(state, 5, 40, -40);
+
+    coalescer.toState(state);
+    EXPECT_EQ(5, HIDReportLayout::get(state, m_buttons));
+    EXPECT_EQ(0, HIDReportLayout::get(state, m_axes[0]));
+    EXPECT_EQ(0, HIDReportLayout::get(state, m_axes[1]));
+}
+
+class HIDAbsoluteCoalescerTests : public ::testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        ASSERT_TRUE(m_layout.parse(s_absolute, sizeof(s_absolute)));
+        ASSERT_EQ(5, m_layout.getReportSize());
+        ASSERT_TRUE(m_layout.findBits(kHIDPageButton, 1, 3, m_buttons));
+        ASSERT_TRUE(m_layout.findUsage(kHIDPageGenericDesktop, kHIDUsageX, m_x));
+        ASSERT_TRUE(m_layout.findUsage(kHIDPageGenericDesktop, kHIDUsageY, m_y));
+    }
+
+    void report(UInt8* report, SInt32 buttons, SInt32 x, SInt32 y) const
+    {
+        memset(report, 0, 5);
+        HIDReportLayout::set(report, m_buttons, buttons);
+        HIDReportLayout::set(report, m_x, x);
+        HIDReportLayout::set(report, m_y, y);
+    }
+
+    HIDReportLayout m_layout;
+    HIDReportField m_buttons;
+    HIDReportField m_x;
+    HIDReportField m_y;
+};
+
+TEST_F(HIDAbsoluteCoalescerTests, merge_sameButtons_keepsNewest)
+{
+    HIDAbsoluteCoalescer coalescer(m_buttons, 5);
+    UInt8 pending[5], next[5];
+    report(pending, 2, 100, 200);
+    report(next, 2, 30000, 7);
+
+    EXPECT_TRUE(coalescer.merge(pending, next));
+    EXPECT_EQ(0, memcmp(next, pending, 5));
+}
+
+TEST_F(HIDAbsoluteCoalescerTests, merge_buttonsDiffer_leavesPending)
+{
+    HIDAbsoluteCoalescer coalescer(m_buttons, 5);
+    UInt8 pending[5], next[5], before[5];
+    report(pending, 2, 100, 200);
+    report(next, 0, 100, 200);
+    memcpy(before, pending, 5);
+
+    EXPECT_FALSE(coalescer.merge(pending, next));
+    EXPECT_EQ(0, memcmp(before, pending, 5));
+}
+
+TEST_F(HIDAbsoluteCoalescerTests, toState_keepsPosition)
+{
+    HIDAbsoluteCoalescer coalescer(m_buttons, 5);
+    UInt8 state[5], before[5];
+    report(state, 1, 1234, 4321);
+    memcpy(before, state, 5);
+
+    coalescer.toState(state);
+    EXPECT_EQ(0, memcmp(before, state, 5));
+}
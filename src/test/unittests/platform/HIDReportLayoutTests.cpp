@@ -0,0 +1,239 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "platform/HIDReportLayout.h"
+
+#include "test/global/gtest.h"
+
+// relative mouse from hid/hid.sh:  3 buttons, 16-bit X, Y and wheel
+static const UInt8 s_mouse[] = {
+    0x05, 0x01, 0x09, 0x02, 0xa1, 0x01, 0x09, 0x01, 0xa1, 0x00,
+    0x05, 0x09, 0x19, 0x01, 0x29, 0x03, 0x15, 0x00, 0x25, 0x01,
+    0x95, 0x03, 0x75, 0x01, 0x81, 0x02, 0x95, 0x01, 0x75, 0x05,
+    0x81, 0x03, 0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x38,
+    0x16, 0x01, 0x80, 0x26, 0xff, 0x7f, 0x75, 0x10, 0x95, 0x03,
+    0x81, 0x06, 0xc0, 0xc0
+};
+
+// boot keyboard from hid/hid.sh
+static const UInt8 s_keyboard[] = {
+    0x05, 0x01, 0x09, 0x06, 0xa1, 0x01, 0x05, 0x07, 0x19, 0xe0,
+    0x29, 0xe7, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x08,
+    0x81, 0x02, 0x95, 0x01, 0x75, 0x08, 0x81, 0x03, 0x95, 0x05,
+    0x75, 0x01, 0x05, 0x08, 0x19, 0x01, 0x29, 0x05, 0x91, 0x02,
+    0x95, 0x01, 0x75, 0x03, 0x91, 0x03, 0x95, 0x06, 0x75, 0x08,
+    0x15, 0x00, 0x25, 0x65, 0x05, 0x07, 0x19, 0x00, 0x29, 0x65,
+    0x81, 0x00, 0xc0
+};
+
+// 8-bit relative X and Y in report 2, after 5 buttons
+static const UInt8 s_reportID[] = {
+    0x05, 0x01, 0x09, 0x02, 0xa1, 0x01, 0x85, 0x02, 0x05, 0x09,
+    0x19, 0x01, 0x29, 0x05, 0x15, 0x00, 0x25, 0x01, 0x95, 0x05,
+    0x75, 0x01, 0x81, 0x02, 0x95, 0x03, 0x81, 0x03, 0x05, 0x01,
+    0x09, 0x30, 0x09, 0x31, 0x15, 0x81, 0x25, 0x7f, 0x75, 0x08,
+    0x95, 0x02, 0x81, 0x06, 0xc0
+};
+
+TEST(HIDReportLayoutTests, parse_mouse_fieldsAtHandCodedOffsets)
+{
+    HIDReportLayout layout;
+    ASSERT_TRUE(layout.parse(s_mouse, sizeof(s_mouse)));
+
+    HIDReportField buttons, x, y, wheel;
+    ASSERT_TRUE(layout.findBits(kHIDPageButton, 1, 3, buttons));
+    ASSERT_TRUE(layout.findUsage(kHIDPageGenericDesktop, kHIDUsageX, x));
+    ASSERT_TRUE(layout.findUsage(kHIDPageGenericDesktop, kHIDUsageY, y));
+    ASSERT_TRUE(layout.findUsage(kHIDPageGenericDesktop, kHIDUsageWheel, wheel));
+
+    EXPECT_EQ(7, layout.getReportSize());
+    EXPECT_EQ(0, layout.getReportID());
+    EXPECT_EQ(0, buttons.m_bitOffset);
+    EXPECT_EQ(3, buttons.m_bitSize);
+    EXPECT_EQ(8, x.m_bitOffset);
+    EXPECT_EQ(24, y.m_bitOffset);
+    EXPECT_EQ(40, wheel.m_bitOffset);
+    EXPECT_EQ(-0x7fff, x.m_logicalMin);
+    EXPECT_EQ(0x7fff, x.m_logicalMax);
+    EXPECT_TRUE(x.m_relative);
+    EXPECT_EQ(HIDReportField::kPackWord, x.m_packing);
+}
+
+TEST(HIDReportLayoutTests, set_signedWord_littleEndianAndClamped)
+{
+    HIDReportLayout layout;
+    ASSERT_TRUE(layout.parse(s_mouse, sizeof(s_mouse)));
+    HIDReportField x, y;
+    layout.findUsage(kHIDPageGenericDesktop, kHIDUsageX, x);
+    layout.findUsage(kHIDPageGenericDesktop, kHIDUsageY, y);
+
+    UInt8 report[7];
+    layout.clear(report);
+    HIDReportLayout::set(report, x, -2);
+    HIDReportLayout::set(report, y, 100000);
+
+    EXPECT_EQ(0xfe, report[1]);
+    EXPECT_EQ(0xff, report[2]);
+    EXPECT_EQ(0xff, report[3]);
+    EXPECT_EQ(0x7f, report[4]);
+    EXPECT_EQ(-2, HIDReportLayout::get(report, x));
+    EXPECT_EQ(0x7fff, HIDReportLayout::get(report, y));
+}
+
+TEST(HIDReportLayoutTests, parse_keyboard_modifiersAndKeyArray)
+{
+    HIDReportLayout layout;
+    ASSERT_TRUE(layout.parse(s_keyboard, sizeof(s_keyboard)));
+
+    HIDReportField modifiers, keys;
+    ASSERT_TRUE(layout.findBits(kHIDPageKeyboard, 0xe0, 0xe7, modifiers));
+    ASSERT_TRUE(layout.findArray(kHIDPageKeyboard, keys));
+
+    // the LED output report doesn't count towards the input report
+    EXPECT_EQ(8, layout.getReportSize());
+    EXPECT_EQ(HIDReportField::kPackByte, modifiers.m_packing);
+    EXPECT_EQ(16, keys.m_bitOffset);
+    EXPECT_EQ(6, keys.m_count);
+    EXPECT_EQ(0x65, keys.m_usageMax);
+}
+
+TEST(HIDReportLayoutTests, setSlot_outOfRange_storesNoKey)
+{
+    HIDReportLayout layout;
+    ASSERT_TRUE(layout.parse(s_keyboard, sizeof(s_keyboard)));
+    HIDReportField keys;
+    layout.findArray(kHIDPageKeyboard, keys);
+
+    UInt8 report[8];
+    layout.clear(report);
+    HIDReportLayout::setSlot(report, keys, 0, 0x04);
+    HIDReportLayout::setSlot(report, keys, 1, 0x68);
+
+    EXPECT_EQ(0x04, report[2]);
+    EXPECT_EQ(0x00, report[3]);
+}
+
+TEST(HIDReportLayoutTests, parse_reportID_prefixesReport)
+{
+    HIDReportLayout layout;
+    ASSERT_TRUE(layout.parse(s_reportID, sizeof(s_reportID)));
+
+    HIDReportField buttons, x;
+    ASSERT_TRUE(layout.findBits(kHIDPageButton, 1, 5, buttons));
+    ASSERT_TRUE(layout.findUsage(kHIDPageGenericDesktop, kHIDUsageX, x));
+
+    EXPECT_EQ(2, layout.getReportID());
+    EXPECT_EQ(4, layout.getReportSize());
+    EXPECT_EQ(8, buttons.m_bitOffset);
+    EXPECT_EQ(16, x.m_bitOffset);
+
+    UInt8 report[4];
+    layout.clear(report);
+    HIDReportLayout::set(report, buttons, 0x11);
+    HIDReportLayout::set(report, x, -1);
+    EXPECT_EQ(2, report[0]);
+    EXPECT_EQ(0x11, report[1]);
+    EXPECT_EQ(0xff, report[2]);
+}
+
+TEST(HIDReportLayoutTests, parse_truncated_fails)
+{
+    HIDReportLayout layout;
+    EXPECT_FALSE(layout.parse(s_mouse, 41));
+}
+
+// one bit variable input with a Report Count of 0xffffffff
+static const UInt8 s_hugeCount[] = {
+    0x05, 0x01, 0x09, 0x02, 0xa1, 0x01, 0x05, 0x09, 0x19, 0x01,
+    0x29, 0x03, 0x75, 0x01, 0x97, 0xff, 0xff, 0xff, 0xff, 0x81,
+    0x02, 0xc0
+};
+
+TEST(HIDReportLayoutTests, parse_hugeReportCount_failsWithoutFields)
+{
+    HIDReportLayout layout;
+    EXPECT_FALSE(layout.parse(s_hugeCount, sizeof(s_hugeCount)));
+}
+
+// the same with a Report Size of 0, so the total is 0 bits
+static const UInt8 s_hugeCountNoSize[] = {
+    0x05, 0x01, 0x09, 0x02, 0xa1, 0x01, 0x05, 0x09, 0x19, 0x01,
+    0x29, 0x03, 0x75, 0x00, 0x97, 0xff, 0xff, 0xff, 0xff, 0x81,
+    0x02, 0xc0
+};
+
+TEST(HIDReportLayoutTests, parse_hugeReportCountNoSize_failsWithoutFields)
+{
+    HIDReportLayout layout;
+    EXPECT_FALSE(layout.parse(s_hugeCountNoSize, sizeof(s_hugeCountNoSize)));
+}
+
+// one 64 bit button field:  fits in a report but not in a field
+static const UInt8 s_wideField[] = {
+    0x05, 0x01, 0x09, 0x02, 0xa1, 0x01, 0x05, 0x09, 0x09, 0x01,
+    0x75, 0x40, 0x95, 0x01, 0x81, 0x02, 0xc0
+};
+
+TEST(HIDReportLayoutTests, parse_reportSizeOver32_fails)
+{
+    HIDReportLayout layout;
+    EXPECT_FALSE(layout.parse(s_wideField, sizeof(s_wideField)));
+}
+
+// n-key rollover keyboard from hid/hid.sh:  LEDs out, usages 0x00-0xe7 in
+static const UInt8 s_nkro[] = {
+    0x05, 0x01, 0x09, 0x06, 0xa1, 0x01, 0x05, 0x08, 0x19, 0x01,
+    0x29, 0x05, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x05,
+    0x91, 0x02, 0x95, 0x01, 0x75, 0x03, 0x91, 0x03, 0x05, 0x07,
+    0x19, 0x00, 0x29, 0xe7, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01,
+    0x95, 0xe8, 0x81, 0x02, 0xc0
+};
+
+TEST(HIDReportLayoutTests, findBitmap_nkro_bitPerUsage)
+{
+    HIDReportLayout layout;
+    ASSERT_TRUE(layout.parse(s_nkro, sizeof(s_nkro)));
+
+    HIDReportField keys, modifiers;
+    ASSERT_TRUE(layout.findBitmap(kHIDPageKeyboard, 0x00, 0xdf, keys));
+    ASSERT_TRUE(layout.findBits(kHIDPageKeyboard, 0xe0, 0xe7, modifiers));
+    EXPECT_EQ(29, layout.getReportSize());
+    EXPECT_EQ(0xe0, keys.m_count);
+    EXPECT_EQ(224, modifiers.m_bitOffset);
+    EXPECT_EQ(HIDReportField::kPackByte, modifiers.m_packing);
+
+    UInt8 report[29];
+    layout.clear(report);
+    HIDReportLayout::setFlag(report, keys, 0x04, true);
+    HIDReportLayout::setFlag(report, keys, 0x1d, true);
+    HIDReportLayout::setFlag(report, keys, 0x73, true);
+    HIDReportLayout::setFlag(report, keys, 0x1d, false);
+    HIDReportLayout::setFlag(report, keys, 0xe0, true);
+
+    EXPECT_EQ(0x10, report[0]);
+    EXPECT_EQ(0x00, report[3]);
+    EXPECT_EQ(0x08, report[14]);
+    EXPECT_EQ(0x00, report[28]);
+}
+
+TEST(HIDReportLayoutTests, findBitmap_bootKeyboard_fails)
+{
+    HIDReportLayout layout;
+    ASSERT_TRUE(layout.parse(s_keyboard, sizeof(s_keyboard)));
+
+    HIDReportField keys;
+    EXPECT_FALSE(layout.findBitmap(kHIDPageKeyboard, 0x00, 0xdf, keys));
+}
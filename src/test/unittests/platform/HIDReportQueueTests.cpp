@@ -0,0 +1,123 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "platform/HIDReportQueue.h"
+
+#include "test/global/gtest.h"
+
+#include <thread>
+
+TEST(HIDReportQueueTests, push_full_failsUntilPopped)
+{
+    HIDReportQueue queue(2, 3);
+    const UInt8 report[] = { 1, 2 };
+    UInt8 out[2];
+    double time;
+
+    // capacity rounds up to 4
+    EXPECT_TRUE(queue.isEmpty());
+    EXPECT_FALSE(queue.pop(out, time));
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.push(report, i));
+    }
+    EXPECT_EQ(4, queue.getSize());
+    EXPECT_FALSE(queue.push(report, 4.0));
+
+    EXPECT_TRUE(queue.pop(out, time));
+    EXPECT_TRUE(queue.push(report, 4.0));
+    EXPECT_FALSE(queue.push(report, 5.0));
+}
+
+TEST(HIDReportQueueTests, pop_wrapsAround_reportsAndTimesInOrder)
+{
+    HIDReportQueue queue(3, 4);
+    UInt8 report[3];
+    double time;
+
+    // go round the ring a few times with it never quite full
+    UInt8 next = 0;
+    UInt8 expected = 0;
+    for (int round = 0; round < 5; ++round) {
+        for (int i = 0; i < 3; ++i, ++next) {
+            const UInt8 in[] = { next, static_cast<UInt8>(next + 1), 0xff };
+            ASSERT_TRUE(queue.push(in, next * 0.5));
+        }
+        for (int i = 0; i < 3; ++i, ++expected) {
+            ASSERT_TRUE(queue.pop(report, time));
+            EXPECT_EQ(expected, report[0]);
+            EXPECT_EQ(expected + 1, report[1]);
+            EXPECT_EQ(0xff, report[2]);
+            EXPECT_EQ(expected * 0.5, time);
+        }
+        EXPECT_TRUE(queue.isEmpty());
+    }
+}
+
+TEST(HIDReportQueueTests, peek_thenDiscard_skipsOldest)
+{
+    HIDReportQueue queue(1, 4);
+    const UInt8 first[]  = { 1 };
+    const UInt8 second[] = { 2 };
+    UInt8 out[1];
+    double time;
+
+    EXPECT_EQ(nullptr, queue.peek());
+    queue.push(first, 1.0);
+    queue.push(second, 2.0);
+
+    const UInt8* oldest = queue.peek();
+    ASSERT_NE(nullptr, oldest);
+    EXPECT_EQ(1, oldest[0]);
+    EXPECT_EQ(2, queue.getSize());
+
+    queue.discard();
+    ASSERT_TRUE(queue.pop(out, time));
+    EXPECT_EQ(2, out[0]);
+    EXPECT_EQ(2.0, time);
+    EXPECT_EQ(nullptr, queue.peek());
+}
+
+TEST(HIDReportQueueTests, pop_otherThread_everyReportOnceInOrder)
+{
+    static const UInt32 kReports = 100000;
+
+    HIDReportQueue queue(4, 16);
+    std::thread producer([&queue] {
+        for (UInt32 i = 0; i < kReports; ++i) {
+            const UInt8 report[] = {
+                static_cast<UInt8>(i), static_cast<UInt8>(i >> 8),
+                static_cast<UInt8>(i >> 16), static_cast<UInt8>(i >> 24)
+            };
+            while (!queue.push(report, i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    UInt8 report[4];
+    double time;
+    for (UInt32 i = 0; i < kReports; ++i) {
+        while (!queue.pop(report, time)) {
+            std::this_thread::yield();
+        }
+        UInt32 value = report[0] | (report[1] << 8) |
+                       (report[2] << 16) | (static_cast<UInt32>(report[3]) << 24);
+        ASSERT_EQ(i, value);
+        ASSERT_EQ(static_cast<double>(i), time);
+    }
+    producer.join();
+    EXPECT_TRUE(queue.isEmpty());
+}
@@ -0,0 +1,76 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "platform/HIDSink.h"
+#include "platform/HIDMouse.h"
+
+#include "test/global/gtest.h"
+
+#include <cstdlib>
+#include <sys/stat.h>
+#include <unistd.h>
+
+TEST(HIDSinkTests, memory_write_recordsReports)
+{
+    HIDMemorySink sink("test", 2);
+    const UInt8 first[]  = { 1, 2, 3 };
+    const UInt8 second[] = { 4, 5, 6 };
+
+    ASSERT_TRUE(sink.open());
+    EXPECT_EQ(IHIDSink::kWritten, sink.write(first, 3));
+    EXPECT_EQ(IHIDSink::kWritten, sink.write(second, 3));
+    EXPECT_EQ(IHIDSink::kWritten, sink.write(first, 3));
+
+    HIDMemorySink::RecordList records;
+    sink.getRecords(records);
+    ASSERT_EQ(2, records.size());
+    EXPECT_EQ(3, sink.getCount());
+    EXPECT_EQ(4, records[1].m_report[0]);
+    EXPECT_LE(records[0].m_time, records[1].m_time);
+}
+
+TEST(HIDSinkTests, pipe_open_noReader_fails)
+{
+    char dir[] = "/tmp/hidsinkXXXXXX";
+    ASSERT_TRUE(mkdtemp(dir) != nullptr);
+    std::string path = std::string(dir) + "/hidg";
+    ASSERT_EQ(0, mkfifo(path.c_str(), 0600));
+
+    HIDPipeSink sink(path);
+    std::vector<UInt8> descriptor;
+    EXPECT_FALSE(sink.open());
+    EXPECT_FALSE(sink.getDescriptor(descriptor));
+
+    unlink(path.c_str());
+    rmdir(dir);
+}
+
+TEST(HIDSinkTests, memory_mouse_reportsReachSink)
+{
+    HIDMemorySink* sink = new HIDMemorySink("mouse");
+    HIDMouse mouse(sink);
+    mouse.relativeMove(5, -3);
+
+    for (int i = 0; i < 100 && sink->getCount() == 0; ++i) {
+        usleep(1000);
+    }
+
+    HIDMemorySink::RecordList records;
+    sink->getRecords(records);
+    ASSERT_EQ(1, records.size());
+    ASSERT_EQ(7, records[0].m_report.size());
+    EXPECT_EQ(5, records[0].m_report[1]);
+    EXPECT_EQ(0xfd, records[0].m_report[3]);
+}
@@ -0,0 +1,68 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "platform/HIDStats.h"
+#include "platform/HIDMouse.h"
+#include "platform/HIDSink.h"
+
+#include "test/global/gtest.h"
+
+#include <unistd.h>
+
+TEST(HIDStatsTests, written_latency_logBuckets)
+{
+    HIDStats stats;
+    for (int i = 0; i < 99; ++i) {
+        // 100us queued, 10us writing
+        stats.written(1.0, 1.00009, 1.0001);
+    }
+    stats.written(1.0, 1.0, 1.5);
+
+    HIDStats::Snapshot snapshot;
+    stats.getSnapshot(snapshot);
+    EXPECT_EQ(100, snapshot.m_written);
+    EXPECT_EQ(100, snapshot.m_latency.getCount());
+    EXPECT_EQ(99, snapshot.m_latency.m_buckets[6]);
+    EXPECT_EQ(1, snapshot.m_latency.m_buckets[18]);
+    EXPECT_DOUBLE_EQ(128.0e-6, snapshot.m_latency.getPercentile(50.0));
+    EXPECT_DOUBLE_EQ(0.5, snapshot.m_latency.getPercentile(99.0));
+    EXPECT_DOUBLE_EQ(0.5, snapshot.m_writeTime.m_max);
+}
+
+TEST(HIDStatsTests, getPercentile_noSamples_zero)
+{
+    HIDStats::Histogram histogram;
+    EXPECT_EQ(0, histogram.getCount());
+    EXPECT_EQ(0.0, histogram.getPercentile(99.0));
+}
+
+TEST(HIDStatsTests, memory_mouse_countsReports)
+{
+    HIDMemorySink* sink = new HIDMemorySink("mouse");
+    HIDMouse mouse(sink);
+    mouse.relativeMove(1, 1);
+    mouse.relativeMove(2, 2);
+
+    for (int i = 0; i < 100 && sink->getCount() < 2; ++i) {
+        usleep(1000);
+    }
+
+    HIDStats::Snapshot snapshot;
+    mouse.getStats(snapshot);
+    EXPECT_EQ(2, snapshot.m_queued);
+    EXPECT_EQ(snapshot.m_written + snapshot.m_coalesced, 2);
+    EXPECT_EQ(snapshot.m_written, snapshot.m_latency.getCount());
+    EXPECT_EQ(0, snapshot.m_stalls);
+}
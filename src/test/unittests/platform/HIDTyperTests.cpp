@@ -0,0 +1,143 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "platform/HIDKeyboard.h"
+#include "platform/HIDSink.h"
+
+#include "test/global/gtest.h"
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// a fifo stands in for the gadget.  pipes have no report descriptor so
+// the keyboard uses its built-in boot protocol one.
+class HIDTyperTests : public ::testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        char dir[] = "/tmp/hidtyperXXXXXX";
+        ASSERT_TRUE(mkdtemp(dir) != nullptr);
+        m_dir  = dir;
+        m_path = m_dir + "/hidg";
+        ASSERT_EQ(0, mkfifo(m_path.c_str(), 0600));
+        m_fd = open(m_path.c_str(), O_RDONLY | O_NONBLOCK);
+        ASSERT_NE(-1, m_fd);
+        fcntl(m_fd, F_SETFL, 0);
+    }
+
+    virtual void TearDown()
+    {
+        close(m_fd);
+        unlink(m_path.c_str());
+        rmdir(m_dir.c_str());
+    }
+
+    // read the next report and return its modifiers and first key
+    void readReport(UInt8& modifier, UInt8& usage)
+    {
+        UInt8 report[8];
+        ASSERT_EQ(8, read(m_fd, report, sizeof(report)));
+        modifier = report[0];
+        usage    = report[2];
+    }
+
+    // check nothing else has been written
+    bool isIdle()
+    {
+        struct pollfd pfd = { m_fd, POLLIN, 0 };
+        return poll(&pfd, 1, 100) == 0;
+    }
+
+protected:
+    std::string m_dir;
+    std::string m_path;
+    int m_fd;
+};
+
+TEST_F(HIDTyperTests, typeText_pipelinesKeysAndReleasesRepeats)
+{
+    HIDKeyboard keyboard(new HIDPipeSink(m_path));
+    EXPECT_EQ(4, keyboard.typeText("abbA"));
+
+    static const UInt8 expected[][2] = {
+        { 0x00, 0x04 },     // a
+        { 0x00, 0x05 },     // b, releasing a
+        { 0x00, 0x00 },     // release b before pressing it again
+        { 0x00, 0x05 },     // b
+        { 0x02, 0x00 },     // shift on its own
+        { 0x02, 0x04 },     // A
+        { 0x00, 0x00 }      // all up
+    };
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) {
+        UInt8 modifier, usage;
+        readReport(modifier, usage);
+        EXPECT_EQ(expected[i][0], modifier) << "report " << i;
+        EXPECT_EQ(expected[i][1], usage) << "report " << i;
+    }
+}
+
+TEST_F(HIDTyperTests, typeText_untypeable_skipped)
+{
+    HIDKeyboard keyboard(new HIDPipeSink(m_path));
+    EXPECT_EQ(2, keyboard.typeText("\xc3\xa9x\n"));
+
+    UInt8 modifier, usage;
+    readReport(modifier, usage);
+    EXPECT_EQ(0x1b, usage);
+    readReport(modifier, usage);
+    EXPECT_EQ(0x28, usage);
+    readReport(modifier, usage);
+    EXPECT_EQ(0x00, usage);
+}
+
+TEST_F(HIDTyperTests, typeText_liveKeysHeld_waitsForRelease)
+{
+    HIDKeyboard keyboard(new HIDPipeSink(m_path));
+    UInt8 modifier, usage;
+
+    // typing mustn't release the user's shift or be shifted by it
+    keyboard.pressKey(kKeyShift_L);
+    EXPECT_EQ(2, keyboard.typeText("ab"));
+    readReport(modifier, usage);
+    EXPECT_EQ(0x02, modifier);
+    EXPECT_EQ(0x00, usage);
+    EXPECT_TRUE(isIdle());
+
+    // a key pressed as well still holds the typing back
+    keyboard.pressKey('x');
+    readReport(modifier, usage);
+    EXPECT_EQ(0x02, modifier);
+    EXPECT_EQ(0x1b, usage);
+    EXPECT_TRUE(isIdle());
+
+    keyboard.releaseKey('x');
+    keyboard.releaseKey(kKeyShift_L);
+    static const UInt8 expected[][2] = {
+        { 0x02, 0x00 },     // x up
+        { 0x00, 0x00 },     // shift up
+        { 0x00, 0x04 },     // a
+        { 0x00, 0x05 },     // b
+        { 0x00, 0x00 }      // all up
+    };
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) {
+        readReport(modifier, usage);
+        EXPECT_EQ(expected[i][0], modifier) << "report " << i;
+        EXPECT_EQ(expected[i][1], usage) << "report " << i;
+    }
+    EXPECT_TRUE(isIdle());
+}
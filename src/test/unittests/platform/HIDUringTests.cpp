@@ -0,0 +1,208 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "platform/HIDDevice.h"
+#include "platform/HIDSink.h"
+#include "platform/HIDStats.h"
+#include "platform/HIDUring.h"
+
+#include "test/global/gtest.h"
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <functional>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// these run through write() if io_uring isn't available, and must
+// behave the same
+
+namespace {
+
+class ByteDevice : public HIDDevice {
+public:
+    ByteDevice(IHIDSink* sink) : HIDDevice(sink, 1) { }
+
+    void send(UInt8 value) const { update(&value); }
+};
+
+// poll for up to 5 seconds
+bool
+waitFor(const std::function<bool()>& done)
+{
+    for (int i = 0; i < 5000; ++i) {
+        if (done()) {
+            return true;
+        }
+        usleep(1000);
+    }
+    return done();
+}
+
+HIDStats::Snapshot
+getStats(const HIDDevice& device)
+{
+    HIDStats::Snapshot snapshot;
+    device.getStats(snapshot);
+    return snapshot;
+}
+
+// read until \c count bytes have arrived or nothing has for a second
+void
+readBytes(int fd, std::vector<UInt8>& bytes, size_t count)
+{
+    UInt8 buffer[4096];
+    while (bytes.size() < count) {
+        struct pollfd pfd;
+        pfd.fd      = fd;
+        pfd.events  = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, 1000) <= 0) {
+            return;
+        }
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            return;
+        }
+        bytes.insert(bytes.end(), buffer, buffer + n);
+    }
+}
+
+}
+
+//! Named pipes standing in for the gadgets, each with a reader
+class HIDUringTests : public ::testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        strcpy(m_dir, "/tmp/hiduringXXXXXX");
+        ASSERT_TRUE(mkdtemp(m_dir) != nullptr);
+    }
+
+    virtual void TearDown()
+    {
+        for (size_t i = 0; i < m_paths.size(); ++i) {
+            close(m_readers[i]);
+            unlink(m_paths[i].c_str());
+        }
+        rmdir(m_dir);
+    }
+
+    // make a pipe and open its read end without blocking
+    std::string makePipe()
+    {
+        std::string path = std::string(m_dir) + "/hidg" +
+                            static_cast<char>('0' + m_paths.size());
+        EXPECT_EQ(0, mkfifo(path.c_str(), 0600));
+        m_paths.push_back(path);
+        m_readers.push_back(open(path.c_str(), O_RDONLY | O_NONBLOCK));
+        EXPECT_NE(-1, m_readers.back());
+        return path;
+    }
+
+protected:
+    char                m_dir[32];
+    std::vector<std::string> m_paths;
+    std::vector<int>    m_readers;
+};
+
+TEST_F(HIDUringTests, send_threeDevices_shareRingAndRecordLatency)
+{
+    HIDUring* uring = HIDUring::acquire();
+    HIDPipeSink* sinks[3];
+    ByteDevice* devices[3];
+    for (int i = 0; i < 3; ++i) {
+        sinks[i]   = new HIDPipeSink(makePipe(), true);
+        devices[i] = new ByteDevice(sinks[i]);
+        EXPECT_EQ(uring != nullptr, sinks[i]->getUringFd() != -1);
+    }
+    EXPECT_EQ(uring, HIDUring::acquire());
+    if (uring != nullptr) {
+        HIDUring::release(uring);
+        HIDUring::release(uring);
+    }
+
+    for (UInt8 value = 1; value <= 10; ++value) {
+        for (int i = 0; i < 3; ++i) {
+            devices[i]->send(static_cast<UInt8>(value + 10 * i));
+        }
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        std::vector<UInt8> bytes;
+        readBytes(m_readers[i], bytes, 10);
+        ASSERT_EQ(10, bytes.size());
+        for (UInt8 value = 1; value <= 10; ++value) {
+            EXPECT_EQ(value + 10 * i, bytes[value - 1]);
+        }
+
+        const HIDDevice* device = devices[i];
+        ASSERT_TRUE(waitFor([device] { return getStats(*device).m_written == 10; }));
+        HIDStats::Snapshot stats = getStats(*device);
+        EXPECT_EQ(10, stats.m_latency.getCount());
+        EXPECT_EQ(10, stats.m_writeTime.getCount());
+        EXPECT_EQ(0, stats.m_stalls);
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        delete devices[i];
+    }
+}
+
+TEST_F(HIDUringTests, send_hostStopsPolling_resyncsOnce)
+{
+    std::string path = makePipe();
+    int reader = m_readers.back();
+
+    // fill the pipe so the next report waits for the host
+    int filler = open(path.c_str(), O_WRONLY | O_NONBLOCK);
+    ASSERT_NE(-1, filler);
+    const UInt8 block[4096] = { };
+    size_t filled = 0;
+    ssize_t n;
+    while ((n = write(filler, block, sizeof(block))) > 0) {
+        filled += static_cast<size_t>(n);
+    }
+    while ((n = write(filler, block, 1)) > 0) {
+        filled += static_cast<size_t>(n);
+    }
+    close(filler);
+
+    ByteDevice device(new HIDPipeSink(path, true));
+    device.send(1);
+    ASSERT_TRUE(waitFor([&device] { return getStats(device).m_stalls == 1; }));
+
+    // folded into the state while the host is away
+    device.send(2);
+    device.send(3);
+    device.send(4);
+    ASSERT_TRUE(waitFor([&device] { return getStats(device).m_queued == 4; }));
+
+    // write() folds reports in between polls for the host, so give it one
+    usleep(250000);
+
+    std::vector<UInt8> bytes;
+    readBytes(reader, bytes, filled + 2);
+    ASSERT_EQ(filled + 1, bytes.size());
+    EXPECT_EQ(4, bytes.back());
+
+    ASSERT_TRUE(waitFor([&device] { return getStats(device).m_dropped == 3; }));
+    HIDStats::Snapshot stats = getStats(device);
+    EXPECT_EQ(1, stats.m_stalls);
+    EXPECT_EQ(0, stats.m_written);
+    EXPECT_EQ(0, stats.m_failures);
+}
@@ -0,0 +1,110 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ClientProxy1_0.h"
+#include "base/EventQueue.h"
+#include "core/protocol_types.h"
+#include "test/mock/io/MockStream.h"
+
+#include "test/global/gtest.h"
+
+#include <vector>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
+
+class ClientProxyTests : public ::testing::Test {
+public:
+    ClientProxyTests() :
+        m_stream(new NiceMock<MockStream>),
+        m_pending(false)
+    {
+        ON_CALL(*m_stream, write(_, _)).WillByDefault(
+                            Invoke(this, &ClientProxyTests::write));
+        ON_CALL(*m_stream, getEventTarget()).WillByDefault(Return(m_stream));
+        ON_CALL(*m_stream, hasPendingOutput()).WillByDefault(
+                            Invoke([this] { return m_pending; }));
+    }
+
+    void                write(const void* data, UInt32 n)
+    {
+        m_writes.push_back(String(static_cast<const char*>(data), n));
+    }
+
+    //! The first four bytes of each write
+    std::vector<String> codes() const
+    {
+        std::vector<String> result;
+        for (const auto& write : m_writes) {
+            result.push_back(write.substr(0, 4));
+        }
+        return result;
+    }
+
+public:
+    EventQueue          m_events;
+    NiceMock<MockStream>* m_stream;
+    bool                m_pending;
+    std::vector<String> m_writes;
+};
+
+TEST_F(ClientProxyTests, mouseMove_pendingOutput_latestSentWhenDrained)
+{
+    ClientProxy1_0 proxy("client", m_stream, &m_events);
+    m_writes.clear();
+
+    m_pending = true;
+    proxy.mouseMove(10, 20);
+    proxy.mouseMove(30, 40);
+    EXPECT_TRUE(m_writes.empty());
+
+    m_pending = false;
+    m_events.dispatchEvent(Event(m_events.forIStream().outputDrained(),
+                            m_stream));
+
+    ASSERT_EQ(1, m_writes.size());
+    EXPECT_EQ(String("DMMV\x00\x1e\x00\x28", 8), m_writes[0]);
+}
+
+TEST_F(ClientProxyTests, keyDown_heldMotion_motionFirst)
+{
+    ClientProxy1_0 proxy("client", m_stream, &m_events);
+    m_writes.clear();
+
+    m_pending = true;
+    proxy.mouseMove(10, 20);
+    proxy.keyDown(0x41, 0, 0);
+    proxy.keyRepeat(0x41, 0, 2, 0);
+    proxy.mouseMove(30, 40);
+    proxy.keyUp(0x41, 0, 0);
+
+    std::vector<String> expected;
+    expected.push_back(kMsgDMouseMove);
+    expected.push_back(kMsgDKeyDown1_0);
+    expected.push_back(kMsgDKeyRepeat1_0);
+    expected.push_back(kMsgDMouseMove);
+    expected.push_back(kMsgDKeyUp1_0);
+    EXPECT_EQ(expected, codes());
+
+    // nothing is left to send once the stream drains
+    m_writes.clear();
+    m_pending = false;
+    m_events.dispatchEvent(Event(m_events.forIStream().outputDrained(),
+                            m_stream));
+    EXPECT_TRUE(m_writes.empty());
+}
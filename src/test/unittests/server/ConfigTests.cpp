@@ -0,0 +1,72 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/Config.h"
+#include "base/EventQueue.h"
+#include "core/option_types.h"
+
+#include "test/global/gtest.h"
+
+#include <sstream>
+
+// read the noopAck global option from a config
+static OptionValue
+readNoopAck(const String& text, Config& config)
+{
+    std::istringstream s(text);
+    s >> config;
+    const Config::ScreenOptions* options = config.getOptions("");
+    auto i = options->find(kOptionNoopAck);
+    return (i == options->end()) ? -1 : i->second;
+}
+
+TEST(ConfigTests, noopAck_roundTrips)
+{
+    static const struct {
+        const char* m_name;
+        OptionValue m_value;
+    } s_modes[] = {
+        { "message", kNoopAckMessage },
+        { "read",    kNoopAckRead },
+        { "none",    kNoopAckNone }
+    };
+
+    EventQueue events;
+    for (const auto& mode : s_modes) {
+        Config config(&events);
+        String text = String("section: options\n\tnoopAck = ") +
+                            mode.m_name + "\nend\n";
+        EXPECT_EQ(mode.m_value, readNoopAck(text, config)) << mode.m_name;
+
+        std::ostringstream written;
+        written << config;
+        EXPECT_NE(String::npos, written.str().find(
+                            String("noopAck = ") + mode.m_name)) << mode.m_name;
+
+        Config reread(&events);
+        EXPECT_EQ(mode.m_value, readNoopAck(written.str(), reread)) << mode.m_name;
+        EXPECT_TRUE(*config.getOptions("") == *reread.getOptions(""))
+                            << mode.m_name;
+    }
+}
+
+TEST(ConfigTests, noopAck_badValue_throws)
+{
+    EventQueue events;
+    Config config(&events);
+    EXPECT_THROW(readNoopAck("section: options\n\tnoopAck = sometimes\nend\n",
+                            config), XConfigRead);
+}
@@ -0,0 +1,136 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/CompactInput.h"
+
+#include "test/global/gtest.h"
+
+static CompactInput
+makeInput(ECompactOp op, SInt32 x = 0, SInt32 y = 0, UInt32 id = 0)
+{
+    CompactInput input{};
+    input.m_op = op;
+    input.m_x  = x;
+    input.m_y  = y;
+    input.m_id = id;
+    return input;
+}
+
+TEST(CompactInputTests, add_smallMove_threeBytes)
+{
+    CompactInputWriter writer;
+    writer.setPosition(100, 100);
+    writer.add(makeInput(kCompactMouseMove, 101, 99));
+
+    ASSERT_EQ(kCompactHeaderSize + 3, writer.getSize());
+    const UInt8* frame = writer.getData();
+    EXPECT_EQ(kCompactFrame, frame[0]);
+    EXPECT_EQ(3, frame[1]);
+    EXPECT_EQ(kCompactMouseMove, frame[2]);
+    EXPECT_EQ(2, frame[3]);
+    EXPECT_EQ(1, frame[4]);
+}
+
+TEST(CompactInputTests, next_mixedFrame_roundTrips)
+{
+    CompactInputWriter writer;
+    writer.setPosition(500, 400);
+    writer.add(makeInput(kCompactMouseMove, 510, 380));
+    writer.add(makeInput(kCompactMouseMove, -20, 70000));
+    writer.add(makeInput(kCompactMouseDown, 0, 0, 1));
+    writer.add(makeInput(kCompactMouseWheel, 0, -120));
+
+    CompactInput key{};
+    key.m_op     = kCompactKeyRepeat;
+    key.m_id     = 0xefff;
+    key.m_mask   = 0x2002;
+    key.m_count  = 3;
+    key.m_button = 38;
+    writer.add(key);
+
+    CompactInputReader reader;
+    reader.setPosition(500, 400);
+    reader.setFrame(writer.getData() + kCompactHeaderSize,
+                            CompactInputReader::getFrameSize(writer.getData()));
+
+    CompactInput input{};
+    ASSERT_TRUE(reader.next(input));
+    EXPECT_EQ(kCompactMouseMove, input.m_op);
+    EXPECT_EQ(510, input.m_x);
+    EXPECT_EQ(380, input.m_y);
+    EXPECT_TRUE(reader.hasMore());
+
+    ASSERT_TRUE(reader.next(input));
+    EXPECT_EQ(-20, input.m_x);
+    EXPECT_EQ(70000, input.m_y);
+
+    ASSERT_TRUE(reader.next(input));
+    EXPECT_EQ(kCompactMouseDown, input.m_op);
+    EXPECT_EQ(1u, input.m_id);
+
+    ASSERT_TRUE(reader.next(input));
+    EXPECT_EQ(kCompactMouseWheel, input.m_op);
+    EXPECT_EQ(-120, input.m_y);
+
+    ASSERT_TRUE(reader.next(input));
+    EXPECT_EQ(kCompactKeyRepeat, input.m_op);
+    EXPECT_EQ(0xefffu, input.m_id);
+    EXPECT_EQ(0x2002u, input.m_mask);
+    EXPECT_EQ(3u, input.m_count);
+    EXPECT_EQ(38u, input.m_button);
+
+    EXPECT_FALSE(reader.hasMore());
+    EXPECT_FALSE(reader.next(input));
+    EXPECT_EQ(kCompactNone, input.m_op);
+}
+
+TEST(CompactInputTests, next_truncated_malformed)
+{
+    // a move whose y varint is cut off
+    const UInt8 frame[] = { kCompactMouseMove, 0x02, 0x80 };
+
+    CompactInputReader reader;
+    reader.setFrame(frame, sizeof(frame));
+
+    CompactInput input{};
+    EXPECT_FALSE(reader.next(input));
+    EXPECT_EQ(kCompactLast, input.m_op);
+    EXPECT_FALSE(reader.hasMore());
+}
+
+TEST(CompactInputTests, hasRoom_fullFrame_false)
+{
+    CompactInputWriter writer;
+    UInt32 count = 0;
+    while (writer.hasRoom()) {
+        writer.add(makeInput(kCompactMouseRelMove, 1, -1));
+        ++count;
+    }
+
+    EXPECT_GT(count, 60u);
+    EXPECT_LE(writer.getSize(), CompactInputWriter::kMaxSize);
+
+    writer.clear();
+    EXPECT_TRUE(writer.isEmpty());
+    EXPECT_EQ(kCompactHeaderSize, writer.getSize());
+}
+
+TEST(CompactInputTests, isFrame_messageCode_false)
+{
+    EXPECT_TRUE(CompactInputReader::isFrame(kCompactFrame));
+    EXPECT_FALSE(CompactInputReader::isFrame('D'));
+    EXPECT_FALSE(CompactInputReader::isFrame('C'));
+}
@@ -0,0 +1,79 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/MotionDatagram.h"
+
+#include "test/global/gtest.h"
+
+TEST(MotionDatagramTests, encode_move_roundTrips)
+{
+    MotionDatagram move;
+    move.m_type  = MotionDatagram::kMove;
+    move.m_token = 0x12345678;
+    move.m_seq   = 0xfffffffe;
+    move.m_x     = -2;
+    move.m_y     = 1000;
+
+    UInt8 buffer[MotionDatagram::kMaxSize];
+    ASSERT_EQ(MotionDatagram::kMaxSize, move.encode(buffer));
+    EXPECT_EQ('M', buffer[0]);
+    EXPECT_EQ(0x12, buffer[1]);
+    EXPECT_EQ(0xff, buffer[9]);
+    EXPECT_EQ(0xfe, buffer[10]);
+
+    MotionDatagram decoded;
+    ASSERT_TRUE(decoded.decode(buffer, MotionDatagram::kMaxSize));
+    EXPECT_EQ(MotionDatagram::kMove, decoded.m_type);
+    EXPECT_EQ(0x12345678u, decoded.m_token);
+    EXPECT_EQ(0xfffffffeu, decoded.m_seq);
+    EXPECT_EQ(-2, decoded.m_x);
+    EXPECT_EQ(1000, decoded.m_y);
+}
+
+TEST(MotionDatagramTests, encode_hello_tokenOnly)
+{
+    MotionDatagram hello;
+    hello.m_token = 42;
+
+    UInt8 buffer[MotionDatagram::kMaxSize];
+    UInt32 size = hello.encode(buffer);
+    EXPECT_EQ(5u, size);
+
+    MotionDatagram decoded;
+    ASSERT_TRUE(decoded.decode(buffer, size));
+    EXPECT_EQ(MotionDatagram::kHello, decoded.m_type);
+    EXPECT_EQ(42u, decoded.m_token);
+}
+
+TEST(MotionDatagramTests, decode_wrongSize_fails)
+{
+    MotionDatagram move;
+    move.m_type = MotionDatagram::kMove;
+
+    UInt8 buffer[MotionDatagram::kMaxSize];
+    move.encode(buffer);
+    EXPECT_FALSE(move.decode(buffer, MotionDatagram::kMaxSize - 1));
+    EXPECT_FALSE(move.decode(buffer, 5));
+}
+
+TEST(MotionDatagramTests, isNewer_wraps)
+{
+    EXPECT_TRUE(MotionDatagram::isNewer(2, 1));
+    EXPECT_FALSE(MotionDatagram::isNewer(1, 2));
+    EXPECT_FALSE(MotionDatagram::isNewer(7, 7));
+    EXPECT_TRUE(MotionDatagram::isNewer(1, 0xffffffff));
+    EXPECT_FALSE(MotionDatagram::isNewer(0xffffffff, 1));
+}
@@ -0,0 +1,123 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/PacketStreamFilter.h"
+#include "test/mock/io/MockStream.h"
+#include "test/mock/synergy/MockEventQueue.h"
+
+#include "test/global/gtest.h"
+
+#include <cstring>
+#include <string>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+namespace {
+
+// collects what reaches the wrapped stream, one string per call
+class Writes {
+public:
+    void                writeBuffers(const synergy::IStream::Buffer* buffers,
+                            UInt32 count)
+    {
+        std::string data;
+        for (UInt32 i = 0; i < count; ++i) {
+            data.append(static_cast<const char*>(buffers[i].m_data),
+                            buffers[i].m_size);
+        }
+        m_calls.push_back(data);
+    }
+
+public:
+    std::vector<std::string> m_calls;
+};
+
+}
+
+TEST(PacketStreamFilterTests, write_lengthAndPayload_oneWrite)
+{
+    NiceMock<MockEventQueue> events;
+    NiceMock<MockStream>* stream = new NiceMock<MockStream>();
+    Writes writes;
+    ON_CALL(*stream, writeBuffers(_, _))
+        .WillByDefault(Invoke(&writes, &Writes::writeBuffers));
+    EXPECT_CALL(*stream, write(_, _)).Times(0);
+
+    PacketStreamFilter filter(&events, stream);
+    filter.write("DMMV", 4);
+
+    ASSERT_EQ(1u, writes.m_calls.size());
+    EXPECT_EQ(std::string("\0\0\0\4DMMV", 8), writes.m_calls[0]);
+}
+
+TEST(PacketStreamFilterTests, writeBuffers_manyBuffers_framedAsOnePacket)
+{
+    NiceMock<MockEventQueue> events;
+    NiceMock<MockStream>* stream = new NiceMock<MockStream>();
+    Writes writes;
+    ON_CALL(*stream, writeBuffers(_, _))
+        .WillByDefault(Invoke(&writes, &Writes::writeBuffers));
+
+    std::string expected("\0\0\1\54", 4);
+    std::vector<std::string> parts;
+    for (int i = 0; i < 30; ++i) {
+        parts.push_back(std::string(10, static_cast<char>('a' + i)));
+        expected += parts.back();
+    }
+    std::vector<synergy::IStream::Buffer> buffers;
+    for (const std::string& part : parts) {
+        synergy::IStream::Buffer buffer = { part.data(),
+                            static_cast<UInt32>(part.size()) };
+        buffers.push_back(buffer);
+    }
+
+    PacketStreamFilter filter(&events, stream);
+    filter.writeBuffers(&buffers[0], static_cast<UInt32>(buffers.size()));
+
+    ASSERT_EQ(1u, writes.m_calls.size());
+    EXPECT_EQ(expected, writes.m_calls[0]);
+}
+
+TEST(PacketStreamFilterTests, cork_forwardedToStream)
+{
+    NiceMock<MockEventQueue> events;
+    NiceMock<MockStream>* stream = new NiceMock<MockStream>();
+    EXPECT_CALL(*stream, cork()).Times(1);
+    EXPECT_CALL(*stream, uncork()).Times(1);
+
+    PacketStreamFilter filter(&events, stream);
+    filter.cork();
+    filter.uncork();
+}
+
+TEST(PacketStreamFilterTests, writeBulk_framed_staysBulk)
+{
+    NiceMock<MockEventQueue> events;
+    NiceMock<MockStream>* stream = new NiceMock<MockStream>();
+    Writes writes;
+    ON_CALL(*stream, writeBulk(_, _))
+        .WillByDefault(Invoke(&writes, &Writes::writeBuffers));
+    EXPECT_CALL(*stream, writeBuffers(_, _)).Times(0);
+
+    synergy::IStream::Buffer buffer = { "DFTR", 4 };
+    PacketStreamFilter filter(&events, stream);
+    filter.writeBulk(&buffer, 1);
+
+    ASSERT_EQ(1u, writes.m_calls.size());
+    EXPECT_EQ(std::string("\0\0\0\4DFTR", 8), writes.m_calls[0]);
+}
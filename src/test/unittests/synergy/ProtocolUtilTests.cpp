@@ -0,0 +1,170 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/ProtocolUtil.h"
+#include "core/clipboard_types.h"
+#include "core/option_types.h"
+#include "core/protocol_types.h"
+#include "test/mock/io/MockStream.h"
+
+#include "test/global/gtest.h"
+
+#include <cstring>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+// collects writes and serves reads from a byte string
+class StreamData {
+public:
+    StreamData() : m_offset(0) { }
+
+    void                write(const void* data, UInt32 n)
+    {
+        m_writes.push_back(String(static_cast<const char*>(data), n));
+    }
+
+    UInt32              read(void* data, UInt32 n)
+    {
+        if (n > m_input.size() - m_offset) {
+            n = static_cast<UInt32>(m_input.size() - m_offset);
+        }
+        memcpy(data, m_input.data() + m_offset, n);
+        m_offset += n;
+        return n;
+    }
+
+    void                attach(MockStream& stream)
+    {
+        ON_CALL(stream, write(_, _)).WillByDefault(Invoke(this, &StreamData::write));
+        ON_CALL(stream, read(_, _)).WillByDefault(Invoke(this, &StreamData::read));
+    }
+
+public:
+    std::vector<String> m_writes;
+    String              m_input;
+    size_t              m_offset;
+};
+
+TEST(ProtocolUtilTests, write_keyDown_oneWriteInNetworkByteOrder)
+{
+    NiceMock<MockStream> stream;
+    StreamData data;
+    data.attach(stream);
+
+    ProtocolUtil::write<MsgDKeyDown>(&stream, 0x41, 0x2002, 0x1e);
+
+    ASSERT_EQ(1, data.m_writes.size());
+    EXPECT_EQ(String("DKDN\x00\x41\x20\x02\x00\x1e", 10), data.m_writes[0]);
+}
+
+TEST(ProtocolUtilTests, write_negativePosition_twosComplement)
+{
+    NiceMock<MockStream> stream;
+    StreamData data;
+    data.attach(stream);
+
+    ProtocolUtil::write<MsgDMouseRelMove>(&stream, -2, 300);
+
+    ASSERT_EQ(1, data.m_writes.size());
+    EXPECT_EQ(String("DMRM\xff\xfe\x01\x2c", 8), data.m_writes[0]);
+}
+
+TEST(ProtocolUtilTests, write_variableFields_lengthPrefixed)
+{
+    NiceMock<MockStream> stream;
+    StreamData data;
+    data.attach(stream);
+
+    OptionsList options;
+    options.push_back(0x01020304);
+    options.push_back(5);
+    ProtocolUtil::write<MsgDSetOptions>(&stream, options);
+    ProtocolUtil::write<MsgDFileTransfer>(&stream, 1, String(300, 'x'));
+
+    ASSERT_EQ(2, data.m_writes.size());
+    EXPECT_EQ(String("DSOP\0\0\0\x02\x01\x02\x03\x04\0\0\0\x05", 16), data.m_writes[0]);
+    ASSERT_EQ(4 + 1 + 4 + 300, data.m_writes[1].size());
+    EXPECT_EQ(String("DFTR\x01\0\0\x01\x2c", 9), data.m_writes[1].substr(0, 9));
+}
+
+TEST(ProtocolUtilTests, read_clipboard_decodesFieldsAfterCode)
+{
+    NiceMock<MockStream> stream;
+    StreamData data;
+    data.attach(stream);
+    data.m_input = String("\x01\x00\x00\x01\x00\x02\0\0\0\x03" "abc", 13);
+
+    ClipboardID id;
+    UInt32 sequence;
+    UInt8 mark;
+    String text;
+    ASSERT_TRUE(ProtocolUtil::read<MsgDClipboard>(&stream, id, sequence, mark, text));
+    EXPECT_EQ(1, id);
+    EXPECT_EQ(256, sequence);
+    EXPECT_EQ(2, mark);
+    EXPECT_EQ("abc", text);
+}
+
+TEST(ProtocolUtilTests, read_truncated_fails)
+{
+    NiceMock<MockStream> stream;
+    StreamData data;
+    data.attach(stream);
+    data.m_input = String("\xff\xfe\x00", 3);
+
+    SInt16 x, y;
+    EXPECT_FALSE(ProtocolUtil::read<MsgDMouseMove>(&stream, x, y));
+}
+
+TEST(ProtocolUtilTests, readMessage_hello_checksCode)
+{
+    NiceMock<MockStream> stream;
+    StreamData data;
+    data.attach(stream);
+    data.m_input = String("Synergy\x00\x01\x00\x06", 11);
+
+    SInt16 major, minor;
+    ASSERT_TRUE(ProtocolUtil::readMessage<MsgHello>(&stream, major, minor));
+    EXPECT_EQ(1, major);
+    EXPECT_EQ(6, minor);
+
+    data.m_input  = String("Synergx\x00\x01\x00\x06", 11);
+    data.m_offset = 0;
+    EXPECT_FALSE(ProtocolUtil::readMessage<MsgHello>(&stream, major, minor));
+}
+
+TEST(ProtocolUtilTests, getMessageID_everyID_roundTripsThroughCode)
+{
+    for (UInt32 i = kMsgIDUnknown + 1; i < kNumMessageIDs; ++i) {
+        EMessageID id = static_cast<EMessageID>(i);
+        const char* code = ProtocolUtil::getMessageCode(id);
+        ASSERT_TRUE(code != NULL);
+        EXPECT_EQ(id, ProtocolUtil::getMessageID(
+                            reinterpret_cast<const UInt8*>(code)));
+    }
+}
+
+TEST(ProtocolUtilTests, getMessageID_unknownCode_unknownID)
+{
+    EXPECT_EQ(kMsgIDDKeyUp, ProtocolUtil::getMessageID(
+                            reinterpret_cast<const UInt8*>("DKUP")));
+    EXPECT_EQ(kMsgIDUnknown, ProtocolUtil::getMessageID(
+                            reinterpret_cast<const UInt8*>("DKUQ")));
+    EXPECT_EQ(kMsgIDUnknown, ProtocolUtil::getMessageID(
+                            reinterpret_cast<const UInt8*>("\0\0\0\0")));
+}